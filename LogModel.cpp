@@ -0,0 +1,122 @@
+// LogModel.cpp
+
+#include "LogModel.h"
+
+#include <QDateTime>
+
+LogModel::LogModel(int capacity, QObject* parent)
+    : QAbstractListModel(parent),
+      capacity_(capacity > 0 ? capacity : 1) {
+    ring_.resize(capacity_);
+}
+
+int LogModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : count_;
+}
+
+int LogModel::count() const {
+    return count_;
+}
+
+int LogModel::capacity() const {
+    return capacity_;
+}
+
+const LogModel::Entry& LogModel::at(int row) const {
+    return ring_[(start_ + row) % capacity_];
+}
+
+QVariant LogModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() < 0 || index.row() >= count_)
+        return {};
+
+    const Entry& e = at(index.row());
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case MessageRole:
+        return e.message;
+    case TagRole:
+        return e.tag;
+    case LevelRole:
+        return e.level;
+    case TimeTextRole:
+        return QDateTime::fromMSecsSinceEpoch(e.timestampMs).toString("hh:mm:ss AP");
+    case IconRole:
+        return e.level >= Warn ? QStringLiteral("../assets/error.png")
+                               : QStringLiteral("../assets/info.png");
+    default:
+        return {};
+    }
+}
+
+QHash<int, QByteArray> LogModel::roleNames() const {
+    return {
+        { MessageRole, "message" },
+        { TagRole, "tag" },
+        { LevelRole, "level" },
+        { TimeTextRole, "timeText" },
+        { IconRole, "iconSource" }
+    };
+}
+
+/*
+ * ==============================================================
+ * void appendBatch(const QVector<Entry>& batch)
+ * ==============================================================
+ * Appends a batch of entries at the end of the ring.
+ * If the ring overflows, the oldest rows are removed first in a single
+ * removal so the view only relayouts once per batch.
+ * A batch larger than the capacity keeps only its newest entries.
+ */
+void LogModel::appendBatch(const QVector<Entry>& batch) {
+    if (batch.isEmpty())
+        return;
+
+    int n = static_cast<int>(batch.size());
+    int skip = 0;
+    if (n > capacity_) {
+        skip = n - capacity_;
+        n = capacity_;
+    }
+
+    const int overflow = count_ + n - capacity_;
+    if (overflow > 0) {
+        beginRemoveRows(QModelIndex(), 0, overflow - 1);
+        start_ = (start_ + overflow) % capacity_;
+        count_ -= overflow;
+        endRemoveRows();
+    }
+
+    beginInsertRows(QModelIndex(), count_, count_ + n - 1);
+    for (int i = 0; i < n; ++i) {
+        ring_[(start_ + count_) % capacity_] = batch[skip + i];
+        ++count_;
+    }
+    endInsertRows();
+
+    emit countChanged();
+}
+
+void LogModel::append(int level, const QString& tag, const QString& message) {
+    Entry e;
+    e.timestampMs = QDateTime::currentMSecsSinceEpoch();
+    e.level = level;
+    e.tag = tag;
+    e.message = message;
+    appendBatch({ e });
+}
+
+void LogModel::clear() {
+    if (count_ == 0)
+        return;
+
+    beginResetModel();
+    for (Entry& e : ring_)
+        e = Entry();
+    start_ = 0;
+    count_ = 0;
+    endResetModel();
+
+    emit countChanged();
+}
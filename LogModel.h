@@ -0,0 +1,74 @@
+#ifndef LOGMODEL_H
+#define LOGMODEL_H
+
+#include <QAbstractListModel>
+#include <QString>
+#include <QVector>
+
+/*
+ * Activity log shown in the dashboard's log panel.
+ * Entries live in a fixed-capacity ring: once full, every append evicts
+ * the oldest rows, so memory stays bounded regardless of uptime.
+ * Rows are ordered oldest -> newest.
+ */
+class LogModel : public QAbstractListModel {
+    Q_OBJECT
+
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(int capacity READ capacity CONSTANT)
+
+   public:
+    // Matches otalog::Level
+    enum Severity {
+        Trace = 0,
+        Debug,
+        Info,
+        Warn,
+        Error
+    };
+    Q_ENUM(Severity)
+
+    enum Roles {
+        MessageRole = Qt::UserRole + 1,
+        TagRole,
+        LevelRole,
+        TimeTextRole,
+        IconRole
+    };
+
+    struct Entry {
+        qint64 timestampMs = 0;
+        int level = Info;
+        QString tag;
+        QString message;
+    };
+
+    explicit LogModel(int capacity = 500, QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    int count() const;
+    int capacity() const;
+
+    // One insert (and at most one eviction) per batch
+    void appendBatch(const QVector<Entry>& batch);
+
+    Q_INVOKABLE void append(int level, const QString& tag, const QString& message);
+    Q_INVOKABLE void clear();
+
+   signals:
+    void countChanged();
+
+   private:
+    const Entry& at(int row) const;
+
+   private:
+    QVector<Entry> ring_;
+    int capacity_;
+    int start_ = 0;
+    int count_ = 0;
+};
+
+#endif // LOGMODEL_H
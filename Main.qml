@@ -12,48 +12,46 @@ Window {
     visible: true
     title: qsTr("OTA Update Manager")
 
-    // Custom Properties
-    property string updateState: "idle"
+    // Cards kept loaded: the one shown and the two most recently shown
+    // before it, most recent first (OtaController.UiState values). The rest
+    // are released and created again, asynchronously, when next needed.
+    readonly property int cardCacheSize: 3
+    property var cardCache: []
+    // Card on screen; lags OtaController.uiState until the new card is ready
+    property int shownCard: -1
+
+    function showCard(state) {
+        const cache = cardCache.filter(s => s !== state)
+        cache.unshift(state)
+        cardCache = cache.slice(0, cardCacheSize)
+
+        const loader = cardLoaders.itemAt(state)
+        if (loader && loader.status === Loader.Ready)
+            shownCard = state
+    }
+
+    // Starts on the card of the cached check result, if there is one
+    Component.onCompleted: showCard(OtaController.uiState)
+
+    // Slows down system sampling while the dashboard cannot be seen
+    onVisibilityChanged: (visibility) => {
+        OtaController.setDashboardVisible(visibility !== Window.Minimized
+                                          && visibility !== Window.Hidden)
+    }
 
     Connections {
-        target: otaController
+        target: OtaController
 
-        function onUpdateCheckStarted() {
-            updateState = "checking"
+        function onUiStateChanged() {
+            showCard(OtaController.uiState)
         }
 
         function onUpdateCheckDone(updateRequest) {
             console.log("update Req " + updateRequest)
-            switch(updateRequest){
-            case 0:
-                updateState = "updateAvailable"
-                break
-            case 1:
-                updateState = "upToDate"
-                break
-            default:
-                updateState = "requestRefused"
-            }
-        }
-
-        function onProgressChanged(percent) {
-
-            if(updateState != "downloadUpdate"){
-                updateState = "downloadUpdate"
-            }
-        }
-
-        function onDownloadFinished() {
-            updateState = "downloadFinished"
-        }
-
-        function onDownloadRejected() {
-            updateState = "requestRefused"
         }
 
         function onErrorOccurred(message) {
             console.log("OTA error: ", message)
-            updateState = "requestRefused"
         }
     }
 
@@ -129,11 +127,11 @@ Window {
                             spacing: 8
 
                             OnlineStatusIndicator {
-                                connected: otaController.serverConnected
+                                connected: OtaController.serverConnected
                             }
 
                             Text {
-                                text: otaController.serverConnected
+                                text: OtaController.serverConnected
                                           ? "Connected to QNX Server"
                                           : "Server Disconnected"
                                 font.pixelSize: 18
@@ -163,51 +161,67 @@ Window {
                     Rectangle {
                         id: updateArea
                         width: parent.width
-                        height: updateLoader.item ? updateLoader.item.implicitHeight : 300
+                        height: {
+                            const loader = cardLoaders.itemAt(shownCard)
+                            return loader && loader.item ? loader.item.implicitHeight : 300
+                        }
                         radius: 15
                         border.width: 1
                         border.color: "#e2e8f0"
                         color: "transparent"
 
-                        Loader {
-                            id: updateLoader
-                            anchors.fill: parent
-
-                            source: {
-                                switch(updateState){
-                                case "idle": return "cards/CardIdle.qml"
-                                case "checking": return "cards/CardChecking.qml"
-                                case "upToDate": return "cards/CardUpToDate.qml"
-                                case "updateAvailable": return "cards/CardUpdateAvailable.qml"
-                                case "requestRefused": return "cards/CardRequestRefused.qml"
-                                case "downloadUpdate": return "cards/CardDownloading.qml"
-                                case "downloadFinished": return "cards/CardDownloadFinished.qml"
-                                default: return "cards/CardIdle.qml"
-                                }
-                            }
-
-                            onLoaded: {
-                                if(item && item.requestUpdate) {
-                                    item.requestUpdate.connect(() => {
-                                        otaController.checkForUpdate();
-                                    })
-                                }
-
-                                if(item && item.returnRequested) {
-                                    item.returnRequested.connect(() => updateState = "idle" )
-                                }
-
-                                if(item && item.checkForUpdate){
-                                    item.checkForUpdate.connect(() => {
-                                        updateState = "updateAvailable"
-                                    })
-                                }
-
-                                if(item && item.downloadUpdate){
-                                    item.downloadUpdate.connect(() => {
-                                        updateState = "downloadUpdate"
-                                        otaController.startDownload()
-                                    })
+                        // One loader per OtaController.UiState, in enum order
+                        Repeater {
+                            id: cardLoaders
+                            model: [
+                                "cards/CardIdle.qml",
+                                "cards/CardChecking.qml",
+                                "cards/CardUpToDate.qml",
+                                "cards/CardUpdateAvailable.qml",
+                                "cards/CardRequestRefused.qml",
+                                "cards/CardDownloading.qml",
+                                "cards/CardDownloadFinished.qml",
+                                "cards/CardError.qml"
+                            ]
+
+                            delegate: Loader {
+                                required property int index
+                                required property string modelData
+
+                                anchors.fill: parent
+                                asynchronous: true
+                                active: cardCache.indexOf(index) >= 0
+                                source: modelData
+                                visible: shownCard === index
+
+                                onLoaded: {
+                                    if(item.requestUpdate) {
+                                        item.requestUpdate.connect(() => {
+                                            OtaController.checkForUpdate();
+                                        })
+                                    }
+
+                                    if(item.returnRequested) {
+                                        item.returnRequested.connect(() => {
+                                            OtaController.uiState = OtaController.Idle
+                                        })
+                                    }
+
+                                    if(item.checkForUpdate){
+                                        item.checkForUpdate.connect(() => {
+                                            OtaController.uiState = OtaController.UpdateAvailable
+                                        })
+                                    }
+
+                                    if(item.downloadUpdate){
+                                        item.downloadUpdate.connect(() => {
+                                            OtaController.uiState = OtaController.Downloading
+                                            OtaController.startDownload()
+                                        })
+                                    }
+
+                                    if (index === OtaController.uiState)
+                                        shownCard = index
                                 }
                             }
                         }
@@ -274,7 +288,7 @@ Window {
                                 StatusTile {
                                     iconSource: "../assets/shield.png"
                                     title: qsTr("CommonAPI")
-                                    subtitle: otaController.serverConnected ?
+                                    subtitle: OtaController.serverConnected ?
                                                 qsTr("Connected") :
                                                 qsTr("Disconnected")
                                     statusText: qsTr("v3.2.4")
@@ -346,25 +360,45 @@ Window {
                                 MetricRow {
                                     source: "../assets/cpu.png"
                                     text: qsTr("CPU")
-                                    deviceData: otaController.cpuPercent + "%"
+                                    deviceData: OtaController.cpuPercent + "%"
+                                    historyMetric: Sparkline.Cpu
+                                }
+
+                                MetricRow {
+                                    source: "../assets/cpu.png"
+                                    text: qsTr("Cores")
+                                    deviceData: OtaController.coreCpuPercent.join("% ") + "%"
+                                                + "  (iowait " + OtaController.iowaitPercent + "%)"
+                                }
+
+                                MetricRow {
+                                    source: "../assets/cpu.png"
+                                    text: qsTr("OTA Client")
+                                    deviceData: OtaController.selfCpuPercent.toFixed(1) + "% · "
+                                                + OtaController.selfRssText + " · "
+                                                + OtaController.selfThreads + " thr"
                                 }
 
                                 MetricRow {
                                     source: "../assets/ram.png"
                                     text: qsTr("Memory")
-                                    deviceData: otaController.memoryText
+                                    deviceData: OtaController.memoryText
+                                    historyMetric: Sparkline.Memory
                                 }
 
                                 MetricRow {
                                     source: "../assets/memory-card.png"
                                     text: qsTr("Storage")
-                                    deviceData: otaController.storageText
+                                    deviceData: OtaController.storageText
                                 }
 
                                 MetricRow {
                                     source: "../assets/temp.png"
                                     text: qsTr("Tempreture")
-                                    deviceData: otaController.temperatureC + "°C"
+                                    deviceData: OtaController.temperatureC + "°C"
+                                    historyMetric: Sparkline.Temperature
+                                    historyMinimum: 30
+                                    historyMaximum: 90
                                 }
                             }
 
@@ -395,7 +429,7 @@ Window {
                                 MetricRow {
                                     source: "../assets/blackberry.png"
                                     text: qsTr("Uptime")
-                                    deviceData: otaController.upTimeText
+                                    deviceData: OtaController.upTimeText
                                 }
                             }
                         }
@@ -410,81 +444,45 @@ Window {
                         width: parent.width
                         height: 400
 
-                        ScrollView {
-                            id: logsScroll
+                        ColumnLayout {
                             anchors.fill: parent
                             anchors.margins: 20
-                            clip: true
-                            ScrollBar.horizontal.policy: ScrollBar.AlwaysOff
-                            ScrollBar.vertical.policy: ScrollBar.AsNeeded
+                            spacing: 10
+
+                            MetricRow {
+                                id: logsheader
+                                Layout.fillWidth: true
+                                source: "../assets/log.png"
+                                text: "Activity Logs"
+                                deviceData: ""
+                            }
 
-                            ColumnLayout {
-                                id: logsColumn
-                                width: logsScroll.availableWidth
+                            // Backed by a fixed-capacity ring in C++, delegates are recycled
+                            ListView {
+                                id: logsList
+                                Layout.fillWidth: true
+                                Layout.fillHeight: true
+                                clip: true
                                 spacing: 10
-
-                                MetricRow {
-                                    id: logsheader
-                                    Layout.fillWidth: true
-                                    source: "../assets/log.png"
-                                    text: "Activity Logs"
-                                    deviceData: ""
-                                }
-
-                                LogEntry {
-                                    Layout.fillWidth: true
-                                    source: "../assets/info.png"
-                                    text: "Dashboard reset"
-                                    myDate: "04:03:16 PM"
-                                }
-
-                                LogEntry {
-                                    Layout.fillWidth: true
-                                    source: "../assets/info.png"
-                                    text: "Update file received"
-                                    myDate: "04:04:10 PM"
-                                }
-
-                                LogEntry {
-                                    Layout.fillWidth: true
-                                    source: "../assets/info.png"
-                                    text: "CRC check passed"
-                                    myDate: "04:05:30 PM"
-                                }
-
-                                LogEntry {
-                                    Layout.fillWidth: true
-                                    source: "../assets/info.png"
-                                    text: "Installation started"
-                                    myDate: "04:06:15 PM"
-                                }
-
-                                LogEntry {
-                                    Layout.fillWidth: true
-                                    source: "../assets/info.png"
-                                    text: "Verifying integrity"
-                                    myDate: "04:07:22 PM"
-                                }
-
-                                LogEntry {
-                                    Layout.fillWidth: true
-                                    source: "../assets/info.png"
-                                    text: "Update completed"
-                                    myDate: "04:08:45 PM"
-                                }
-
-                                LogEntry {
-                                    Layout.fillWidth: true
-                                    source: "../assets/info.png"
-                                    text: "System reboot required"
-                                    myDate: "04:09:10 PM"
+                                reuseItems: true
+                                model: OtaController.logModel
+                                ScrollBar.vertical: ScrollBar { policy: ScrollBar.AsNeeded }
+
+                                delegate: LogEntry {
+                                    required property string message
+                                    required property string timeText
+                                    required property string iconSource
+
+                                    width: ListView.view.width
+                                    source: iconSource
+                                    text: message
+                                    myDate: timeText
                                 }
 
-                                LogEntry {
-                                    Layout.fillWidth: true
-                                    source: "../assets/info.png"
-                                    text: "Backup created"
-                                    myDate: "04:10:00 PM"
+                                // Follow new entries unless the user is scrolling back
+                                onCountChanged: {
+                                    if (!moving && !dragging)
+                                        positionViewAtEnd()
                                 }
                             }
                         }
@@ -3,7 +3,19 @@
 #include "OtaController.h"
 #include "OtaBackend.h"
 
+#include <algorithm>
 #include <chrono>
+#include <QGuiApplication>
+#include <QJSEngine>
+#include <QStringList>
+#include <QVariantMap>
+
+#include <sys/resource.h>
+
+// No input for this long switches the monitor to the idle sampling profile
+static const int kUserIdleTimeoutMs = 60 * 1000;
+// Frames per minute and idle CPU are reported at this period
+static const int kRenderStatsIntervalMs = 60 * 1000;
 
 // ------------------------------------------------------------
 // Helper: read uint32 from a text file
@@ -27,16 +39,37 @@ static bool readUint32FromFile(const QString& path, uint32_t& valueOut) {
     return ok;
 }
 
+// Label of an artifact in the bundle list
+static QString bundleStateText(BundleTransfer::State state) {
+    switch (state) {
+    case BundleTransfer::State::Checking:     return "Checking";
+    case BundleTransfer::State::Queued:       return "Queued";
+    case BundleTransfer::State::Transferring: return "Downloading";
+    case BundleTransfer::State::Verifying:    return "Verifying";
+    case BundleTransfer::State::Done:         return "Done";
+    case BundleTransfer::State::Failed:       return "Failed";
+    }
+    return QString();
+}
+
+namespace {
+OtaController* g_instance = nullptr;
+}
+
 OtaController::OtaController(QObject* parent)
     : QObject(parent),
-      backend_(std::make_unique<OtaBackend>("rpi4-update.wic")) {
+      backend_(std::make_unique<OtaBackend>("rpi4-update.wic")),
+      logModel_(new LogModel(500, this)),
+      prefetch_(PrefetchScheduler::configFromEnv()) {
 
     // ---- Backend → Qt bridge (progress + speed) ----
     backend_->setProgressCallback([this](int percent) {
         const auto now = std::chrono::steady_clock::now();
 
                 // Ensure downloadStart_ is initialized at the beginning of a transfer
-        if (percent <= 0 || downloadStart_ == std::chrono::steady_clock::time_point{}) {
+        if (bundleMode_) {
+            // speed_ comes from the bundle scheduler, which leaves out skipped artifacts
+        } else if (percent <= 0 || downloadStart_ == std::chrono::steady_clock::time_point{}) {
             downloadStart_ = now;
             speed_ = 0.0;
         } else {
@@ -54,6 +87,11 @@ OtaController::OtaController(QObject* parent)
             this,
             [this, percent]() {
                 progress_ = percent;
+                // A background prefetch stays off the update cards
+                if (prefetchActive_) {
+                    emit prefetchChanged();
+                    return;
+                }
                 emit progressChanged(percent);
                 emit speedChanged(speed_.load());
             },
@@ -65,8 +103,14 @@ OtaController::OtaController(QObject* parent)
         QMetaObject::invokeMethod(
             this,
             [this]() {
+                if (prefetchActive_) {
+                    finishPrefetch(true, QString());
+                    return;
+                }
+                readyVersion_ = updateInfo_.getNewVersion();
                 setBusy(false);
                 emit downloadFinished(true);
+                emit prefetchChanged();
             },
             Qt::QueuedConnection
             );
@@ -76,6 +120,12 @@ OtaController::OtaController(QObject* parent)
         QMetaObject::invokeMethod(
             this,
             [this, msg]() {
+                if (prefetchActive_) {
+                    // A failed check is accounted for by its own result
+                    if (prefetchDownloading_)
+                        finishPrefetch(false, QString::fromStdString(msg));
+                    return;
+                }
                 setBusy(false);
                 updateServerConnected();
                 emit errorOccurred(QString::fromStdString(msg));
@@ -84,6 +134,37 @@ OtaController::OtaController(QObject* parent)
             );
     });
 
+    // Per-artifact view of a bundle download
+    backend_->setBundleCallback([this](const BundleTransfer::Progress& p) {
+        bundleMode_ = true;
+        speed_ = p.bytesPerSec / (1024.0 * 1024.0);
+
+        QVariantList artifacts;
+        for (const BundleTransfer::ArtifactStatus& a : p.artifacts) {
+            QVariantMap item;
+            item["name"] = QString::fromStdString(a.name);
+            item["sizeMB"] = a.size / (1024.0 * 1024.0);
+            item["progress"] = a.size ? static_cast<int>((a.doneBytes * 100) / a.size) : 100;
+            item["state"] = bundleStateText(a.state);
+            item["speedMBps"] = a.bytesPerSec / (1024.0 * 1024.0);
+            item["skipped"] = a.skipped;
+            artifacts.append(item);
+        }
+
+        QMetaObject::invokeMethod(
+            this,
+            [this, artifacts, totalBytes = p.totalBytes]() {
+                artifacts_ = artifacts;
+                if (bundleBytes_ != totalBytes) {
+                    bundleBytes_ = totalBytes;
+                    emit totalSizeChanged();
+                }
+                if (!prefetchActive_) emit artifactsChanged();
+            },
+            Qt::QueuedConnection
+            );
+    });
+
             // ---- Backend → Qt bridge (chunk info) ----
     backend_->setChunkCallback([this](uint32_t index, uint32_t total) {
         QMetaObject::invokeMethod(
@@ -109,16 +190,351 @@ OtaController::OtaController(QObject* parent)
                 stTotal_ = snap.storageTotalBytes;
                 temperatureC_ = snap.temperatureC;
                 upTimeSeconds_ = snap.uptimeSeconds;
+                lastSnapshot_ = snap;
+                if (lowPower_) {
+                    idleCpuSum_ += snap.selfCpuPercent;
+                    ++idleCpuSamples_;
+                }
+
+                // In low power, only a change of what is shown reaches the
+                // scene graph (bindings, sparklines, the effects above them)
+                const QString key = systemInfoKey();
+                if (!lowPower_ || key != lastSystemInfoKey_) {
+                    lastSystemInfoKey_ = key;
+                    emit systemInfoChanged();
+                }
+                updateRenderMode();
+                updatePrefetchActivity();
+            },
 
-                emit systemInfoChanged();
+            Qt::QueuedConnection
+        );
+    });
+
+    // Service (re)appeared: refresh the cached answer right away
+    backend_->setAvailabilityCallback([this](bool available) {
+        QMetaObject::invokeMethod(
+            this,
+            [this, available]() {
+                updateServerConnected();
+                if (available)
+                    refreshUpdateCheck();
             },
+            Qt::QueuedConnection
+        );
+    });
 
+    if (!g_instance)
+        g_instance = this;
+
+    // Last answer from the disk cache, so the first frame shows the right card
+    if (backend_->loadCachedUpdate(readCurrentVersion())) {
+        updateInfo_ = backend_->updateInfo_;
+        updateRequest = classifyUpdateInfo(updateInfo_);
+        hasCheckResult_ = true;
+        uiState_ = uiStateFor(updateRequest);
+    }
+
+    // Backend log records arrive in batches from the logger's drain thread
+    backend_->setLogCallback([this](const std::vector<otalog::Line>& lines, size_t count) {
+        QVector<LogModel::Entry> batch;
+        batch.reserve(static_cast<int>(count));
+        for (size_t i = 0; i < count; ++i) {
+            const otalog::Line& line = lines[i];
+            LogModel::Entry e;
+            e.timestampMs = static_cast<qint64>(line.realtimeNs / 1000000ULL);
+            e.level = static_cast<int>(line.level);
+            e.tag = QString::fromLatin1(line.tag);
+            e.message = QString::fromStdString(line.message);
+            batch.push_back(std::move(e));
+        }
+
+        QMetaObject::invokeMethod(
+            this,
+            [this, batch]() {
+                logModel_->appendBatch(batch);
+            },
             Qt::QueuedConnection
         );
     });
+
+    // ---- Activity profile: visible + recent input -> fast sampling ----
+    idleTimer_.setSingleShot(true);
+    idleTimer_.setInterval(kUserIdleTimeoutMs);
+    connect(&idleTimer_, &QTimer::timeout, this, &OtaController::updateActivityProfile);
+    connect(this, &OtaController::busyChanged, this, &OtaController::updateActivityProfile);
+    if (auto* app = qobject_cast<QGuiApplication*>(QCoreApplication::instance())) {
+        connect(app, &QGuiApplication::applicationStateChanged,
+                this, &OtaController::updateActivityProfile);
+        app->installEventFilter(this);
+    }
+    idleTimer_.start();
+
+    // ---- Low-power rendering: auto (default), on or off ----
+    const QString renderMode = qEnvironmentVariable("OTA_LOW_POWER").trimmed().toLower();
+    if (renderMode == "on" || renderMode == "1")
+        renderMode_ = RenderMode::On;
+    else if (renderMode == "off" || renderMode == "0")
+        renderMode_ = RenderMode::Off;
+    renderStatsStart_ = std::chrono::steady_clock::now();
+    renderStatsTimer_.setInterval(kRenderStatsIntervalMs);
+    connect(&renderStatsTimer_, &QTimer::timeout, this, &OtaController::updateRenderStats);
+    renderStatsTimer_.start();
+    updateRenderMode();
+
+    // ---- Background prefetch: periodic checks, download while idle ----
+    prefetchTimer_.setSingleShot(true);
+    connect(&prefetchTimer_, &QTimer::timeout, this, &OtaController::runPrefetchCheck);
+
+    // ---- UI activity entries ----
+    connect(this, &OtaController::updateCheckStarted, this, [this]() {
+        logModel_->append(LogModel::Info, "Controller", "Checking for updates");
+    });
+    connect(this, &OtaController::updateCheckDone, this, [this](CheckUpdateState state) {
+        switch (state) {
+        case Available:
+            logModel_->append(LogModel::Info, "Controller", "Update available");
+            break;
+        case UpToDate:
+            logModel_->append(LogModel::Info, "Controller", "System is up to date");
+            break;
+        default:
+            logModel_->append(LogModel::Warn, "Controller", "Update request refused");
+        }
+    });
+    connect(this, &OtaController::downloadFinished, this, [this](bool success) {
+        logModel_->append(success ? LogModel::Info : LogModel::Error, "Controller",
+                          success ? "Update file received" : "Download failed");
+    });
+    connect(this, &OtaController::downloadRejected, this, [this]() {
+        logModel_->append(LogModel::Warn, "Controller", "Download rejected");
+    });
+
+    // ---- Card state ----
+    connect(this, &OtaController::updateCheckStarted, this, [this]() {
+        setUiState(UiState::Checking);
+    });
+    connect(this, &OtaController::updateCheckDone, this, [this](CheckUpdateState state) {
+        setUiState(uiStateFor(state));
+    });
+    // A silent re-check only replaces a check result (or the idle card)
+    connect(this, &OtaController::updateCheckRefreshed, this, [this](CheckUpdateState state) {
+        if (uiState_ == UiState::Idle || uiState_ == UiState::UpToDate
+            || uiState_ == UiState::UpdateAvailable || uiState_ == UiState::RequestRefused
+            || uiState_ == UiState::Error)
+            setUiState(uiStateFor(state));
+    });
+    connect(this, &OtaController::progressChanged, this, [this]() {
+        setUiState(UiState::Downloading);
+    });
+    connect(this, &OtaController::downloadFinished, this, [this]() {
+        setUiState(UiState::DownloadFinished);
+    });
+    connect(this, &OtaController::downloadRejected, this, [this]() {
+        setUiState(UiState::RequestRefused);
+    });
+    // RequestRefused is the server's answer (a check result or a rejected
+    // download); everything else that fails gets the error card
+    connect(this, &OtaController::errorOccurred, this, [this](const QString& message) {
+        lastError_ = message;
+        setUiState(UiState::Error);
+    });
+}
+
+OtaController::~OtaController() {
+    {
+        std::lock_guard<std::mutex> lk(workerMutex_);
+        workerStop_ = true;
+        workerTasks_.clear();
+    }
+    workerCv_.notify_all();
+    // Ends a check or manifest fetch the worker may be blocked in
+    backend_->stop();
+    if (worker_.joinable())
+        worker_.join();
+
+    if (g_instance == this)
+        g_instance = nullptr;
 }
 
-OtaController::~OtaController() = default;
+OtaController* OtaController::create(QQmlEngine*, QJSEngine*) {
+    // Owned by main(), not by the engine
+    QJSEngine::setObjectOwnership(g_instance, QJSEngine::CppOwnership);
+    return g_instance;
+}
+
+OtaController::UiState OtaController::uiState() const {
+    return uiState_;
+}
+
+void OtaController::setUiState(UiState state) {
+    if (uiState_ == state)
+        return;
+    uiState_ = state;
+    emit uiStateChanged();
+}
+
+OtaController::UiState OtaController::uiStateFor(CheckUpdateState state) {
+    switch (state) {
+    case Available: return UiState::UpdateAvailable;
+    case UpToDate:  return UiState::UpToDate;
+    default:        return UiState::RequestRefused;
+    }
+}
+
+/*
+ * ==============================================================
+ * Activity profile
+ * ==============================================================
+ * Background: window hidden/minimized or application not shown.
+ * Foreground: visible and either busy or touched within the idle timeout.
+ * Idle:       visible but untouched.
+ */
+bool OtaController::eventFilter(QObject* watched, QEvent* event) {
+    switch (event->type()) {
+    case QEvent::MouseButtonPress:
+    case QEvent::Wheel:
+    case QEvent::KeyPress:
+    case QEvent::TouchBegin: {
+        const bool wasIdle = !idleTimer_.isActive();
+        idleTimer_.start();
+        if (wasIdle)
+            updateActivityProfile();
+        break;
+    }
+    default:
+        break;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void OtaController::setDashboardVisible(bool visible) {
+    if (dashboardVisible_ == visible)
+        return;
+    dashboardVisible_ = visible;
+    updateActivityProfile();
+}
+
+void OtaController::updateActivityProfile() {
+    const Qt::ApplicationState state = QGuiApplication::applicationState();
+    OtaBackend::ActivityProfile profile;
+
+    if (!dashboardVisible_ || state == Qt::ApplicationHidden || state == Qt::ApplicationSuspended)
+        profile = OtaBackend::ActivityProfile::Background;
+    else if (busy_ || idleTimer_.isActive())
+        profile = OtaBackend::ActivityProfile::Foreground;
+    else
+        profile = OtaBackend::ActivityProfile::Idle;
+
+    activityProfile_ = profile;
+    backend_->setActivityProfile(profile);
+    updateRenderMode();
+}
+
+/*
+ * ==============================================================
+ * Low-power rendering
+ * ==============================================================
+ * On while nobody is looking (idle or background profile, and not busy)
+ * or while the thermal governor caps the transfer. The QML pauses the
+ * spinners and drops the card shadows on lowPower, and systemInfoChanged
+ * is only emitted when a shown value changes, so an idle dashboard
+ * renders a frame when its data does and not in between.
+ * OTA_LOW_POWER=on|off forces the mode.
+ */
+void OtaController::updateRenderMode() {
+    bool lowPower = false;
+    switch (renderMode_) {
+    case RenderMode::On:
+        lowPower = true;
+        break;
+    case RenderMode::Off:
+        lowPower = false;
+        break;
+    case RenderMode::Auto:
+        lowPower = thermalLimited()
+                   || (!busy_ && activityProfile_ != OtaBackend::ActivityProfile::Foreground);
+        break;
+    }
+    if (lowPower_ == lowPower)
+        return;
+    lowPower_ = lowPower;
+    // Diagnostics, not activity: kept out of the dashboard's log
+    OTA_LOG_DEBUG("Render", "{}",
+                  lowPower ? (thermalLimited() ? "Low-power rendering (thermal limit)"
+                                               : "Low-power rendering (idle)")
+                           : "Full rendering");
+    emit lowPowerChanged();
+    // Catch up on whatever the low-power mode held back
+    if (!lowPower) {
+        lastSystemInfoKey_ = systemInfoKey();
+        emit systemInfoChanged();
+    }
+}
+
+void OtaController::updateRenderStats() {
+    const auto now = std::chrono::steady_clock::now();
+    const double minutes = std::chrono::duration<double>(now - renderStatsStart_).count() / 60.0;
+    renderStatsStart_ = now;
+    const int frames = framesThisMinute_.exchange(0);
+    framesPerMinute_ = minutes > 0.0 ? static_cast<int>(frames / minutes + 0.5) : frames;
+    idleCpuPercent_ = idleCpuSamples_ > 0 ? idleCpuSum_ / idleCpuSamples_ : -1.0;
+    idleCpuSum_ = 0.0;
+    idleCpuSamples_ = 0;
+
+    if (idleCpuPercent_ >= 0.0)
+        OTA_LOG_DEBUG("Render", "{} frames/min, {}% CPU in low power",
+                      framesPerMinute_, idleCpuPercent_);
+    else
+        OTA_LOG_DEBUG("Render", "{} frames/min", framesPerMinute_);
+    emit renderStatsChanged();
+}
+
+// The values the dashboard shows, as displayed. Our own CPU and the
+// per-core bars move on nearly every sample: they only count in whole
+// percent and 10% steps, or low power would redraw every time.
+QString OtaController::systemInfoKey() const {
+    QStringList key;
+    key << QString::number(cpuPercent()) << memoryText() << storageText()
+        << QString::number(temperatureC(), 'f', 1) << upTimeText()
+        << QString::number(iowaitPercent()) << QString::number(qRound(selfCpuPercent()))
+        << selfRssText() << QString::number(selfThreads())
+        << QString::number(diskWriteMBps(), 'f', 1) << QString::number(diskIops())
+        << QString::number(diskUtilPercent()) << netInterface()
+        << QString::number(netRxMBps(), 'f', 1) << QString::number(netUtilPercent())
+        << bottleneckText() << throttleText() << thermalText() << rateLimitText();
+    for (int i = 0; i < lastSnapshot_.coreCount; ++i)
+        key << QString::number(qRound(lastSnapshot_.coreCpuPercent[i] / 10.0));
+    return key.join('|');
+}
+
+bool OtaController::lowPower() const {
+    return lowPower_;
+}
+
+int OtaController::framesPerMinute() const {
+    return framesPerMinute_;
+}
+
+double OtaController::idleCpuPercent() const {
+    return idleCpuPercent_;
+}
+
+void OtaController::countFrame() {
+    framesThisMinute_.fetch_add(1, std::memory_order_relaxed);
+}
+
+LogModel* OtaController::logModel() const {
+    return logModel_;
+}
+
+QString OtaController::lastError() const {
+    return lastError_;
+}
+
+const MetricsHistory& OtaController::history() const {
+    return backend_->history();
+}
 
 bool OtaController::isBusy() const {
     return busy_.load();
@@ -145,18 +561,23 @@ int OtaController::chunksReceived() const {
 }
 
 uint64_t OtaController::totalSize() const {
-    return backend_ ? backend_->updateSize() : 0;
+    return bundleBytes_ ? bundleBytes_ : updateInfo_.getSize();
 }
 
 void OtaController::setBusy(bool value) {
     busy_ = value;
     emit busyChanged();
+    updateRenderMode();
 }
 
 void OtaController::updateServerConnected() {
     const bool connected = backend_ && backend_->isServerAvailable();
     if (serverConnected_ != connected) {
         serverConnected_ = connected;
+        if (connected) {
+            StartupTrace::instance().mark("connected");
+            emit startupReportChanged();
+        }
         emit serverConnectedChanged(connected);
     }
 }
@@ -220,13 +641,129 @@ QString OtaController::upTimeText() const {
     return formatUptime(upTimeSeconds_.load());
 }
 
+QVariantList OtaController::coreCpuPercent() const {
+    QVariantList cores;
+    for (int i = 0; i < lastSnapshot_.coreCount; ++i)
+        cores.append(lastSnapshot_.coreCpuPercent[i]);
+    return cores;
+}
+
+int OtaController::iowaitPercent() const {
+    return lastSnapshot_.iowaitPercent;
+}
+
+double OtaController::selfCpuPercent() const {
+    return lastSnapshot_.selfCpuPercent;
+}
+
+QString OtaController::selfRssText() const {
+    return QString("%1 MB").arg(lastSnapshot_.selfRssBytes / (1024.0 * 1024.0), 0, 'f', 1);
+}
+
+int OtaController::selfThreads() const {
+    return static_cast<int>(lastSnapshot_.selfThreads);
+}
+
+double OtaController::diskReadMBps() const {
+    return lastSnapshot_.diskReadBps / (1024.0 * 1024.0);
+}
+
+double OtaController::diskWriteMBps() const {
+    return lastSnapshot_.diskWriteBps / (1024.0 * 1024.0);
+}
+
+int OtaController::diskIops() const {
+    return static_cast<int>(lastSnapshot_.diskIops + 0.5);
+}
+
+int OtaController::diskUtilPercent() const {
+    return lastSnapshot_.diskUtilPercent;
+}
+
+QString OtaController::netInterface() const {
+    return QString::fromLatin1(lastSnapshot_.netInterface);
+}
+
+double OtaController::netRxMBps() const {
+    return lastSnapshot_.netRxBps / (1024.0 * 1024.0);
+}
+
+int OtaController::netLinkMbps() const {
+    return lastSnapshot_.netLinkMbps;
+}
+
+int OtaController::netUtilPercent() const {
+    return lastSnapshot_.netUtilPercent;
+}
+
+// Which resource is saturated while a transfer runs, empty if none is
+QString OtaController::bottleneckText() const {
+    static const int kSaturatedPercent = 85;
+
+    if (!busy_) return QString();
+    if (lastSnapshot_.diskUtilPercent >= kSaturatedPercent) return QStringLiteral("Storage");
+    if (lastSnapshot_.netUtilPercent >= kSaturatedPercent) return QStringLiteral("Network");
+    if (lastSnapshot_.cpuPercent >= kSaturatedPercent) return QStringLiteral("CPU");
+    return QString();
+}
+
+bool OtaController::downloadThrottled() const {
+    return lastSnapshot_.throttleCause != 0;
+}
+
+QString OtaController::throttleText() const {
+    const int cause = lastSnapshot_.throttleCause;
+    if (!cause) return QString();
+
+    QStringList causes;
+    if (cause & OtaBackend::ThrottleMemory)
+        causes << QString("memory pressure %1%").arg(lastSnapshot_.memoryPressure, 0, 'f', 1);
+    if (cause & OtaBackend::ThrottleIo)
+        causes << QString("I/O pressure %1%").arg(lastSnapshot_.ioPressure, 0, 'f', 1);
+
+    return QString("Throttled by %1 (window %2/%3)")
+        .arg(causes.join(", "))
+        .arg(lastSnapshot_.downloadWindow)
+        .arg(lastSnapshot_.downloadWindowMax);
+}
+
+bool OtaController::thermalLimited() const {
+    return lastSnapshot_.thermalRateLimitBps != 0;
+}
+
+QString OtaController::thermalText() const {
+    if (!thermalLimited()) return QString();
+    return QString("Thermal limit %1 MB/s, %2 verify workers (trend %3 °C/min)")
+        .arg(lastSnapshot_.thermalRateLimitBps / (1024.0 * 1024.0), 0, 'f', 1)
+        .arg(lastSnapshot_.thermalWorkerLimit)
+        .arg(lastSnapshot_.thermalTrendCPerMin, 0, 'f', 1);
+}
+
+bool OtaController::backgroundTransfer() const {
+    return backend_->transferClass() == OtaBackend::TransferClass::Background;
+}
+
+void OtaController::setBackgroundTransfer(bool background) {
+    if (backgroundTransfer() == background)
+        return;
+    backend_->setTransferClass(background ? OtaBackend::TransferClass::Background
+                                          : OtaBackend::TransferClass::Foreground);
+    emit backgroundTransferChanged();
+}
+
+QString OtaController::rateLimitText() const {
+    if (lastSnapshot_.rateLimitBps == 0) return QString();
+    return QString("Rate limit %1 MB/s")
+        .arg(lastSnapshot_.rateLimitBps / (1024.0 * 1024.0), 0, 'f', 1);
+}
+
 
 /*
  * ==============================================================
  * void runAsync(std::function<void()> task)
  * ==============================================================
  * Controller's threading gatekeeper, ensures UI never blocks.
- * Runs a blocking operation on a detached worker thread.
+ * Runs a blocking operation on the controller's worker thread.
  * Uses 'busy_' state to prevent overlapping operations.
  */
 void OtaController::runAsync(std::function<void()> task) {
@@ -234,9 +771,40 @@ void OtaController::runAsync(std::function<void()> task) {
 
     setBusy(true);
 
-    std::thread([task, this]() {
+    postToWorker(std::move(task));
+}
+
+/*
+ * ==============================================================
+ * void postToWorker(std::function<void()> task)
+ * ==============================================================
+ * Queues a blocking backend call for worker_, started on first use.
+ * Tasks must not touch GUI state; they post their results back with
+ * QMetaObject::invokeMethod(..., Qt::QueuedConnection).
+ */
+void OtaController::postToWorker(std::function<void()> task) {
+    std::lock_guard<std::mutex> lk(workerMutex_);
+    if (workerStop_)
+        return;
+    workerTasks_.push_back(std::move(task));
+    if (!worker_.joinable())
+        worker_ = std::thread([this]() { workerLoop(); });
+    workerCv_.notify_one();
+}
+
+void OtaController::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lk(workerMutex_);
+            workerCv_.wait(lk, [this]() { return workerStop_ || !workerTasks_.empty(); });
+            if (workerStop_)
+                return;
+            task = std::move(workerTasks_.front());
+            workerTasks_.pop_front();
+        }
         task();
-    }).detach();
+    }
 }
 
 /*
@@ -249,31 +817,169 @@ void OtaController::runAsync(std::function<void()> task) {
 
 void OtaController::initialize() {
     runAsync([this]() {
-        // Read current version (fallback to 0 if missing/invalid)
-        uint32_t version = 0;
-        const QString versionPath = UPDATE_VERSION_PATH;
-
-        if (!readUint32FromFile(versionPath, version)) {
-            version = 0;
-            qWarning() << "[OtaController] Failed to read version file:" << versionPath
-                       << "-> using 0";
-        }
-        currentVersion_ = version;
-
         const bool ok = backend_->init();
 
         QMetaObject::invokeMethod(this, [this, ok]() {
             setBusy(false);
             updateServerConnected();
+            initReturned_ = true;
+            publishStartupReport();
 
             if (!ok) {
                 emit errorOccurred("Backend init failed");
+                return;
             }
+
+            // Speculative: the service just became reachable
+            refreshUpdateCheck();
+            if (prefetch_.config().enabled)
+                schedulePrefetchCheck();
+        }, Qt::QueuedConnection);
+    });
+}
+
+QString OtaController::startupReport() const {
+    const std::vector<std::string> lines = StartupTrace::instance().report();
+    QStringList out;
+    for (const std::string& line : lines)
+        out << QString::fromStdString(line);
+    return out.join('\n');
+}
+
+double OtaController::timeToFirstFrameMs() const {
+    const uint64_t ns = StartupTrace::instance().endNs("firstFrame");
+    return ns ? ns / 1e6 : -1.0;
+}
+
+double OtaController::timeToConnectedMs() const {
+    const uint64_t ns = StartupTrace::instance().endNs("connected");
+    return ns ? ns / 1e6 : -1.0;
+}
+
+void OtaController::onFirstFrame() {
+    firstFrameSeen_ = true;
+    emit startupReportChanged();
+    publishStartupReport();
+}
+
+/*
+ * ==============================================================
+ * void publishStartupReport()
+ * ==============================================================
+ * Once both the first frame and backend init are done: the phases go to
+ * the activity log, and with OTA_STARTUP_REPORT set one JSON line is
+ * appended to that file (startup_bench.sh compares runs on it). A server
+ * that shows up later still moves timeToConnectedMs, not the file.
+ */
+void OtaController::publishStartupReport() {
+    if (startupReported_ || !firstFrameSeen_ || !initReturned_)
+        return;
+    startupReported_ = true;
+
+    const StartupTrace& trace = StartupTrace::instance();
+    logModel_->append(LogModel::Info, "Startup",
+                      QString("First frame %1 ms, connected %2 ms")
+                          .arg(timeToFirstFrameMs(), 0, 'f', 1)
+                          .arg(timeToConnectedMs(), 0, 'f', 1));
+    for (const std::string& line : trace.report())
+        OTA_LOG_INFO("Startup", "{}", line);
+
+    const QString path = qEnvironmentVariable("OTA_STARTUP_REPORT");
+    if (path.isEmpty())
+        return;
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        qWarning() << "[OtaController] Cannot write startup report:" << path;
+        return;
+    }
+    // Peak resident memory up to the first frame (all cards are loaded lazily)
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    const QString line =
+        QString("{\"time_to_first_frame_ms\":%1,\"time_to_connected_ms\":%2,\"max_rss_kb\":%3,%4}\n")
+            .arg(timeToFirstFrameMs(), 0, 'f', 3)
+            .arg(timeToConnectedMs(), 0, 'f', 3)
+            .arg(static_cast<qlonglong>(usage.ru_maxrss))
+            .arg(QString::fromStdString(trace.jsonFields()));
+    file.write(line.toUtf8());
+}
+
+/*
+ * ==============================================================
+ * uint32_t readCurrentVersion()
+ * ==============================================================
+ * Re-read before every check: the version file changes when an update
+ * is installed, and cached answers are keyed by it.
+ */
+uint32_t OtaController::readCurrentVersion() {
+    // Fallback to 0 if missing/invalid
+    uint32_t version = 0;
+    const QString versionPath = UPDATE_VERSION_PATH;
+
+    if (!readUint32FromFile(versionPath, version)) {
+        version = 0;
+        qWarning() << "[OtaController] Failed to read version file:" << versionPath
+                   << "-> using 0";
+    }
+    return version;
+}
+
+CheckUpdateState OtaController::classifyUpdateInfo(const ft::FileTransfer::UpdateInfo& info) {
+    if(!(info.getSize() > 0) || (info.getResultCode() != 0)) {
+        return ERROR;
+    }else if(!(info.getIsNew())) {
+        return UpToDate;
+    }
+    return Available;
+}
+
+int OtaController::cachedCheckResult() const {
+    return hasCheckResult_ ? static_cast<int>(updateRequest) : -1;
+}
+
+/*
+ * ==============================================================
+ * void refreshUpdateCheck()
+ * ==============================================================
+ * Asks the service again, bypassing the cache, without the "checking"
+ * card. Runs once the backend is up and whenever the service comes back.
+ * The card only changes if the answer does (updateCheckRefreshed).
+ */
+void OtaController::refreshUpdateCheck() {
+    if (busy_ || prefetchActive_)
+        return;
+
+    prefetchActive_ = true;
+    postToWorker([this]() {
+        const uint32_t version = readCurrentVersion();
+
+        std::lock_guard<std::mutex> lk(backendMutex_);
+        const bool ok = backend_->requestUpdate(version, OtaBackend::CheckPolicy::Refresh);
+        const ft::FileTransfer::UpdateInfo info = backend_->updateInfo_;
+
+        QMetaObject::invokeMethod(this, [this, ok, info]() {
+            prefetchActive_ = false;
+            updateServerConnected();
+            const CheckUpdateState state = classifyUpdateInfo(info);
+            if (!ok || (hasCheckResult_ && state == updateRequest))
+                return;
+
+            updateInfo_ = info;
+            updateRequest = state;
+            hasCheckResult_ = true;
+            emit totalSizeChanged();
+            emit updateCheckRefreshed(state);
         }, Qt::QueuedConnection);
     });
 }
 
 void OtaController::checkForUpdate() {
+    // The background download knows the answer already
+    if (prefetchDownloading_) {
+        emit updateCheckDone(Available);
+        return;
+    }
+
     runAsync([this]() {
 
         QMetaObject::invokeMethod(this, [this]() {
@@ -281,7 +987,10 @@ void OtaController::checkForUpdate() {
             updateServerConnected();
         }, Qt::QueuedConnection);
 
-        if (!backend_->requestUpdate(currentVersion_)) {
+        const uint32_t version = readCurrentVersion();
+
+        std::lock_guard<std::mutex> lk(backendMutex_);
+        if (!backend_->requestUpdate(version, OtaBackend::CheckPolicy::PreferCache)) {
             QMetaObject::invokeMethod(this, [this]() {
                 setBusy(false);
                 updateServerConnected();
@@ -290,15 +999,12 @@ void OtaController::checkForUpdate() {
             return;
         }
 
-        if(!(backend_->updateSize() > 0) || (backend_->updateInfo_.getResultCode() != 0)) {
-            updateRequest = ERROR;
-        }else if(!(backend_->updateInfo_.getIsNew())) {
-            updateRequest = UpToDate;
-        }else {
-            updateRequest = Available;
-        }
+        const ft::FileTransfer::UpdateInfo info = backend_->updateInfo_;
 
-        QMetaObject::invokeMethod(this, [this]() {
+        QMetaObject::invokeMethod(this, [this, info]() {
+            updateInfo_ = info;
+            updateRequest = classifyUpdateInfo(info);
+            hasCheckResult_ = true;
             setBusy(false);
             emit totalSizeChanged();
             emit updateCheckDone(updateRequest);
@@ -307,6 +1013,21 @@ void OtaController::checkForUpdate() {
 }
 
 void OtaController::startDownload() {
+    // Already fetched in the background, or being fetched: no new transfer
+    if (prefetchDownloading_) {
+        promotePrefetch();
+        return;
+    }
+    if (readyVersion_ != 0 && !busy_ && updateInfo_.getNewVersion() == readyVersion_) {
+        logModel_->append(LogModel::Info, "Controller", "Update already downloaded");
+        progress_ = 100;
+        emit progressChanged(100);
+        emit downloadFinished(true);
+        return;
+    }
+    if (!busy_)
+        readyVersion_ = 0;   // the transfer rewrites the image
+
     runAsync([this]() {
 
         // Reset UI-visible transfer stats at the start of a new download
@@ -316,6 +1037,9 @@ void OtaController::startDownload() {
             progress_ = 0;
             speed_ = 0.0;
             downloadStart_ = std::chrono::steady_clock::time_point{};
+            bundleBytes_ = 0;
+            artifacts_.clear();
+            emit artifactsChanged();
 
             totalChunks_ = 0;
             chunksReceived_ = 0;
@@ -325,6 +1049,8 @@ void OtaController::startDownload() {
             emit chunkInfoChanged();
         }, Qt::QueuedConnection);
 
+        std::lock_guard<std::mutex> lk(backendMutex_);
+
                 // Up-to-date guard: no download if server reported size==0
         if (backend_->updateSize() == 0) {
             QMetaObject::invokeMethod(this, [this]() {
@@ -334,11 +1060,15 @@ void OtaController::startDownload() {
             return;
         }
 
-        if (!backend_->startDownload()) {
-            QMetaObject::invokeMethod(this, [this]() {
+        bundleMode_ = false;
+        // A failure other than the server's refusal was reported through
+        // the error callback and has already set the error card
+        const OtaBackend::StartResult result = backend_->startDownload();
+        if (result != OtaBackend::StartResult::Started) {
+            QMetaObject::invokeMethod(this, [this, result]() {
                 setBusy(false);
                 updateServerConnected();
-                emit downloadRejected();
+                if (result == OtaBackend::StartResult::Refused) emit downloadRejected();
             }, Qt::QueuedConnection);
             return;
         }
@@ -365,3 +1095,178 @@ void OtaController::applyUpdate() {
 
     QProcess::startDetached("systemctl", { "reboot" });
 }
+
+/*
+ * ==============================================================
+ * Background prefetch
+ * ==============================================================
+ * Checks for updates on the PrefetchScheduler's timetable without
+ * touching the update cards. When one is available and the device is
+ * idle it is downloaded in the background transfer class; the transfer
+ * is paused while the device is busy. "Download" then either finds the
+ * image ready or takes over the running transfer at full speed.
+ */
+void OtaController::schedulePrefetchCheck() {
+    const double sec = prefetch_.nextCheckDelaySec();
+    prefetchTimer_.start(static_cast<int>(std::min(sec, 24 * 3600.0) * 1000.0));
+    logModel_->append(LogModel::Debug, "Prefetch",
+                      QString("Next update check in %1 min").arg(sec / 60.0, 0, 'f', 1));
+}
+
+void OtaController::runPrefetchCheck() {
+    // The user is at it; try again on the next slot
+    if (busy_ || prefetchActive_) {
+        schedulePrefetchCheck();
+        return;
+    }
+
+    prefetchActive_ = true;
+    postToWorker([this]() {
+        const uint32_t version = readCurrentVersion();
+
+        std::lock_guard<std::mutex> lk(backendMutex_);
+        const bool ok = backend_->requestUpdate(version, OtaBackend::CheckPolicy::PreferCache);
+        const ft::FileTransfer::UpdateInfo info = backend_->updateInfo_;
+        const bool available = ok && info.getSize() > 0 && info.getResultCode() == 0 && info.getIsNew();
+
+        QMetaObject::invokeMethod(this, [this, ok, available, info]() {
+            if (ok)
+                updateInfo_ = info;
+            onPrefetchChecked(ok, available, info.getNewVersion());
+        }, Qt::QueuedConnection);
+    });
+}
+
+void OtaController::onPrefetchChecked(bool ok, bool available, uint32_t version) {
+    prefetchActive_ = false;
+    updateServerConnected();
+
+    if (!ok) {
+        prefetch_.checkFailed();
+        logModel_->append(LogModel::Warn, "Prefetch",
+                          QString("Update check failed (%1 in a row)").arg(prefetch_.failures()));
+    } else {
+        prefetch_.checkSucceeded();
+        pendingVersion_ = (available && version != readyVersion_) ? version : 0;
+        if (pendingVersion_ != 0) {
+            logModel_->append(LogModel::Info, "Prefetch", QString("Update %1 available").arg(version));
+            emit totalSizeChanged();
+            if (prefetch_.isIdle())
+                startPrefetchDownload();
+        }
+    }
+
+    schedulePrefetchCheck();
+    emit prefetchChanged();
+}
+
+void OtaController::startPrefetchDownload() {
+    if (busy_ || prefetchActive_ || pendingVersion_ == 0)
+        return;
+
+    prefetchActive_ = true;
+    prefetchDownloading_ = true;
+    prefetchPaused_ = false;
+    readyVersion_ = 0;
+    progress_ = 0;
+    speed_ = 0.0;
+    downloadStart_ = std::chrono::steady_clock::time_point{};
+    bundleBytes_ = 0;
+    totalChunks_ = 0;
+    chunksReceived_ = 0;
+
+    setBackgroundTransfer(true);
+    logModel_->append(LogModel::Info, "Prefetch",
+                      QString("Downloading update %1 in the background").arg(pendingVersion_));
+
+    // Failures come back through the error callback
+    postToWorker([this]() {
+        std::lock_guard<std::mutex> lk(backendMutex_);
+        bundleMode_ = false;
+        backend_->startDownload();
+    });
+
+    emit prefetchChanged();
+}
+
+void OtaController::finishPrefetch(bool ok, const QString& message) {
+    prefetchActive_ = false;
+    prefetchDownloading_ = false;
+    prefetchPaused_ = false;
+
+    if (ok) {
+        readyVersion_ = pendingVersion_;
+        logModel_->append(LogModel::Info, "Prefetch",
+                          QString("Update %1 downloaded, ready to install").arg(readyVersion_));
+    } else {
+        // Retried after the next (backed off) check
+        prefetch_.checkFailed();
+        logModel_->append(LogModel::Warn, "Prefetch", "Background download failed: " + message);
+        schedulePrefetchCheck();
+    }
+    pendingVersion_ = 0;
+    setBackgroundTransfer(false);
+    emit prefetchChanged();
+}
+
+// "Download" while the prefetch runs: the same transfer, at full speed and on the cards
+void OtaController::promotePrefetch() {
+    prefetchActive_ = false;
+    prefetchDownloading_ = false;
+    prefetchPaused_ = false;
+
+    setBusy(true);
+    backend_->setTransferPaused(false);
+    setBackgroundTransfer(false);
+    logModel_->append(LogModel::Info, "Prefetch", "Background download moved to the foreground");
+
+    emit progressChanged(progress_.load());
+    emit chunkInfoChanged();
+    emit prefetchChanged();
+}
+
+void OtaController::updatePrefetchActivity() {
+    if (!prefetch_.config().enabled)
+        return;
+
+    const OtaBackend::SystemInfoSnapshot& s = lastSnapshot_;
+    const int cores = std::max(1, s.coreCount);
+    PrefetchScheduler::Activity activity;
+    activity.cpuPercent = std::max(0.0, s.cpuPercent - s.selfCpuPercent / cores);
+    activity.loadPerCore = s.loadAverage1 / cores;
+    activity.memoryPressure = s.memoryPressure;
+    activity.ioPressure = s.ioPressure;
+
+    const double nowSec = std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (!prefetch_.update(nowSec, activity))
+        return;
+
+    const bool idle = prefetch_.isIdle();
+    if (prefetchDownloading_) {
+        prefetchPaused_ = !idle;
+        backend_->setTransferPaused(prefetchPaused_);
+    } else if (idle && pendingVersion_ != 0) {
+        startPrefetchDownload();
+    }
+    emit prefetchChanged();
+}
+
+QVariantList OtaController::artifacts() const {
+    return artifacts_;
+}
+
+QString OtaController::prefetchText() const {
+    if (prefetchDownloading_) {
+        return prefetchPaused_
+            ? QString("Background download of update %1 paused while the device is busy (%2%)")
+                  .arg(pendingVersion_).arg(progress_.load())
+            : QString("Downloading update %1 in the background (%2%)")
+                  .arg(pendingVersion_).arg(progress_.load());
+    }
+    if (readyVersion_ != 0)
+        return QString("Update %1 downloaded, ready to install").arg(readyVersion_);
+    if (pendingVersion_ != 0)
+        return QString("Update %1 will download when the device is idle").arg(pendingVersion_);
+    return QString();
+}
@@ -5,6 +5,9 @@
 #include <QObject>
 #include <QString>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <thread>
 #include <QFile>
@@ -13,14 +16,22 @@
 #include <chrono>
 #include <QMetaObject>
 #include <QProcess>
+#include <QVariantList>
+#include <QTimer>
+#include <QEvent>
+#include <QtQml/qqmlregistration.h>
 
 
 
 
 
 #include "OtaBackend.h"
+#include "LogModel.h"
+#include "PrefetchScheduler.h"
 
 class OtaBackend;
+class QQmlEngine;
+class QJSEngine;
 
 enum CheckUpdateState {
     Available,
@@ -33,7 +44,12 @@ enum CheckUpdateState {
 
 class OtaController : public QObject {
     Q_OBJECT
+    // Typed singleton (OtaController in QML), so qmlcachegen can compile the
+    // bindings that read it to C++ instead of looking up a context property
+    QML_ELEMENT
+    QML_SINGLETON
 
+    Q_PROPERTY(UiState uiState READ uiState WRITE setUiState NOTIFY uiStateChanged)
     Q_PROPERTY(int progress READ progress NOTIFY progressChanged)
     Q_PROPERTY(bool busy READ isBusy NOTIFY busyChanged)
     Q_PROPERTY(bool serverConnected READ serverConnected NOTIFY serverConnectedChanged)
@@ -46,12 +62,61 @@ class OtaController : public QObject {
     Q_PROPERTY(QString storageText READ storageText NOTIFY systemInfoChanged)
     Q_PROPERTY(double temperatureC READ temperatureC NOTIFY systemInfoChanged)
     Q_PROPERTY(QString upTimeText READ upTimeText NOTIFY systemInfoChanged)
+    Q_PROPERTY(QVariantList coreCpuPercent READ coreCpuPercent NOTIFY systemInfoChanged)
+    Q_PROPERTY(int iowaitPercent READ iowaitPercent NOTIFY systemInfoChanged)
+    Q_PROPERTY(double selfCpuPercent READ selfCpuPercent NOTIFY systemInfoChanged)
+    Q_PROPERTY(QString selfRssText READ selfRssText NOTIFY systemInfoChanged)
+    Q_PROPERTY(int selfThreads READ selfThreads NOTIFY systemInfoChanged)
+    Q_PROPERTY(double diskReadMBps READ diskReadMBps NOTIFY systemInfoChanged)
+    Q_PROPERTY(double diskWriteMBps READ diskWriteMBps NOTIFY systemInfoChanged)
+    Q_PROPERTY(int diskIops READ diskIops NOTIFY systemInfoChanged)
+    Q_PROPERTY(int diskUtilPercent READ diskUtilPercent NOTIFY systemInfoChanged)
+    Q_PROPERTY(QString netInterface READ netInterface NOTIFY systemInfoChanged)
+    Q_PROPERTY(double netRxMBps READ netRxMBps NOTIFY systemInfoChanged)
+    Q_PROPERTY(int netLinkMbps READ netLinkMbps NOTIFY systemInfoChanged)
+    Q_PROPERTY(int netUtilPercent READ netUtilPercent NOTIFY systemInfoChanged)
+    Q_PROPERTY(QString bottleneckText READ bottleneckText NOTIFY systemInfoChanged)
+    Q_PROPERTY(bool downloadThrottled READ downloadThrottled NOTIFY systemInfoChanged)
+    Q_PROPERTY(QString throttleText READ throttleText NOTIFY systemInfoChanged)
+    Q_PROPERTY(bool thermalLimited READ thermalLimited NOTIFY systemInfoChanged)
+    Q_PROPERTY(QString thermalText READ thermalText NOTIFY systemInfoChanged)
+    Q_PROPERTY(bool backgroundTransfer READ backgroundTransfer WRITE setBackgroundTransfer NOTIFY backgroundTransferChanged)
+    Q_PROPERTY(QString rateLimitText READ rateLimitText NOTIFY systemInfoChanged)
+    Q_PROPERTY(QString prefetchText READ prefetchText NOTIFY prefetchChanged)
+    Q_PROPERTY(QVariantList artifacts READ artifacts NOTIFY artifactsChanged)
+    Q_PROPERTY(LogModel* logModel READ logModel CONSTANT)
+    Q_PROPERTY(QString lastError READ lastError NOTIFY errorOccurred)
+    Q_PROPERTY(bool lowPower READ lowPower NOTIFY lowPowerChanged)
+    Q_PROPERTY(int framesPerMinute READ framesPerMinute NOTIFY renderStatsChanged)
+    Q_PROPERTY(double idleCpuPercent READ idleCpuPercent NOTIFY renderStatsChanged)
+    Q_PROPERTY(QString startupReport READ startupReport NOTIFY startupReportChanged)
+    Q_PROPERTY(double timeToFirstFrameMs READ timeToFirstFrameMs NOTIFY startupReportChanged)
+    Q_PROPERTY(double timeToConnectedMs READ timeToConnectedMs NOTIFY startupReportChanged)
 
 
    public:
+    // Card shown in the update area, one per cards/Card*.qml
+    enum class UiState {
+        Idle,
+        Checking,
+        UpToDate,
+        UpdateAvailable,
+        RequestRefused,
+        Downloading,
+        DownloadFinished,
+        Error           // transfer, connection or backend failure (lastError)
+    };
+    Q_ENUM(UiState)
+
     explicit OtaController(QObject* parent = nullptr);
     ~OtaController();
 
+    // The QML singleton is the controller main() made (the first one)
+    static OtaController* create(QQmlEngine* qmlEngine, QJSEngine* jsEngine);
+
+    UiState uiState() const;
+    void setUiState(UiState state);
+
     int progress() const;
     bool isBusy() const;
     bool isServerAvailable() const;
@@ -67,6 +132,52 @@ class OtaController : public QObject {
     QString storageText() const;
     double temperatureC() const;
     QString upTimeText() const;
+    QVariantList coreCpuPercent() const;
+    int iowaitPercent() const;
+    double selfCpuPercent() const;
+    QString selfRssText() const;
+    int selfThreads() const;
+    // throughput next to the transfer speed
+    double diskReadMBps() const;
+    double diskWriteMBps() const;
+    int diskIops() const;
+    int diskUtilPercent() const;
+    QString netInterface() const;
+    double netRxMBps() const;
+    int netLinkMbps() const;
+    int netUtilPercent() const;
+    QString bottleneckText() const;
+    bool downloadThrottled() const;
+    QString throttleText() const;
+    bool thermalLimited() const;
+    QString thermalText() const;
+    // transfer class (switchable during a download)
+    bool backgroundTransfer() const;
+    void setBackgroundTransfer(bool background);
+    QString rateLimitText() const;
+    // opportunistic background prefetch
+    QString prefetchText() const;
+    // artifacts of a bundle download (empty for a single image)
+    QVariantList artifacts() const;
+    // activity log
+    LogModel* logModel() const;
+    QString lastError() const;
+    // metrics history of the backend (read by Sparkline items)
+    const MetricsHistory& history() const;
+    // low-power rendering: non-essential animations and effects paused
+    bool lowPower() const;
+    // frames presented in the last minute, CPU use of the client in low power
+    // over that minute (-1 if it was not in low power)
+    int framesPerMinute() const;
+    double idleCpuPercent() const;
+    // A frame was presented (render thread)
+    void countFrame();
+    // startup phases (StartupTrace), from the process start; -1 until seen
+    QString startupReport() const;
+    double timeToFirstFrameMs() const;
+    double timeToConnectedMs() const;
+    // The root window presented its first frame (GUI thread)
+    void onFirstFrame();
 
 
 
@@ -74,10 +185,20 @@ class OtaController : public QObject {
     Q_INVOKABLE void checkForUpdate();
     Q_INVOKABLE void startDownload();
     Q_INVOKABLE void applyUpdate();
+    Q_INVOKABLE void setDashboardVisible(bool visible);
+    // Result of the last check (CheckUpdateState) if one is known, from the
+    // disk cache at startup; -1 otherwise
+    Q_INVOKABLE int cachedCheckResult() const;
+
+   protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
 
    signals:
+    void uiStateChanged();
     void progressChanged(int percent);
     void updateCheckDone(CheckUpdateState);
+    // A silent re-check changed the answer
+    void updateCheckRefreshed(CheckUpdateState);
     void downloadRejected();
     void busyChanged();
     void updateAvailable(bool available);
@@ -89,19 +210,47 @@ class OtaController : public QObject {
     void speedChanged(double speed);
     void chunkInfoChanged();
     void systemInfoChanged();
+    void backgroundTransferChanged();
+    void prefetchChanged();
+    void artifactsChanged();
+    void startupReportChanged();
+    void lowPowerChanged();
+    void renderStatsChanged();
 
 
    private:
     //void setProgress(int value);
     void setBusy(bool value);
     void runAsync(std::function<void()> task);
+    void postToWorker(std::function<void()> task);
+    void workerLoop();
+    void updateActivityProfile();
+    static uint32_t readCurrentVersion();
+    static CheckUpdateState classifyUpdateInfo(const ft::FileTransfer::UpdateInfo& info);
+    static UiState uiStateFor(CheckUpdateState state);
+    void refreshUpdateCheck();
+    void schedulePrefetchCheck();
+    void runPrefetchCheck();
+    void onPrefetchChecked(bool ok, bool available, uint32_t version);
+    void startPrefetchDownload();
+    void finishPrefetch(bool ok, const QString& message);
+    void promotePrefetch();
+    void updatePrefetchActivity();
+    void publishStartupReport();
+    void updateRenderMode();
+    void updateRenderStats();
+    QString systemInfoKey() const;
 
    private:
-    uint32_t currentVersion_{0};
-
     std::unique_ptr<OtaBackend> backend_;
 
-    std::thread backendThread_;
+    // Blocking backend calls run in order on worker_, which the destructor
+    // joins; results reach the GUI thread through queued invocations
+    std::thread worker_;
+    std::mutex workerMutex_;
+    std::condition_variable workerCv_;
+    std::deque<std::function<void()>> workerTasks_;
+    bool workerStop_{false};
     std::mutex backendMutex_;
 
     std::atomic<bool> busy_{false};
@@ -118,13 +267,59 @@ class OtaController : public QObject {
     std::atomic<uint64_t> stTotal_{0};
     std::atomic<double> temperatureC_{0.0};
     std::atomic<uint64_t> upTimeSeconds_{0};
+    // Latest snapshot (GUI thread only), source of the per-core / per-process values
+    OtaBackend::SystemInfoSnapshot lastSnapshot_;
 
 
+    // Last check answer (GUI thread), copied from the backend under backendMutex_
+    ft::FileTransfer::UpdateInfo updateInfo_;
+    uint64_t bundleBytes_{0};                   // bundle download in progress
     CheckUpdateState updateRequest;
+    bool hasCheckResult_{false};
+    UiState uiState_{UiState::Idle};
+    QString lastError_;
 
 
     std::chrono::steady_clock::time_point downloadStart_;
 
+    LogModel* logModel_;
+
+    // Activity profile (sampling rates)
+    QTimer idleTimer_;
+    bool dashboardVisible_{true};
+    OtaBackend::ActivityProfile activityProfile_{OtaBackend::ActivityProfile::Foreground};
+
+    // Low-power rendering (GUI thread, except the frame counter)
+    enum class RenderMode { Auto, On, Off };
+    RenderMode renderMode_{RenderMode::Auto};
+    bool lowPower_{false};
+    QString lastSystemInfoKey_;                 // shown values at the last systemInfoChanged
+    std::atomic<int> framesThisMinute_{0};
+    QTimer renderStatsTimer_;
+    std::chrono::steady_clock::time_point renderStatsStart_;
+    int framesPerMinute_{0};
+    double idleCpuSum_{0.0};
+    int idleCpuSamples_{0};
+    double idleCpuPercent_{-1.0};
+
+    // Background prefetch (GUI thread, except the flag)
+    PrefetchScheduler prefetch_;
+    QTimer prefetchTimer_;
+    std::atomic<bool> prefetchActive_{false};   // silent check or download in flight
+    bool prefetchDownloading_{false};
+    bool prefetchPaused_{false};
+    uint32_t pendingVersion_{0};                // available, not fetched yet
+    uint32_t readyVersion_{0};                  // downloaded and verified
+
+    // Bundle download
+    std::atomic<bool> bundleMode_{false};
+    QVariantList artifacts_;
+
+    // Startup report, once the first frame is up and init has returned
+    bool firstFrameSeen_{false};
+    bool initReturned_{false};
+    bool startupReported_{false};
+
 };
 
 #endif // OTACONTROLLER_H
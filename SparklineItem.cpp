@@ -0,0 +1,253 @@
+// SparklineItem.cpp
+
+#include "SparklineItem.h"
+
+#include <QElapsedTimer>
+#include <QMatrix4x4>
+#include <QSGFlatColorMaterial>
+#include <QSGGeometryNode>
+#include <QSGTransformNode>
+#include <QtGlobal>
+
+#include <algorithm>
+
+#include "OtaController.h"
+
+// x is stored in sample units; past this the geometry is rebuilt so the
+// float coordinates stay exact.
+static const quint64 kRebaseAfter = 1u << 22;
+
+// OTA_FRAME_STATS=1 logs the average scene graph update cost
+static const bool kFrameStats = qEnvironmentVariableIntValue("OTA_FRAME_STATS") != 0;
+
+SparklineItem::SparklineItem(QQuickItem* parent)
+    : QQuickItem(parent) {
+    setFlag(ItemHasContents, true);
+}
+
+QObject* SparklineItem::source() const {
+    return controller_.data();
+}
+
+void SparklineItem::setSource(QObject* source) {
+    OtaController* controller = qobject_cast<OtaController*>(source);
+    if (controller == controller_) return;
+
+    if (controller_) disconnect(controller_, nullptr, this, nullptr);
+    controller_ = controller;
+    if (controller_) {
+        connect(controller_, &OtaController::systemInfoChanged, this, &SparklineItem::pullHistory);
+    }
+
+    emit sourceChanged();
+    restart();
+}
+
+SparklineItem::Metric SparklineItem::metric() const {
+    return metric_;
+}
+
+void SparklineItem::setMetric(Metric metric) {
+    if (metric == metric_) return;
+    metric_ = metric;
+    emit metricChanged();
+    restart();
+}
+
+int SparklineItem::samples() const {
+    return samples_;
+}
+
+void SparklineItem::setSamples(int samples) {
+    samples = qBound(2, samples, int(MetricsHistory::kRawCapacity));
+    if (samples == samples_) return;
+    samples_ = samples;
+    emit samplesChanged();
+    restart();
+}
+
+double SparklineItem::minimum() const {
+    return minimum_;
+}
+
+void SparklineItem::setMinimum(double value) {
+    if (qFuzzyCompare(value, minimum_)) return;
+    minimum_ = value;
+    emit rangeChanged();
+    restart();
+}
+
+double SparklineItem::maximum() const {
+    return maximum_;
+}
+
+void SparklineItem::setMaximum(double value) {
+    if (qFuzzyCompare(value, maximum_)) return;
+    maximum_ = value;
+    emit rangeChanged();
+    restart();
+}
+
+QColor SparklineItem::color() const {
+    return color_;
+}
+
+void SparklineItem::setColor(const QColor& color) {
+    if (color == color_) return;
+    color_ = color;
+    colorDirty_ = true;
+    emit colorChanged();
+    update();
+}
+
+// Resizing only changes the transform
+void SparklineItem::geometryChange(const QRectF& newGeometry, const QRectF& oldGeometry) {
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) update();
+}
+
+// Rebuilds the line from the last `samples` entries of the history
+void SparklineItem::restart() {
+    pending_.clear();
+    lastSequence_ = 0;
+    resetGeometry_ = true;
+    pullHistory();
+    update();
+}
+
+/*
+ * Runs on the GUI thread after every published snapshot (the backend
+ * records the history before notifying). Copies only the samples that
+ * arrived since the last call, at most `samples` of them.
+ */
+void SparklineItem::pullHistory() {
+    if (!controller_) return;
+
+    const MetricsHistory& history = controller_->history();
+    {
+        auto lock = history.lock();
+        const quint64 sequence = history.sequence(MetricsHistory::Raw);
+        if (sequence == lastSequence_) return;
+
+        const MetricsHistory::Series series =
+            history.series(MetricsHistory::Raw, static_cast<MetricsHistory::Metric>(metric_));
+        const size_t fresh = std::min<size_t>({ static_cast<size_t>(sequence - lastSequence_),
+                                                series.size(),
+                                                static_cast<size_t>(samples_) + 1 });
+
+        for (size_t i = series.size() - fresh; i < series.size(); ++i) {
+            pending_.append(series.meanAt(i));
+        }
+        lastSequence_ = sequence;
+    }
+
+    // Only the newest samples_ + 1 points can still be visible
+    if (pending_.size() > samples_ + 1) {
+        pending_.remove(0, pending_.size() - (samples_ + 1));
+    }
+    update();
+}
+
+/*
+ * ==============================================================
+ * QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData*)
+ * ==============================================================
+ * Render thread, GUI thread blocked. Writes one segment (two vertices)
+ * per pending sample into the ring slot it owns, then moves the transform
+ * so the newest sample sits at the right edge.
+ */
+QSGNode* SparklineItem::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData*) {
+    QElapsedTimer timer;
+    if (kFrameStats) timer.start();
+
+    auto* root = static_cast<QSGTransformNode*>(oldNode);
+    QSGGeometryNode* line = nullptr;
+
+    if (!root) {
+        root = new QSGTransformNode;
+        line = new QSGGeometryNode;
+
+        auto* geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), 0);
+        geometry->setDrawingMode(QSGGeometry::DrawLines);
+        geometry->setLineWidth(2.0f);
+        line->setGeometry(geometry);
+        line->setFlag(QSGNode::OwnsGeometry);
+
+        line->setMaterial(new QSGFlatColorMaterial);
+        line->setFlag(QSGNode::OwnsMaterial);
+
+        root->appendChildNode(line);
+        resetGeometry_ = true;
+        colorDirty_ = true;
+    } else {
+        line = static_cast<QSGGeometryNode*>(root->firstChild());
+    }
+
+    QSGGeometry* geometry = line->geometry();
+
+    if (pushed_ >= kRebaseAfter) {
+        // Refilled from the history on the next GUI pass
+        pending_.clear();
+        lastSequence_ = 0;
+        resetGeometry_ = true;
+        QMetaObject::invokeMethod(this, &SparklineItem::pullHistory, Qt::QueuedConnection);
+    }
+
+    if (resetGeometry_) {
+        geometry->allocate(2 * samples_);
+        // Unused slots are zero-length segments, which rasterize nothing
+        QSGGeometry::Point2D* v = geometry->vertexDataAsPoint2D();
+        for (int i = 0; i < geometry->vertexCount(); ++i) v[i].set(-1.0f, 0.0f);
+        pushed_ = 0;
+        hasLast_ = false;
+        resetGeometry_ = false;
+    }
+
+    if (!pending_.isEmpty()) {
+        QSGGeometry::Point2D* v = geometry->vertexDataAsPoint2D();
+        const float lo = static_cast<float>(std::min(minimum_, maximum_));
+        const float hi = static_cast<float>(std::max(minimum_, maximum_));
+
+        for (float value : std::as_const(pending_)) {
+            value = qBound(lo, value, hi);
+            if (hasLast_) {
+                const int slot = static_cast<int>(pushed_ % static_cast<quint64>(samples_));
+                v[2 * slot].set(static_cast<float>(pushed_ - 1), lastValue_);
+                v[2 * slot + 1].set(static_cast<float>(pushed_), value);
+            }
+            lastValue_ = value;
+            hasLast_ = true;
+            ++pushed_;
+        }
+        pending_.clear();
+        line->markDirty(QSGNode::DirtyGeometry);
+    }
+
+    if (colorDirty_) {
+        static_cast<QSGFlatColorMaterial*>(line->material())->setColor(color_);
+        line->markDirty(QSGNode::DirtyMaterial);
+        colorDirty_ = false;
+    }
+
+    // Sample units -> item: newest point at the right edge, minimum at the bottom
+    const double span = (maximum_ != minimum_) ? (maximum_ - minimum_) : 1.0;
+    const double newest = pushed_ > 0 ? static_cast<double>(pushed_ - 1) : 0.0;
+    QMatrix4x4 m;
+    m.translate(0.0f, static_cast<float>(height()));
+    m.scale(static_cast<float>(width() / samples_), static_cast<float>(-height() / span));
+    m.translate(static_cast<float>(samples_ - newest), static_cast<float>(-minimum_));
+    root->setMatrix(m);
+
+    if (kFrameStats) {
+        static qint64 totalNs = 0;
+        static int updates = 0;
+        totalNs += timer.nsecsElapsed();
+        if (++updates == 600) {
+            qInfo("[Sparkline] updatePaintNode avg %.1f us over %d updates", totalNs / 1000.0 / updates, updates);
+            totalNs = 0;
+            updates = 0;
+        }
+    }
+
+    return root;
+}
@@ -0,0 +1,92 @@
+#ifndef SPARKLINEITEM_H
+#define SPARKLINEITEM_H
+
+#include <QColor>
+#include <QPointer>
+#include <QQuickItem>
+#include <QVector>
+#include <QtQml/qqmlregistration.h>
+
+class OtaController;
+
+/*
+ * Sparkline of one metric from the backend's MetricsHistory, drawn by the
+ * scene graph (one QSGGeometryNode, no Canvas).
+ *
+ * The geometry holds a fixed ring of `samples` line segments in sample
+ * units; a transform node maps them to the item, so scrolling and scaling
+ * are a matrix change. Each new sample rewrites one segment, and the
+ * vertex count never depends on how long the history is.
+ */
+class SparklineItem : public QQuickItem {
+    Q_OBJECT
+    QML_NAMED_ELEMENT(Sparkline)
+
+    // OtaController providing the history (set to the OtaController singleton)
+    Q_PROPERTY(QObject* source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(Metric metric READ metric WRITE setMetric NOTIFY metricChanged)
+    Q_PROPERTY(int samples READ samples WRITE setSamples NOTIFY samplesChanged)
+    Q_PROPERTY(double minimum READ minimum WRITE setMinimum NOTIFY rangeChanged)
+    Q_PROPERTY(double maximum READ maximum WRITE setMaximum NOTIFY rangeChanged)
+    Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
+
+   public:
+    // Matches MetricsHistory::Metric
+    enum Metric {
+        Cpu = 0,
+        Iowait,
+        Memory,
+        Temperature,
+        SelfCpu,
+        SelfRss
+    };
+    Q_ENUM(Metric)
+
+    explicit SparklineItem(QQuickItem* parent = nullptr);
+
+    QObject* source() const;
+    void setSource(QObject* source);
+    Metric metric() const;
+    void setMetric(Metric metric);
+    int samples() const;
+    void setSamples(int samples);
+    double minimum() const;
+    void setMinimum(double value);
+    double maximum() const;
+    void setMaximum(double value);
+    QColor color() const;
+    void setColor(const QColor& color);
+
+   signals:
+    void sourceChanged();
+    void metricChanged();
+    void samplesChanged();
+    void rangeChanged();
+    void colorChanged();
+
+   protected:
+    QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData*) override;
+    void geometryChange(const QRectF& newGeometry, const QRectF& oldGeometry) override;
+
+   private:
+    void pullHistory();
+    void restart();
+
+    QPointer<OtaController> controller_;
+    Metric metric_ = Cpu;
+    int samples_ = 120;
+    double minimum_ = 0.0;
+    double maximum_ = 100.0;
+    QColor color_ = QColor("#2563eb");
+
+    // Samples read from the history but not yet in the geometry (GUI thread)
+    QVector<float> pending_;
+    quint64 lastSequence_ = 0;
+    quint64 pushed_ = 0;           // samples written to the geometry so far
+    bool hasLast_ = false;
+    float lastValue_ = 0.0f;
+    bool resetGeometry_ = true;
+    bool colorDirty_ = true;
+};
+
+#endif  // SPARKLINEITEM_H
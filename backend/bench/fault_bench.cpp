@@ -0,0 +1,109 @@
+/*
+ * ==============================================================
+ * fault_bench
+ * ==============================================================
+ * One download of the offered image under the fault schedule of the
+ * environment (OTA_FAULTS on this side, OTA_GW_FAULTS on the gateway)
+ * and one result line:
+ * - result: ok (CRC verified), error (the backend reported a failure)
+ *   or stuck (neither within the timeout)
+ * - goodput: image size over the time to the verified file
+ * - gap: longest time without a new chunk on disk, i.e. how long the
+ *   worst fault held the download up
+ * - the faults injected here and the repair counters
+ * Exit status 0 for ok, 1 for error, 3 for stuck. fault_suite.sh runs
+ * it per fault class and compares against a clean run.
+ *
+ * Usage: fault_bench [label] [timeout s]
+ */
+
+#include "OtaBackend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const std::string label = argc > 1 ? argv[1] : "-";
+    const long timeoutSec = argc > 2 ? std::atol(argv[2]) : 120;
+
+    OtaConfig config = OtaConfig::fromEnv();
+    config.manifestName.clear();
+    config.rangeStreams = 1;
+
+    OtaBackend backend("rpi4-update.wic", config);
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false, ok = false;
+    Clock::time_point lastChunk;
+    double maxGapMs = 0.0;
+
+    backend.setChunkCallback([&](uint32_t, uint32_t) {
+        const Clock::time_point now = Clock::now();
+        std::lock_guard<std::mutex> lk(mutex);
+        maxGapMs = std::max(maxGapMs, std::chrono::duration<double, std::milli>(now - lastChunk).count());
+        lastChunk = now;
+    });
+    backend.setFinishedCallback([&]() {
+        std::lock_guard<std::mutex> lk(mutex);
+        done = ok = true;
+        cv.notify_all();
+    });
+    backend.setErrorCallback([&](const std::string& msg) {
+        std::fprintf(stderr, "error: %s\n", msg.c_str());
+        std::lock_guard<std::mutex> lk(mutex);
+        done = true;
+        cv.notify_all();
+    });
+
+    if (!backend.init() || !backend.requestUpdate(0) || backend.updateSize() == 0) {
+        std::fprintf(stderr, "no service or no image offered\n");
+        return 1;
+    }
+    const double mib = static_cast<double>(backend.updateSize()) / (1024.0 * 1024.0);
+
+    const Clock::time_point start = Clock::now();
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        lastChunk = start;
+    }
+    const bool started = backend.startDownload() == OtaBackend::StartResult::Started;
+
+    bool finished = false;
+    double gapMs = 0.0;
+    {
+        std::unique_lock<std::mutex> lk(mutex);
+        finished = started && cv.wait_for(lk, std::chrono::seconds(timeoutSec), [&]() { return done; });
+        gapMs = maxGapMs;
+    }
+    const double sec = std::chrono::duration<double>(Clock::now() - start).count();
+    const char* result = !started || (finished && !ok) ? "error" : finished ? "ok" : "stuck";
+
+    const FaultInjector::Stats faults = backend.faultStats();
+    const OtaBackend::RepairStats repair = backend.repairStats();
+    std::printf("%-16s %-4s %-6s %8.2f s %8.1f MiB/s  gap %8.1f ms  faults %llu (drop %llu dup %llu reorder %llu "
+                "stall %llu)  nacks %llu repaired %llu\n",
+                label.c_str(), backend.isUnreliableTransport() ? "udp" : "tcp", result, sec,
+                ok ? mib / sec : 0.0, gapMs,
+                static_cast<unsigned long long>(faults.faults()),
+                static_cast<unsigned long long>(faults.dropped),
+                static_cast<unsigned long long>(faults.duplicated),
+                static_cast<unsigned long long>(faults.reordered),
+                static_cast<unsigned long long>(faults.stalls),
+                static_cast<unsigned long long>(repair.nacks),
+                static_cast<unsigned long long>(repair.repairedChunks));
+    std::fflush(stdout);
+
+    backend.stop();
+    return ok ? 0 : (finished || !started) ? 1 : 3;
+}
@@ -0,0 +1,116 @@
+#!/bin/sh
+#
+# Recovery of the client from each fault class, over TCP and UDP: starts
+# the reference gateway per scenario, runs fault_bench against it and
+# checks the outcome. Client side faults go through OTA_FAULTS, a
+# restart through the gateway's OTA_GW_FAULTS. Every run uses the same
+# seed, so a failure repeats.
+#
+#   expect ok     the download must verify
+#   expect safe   the client need not recover, but must not finish with
+#                 a wrong file
+#
+# Every scenario expects ok: on both transports the single image goes
+# through the chunk bitmap and NACK repair.
+#
+# The nack-* scenarios cross chunks over a repair request: held back
+# (reorder) or stalled past the repair idle time, chunks of one stream
+# arrive after the client has asked for the next range on the instance.
+#
+# Any verified file is also compared byte for byte with the served image.
+# Per scenario it prints the fault_bench line, then the extra time and the
+# longest stall over the clean run of the same transport (the time to
+# recover). Exits 1 if a scenario fails its expectation.
+#
+# Usage: fault_suite.sh [gateway binary] [bench binary] [timeout s] [seed]
+
+set -u
+
+GATEWAY=${1:-./ota_gateway}
+BENCH=${2:-./fault_bench}
+TIMEOUT=${3:-30}
+SEED=${4:-1}
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+IMAGE_DIR=${OTA_GW_DIR:-$ROOT/data/server/}
+IMAGE=${OTA_GW_IMAGE:-rpi4-update.wic}
+WORK=$(mktemp -d)
+FAILED=0
+
+# label transport client-faults gateway-faults expect
+SCENARIOS="clean tcp - - ok
+dup tcp dup=0.01 - ok
+stall tcp stall=0.002,stall_ms=500 - ok
+reorder tcp reorder=0.01,depth=4 - ok
+drop tcp drop=0.002 - ok
+restart tcp - restart=1,after=100,limit=1,restart_ms=2000 ok
+clean udp - - ok
+dup udp dup=0.01 - ok
+stall udp stall=0.002,stall_ms=500 - ok
+reorder udp reorder=0.01,depth=4 - ok
+drop udp drop=0.01 - ok
+restart udp - restart=1,after=100,limit=1,restart_ms=2000 ok
+nack-reorder udp drop=0.01,reorder=0.05,depth=16 - ok
+nack-stall udp drop=0.01,stall=0.005,stall_ms=400 - ok"
+
+cleanup() {
+    rm -rf "$WORK"
+    [ -n "${GATEWAY_PID:-}" ] && kill "$GATEWAY_PID" 2>/dev/null
+}
+trap cleanup EXIT INT TERM
+
+[ -f "$IMAGE_DIR/$IMAGE" ] || { echo "no image $IMAGE_DIR/$IMAGE" >&2; exit 2; }
+
+config() {
+    [ "$1" = udp ] && echo "$ROOT/vsomeip-udp.json" || echo "$ROOT/vsomeip.json"
+}
+
+# field <n> <line>: the n-th word of a fault_bench line
+field() {
+    echo "$2" | awk -v n="$1" '{ print $n }'
+}
+
+while read -r label transport client server expect; do
+    [ "$client" = - ] && client= || client="seed=$SEED,$client"
+    [ "$server" = - ] && server= || server="seed=$SEED,$server"
+    cfg=$(config "$transport")
+
+    VSOMEIP_CONFIGURATION=$cfg VSOMEIP_APPLICATION_NAME=service-sample OTA_LOG_LEVEL=warn \
+        OTA_GW_DIR=$IMAGE_DIR OTA_GW_IMAGE=$IMAGE OTA_GW_FAULTS=$server \
+        "$GATEWAY" >/dev/null 2>&1 &
+    GATEWAY_PID=$!
+    sleep 2
+
+    rm -f "$WORK/$IMAGE"
+    line=$(VSOMEIP_CONFIGURATION=$cfg OTA_TRANSPORT=$transport OTA_FAULTS=$client \
+        OTA_DATA_DIR=$WORK OTA_LOG_LEVEL=error "$BENCH" "$label" "$TIMEOUT" 2>/dev/null </dev/null)
+    status=$?
+
+    kill "$GATEWAY_PID" 2>/dev/null
+    wait "$GATEWAY_PID" 2>/dev/null
+    GATEWAY_PID=
+
+    verdict=pass
+    if [ "$status" -eq 0 ] && ! cmp -s "$WORK/$IMAGE" "$IMAGE_DIR/$IMAGE"; then
+        verdict="FAIL (verified file differs from the image)"
+    elif [ "$expect" = ok ] && [ "$status" -ne 0 ]; then
+        verdict="FAIL (expected to recover)"
+    fi
+    [ "$verdict" = pass ] || FAILED=1
+
+    sec=$(field 4 "$line")
+    gap=$(field 9 "$line")
+    if [ "$label" = clean ]; then
+        baseSec=$sec
+        baseGap=$gap
+    fi
+    echo "$line"
+    if [ "$status" -eq 0 ] && [ -n "${baseSec:-}" ]; then
+        awk -v s="$sec" -v bs="$baseSec" -v g="$gap" -v bg="$baseGap" -v v="$verdict" \
+            'BEGIN { printf "    +%.2f s over clean, recover %.1f ms, %s\n", s - bs, g - bg, v }'
+    else
+        echo "    $verdict"
+    fi
+done <<EOF
+$SCENARIOS
+EOF
+exit $FAILED
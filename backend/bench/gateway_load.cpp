@@ -0,0 +1,200 @@
+/*
+ * ==============================================================
+ * gateway_load
+ * ==============================================================
+ * Load test of the gateway scheduler and chunk cache, in process: N
+ * simulated clients (1 to 200) want a download of the same image at
+ * once. They ask through GatewayStub, as ota_gateway's instances are
+ * asked, spread over the lanes (default 4, one per instance): a client
+ * refused on a busy lane asks again once it frees up. The sink copies
+ * every chunk once, as the SOME/IP serialization would, and records when
+ * each client got its first and last chunk, so both times include the
+ * wait for the lane. Per client count it prints the aggregate
+ * throughput, time to first chunk and completion time percentiles, the
+ * busy refusals and the cache hit rate. The network is not part of it:
+ * this is the gateway's own capacity, see transport_bench and swarm_load
+ * for end-to-end numbers.
+ * OTA_GW_WORKERS, OTA_GW_QUANTUM, OTA_GW_CACHE_MB and OTA_FEC apply.
+ *
+ * Usage: gateway_load [image MiB] [max clients] [lanes]
+ */
+
+#include "GatewayCore.h"
+#include "GatewayStub.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Client {
+    Clock::time_point first;
+    Clock::time_point done;
+    bool started = false;
+    std::vector<uint8_t> scratch;
+};
+
+double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    const size_t i = std::min(v.size() - 1, static_cast<size_t>(p * static_cast<double>(v.size())));
+    return v[i];
+}
+
+bool writeImage(const std::string& path, size_t mib) {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    std::mt19937 rng(1);
+    std::vector<uint32_t> block(256 * 1024);
+    for (size_t i = 0; i < mib; ++i) {
+        for (uint32_t& w : block) w = rng();
+        if (std::fwrite(block.data(), sizeof(uint32_t), block.size(), f) != block.size()) {
+            std::fclose(f);
+            return false;
+        }
+    }
+    return std::fclose(f) == 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const size_t mib = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32;
+    const size_t maxClients = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200;
+    const size_t lanes = std::max<size_t>(1, argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 4);
+
+    char dir[] = "/tmp/gateway_load.XXXXXX";
+    if (!mkdtemp(dir)) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    const std::string image = std::string(dir) + "/load.img";
+    if (mib == 0 || !writeImage(image, mib)) {
+        std::fprintf(stderr, "cannot write %s\n", image.c_str());
+        return 1;
+    }
+
+    GatewayCore::Config cfg = GatewayCore::configFromEnv();
+    cfg.dir = dir;
+    cfg.image = "load.img";
+    cfg.passes = 1;
+
+    std::printf("image %zu MiB, %zu lanes, %u workers, quantum %u, cache %zu MiB%s\n", mib, lanes, cfg.workers,
+                cfg.quantum, cfg.cacheBytes >> 20, cfg.fec.k ? ", FEC" : "");
+    std::printf("%8s %10s %12s %12s %12s %12s %8s %8s\n", "clients", "MiB/s", "first p50", "first p99",
+                "done p50", "done p99", "busy", "hit %");
+
+    const size_t counts[] = {1, 2, 5, 10, 20, 50, 100, 200};
+    for (size_t n : counts) {
+        if (n > maxClients) break;
+
+        std::vector<Client> clients(n);
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t finished = 0;
+        // Per lane: the client it serves (kNone: free) and the ones waiting
+        const size_t kNone = ~static_cast<size_t>(0);
+        std::vector<size_t> owner(lanes, kNone);
+        std::vector<std::deque<size_t>> waiting(lanes);
+
+        GatewayCore core(cfg, lanes, [&](size_t lane, uint32_t index, const ChunkCache::Buffer& data, bool last) {
+            size_t id;
+            {
+                std::lock_guard<std::mutex> lk(mutex);
+                id = owner[lane];
+            }
+            if (id == kNone) return;
+            // Parity is not counted: that of a finished transfer trails its
+            // last chunk and may reach the lane's next client
+            const bool parity = (index & FecDecoder::kParityFlag) != 0;
+            Client& c = clients[id];
+            if (!c.started && !parity) {
+                c.first = Clock::now();
+                c.started = true;
+            }
+            if (!parity) {
+                c.scratch.resize(data->size());
+                std::memcpy(c.scratch.data(), data->data(), data->size());
+            }
+            if (last) {
+                c.done = Clock::now();
+                std::lock_guard<std::mutex> lk(mutex);
+                owner[lane] = kNone;
+                ++finished;
+                cv.notify_all();
+            }
+        });
+        std::vector<std::unique_ptr<GatewayStub>> stubs;
+        for (size_t l = 0; l < lanes; ++l) stubs.emplace_back(new GatewayStub(core, l));
+        core.start();
+
+        // Under mutex: a lane is free for its next waiting client
+        auto laneFree = [&]() {
+            for (size_t l = 0; l < lanes; ++l) {
+                if (owner[l] == kNone && !waiting[l].empty()) return true;
+            }
+            return false;
+        };
+
+        const Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < n; ++i) waiting[i % lanes].push_back(i);
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            while (finished < clients.size()) {
+                bool retry = false;
+                for (size_t l = 0; l < lanes; ++l) {
+                    if (owner[l] != kNone || waiting[l].empty()) continue;
+                    const size_t id = waiting[l].front();
+                    owner[l] = id;
+                    lk.unlock();
+                    const bool accepted = stubs[l]->startFor(id + 1, cfg.image);
+                    lk.lock();
+                    if (accepted) {
+                        waiting[l].pop_front();
+                    } else {
+                        owner[l] = kNone;   // the last transfer's parity is still going out
+                        retry = true;
+                    }
+                }
+                if (retry) {
+                    cv.wait_for(lk, std::chrono::milliseconds(1));
+                } else {
+                    cv.wait(lk, [&]() { return finished == clients.size() || laneFree(); });
+                }
+            }
+        }
+        const double sec = std::chrono::duration<double>(Clock::now() - start).count();
+        const GatewayCore::Stats stats = core.stats();
+        core.stop();
+
+        std::vector<double> first, done;
+        for (const Client& c : clients) {
+            first.push_back(std::chrono::duration<double, std::milli>(c.first - start).count());
+            done.push_back(std::chrono::duration<double, std::milli>(c.done - start).count());
+        }
+        const double lookups = static_cast<double>(stats.cache.hits + stats.cache.misses);
+
+        std::printf("%8zu %10.1f %9.2f ms %9.2f ms %9.1f ms %9.1f ms %8llu %7.1f%%\n", n,
+                    static_cast<double>(mib * n) / sec, percentile(first, 0.5), percentile(first, 0.99),
+                    percentile(done, 0.5), percentile(done, 0.99), static_cast<unsigned long long>(stats.busy),
+                    lookups > 0 ? 100.0 * static_cast<double>(stats.cache.hits) / lookups : 0.0);
+    }
+
+    unlink(image.c_str());
+    rmdir(dir);
+    return 0;
+}
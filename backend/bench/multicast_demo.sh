@@ -0,0 +1,76 @@
+#!/bin/sh
+#
+# One image to 1..N clients on this host: unicast UDP (every client gets
+# its own stream) against one multicast stream with FEC. Prints each
+# client's throughput and the bytes that crossed loopback per run, which
+# grow with N for unicast and stay flat for multicast. Needs the
+# reference server; SERVER is the command that starts it.
+#
+# Usage: SERVER=/path/to/ota-server multicast_demo.sh [bench binary] [max clients] [fec k,m] [loss %]
+
+set -u
+
+BENCH=${1:-./transport_bench}
+MAX=${2:-8}
+FEC=${3:-16,2}
+LOSS=${4:-0}
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+: "${SERVER:?set SERVER to the reference server command}"
+WORK=$(mktemp -d)
+
+cleanup() {
+    rm -rf "$WORK"
+    [ "$LOSS" != "0" ] && tc qdisc del dev lo root 2>/dev/null
+    [ -n "${SERVER_PID:-}" ] && kill "$SERVER_PID" 2>/dev/null
+}
+trap cleanup EXIT INT TERM
+
+if [ "$LOSS" != "0" ]; then
+    tc qdisc add dev lo root netem loss "${LOSS}%" || exit 1
+fi
+
+lo_bytes() {
+    cat /sys/class/net/lo/statistics/tx_bytes
+}
+
+run() {
+    transport=$1 config=$2 clients=$3
+    VSOMEIP_CONFIGURATION=$config OTA_FEC=$FEC VSOMEIP_APPLICATION_NAME=service-sample \
+        $SERVER >/dev/null 2>&1 &
+    SERVER_PID=$!
+    sleep 2
+
+    before=$(lo_bytes)
+    start=$(date +%s.%N)
+    i=1
+    while [ "$i" -le "$clients" ]; do
+        dir=$WORK/client-$i
+        mkdir -p "$dir"
+        VSOMEIP_CONFIGURATION=$config OTA_TRANSPORT=$transport OTA_FEC=$FEC \
+            OTA_CONNECTION_ID=client-$i OTA_DATA_DIR=$dir OTA_LOG_LEVEL=warn \
+            "$BENCH" 1 "$transport client $i/$clients" &
+        i=$((i + 1))
+    done
+    wait_clients
+    end=$(date +%s.%N)
+    after=$(lo_bytes)
+
+    echo "$transport x$clients: $(echo "$end - $start" | bc) s, $(( (after - before) / 1048576 )) MiB on loopback"
+    kill "$SERVER_PID" 2>/dev/null
+    wait "$SERVER_PID" 2>/dev/null
+    SERVER_PID=
+}
+
+# Waits for the client jobs only, the server keeps running
+wait_clients() {
+    for pid in $(jobs -p); do
+        [ "$pid" = "$SERVER_PID" ] || wait "$pid"
+    done
+}
+
+n=1
+while [ "$n" -le "$MAX" ]; do
+    run udp "$ROOT/vsomeip-udp.json" "$n"
+    run multicast "$ROOT/vsomeip-multicast.json" "$n"
+    n=$((n * 2))
+done
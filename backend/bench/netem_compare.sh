@@ -0,0 +1,49 @@
+#!/bin/sh
+#
+# TCP against UDP + NACK repair on loopback, with tc netem adding loss
+# and delay. Needs root (tc) and the reference server; SERVER is the
+# command that starts it, run with the same VSOMEIP_CONFIGURATION as the
+# client for each transport.
+#
+# Usage: SERVER=/path/to/ota-server netem_compare.sh [bench binary] [runs]
+
+set -u
+
+BENCH=${1:-./transport_bench}
+RUNS=${2:-3}
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+: "${SERVER:?set SERVER to the reference server command}"
+
+# loss% delay
+PROFILES="0 0ms
+0.1 1ms
+1 5ms
+3 10ms"
+
+cleanup() {
+    tc qdisc del dev lo root 2>/dev/null
+    [ -n "${SERVER_PID:-}" ] && kill "$SERVER_PID" 2>/dev/null
+}
+trap cleanup EXIT INT TERM
+
+run() {
+    transport=$1 config=$2 label=$3
+    VSOMEIP_CONFIGURATION=$config VSOMEIP_APPLICATION_NAME=service-sample $SERVER >/dev/null 2>&1 &
+    SERVER_PID=$!
+    sleep 2
+    VSOMEIP_CONFIGURATION=$config OTA_TRANSPORT=$transport OTA_LOG_LEVEL=warn \
+        "$BENCH" "$RUNS" "$label"
+    kill "$SERVER_PID" 2>/dev/null
+    wait "$SERVER_PID" 2>/dev/null
+    SERVER_PID=
+}
+
+echo "$PROFILES" | while read -r loss delay; do
+    tc qdisc del dev lo root 2>/dev/null
+    if [ "$loss" != "0" ] || [ "$delay" != "0ms" ]; then
+        tc qdisc add dev lo root netem loss "${loss}%" delay "$delay" || exit 1
+    fi
+    label="loss ${loss}% delay ${delay}"
+    run tcp "$ROOT/vsomeip.json" "$label"
+    run udp "$ROOT/vsomeip-udp.json" "$label"
+done
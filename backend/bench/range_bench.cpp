@@ -0,0 +1,147 @@
+/*
+ * ==============================================================
+ * range_bench
+ * ==============================================================
+ * Download throughput from 1 to N range streams against a running
+ * service (the local reference server, see vsomeip.json). For every
+ * stream count the image is downloaded [runs] times with OtaBackend:
+ * - transfer: startDownload() until every byte is on disk (100%)
+ * - total: until the finished callback, i.e. including the CRC check
+ * Stream counts above the number of available instances fall back to
+ * fewer streams, which the backend log shows.
+ *
+ * Usage: range_bench [max streams] [runs] [file]
+ */
+
+#include "OtaBackend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Run {
+    bool ok = false;
+    double transferSec = 0.0;
+    double totalSec = 0.0;
+};
+
+class Waiter {
+   public:
+    void reset() {
+        std::lock_guard<std::mutex> lk(mutex_);
+        done_ = false;
+        ok_ = false;
+        transferDone_ = false;
+        start_ = std::chrono::steady_clock::now();
+    }
+
+    void progress(int percent) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (percent >= 100 && !transferDone_) {
+            transferDone_ = true;
+            transferEnd_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    void finish(bool ok) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (done_) return;
+        done_ = true;
+        ok_ = ok;
+        end_ = std::chrono::steady_clock::now();
+        cv_.notify_all();
+    }
+
+    Run wait(std::chrono::seconds timeout) {
+        std::unique_lock<std::mutex> lk(mutex_);
+        Run r;
+        if (!cv_.wait_for(lk, timeout, [this]() { return done_; })) return r;
+        r.ok = ok_;
+        r.totalSec = std::chrono::duration<double>(end_ - start_).count();
+        r.transferSec = transferDone_
+            ? std::chrono::duration<double>(transferEnd_ - start_).count()
+            : r.totalSec;
+        return r;
+    }
+
+   private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool done_ = false;
+    bool ok_ = false;
+    bool transferDone_ = false;
+    std::chrono::steady_clock::time_point start_, transferEnd_, end_;
+};
+
+double median(std::vector<double> v) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const size_t maxStreams = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4;
+    const int runs = argc > 2 ? std::atoi(argv[2]) : 3;
+    const std::string file = argc > 3 ? argv[3] : "rpi4-update.wic";
+
+    // Bundles would bypass the range path
+    OtaConfig config = OtaConfig::fromEnv();
+    config.manifestName.clear();
+
+    OtaBackend backend(file, config);
+    Waiter waiter;
+    backend.setProgressCallback([&](int percent) { waiter.progress(percent); });
+    backend.setFinishedCallback([&]() { waiter.finish(true); });
+    backend.setErrorCallback([&](const std::string& msg) {
+        std::fprintf(stderr, "error: %s\n", msg.c_str());
+        waiter.finish(false);
+    });
+
+    if (!backend.init()) {
+        std::fprintf(stderr, "service not available\n");
+        return 1;
+    }
+    if (!backend.requestUpdate(0) || backend.updateSize() == 0) {
+        std::fprintf(stderr, "no image offered\n");
+        return 1;
+    }
+
+    const double mib = static_cast<double>(backend.updateSize()) / (1024.0 * 1024.0);
+    std::printf("%s: %.1f MiB, %d runs per stream count\n\n", file.c_str(), mib, runs);
+    std::printf("%-8s %14s %14s %10s\n", "streams", "transfer MiB/s", "total MiB/s", "speedup");
+
+    double base = 0.0;
+    for (size_t streams = 1; streams <= std::max<size_t>(1, maxStreams); ++streams) {
+        backend.setRangeStreams(streams);
+        std::vector<double> transfer, total;
+
+        for (int i = 0; i < runs; ++i) {
+            waiter.reset();
+            if (backend.startDownload() != OtaBackend::StartResult::Started) break;
+            const Run r = waiter.wait(std::chrono::seconds(600));
+            if (!r.ok) break;
+            transfer.push_back(mib / r.transferSec);
+            total.push_back(mib / r.totalSec);
+        }
+        if (transfer.empty()) {
+            std::printf("%-8zu %14s\n", streams, "failed");
+            continue;
+        }
+
+        const double t = median(transfer);
+        if (streams == 1) base = t;
+        std::printf("%-8zu %14.1f %14.1f %9.2fx\n", streams, t, median(total), base > 0 ? t / base : 0.0);
+    }
+
+    backend.stop();
+    return 0;
+}
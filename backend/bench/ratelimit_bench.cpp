@@ -0,0 +1,175 @@
+/*
+ * ==============================================================
+ * ratelimit_bench
+ * ==============================================================
+ * Effect of the background transfer class on a latency-sensitive flow.
+ * 1. Link: a bulk transfer and a small request/response probe (200 B every
+ *    10 ms) share one bottleneck with a FIFO buffer. Simulated in 50 us
+ *    steps with the real TokenBucket; reports the probe's queueing delay.
+ * 2. CPU: one thread per core hashes (CRC-32) at normal priority, then at
+ *    background priority, while a probe thread measures how late its 1 ms
+ *    sleeps wake up. Real threads, real scheduler.
+ * 3. Accuracy: a 4 MiB/s bucket paced on the real clock for 2 s.
+ *
+ * Usage: ratelimit_bench [link Mbit/s] [buffer KiB]
+ */
+
+#include "Crc32.h"
+#include "ThreadPriority.h"
+#include "TokenBucket.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Latency {
+    double p50Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+};
+
+Latency summarize(std::vector<double>& ms) {
+    Latency l;
+    if (ms.empty()) return l;
+    std::sort(ms.begin(), ms.end());
+    l.p50Ms = ms[ms.size() / 2];
+    l.p99Ms = ms[std::min(ms.size() - 1, ms.size() * 99 / 100)];
+    l.maxMs = ms.back();
+    return l;
+}
+
+const uint64_t kStepNs = 50000;
+const uint64_t kPacket = 1448;
+const uint64_t kProbeBytes = 200;
+const uint64_t kProbeEveryNs = 10000000;
+
+// One bottleneck, FIFO, tail drop for bulk (the sender backs off and
+// keeps the buffer full, like a loss-based TCP would)
+// bulkRateBps 0 is unlimited; no bulk flow at all when !bulk
+void simulateLink(const char* name, double linkBps, uint64_t bufferBytes, bool bulk, uint64_t bulkRateBps) {
+    // Same depth as DownloadPipeline::setRateLimit()
+    TokenBucket bucket;
+    bucket.configure(bulkRateBps, std::max<uint64_t>(64 * 1024, bulkRateBps / 20));
+
+    struct Packet {
+        uint64_t bytes;
+        uint64_t enqueuedNs;
+        bool probe;
+    };
+    std::deque<Packet> queue;
+    uint64_t queuedBytes = 0;
+    double linkCredit = 0.0;
+    uint64_t bulkBytes = 0;
+    uint64_t sendAtNs = 0;
+    bool reserved = false;
+    std::vector<double> probeMs;
+
+    const uint64_t durationNs = 20ULL * 1000000000ULL;
+    for (uint64_t now = kStepNs; now <= durationNs; now += kStepNs) {
+        // Bulk sender
+        while (bulk) {
+            if (!reserved) {
+                sendAtNs = now + bucket.reserve(kPacket, now);
+                reserved = true;
+            }
+            if (sendAtNs > now || queuedBytes + kPacket > bufferBytes) break;
+            queue.push_back({kPacket, now, false});
+            queuedBytes += kPacket;
+            reserved = false;
+        }
+
+        if (now % kProbeEveryNs == 0) {
+            queue.push_back({kProbeBytes, now, true});
+            queuedBytes += kProbeBytes;
+        }
+
+        // Link drains at its rate
+        linkCredit += linkBps * static_cast<double>(kStepNs) / 1e9;
+        while (!queue.empty() && linkCredit >= static_cast<double>(queue.front().bytes)) {
+            const Packet p = queue.front();
+            queue.pop_front();
+            linkCredit -= static_cast<double>(p.bytes);
+            queuedBytes -= p.bytes;
+            if (p.probe) {
+                probeMs.push_back(static_cast<double>(now - p.enqueuedNs) / 1e6);
+            } else {
+                bulkBytes += p.bytes;
+            }
+        }
+        if (queue.empty()) linkCredit = std::min(linkCredit, static_cast<double>(kPacket));
+    }
+
+    const Latency l = summarize(probeMs);
+    std::printf("  %-24s bulk %6.2f MB/s   probe p50 %6.2f ms  p99 %6.2f ms  max %6.2f ms\n",
+                name, bulkBytes / 20.0 / 1e6, l.p50Ms, l.p99Ms, l.maxMs);
+}
+
+Latency cpuContention(bool background, unsigned hashers) {
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> pool;
+    for (unsigned i = 0; i < hashers; ++i) {
+        pool.emplace_back([&]() {
+            threadpriority::setCurrentThreadBackground(background);
+            std::vector<uint8_t> buf(1024 * 1024, 0x5a);
+            uint32_t crc = 0;
+            while (!stop.load(std::memory_order_relaxed)) crc = crc32::update(crc, buf.data(), buf.size());
+            if (crc == 1) std::printf(" ");
+        });
+    }
+
+    std::vector<double> lateMs;
+    const auto sleep = std::chrono::milliseconds(1);
+    for (int i = 0; i < 2000; ++i) {
+        const auto t0 = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(sleep);
+        const auto late = std::chrono::steady_clock::now() - t0 - sleep;
+        lateMs.push_back(std::chrono::duration<double, std::milli>(late).count());
+    }
+
+    stop = true;
+    for (auto& t : pool) t.join();
+    return summarize(lateMs);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const double linkMbit = argc > 1 ? std::atof(argv[1]) : 100.0;
+    const uint64_t bufferKiB = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 512;
+    const double linkBps = linkMbit * 1e6 / 8.0;
+
+    std::printf("Link %.0f Mbit/s, %llu KiB bottleneck buffer, probe %llu B every 10 ms\n", linkMbit,
+                static_cast<unsigned long long>(bufferKiB), static_cast<unsigned long long>(kProbeBytes));
+    simulateLink("no transfer", linkBps, bufferKiB * 1024, false, 0);
+    simulateLink("foreground (unlimited)", linkBps, bufferKiB * 1024, true, 0);
+    simulateLink("background 50% of link", linkBps, bufferKiB * 1024, true, static_cast<uint64_t>(linkBps / 2));
+    simulateLink("background 2 MiB/s", linkBps, bufferKiB * 1024, true, 2 * 1024 * 1024);
+
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("\n%u hashing threads vs a 1 ms sleep probe (wakeup lateness)\n", cores);
+    const Latency idle = cpuContention(false, 0);
+    const Latency fg = cpuContention(false, cores);
+    const Latency bg = cpuContention(true, cores);
+    std::printf("  %-24s p50 %6.3f ms  p99 %6.3f ms  max %6.3f ms\n", "no hashing", idle.p50Ms, idle.p99Ms, idle.maxMs);
+    std::printf("  %-24s p50 %6.3f ms  p99 %6.3f ms  max %6.3f ms\n", "hashers at nice 0", fg.p50Ms, fg.p99Ms, fg.maxMs);
+    std::printf("  %-24s p50 %6.3f ms  p99 %6.3f ms  max %6.3f ms\n", "hashers in background", bg.p50Ms, bg.p99Ms, bg.maxMs);
+
+    TokenBucket bucket(4 * 1024 * 1024, 1024 * 1024);
+    const uint64_t start = TokenBucket::nowNs();
+    uint64_t sent = 0;
+    while (TokenBucket::nowNs() - start < 2000000000ULL) {
+        const uint64_t waitNs = bucket.reserve(64 * 1024, TokenBucket::nowNs());
+        if (waitNs) std::this_thread::sleep_for(std::chrono::nanoseconds(waitNs));
+        sent += 64 * 1024;
+    }
+    const double sec = static_cast<double>(TokenBucket::nowNs() - start) / 1e9;
+    std::printf("\nBucket at 4.00 MiB/s (1 MiB burst): %.2f MiB/s over %.2f s\n", sent / sec / (1024.0 * 1024.0), sec);
+    return 0;
+}
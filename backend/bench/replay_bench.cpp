@@ -0,0 +1,147 @@
+/*
+ * ==============================================================
+ * replay_bench
+ * ==============================================================
+ * Receive pipeline benchmark without a service: replays a chunk
+ * recording (made with OTA_RECORD_CHUNKS=<file> on any download, e.g.
+ * transport_bench) into OtaBackend [runs] times and prints the median
+ * of
+ * - transfer: replay start until every byte is on disk (100%)
+ * - total: until the finished callback, i.e. including the CRC check
+ * Speed 0 (default) feeds the events as fast as the pipeline takes
+ * them, which is what regression runs should use; 1 keeps the recorded
+ * arrival times. A CRC mismatch fails the run.
+ *
+ * Usage: replay_bench <recording> [runs] [speed]
+ */
+
+#include "OtaBackend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Run {
+    bool ok = false;
+    double transferSec = 0.0;
+    double totalSec = 0.0;
+};
+
+class Waiter {
+   public:
+    void reset() {
+        std::lock_guard<std::mutex> lk(mutex_);
+        done_ = false;
+        ok_ = false;
+        transferDone_ = false;
+        start_ = std::chrono::steady_clock::now();
+    }
+
+    void progress(int percent) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (percent >= 100 && !transferDone_) {
+            transferDone_ = true;
+            transferEnd_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    void finish(bool ok) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (done_) return;
+        done_ = true;
+        ok_ = ok;
+        end_ = std::chrono::steady_clock::now();
+        cv_.notify_all();
+    }
+
+    Run wait(std::chrono::seconds timeout) {
+        std::unique_lock<std::mutex> lk(mutex_);
+        Run r;
+        if (!cv_.wait_for(lk, timeout, [this]() { return done_; })) return r;
+        r.ok = ok_;
+        r.totalSec = std::chrono::duration<double>(end_ - start_).count();
+        r.transferSec = transferDone_
+            ? std::chrono::duration<double>(transferEnd_ - start_).count()
+            : r.totalSec;
+        return r;
+    }
+
+   private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool done_ = false;
+    bool ok_ = false;
+    bool transferDone_ = false;
+    std::chrono::steady_clock::time_point start_, transferEnd_, end_;
+};
+
+double median(std::vector<double> v) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <recording> [runs] [speed]\n", argv[0]);
+        return 2;
+    }
+    const std::string recording = argv[1];
+    const int runs = argc > 2 ? std::atoi(argv[2]) : 5;
+    const double speed = argc > 3 ? std::strtod(argv[3], nullptr) : 0.0;
+
+    // Written to /tmp unless OTA_DATA_DIR says otherwise
+    OtaConfig config = OtaConfig::fromEnv();
+    if (config.dataDir.empty()) config.dataDir = "/tmp/";
+    config.recordPath.clear();
+    config.transport = OtaConfig::Transport::Reliable;
+
+    ChunkRecording rec;
+    std::string error;
+    if (!rec.open(recording, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    const double mib = static_cast<double>(rec.header().imageSize) / (1024.0 * 1024.0);
+    std::printf("%s: %.1f MiB, %llu events, %d runs, %s\n", recording.c_str(), mib,
+                static_cast<unsigned long long>(rec.events()), runs,
+                speed > 0.0 ? "recorded timing" : "full speed");
+    rec.close();
+
+    OtaBackend backend("replay.img", config);
+    Waiter waiter;
+    backend.setProgressCallback([&](int percent) { waiter.progress(percent); });
+    backend.setFinishedCallback([&]() { waiter.finish(true); });
+    backend.setErrorCallback([&](const std::string& msg) {
+        std::fprintf(stderr, "error: %s\n", msg.c_str());
+        waiter.finish(false);
+    });
+
+    std::vector<double> transfer, total;
+    int failed = 0;
+    for (int i = 0; i < runs; ++i) {
+        waiter.reset();
+        if (!backend.startReplay(recording, speed)) return 1;
+        const Run r = waiter.wait(std::chrono::seconds(600));
+        if (!r.ok) {
+            ++failed;
+            continue;
+        }
+        transfer.push_back(mib / r.transferSec);
+        total.push_back(mib / r.totalSec);
+    }
+
+    std::printf("transfer %.1f MiB/s  total %.1f MiB/s  (median, %d/%d ok)\n", median(transfer), median(total),
+                runs - failed, runs);
+    backend.stop();
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * ==============================================================
+ * sampler_bench
+ * ==============================================================
+ * Measures what one system-info tick costs the monitor itself.
+ * Compares the stdio-based readers (fopen/fgets/sscanf/fscanf + statvfs)
+ * used previously with SystemSampler (persistent fds + pread).
+ *
+ * Usage: sampler_bench [iterations]
+ */
+
+#include "SystemSampler.h"
+
+#include <sys/statvfs.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Reference implementation of the previous per-tick readers
+void legacyTick() {
+    char line[512];
+    FILE* f = std::fopen("/proc/stat", "r");
+    if (f) {
+        if (std::fgets(line, sizeof(line), f)) {
+            char label[8];
+            unsigned long v[10] = {0};
+            std::sscanf(line, "%7s %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu", label,
+                        &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7], &v[8], &v[9]);
+        }
+        std::fclose(f);
+    }
+
+    f = std::fopen("/proc/meminfo", "r");
+    if (f) {
+        char key[64], unit[32];
+        unsigned long kb = 0;
+        int found = 0;
+        while (found < 2 && std::fscanf(f, "%63s %lu %31s\n", key, &kb, unit) == 3) {
+            if (!std::strcmp(key, "MemTotal:") || !std::strcmp(key, "MemAvailable:")) ++found;
+        }
+        std::fclose(f);
+    }
+
+    struct statvfs vfs;
+    statvfs("/", &vfs);
+
+    f = std::fopen(SystemSampler::kDefaultThermalPath, "r");
+    if (f) {
+        long milli = 0;
+        if (std::fscanf(f, "%ld", &milli) != 1) milli = 0;
+        std::fclose(f);
+    }
+
+    f = std::fopen("/proc/uptime", "r");
+    if (f) {
+        double up = 0.0;
+        if (std::fscanf(f, "%lf", &up) != 1) up = 0.0;
+        std::fclose(f);
+    }
+}
+
+void samplerTick(SystemSampler& s) {
+    SystemSampler::CpuCounters cpu;
+    SystemSampler::ProcessCounters self;
+    uint64_t a = 0, b = 0;
+    double t = 0.0;
+    s.readCpuCounters(cpu);
+    s.readSelf(self);
+    s.readMemory(a, b);
+    s.readStorage(a, b);
+    s.readTemperature(t);
+    s.readUptime(a);
+}
+
+template <typename Fn>
+double nsPerCall(int iterations, Fn fn) {
+    // Warm up page cache and dentries
+    for (int i = 0; i < 100; ++i) fn();
+
+    const auto t0 = Clock::now();
+    for (int i = 0; i < iterations; ++i) fn();
+    const auto t1 = Clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int iterations = (argc > 1) ? std::atoi(argv[1]) : 20000;
+
+    SystemSampler sampler;
+    sampler.open();
+
+    SystemSampler::CpuCounters cpu;
+    SystemSampler::ProcessCounters self;
+    uint64_t a = 0, b = 0;
+    double t = 0.0;
+
+    const double legacy = nsPerCall(iterations, legacyTick);
+    const double full = nsPerCall(iterations, [&] { samplerTick(sampler); });
+
+    std::printf("iterations: %d\n", iterations);
+    std::printf("%-22s %10.0f ns/tick\n", "legacy stdio tick", legacy);
+    std::printf("%-22s %10.0f ns/tick  (%.1fx)\n", "sampler tick", full, legacy / full);
+    std::printf("  %-20s %10.0f ns\n", "cpu (all cores)", nsPerCall(iterations, [&] { sampler.readCpuCounters(cpu); }));
+    std::printf("  %-20s %10.0f ns\n", "self", nsPerCall(iterations, [&] { sampler.readSelf(self); }));
+    std::printf("  %-20s %10.0f ns\n", "memory", nsPerCall(iterations, [&] { sampler.readMemory(a, b); }));
+    std::printf("  %-20s %10.0f ns\n", "storage", nsPerCall(iterations, [&] { sampler.readStorage(a, b); }));
+    std::printf("  %-20s %10.0f ns\n", "temperature", nsPerCall(iterations, [&] { sampler.readTemperature(t); }));
+    std::printf("  %-20s %10.0f ns\n", "uptime", nsPerCall(iterations, [&] { sampler.readUptime(a); }));
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+#!/bin/sh
+#
+# Startup regression check: launches the app N times with
+# OTA_STARTUP_REPORT set, stops each run once its report line is written
+# (first frame shown and backend init returned) and prints the median and
+# p90 of time to first frame, time to connected and the peak resident
+# memory at that point. Start the gateway first if time to connected
+# should mean something; without a service it is -1.
+#
+# With a baseline file (two numbers: first frame and connected median in
+# ms, as printed by a previous run with -w), exits 1 if either median is
+# more than TOLERANCE percent slower.
+#
+# Usage: startup_bench.sh [app binary] [runs] [baseline file] [-w]
+#   TOLERANCE (default 15), RUN_TIMEOUT s per run (default 60)
+
+set -u
+
+APP=${1:-./appqnxOta}
+RUNS=${2:-10}
+BASELINE=${3:-}
+WRITE=${4:-}
+TOLERANCE=${TOLERANCE:-15}
+RUN_TIMEOUT=${RUN_TIMEOUT:-60}
+WORK=$(mktemp -d)
+REPORT=$WORK/startup.jsonl
+
+cleanup() {
+    rm -rf "$WORK"
+    [ -n "${APP_PID:-}" ] && kill "$APP_PID" 2>/dev/null
+}
+trap cleanup EXIT INT TERM
+
+i=0
+while [ "$i" -lt "$RUNS" ]; do
+    before=$(cat "$REPORT" 2>/dev/null | wc -l)
+    OTA_STARTUP_REPORT=$REPORT OTA_LOG_LEVEL=warn "$APP" >/dev/null 2>&1 &
+    APP_PID=$!
+    waited=0
+    while [ "$(cat "$REPORT" 2>/dev/null | wc -l)" -le "$before" ] && [ "$waited" -lt $((RUN_TIMEOUT * 10)) ]; do
+        sleep 0.1
+        waited=$((waited + 1))
+    done
+    kill "$APP_PID" 2>/dev/null
+    wait "$APP_PID" 2>/dev/null
+    APP_PID=
+    [ "$(cat "$REPORT" 2>/dev/null | wc -l)" -gt "$before" ] || echo "run $i: no report within ${RUN_TIMEOUT}s" >&2
+    i=$((i + 1))
+done
+
+[ -s "$REPORT" ] || { echo "no startup reports" >&2; exit 2; }
+
+# stats <key>: "median p90" of one metric over the runs that reached it
+stats() {
+    sed -n "s/.*\"$1\":\([-0-9.]*\).*/\1/p" "$REPORT" | awk '$1 >= 0' | sort -n |
+        awk '{ v[NR] = $1 }
+             END {
+                 if (NR == 0) { print "-1 -1"; exit }
+                 printf "%.1f %.1f\n", v[int((NR + 1) / 2)], v[int(NR * 0.9 + 0.999)]
+             }'
+}
+
+frame=$(stats time_to_first_frame_ms)
+conn=$(stats time_to_connected_ms)
+rss=$(stats max_rss_kb)
+frameMedian=${frame% *}
+connMedian=${conn% *}
+echo "runs $(wc -l < "$REPORT")"
+echo "time to first frame  median ${frameMedian} ms  p90 ${frame#* } ms"
+echo "time to connected    median ${connMedian} ms  p90 ${conn#* } ms"
+echo "peak RSS             median ${rss% *} KiB  p90 ${rss#* } KiB"
+
+if [ -n "$BASELINE" ] && [ "$WRITE" = -w ]; then
+    echo "$frameMedian $connMedian" > "$BASELINE"
+    echo "baseline written to $BASELINE"
+elif [ -n "$BASELINE" ]; then
+    read -r baseFrame baseConn < "$BASELINE"
+    awk -v f="$frameMedian" -v bf="$baseFrame" -v c="$connMedian" -v bc="$baseConn" -v t="$TOLERANCE" '
+        function check(name, v, b) {
+            if (b <= 0 || v < 0) return 0
+            printf "%-15s %+.1f%% against baseline %.1f ms\n", name, (v - b) * 100 / b, b
+            return v > b * (1 + t / 100)
+        }
+        BEGIN {
+            bad = check("first frame", f, bf)
+            bad = check("connected", c, bc) || bad
+            if (bad) print "REGRESSION (tolerance " t "%)"
+            exit bad
+        }'
+    exit $?
+fi
@@ -0,0 +1,62 @@
+#!/bin/sh
+#
+# Writes a vsomeip and a CommonAPI SOME/IP configuration with N instances
+# of the file transfer service (0x7000.., TCP ports 30509..) into DIR, and
+# prints the environment for ota_gateway and swarm_load to use them. Each
+# instance carries one transfer at a time, so N bounds the concurrent
+# downloads of the swarm.
+#
+# Usage: swarm_config.sh [instances] [dir]
+#   eval "$(swarm_config.sh 32 /tmp/swarm)"
+
+set -eu
+
+N=${1:-16}
+DIR=${2:-.}
+mkdir -p "$DIR"
+JSON=$DIR/vsomeip-swarm.json
+INI=$DIR/commonapi-someip-swarm.ini
+
+{
+    echo '{'
+    echo '    "unicast": "127.0.0.1",'
+    echo '    "logging": { "level": "warning", "console": "true" },'
+    echo '    "applications": ['
+    echo '        { "name": "client-sample", "id": "0x1313" },'
+    echo '        { "name": "service-sample", "id": "0x1277" }'
+    echo '    ],'
+    echo '    "services": ['
+    i=0
+    while [ "$i" -lt "$N" ]; do
+        sep=,
+        [ "$i" -eq $((N - 1)) ] && sep=
+        printf '        { "service": "0x6000", "instance": "0x%04x", "reliable": "%d" }%s\n' \
+            $((0x7000 + i)) $((30509 + i)) "$sep"
+        i=$((i + 1))
+    done
+    echo '    ],'
+    echo '    "routing": "service-sample",'
+    echo '    "service-discovery": {'
+    echo '        "enable": "true",'
+    echo '        "multicast": "224.224.224.245",'
+    echo '        "port": "30490",'
+    echo '        "protocol": "udp"'
+    echo '    }'
+    echo '}'
+} >"$JSON"
+
+: >"$INI"
+list=filetransfer.example.FileTransfer
+i=1
+while [ "$i" -lt "$N" ]; do
+    name=filetransfer.example.FileTransfer$((i + 1))
+    printf '[local:filetransfer.example.FileTransfer:v0_1:%s]\nservice=0x6000\ninstance=0x%04x\n\n' \
+        "$name" $((0x7000 + i)) >>"$INI"
+    list=$list,$name
+    i=$((i + 1))
+done
+
+echo "export VSOMEIP_CONFIGURATION=$JSON"
+echo "export COMMONAPI_SOMEIP_CONFIG=$INI"
+echo "export OTA_GW_INSTANCES=$list"
+echo "export OTA_SWARM_INSTANCES=$list"
@@ -0,0 +1,576 @@
+/*
+ * ==============================================================
+ * swarm_load
+ * ==============================================================
+ * Fleet simulator for sizing a gateway: N clients in one process, each
+ * going through the OtaBackend flow (update check, transfer, CRC check)
+ * against a running service such as ota_gateway.
+ *
+ * - Proxies: one per service instance, shared by the clients. A chunk
+ *   carries no transfer id, so an instance carries one transfer at a
+ *   time; clients assigned to the same instance queue for it (the wait
+ *   is part of their completion time). More instances, more parallel
+ *   transfers: see swarm_config.sh.
+ * - Writers: a small pool hashes the chunks, each client on one writer
+ *   so its chunks stay in order, and discards them unless
+ *   OTA_SWARM_WRITE_DIR is set.
+ * - Think time before each check (exponential, OTA_SWARM_THINK_MS),
+ *   version skew (OTA_SWARM_UP_TO_DATE % of the clients are on the
+ *   offered version, the others 1 to OTA_SWARM_SKEW versions behind),
+ *   failure injection (OTA_SWARM_ABORT % of transfers are abandoned
+ *   halfway, OTA_SWARM_CORRUPT % get one byte flipped and fail the
+ *   CRC); failed clients retry up to OTA_SWARM_RETRIES times.
+ *
+ * Prints the aggregate throughput, completion time percentiles (check
+ * to verified, without think time), outcome counts, and the CPU use of
+ * the gateway process (OTA_SWARM_GATEWAY_PID, else the process named
+ * ota_gateway) and of the swarm itself over the run.
+ *
+ * Usage: swarm_load [clients] [image]
+ */
+
+#include <CommonAPI/CommonAPI.hpp>
+#include <v0/filetransfer/example/FileTransferProxy.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "ChunkEventDeployment.h"
+#include "Crc32.h"
+#include "FecDecoder.h"
+
+namespace ft = v0::filetransfer::example;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    size_t clients = 20;
+    std::string image = "rpi4-update.wic";
+    std::vector<std::string> instances;
+    std::string connection = "client-sample";
+    double thinkMs = 500.0;
+    unsigned upToDatePct = 0;
+    unsigned skew = 3;
+    unsigned abortPct = 0;
+    unsigned corruptPct = 0;
+    unsigned retries = 3;
+    unsigned writers = 2;
+    std::string writeDir;               // empty: discard
+    unsigned timeoutSec = 300;
+};
+
+unsigned envUnsigned(const char* name, unsigned fallback) {
+    const char* v = std::getenv(name);
+    return v && *v ? static_cast<unsigned>(std::strtoul(v, nullptr, 10)) : fallback;
+}
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> out;
+    size_t from = 0;
+    while (from <= list.size()) {
+        const size_t comma = std::min(list.find(',', from), list.size());
+        if (comma > from) out.push_back(list.substr(from, comma - from));
+        from = comma + 1;
+    }
+    return out;
+}
+
+Options optionsFromEnv(int argc, char** argv) {
+    Options o;
+    if (argc > 1) o.clients = std::max<size_t>(1, std::strtoul(argv[1], nullptr, 10));
+    if (argc > 2) o.image = argv[2];
+
+    const char* instances = std::getenv("OTA_SWARM_INSTANCES");
+    o.instances = splitList(instances ? instances
+                                      : "filetransfer.example.FileTransfer,filetransfer.example.FileTransfer2,"
+                                        "filetransfer.example.FileTransfer3,filetransfer.example.FileTransfer4");
+    if (const char* v = std::getenv("OTA_CONNECTION_ID")) o.connection = v;
+    if (const char* v = std::getenv("OTA_SWARM_THINK_MS")) o.thinkMs = std::strtod(v, nullptr);
+    if (const char* v = std::getenv("OTA_SWARM_WRITE_DIR")) o.writeDir = v;
+    o.upToDatePct = std::min(100u, envUnsigned("OTA_SWARM_UP_TO_DATE", o.upToDatePct));
+    o.skew = std::max(1u, envUnsigned("OTA_SWARM_SKEW", o.skew));
+    o.abortPct = std::min(100u, envUnsigned("OTA_SWARM_ABORT", o.abortPct));
+    o.corruptPct = std::min(100u, envUnsigned("OTA_SWARM_CORRUPT", o.corruptPct));
+    o.retries = envUnsigned("OTA_SWARM_RETRIES", o.retries);
+    o.writers = std::max(1u, envUnsigned("OTA_SWARM_WRITERS", o.writers));
+    o.timeoutSec = std::max(1u, envUnsigned("OTA_SWARM_TIMEOUT", o.timeoutSec));
+    return o;
+}
+
+// utime + stime of a process in seconds, negative if unknown
+double processCpuSec(pid_t pid) {
+    std::ifstream in("/proc/" + std::to_string(pid) + "/stat");
+    std::string stat((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    const size_t paren = stat.rfind(')');
+    if (paren == std::string::npos) return -1.0;
+
+    // Fields after the command name start at 3 (state); utime is 14
+    unsigned long long utime = 0, stime = 0;
+    const char* p = stat.c_str() + paren + 2;
+    for (int field = 3; field < 14 && *p; ++field) {
+        p = std::strchr(p, ' ');
+        if (!p) return -1.0;
+        ++p;
+    }
+    if (std::sscanf(p, "%llu %llu", &utime, &stime) != 2) return -1.0;
+    return static_cast<double>(utime + stime) / static_cast<double>(sysconf(_SC_CLK_TCK));
+}
+
+pid_t findGateway() {
+    if (const char* v = std::getenv("OTA_SWARM_GATEWAY_PID")) return static_cast<pid_t>(std::atoi(v));
+    DIR* dir = opendir("/proc");
+    if (!dir) return 0;
+    pid_t found = 0;
+    while (dirent* e = readdir(dir)) {
+        const pid_t pid = static_cast<pid_t>(std::atoi(e->d_name));
+        if (pid <= 0) continue;
+        std::ifstream comm(std::string("/proc/") + e->d_name + "/comm");
+        std::string name;
+        if (std::getline(comm, name) && name == "ota_gateway") {
+            found = pid;
+            break;
+        }
+    }
+    closedir(dir);
+    return found;
+}
+
+double selfCpuSec() {
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return static_cast<double>(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) +
+           static_cast<double>(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    const size_t i = std::min(v.size() - 1, static_cast<size_t>(p * static_cast<double>(v.size())));
+    return v[i];
+}
+
+/*
+ * One simulated client. The transfer state is shared by its thread, the
+ * chunk callback and its writer, under mutex; crc and out belong to the
+ * writer while a transfer runs.
+ */
+struct Client {
+    size_t id = 0;
+    uint32_t version = 0;
+    std::mt19937 rng;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool transferDone = false;      // last chunk seen, aborted or broken
+    bool aborted = false;
+    bool broken = false;
+    bool verified = false;          // set by the writer
+    bool ok = false;
+
+    // Callback side, only while the client owns its instance
+    uint32_t expected = 0;
+    uint32_t abortAt = 0;           // chunk index + 1, 0: none
+    uint32_t corruptAt = 0;
+
+    // Writer side
+    uint32_t crc = 0;
+    FILE* out = nullptr;
+};
+
+struct WriteJob {
+    Client* client;
+    std::shared_ptr<std::vector<uint8_t>> data;   // null: finish the transfer
+    uint32_t expectedCrc;
+};
+
+/*
+ * Writer shard: one thread, a bounded queue. A full queue blocks the
+ * CommonAPI callback. The real client refuses the chunk and paces the
+ * sender instead; hashing keeps up here, so that rarely matters.
+ */
+class Writer {
+   public:
+    static constexpr size_t kQueueMax = 64;
+
+    Writer() : thread_([this]() { run(); }) {}
+
+    ~Writer() {
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    void push(WriteJob job) {
+        std::unique_lock<std::mutex> lk(mutex_);
+        cv_.wait(lk, [this]() { return queue_.size() < kQueueMax; });
+        queue_.push_back(std::move(job));
+        cv_.notify_all();
+    }
+
+   private:
+    void run() {
+        for (;;) {
+            WriteJob job;
+            {
+                std::unique_lock<std::mutex> lk(mutex_);
+                cv_.wait(lk, [this]() { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) return;
+                job = std::move(queue_.front());
+                queue_.pop_front();
+                cv_.notify_all();
+            }
+
+            Client& c = *job.client;
+            if (job.data) {
+                c.crc = crc32::update(c.crc, job.data->data(), job.data->size());
+                if (c.out) std::fwrite(job.data->data(), 1, job.data->size(), c.out);
+                continue;
+            }
+            if (c.out) {
+                std::fclose(c.out);
+                c.out = nullptr;
+            }
+            std::lock_guard<std::mutex> lk(c.mutex);
+            c.verified = true;
+            c.ok = c.crc == job.expectedCrc;
+            c.cv.notify_all();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<WriteJob> queue_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+/*
+ * A service instance: its proxy, the client currently owning it, and a
+ * FIFO of tickets for the clients waiting.
+ */
+struct Instance {
+    std::shared_ptr<ft::FileTransferProxy<>> proxy;
+    std::mutex mutex;
+    std::condition_variable cv;
+    Client* owner = nullptr;
+    uint64_t nextTicket = 0;
+    uint64_t serving = 0;
+};
+
+struct Totals {
+    std::mutex mutex;
+    std::vector<double> completionSec;
+    std::vector<double> waitSec;
+    uint64_t bytes = 0;
+    unsigned upToDate = 0;
+    unsigned failed = 0;
+    unsigned retries = 0;
+    unsigned aborted = 0;
+    unsigned corrupted = 0;
+    unsigned refused = 0;
+};
+
+class Swarm {
+   public:
+    explicit Swarm(const Options& o) : o_(o) {
+        for (unsigned i = 0; i < o_.writers; ++i) writers_.emplace_back(new Writer());
+    }
+
+    bool connect();
+    uint32_t latestVersion() const { return latest_; }
+    void runClient(Client& c);
+    Totals& totals() { return totals_; }
+
+   private:
+    enum class Outcome { Verified, UpToDate, Failed };
+
+    Outcome attempt(Client& c, Instance& inst, double& waitSec);
+    void onChunk(Instance& inst, uint32_t index, const CommonAPI::ByteBuffer& data, bool last);
+    void finishTransfer(Client& c);
+
+    const Options& o_;
+    std::vector<std::unique_ptr<Instance>> instances_;
+    std::vector<std::unique_ptr<Writer>> writers_;
+    uint32_t latest_ = 0;
+    uint64_t size_ = 0;
+    uint32_t crc_ = 0;
+    Totals totals_;
+};
+
+bool Swarm::connect() {
+    CommonAPI::Runtime::setProperty("LibraryBase", "FileTransfer");
+    chunkevent::registerProxyDeployment();
+    std::shared_ptr<CommonAPI::Runtime> runtime = CommonAPI::Runtime::get();
+    if (!runtime) return false;
+
+    for (const std::string& name : o_.instances) {
+        std::unique_ptr<Instance> inst(new Instance());
+        inst->proxy = runtime->buildProxy<ft::FileTransferProxy>("local", name, o_.connection);
+        if (!inst->proxy) {
+            std::fprintf(stderr, "no proxy for %s\n", name.c_str());
+            continue;
+        }
+        const Clock::time_point deadline = Clock::now() + std::chrono::seconds(10);
+        while (!inst->proxy->isAvailable() && Clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        if (!inst->proxy->isAvailable()) {
+            std::fprintf(stderr, "%s not available\n", name.c_str());
+            continue;
+        }
+        Instance* raw = inst.get();
+        inst->proxy->getFileChunkEvent().subscribe(
+            [this, raw](uint32_t index, const CommonAPI::ByteBuffer& data, bool last) {
+                onChunk(*raw, index, data, last);
+            });
+        instances_.push_back(std::move(inst));
+    }
+    if (instances_.empty()) return false;
+
+    CommonAPI::CallStatus status;
+    ft::FileTransfer::UpdateInfo info;
+    instances_[0]->proxy->requestUpdate(0, status, info);
+    if (status != CommonAPI::CallStatus::SUCCESS || !info.getExists() || info.getSize() == 0) {
+        std::fprintf(stderr, "no image offered\n");
+        return false;
+    }
+    latest_ = info.getNewVersion();
+    size_ = info.getSize();
+    crc_ = info.getCrc();
+    return true;
+}
+
+/*
+ * ==============================================================
+ * void onChunk(Instance& inst, uint32_t index, const CommonAPI::ByteBuffer& data, bool last)
+ * ==============================================================
+ * Runs on the CommonAPI dispatch thread, under the instance lock: once a
+ * client has released its instance, no chunk of it is in flight. Chunks
+ * before index 0 of the owner's transfer are the tail of the previous,
+ * abandoned one and are dropped, as is FEC parity.
+ */
+void Swarm::onChunk(Instance& inst, uint32_t index, const CommonAPI::ByteBuffer& data, bool last) {
+    if (index & FecDecoder::kParityFlag) return;
+
+    std::lock_guard<std::mutex> ik(inst.mutex);
+    Client* c = inst.owner;
+    if (!c) return;
+
+    {
+        std::lock_guard<std::mutex> lk(c->mutex);
+        if (c->transferDone || (c->expected == 0 && index != 0)) return;
+        if (index != c->expected || (c->abortAt != 0 && index + 1 == c->abortAt)) {
+            // Out of order on a reliable transport, or the injected abort
+            c->broken = index != c->expected;
+            c->aborted = !c->broken;
+            c->transferDone = true;
+            c->cv.notify_all();
+            return;
+        }
+        ++c->expected;
+    }
+
+    auto copy = std::make_shared<std::vector<uint8_t>>(data.begin(), data.end());
+    if (c->corruptAt == index + 1 && !copy->empty()) (*copy)[copy->size() / 2] ^= 0x5a;
+    writers_[c->id % writers_.size()]->push(WriteJob{c, copy, 0});
+
+    if (last) finishTransfer(*c);
+}
+
+void Swarm::finishTransfer(Client& c) {
+    {
+        std::lock_guard<std::mutex> lk(c.mutex);
+        c.transferDone = true;
+        c.cv.notify_all();
+    }
+    writers_[c.id % writers_.size()]->push(WriteJob{&c, nullptr, crc_});
+}
+
+/*
+ * ==============================================================
+ * Outcome attempt(Client& c, Instance& inst, double& waitSec)
+ * ==============================================================
+ * One pass of the client flow: check, wait for the instance, transfer,
+ * verify. The instance is released as soon as the chunks stop, so the
+ * CRC check of one client overlaps the transfer of the next.
+ */
+Swarm::Outcome Swarm::attempt(Client& c, Instance& inst, double& waitSec) {
+    CommonAPI::CallStatus status;
+    ft::FileTransfer::UpdateInfo info;
+    inst.proxy->requestUpdate(c.version, status, info);
+    if (status != CommonAPI::CallStatus::SUCCESS) return Outcome::Failed;
+    if (!info.getIsNew() || info.getResultCode() != 0) return Outcome::UpToDate;
+
+    const uint32_t chunks = static_cast<uint32_t>((size_ + 64 * 1024 - 1) / (64 * 1024));
+    std::uniform_int_distribution<unsigned> pct(0, 99);
+    std::uniform_int_distribution<uint32_t> at(1, std::max<uint32_t>(1, chunks - 1));
+    const bool abort = chunks > 1 && pct(c.rng) < o_.abortPct;
+    const bool corrupt = !abort && pct(c.rng) < o_.corruptPct;
+
+    // Queue for the instance
+    const Clock::time_point queued = Clock::now();
+    {
+        std::unique_lock<std::mutex> lk(inst.mutex);
+        const uint64_t ticket = inst.nextTicket++;
+        inst.cv.wait(lk, [&]() { return inst.serving == ticket; });
+
+        std::lock_guard<std::mutex> ck(c.mutex);
+        c.transferDone = c.verified = c.ok = c.aborted = c.broken = false;
+        c.expected = 0;
+        c.abortAt = abort ? at(c.rng) : 0;
+        c.corruptAt = corrupt ? at(c.rng) : 0;
+        c.crc = 0;
+        if (!o_.writeDir.empty()) {
+            const std::string path = o_.writeDir + "/client-" + std::to_string(c.id) + ".img";
+            c.out = std::fopen(path.c_str(), "wb");
+        }
+        inst.owner = &c;
+    }
+    waitSec = std::chrono::duration<double>(Clock::now() - queued).count();
+
+    bool accepted = false;
+    inst.proxy->startTransfer(o_.image, status, accepted);
+    bool transferred = false;
+    if (status == CommonAPI::CallStatus::SUCCESS && accepted) {
+        std::unique_lock<std::mutex> lk(c.mutex);
+        transferred = c.cv.wait_for(lk, std::chrono::seconds(o_.timeoutSec), [&]() { return c.transferDone; });
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(inst.mutex);
+        inst.owner = nullptr;
+        ++inst.serving;
+    }
+    inst.cv.notify_all();
+
+    // Anything but a complete transfer still has to flush its writer
+    bool complete;
+    {
+        std::lock_guard<std::mutex> lk(c.mutex);
+        complete = transferred && !c.aborted && !c.broken;
+    }
+    if (!complete) finishTransfer(c);
+
+    std::unique_lock<std::mutex> lk(c.mutex);
+    c.cv.wait(lk, [&]() { return c.verified; });
+
+    std::lock_guard<std::mutex> tk(totals_.mutex);
+    if (!accepted) ++totals_.refused;
+    if (c.aborted) ++totals_.aborted;
+    if (!complete) return Outcome::Failed;
+    if (!c.ok) {
+        if (c.corruptAt != 0) ++totals_.corrupted;
+        return Outcome::Failed;
+    }
+    totals_.bytes += size_;
+    return Outcome::Verified;
+}
+
+void Swarm::runClient(Client& c) {
+    Instance& inst = *instances_[c.id % instances_.size()];
+    std::exponential_distribution<double> think(o_.thinkMs > 0.0 ? 1.0 / o_.thinkMs : 1.0);
+
+    for (unsigned tries = 0; tries <= o_.retries; ++tries) {
+        if (o_.thinkMs > 0.0) std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(think(c.rng)));
+
+        const Clock::time_point start = Clock::now();
+        double waitSec = 0.0;
+        const Outcome outcome = attempt(c, inst, waitSec);
+        const double sec = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lk(totals_.mutex);
+        if (outcome == Outcome::UpToDate) {
+            ++totals_.upToDate;
+            return;
+        }
+        if (outcome == Outcome::Verified) {
+            totals_.completionSec.push_back(sec);
+            totals_.waitSec.push_back(waitSec);
+            return;
+        }
+        if (tries < o_.retries) ++totals_.retries;
+    }
+    std::lock_guard<std::mutex> lk(totals_.mutex);
+    ++totals_.failed;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const Options o = optionsFromEnv(argc, argv);
+
+    Swarm swarm(o);
+    if (!swarm.connect()) {
+        std::fprintf(stderr, "no service\n");
+        return 1;
+    }
+
+    // Version skew: a share of the fleet is current, the rest 1..skew behind
+    std::vector<std::unique_ptr<Client>> clients;
+    std::mt19937 seed(42);
+    std::uniform_int_distribution<unsigned> pct(0, 99);
+    std::uniform_int_distribution<unsigned> behind(1, o.skew);
+    for (size_t i = 0; i < o.clients; ++i) {
+        std::unique_ptr<Client> c(new Client());
+        c->id = i;
+        c->rng.seed(seed());
+        const uint32_t latest = swarm.latestVersion();
+        c->version = pct(seed) < o.upToDatePct ? latest : latest - std::min<uint32_t>(latest, behind(seed));
+        clients.push_back(std::move(c));
+    }
+
+    const pid_t gateway = findGateway();
+    const double gatewayCpu0 = gateway > 0 ? processCpuSec(gateway) : -1.0;
+    const double selfCpu0 = selfCpuSec();
+    const Clock::time_point start = Clock::now();
+
+    std::vector<std::thread> threads;
+    for (auto& c : clients) {
+        Client* raw = c.get();
+        threads.emplace_back([&swarm, raw]() { swarm.runClient(*raw); });
+    }
+    for (std::thread& t : threads) t.join();
+
+    const double wall = std::chrono::duration<double>(Clock::now() - start).count();
+    const double gatewayCpu1 = gateway > 0 ? processCpuSec(gateway) : -1.0;
+    const double selfCpu = selfCpuSec() - selfCpu0;
+
+    Totals& t = swarm.totals();
+    std::printf("clients %zu, instances %zu, writers %u, think %.0f ms\n", o.clients, o.instances.size(),
+                o.writers, o.thinkMs);
+    std::printf("verified %zu  up-to-date %u  failed %u  retries %u (aborted %u, corrupt %u, refused %u)\n",
+                t.completionSec.size(), t.upToDate, t.failed, t.retries, t.aborted, t.corrupted, t.refused);
+    std::printf("throughput %.1f MiB/s over %.1f s\n", static_cast<double>(t.bytes) / (1024.0 * 1024.0) / wall,
+                wall);
+    std::printf("completion p50 %.2f s  p90 %.2f s  p99 %.2f s  max %.2f s  (queued p50 %.2f s)\n",
+                percentile(t.completionSec, 0.5), percentile(t.completionSec, 0.9),
+                percentile(t.completionSec, 0.99), percentile(t.completionSec, 1.0), percentile(t.waitSec, 0.5));
+    if (gatewayCpu0 >= 0.0 && gatewayCpu1 >= 0.0) {
+        std::printf("gateway cpu %.0f%% (pid %d)  swarm cpu %.0f%%\n", 100.0 * (gatewayCpu1 - gatewayCpu0) / wall,
+                    static_cast<int>(gateway), 100.0 * selfCpu / wall);
+    } else {
+        std::printf("gateway cpu n/a  swarm cpu %.0f%%\n", 100.0 * selfCpu / wall);
+    }
+    return t.failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * ==============================================================
+ * thermal_sim
+ * ==============================================================
+ * Runs ThermalGovernor against a first-order thermal model of a fanless
+ * board during a long transfer and compares it with running flat out into
+ * the firmware throttle.
+ * - SoC power grows with the transfer rate; temperature follows
+ *   dT/dt = (ambient + k * rate - T) / tau.
+ * - Above 80 C the "firmware" halves the achievable rate until the SoC
+ *   is back under 75 C (boost-then-throttle).
+ *
+ * Usage: thermal_sim [seconds] [link MB/s]
+ *
+ * To exercise the real backend instead, point it at a fake zone:
+ *   echo 70000 > /tmp/fake_temp && OTA_THERMAL_ZONE=/tmp/fake_temp appqnxOta
+ * and write new millidegree values into the file while downloading.
+ */
+
+#include "ThermalGovernor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+struct Result {
+    double megabytes = 0.0;
+    double peakC = 0.0;
+    double rateStdDev = 0.0;
+    int firmwareThrottledSec = 0;
+};
+
+const double kAmbientC = 45.0;
+const double kTauSec = 120.0;
+const double kCPerMBps = 0.45;     // steady-state rise per MB/s
+const double kFirmwareTripC = 80.0;
+const double kFirmwareReleaseC = 75.0;
+
+Result simulate(int seconds, double linkMBps, bool governed) {
+    ThermalGovernor::Config config;
+    config.maxWorkers = 4;
+    ThermalGovernor governor(config);
+
+    Result r;
+    double tempC = 55.0;
+    bool firmwareThrottled = false;
+    double sum = 0.0, sumSq = 0.0;
+
+    for (int t = 0; t < seconds; ++t) {
+        double rate = linkMBps;
+        if (governed && governor.rateLimitBps()) {
+            rate = std::min(rate, governor.rateLimitBps() / (1024.0 * 1024.0));
+        }
+
+        if (tempC >= kFirmwareTripC) firmwareThrottled = true;
+        if (tempC < kFirmwareReleaseC) firmwareThrottled = false;
+        if (firmwareThrottled) {
+            rate *= 0.5;
+            ++r.firmwareThrottledSec;
+        }
+
+        tempC += (kAmbientC + kCPerMBps * rate - tempC) / kTauSec;
+        r.peakC = std::max(r.peakC, tempC);
+        r.megabytes += rate;
+        sum += rate;
+        sumSq += rate * rate;
+
+        // The governor sees one reading every 2 s, like the foreground profile
+        if (governed && t % 2 == 0) governor.update(t, tempC, rate * 1024.0 * 1024.0);
+    }
+
+    const double mean = sum / seconds;
+    r.rateStdDev = std::sqrt(std::max(0.0, sumSq / seconds - mean * mean));
+    return r;
+}
+
+void print(const char* name, const Result& r, int seconds) {
+    std::printf("%-12s %8.0f MB  %6.1f MB/s avg  %5.1f MB/s stddev  peak %5.1f C  firmware throttled %4d s\n",
+                name, r.megabytes, r.megabytes / seconds, r.rateStdDev, r.peakC, r.firmwareThrottledSec);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int seconds = argc > 1 ? std::atoi(argv[1]) : 1800;
+    const double linkMBps = argc > 2 ? std::atof(argv[2]) : 90.0;
+
+    std::printf("%d s transfer, link %.0f MB/s, ceiling %.0f C\n", seconds, linkMBps,
+                ThermalGovernor::Config().ceilingC);
+    print("unmanaged", simulate(seconds, linkMBps, false), seconds);
+    print("governed", simulate(seconds, linkMBps, true), seconds);
+    return 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * ==============================================================
+ * transport_bench
+ * ==============================================================
+ * Downloads the offered image [runs] times over whatever transport the
+ * environment selects (VSOMEIP_CONFIGURATION, OTA_TRANSPORT, OTA_FEC) and
+ * prints one result line: median throughput and, on UDP or multicast,
+ * the repair and FEC counters of the last run.
+ * - bench/netem_compare.sh: TCP against UDP under tc netem loss / delay
+ * - bench/multicast_demo.sh: several clients of one multicast stream
+ *
+ * Usage: transport_bench [runs] [label]
+ */
+
+#include "OtaBackend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    const int runs = argc > 1 ? std::atoi(argv[1]) : 3;
+    const std::string label = argc > 2 ? argv[2] : "-";
+
+    OtaConfig config = OtaConfig::fromEnv();
+    config.manifestName.clear();
+    config.rangeStreams = 1;
+
+    OtaBackend backend("rpi4-update.wic", config);
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false, ok = false;
+
+    backend.setFinishedCallback([&]() {
+        std::lock_guard<std::mutex> lk(mutex);
+        done = ok = true;
+        cv.notify_all();
+    });
+    backend.setErrorCallback([&](const std::string& msg) {
+        std::fprintf(stderr, "error: %s\n", msg.c_str());
+        std::lock_guard<std::mutex> lk(mutex);
+        done = true;
+        ok = false;
+        cv.notify_all();
+    });
+
+    if (!backend.init() || !backend.requestUpdate(0) || backend.updateSize() == 0) {
+        std::fprintf(stderr, "no service or no image offered\n");
+        return 1;
+    }
+    const double mib = static_cast<double>(backend.updateSize()) / (1024.0 * 1024.0);
+
+    std::vector<double> rates;
+    int failed = 0;
+    for (int i = 0; i < runs; ++i) {
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            done = ok = false;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        if (backend.startDownload() != OtaBackend::StartResult::Started) {
+            ++failed;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lk(mutex);
+        if (!cv.wait_for(lk, std::chrono::seconds(600), [&]() { return done; }) || !ok) {
+            ++failed;
+            continue;
+        }
+        const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        rates.push_back(mib / sec);
+    }
+
+    std::sort(rates.begin(), rates.end());
+    const double median = rates.empty() ? 0.0 : rates[rates.size() / 2];
+    const OtaBackend::RepairStats repair = backend.repairStats();
+
+    std::printf("%-24s %-4s %8.1f MiB/s  %d/%d ok  nacks %llu repaired %llu fec %llu dup %llu\n",
+                label.c_str(), backend.isUnreliableTransport() ? "udp" : "tcp", median,
+                runs - failed, runs,
+                static_cast<unsigned long long>(repair.nacks),
+                static_cast<unsigned long long>(repair.repairedChunks),
+                static_cast<unsigned long long>(repair.fecRebuilt),
+                static_cast<unsigned long long>(repair.duplicates));
+
+    backend.stop();
+    return failed == runs ? 1 : 0;
+}
@@ -0,0 +1,127 @@
+#include "JsonWriter.h"
+
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+
+JsonWriter::JsonWriter()
+    : out_("{") {}
+
+void JsonWriter::key(const char* key) {
+    if (!first_) out_ += ',';
+    first_ = false;
+    out_ += '"';
+    out_ += key;
+    out_ += "\":";
+}
+
+JsonWriter& JsonWriter::add(const char* k, const std::string& value) {
+    key(k);
+    out_ += '"';
+    for (const char c : value) {
+        switch (c) {
+            case '"': out_ += "\\\""; break;
+            case '\\': out_ += "\\\\"; break;
+            case '\n': out_ += "\\n"; break;
+            case '\r': out_ += "\\r"; break;
+            case '\t': out_ += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+                    out_ += buf;
+                } else {
+                    out_ += c;
+                }
+        }
+    }
+    out_ += '"';
+    return *this;
+}
+
+JsonWriter& JsonWriter::add(const char* k, const char* value) {
+    return add(k, std::string(value ? value : ""));
+}
+
+JsonWriter& JsonWriter::add(const char* k, bool value) {
+    key(k);
+    out_ += value ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::add(const char* k, int value) {
+    return add(k, static_cast<int64_t>(value));
+}
+
+JsonWriter& JsonWriter::add(const char* k, unsigned value) {
+    return add(k, static_cast<uint64_t>(value));
+}
+
+JsonWriter& JsonWriter::add(const char* k, int64_t value) {
+    key(k);
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "%" PRId64, value);
+    out_ += buf;
+    return *this;
+}
+
+JsonWriter& JsonWriter::add(const char* k, uint64_t value) {
+    key(k);
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "%" PRIu64, value);
+    out_ += buf;
+    return *this;
+}
+
+JsonWriter& JsonWriter::add(const char* k, double value) {
+    if (!std::isfinite(value)) return addNull(k);
+    key(k);
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.6g", value);
+    out_ += buf;
+    return *this;
+}
+
+JsonWriter& JsonWriter::addNull(const char* k) {
+    key(k);
+    out_ += "null";
+    return *this;
+}
+
+JsonWriter& JsonWriter::addArray(const char* k, const int* values, size_t count) {
+    key(k);
+    out_ += '[';
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) out_ += ',';
+        out_ += std::to_string(values[i]);
+    }
+    out_ += ']';
+    return *this;
+}
+
+JsonWriter& JsonWriter::begin(const char* k) {
+    key(k);
+    out_ += '{';
+    ++depth_;
+    first_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::end() {
+    if (depth_ == 0) return *this;
+    out_ += '}';
+    --depth_;
+    first_ = false;
+    return *this;
+}
+
+std::string JsonWriter::str() const {
+    return out_ + std::string(static_cast<size_t>(depth_) + 1, '}');
+}
+
+void JsonWriter::print() const {
+    const std::string line = str();
+    std::fwrite(line.data(), 1, line.size(), stdout);
+    std::fputc('\n', stdout);
+    std::fflush(stdout);
+}
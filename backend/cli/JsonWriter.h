@@ -0,0 +1,50 @@
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * ==============================================================
+ * JsonWriter
+ * ==============================================================
+ * One JSON object on one line, built field by field: the output format
+ * of ota-cli, one object per result or event, so a script can read it
+ * line by line (NDJSON). Keys are literals and not escaped; string
+ * values are. Non-finite doubles are written as null.
+ */
+class JsonWriter {
+   public:
+    JsonWriter();
+
+    JsonWriter& add(const char* key, const std::string& value);
+    JsonWriter& add(const char* key, const char* value);
+    JsonWriter& add(const char* key, bool value);
+    JsonWriter& add(const char* key, int value);
+    JsonWriter& add(const char* key, unsigned value);
+    JsonWriter& add(const char* key, int64_t value);
+    JsonWriter& add(const char* key, uint64_t value);
+    JsonWriter& add(const char* key, double value);
+    JsonWriter& addNull(const char* key);
+    JsonWriter& addArray(const char* key, const int* values, size_t count);
+
+    // Nested object: fields up to end() go into it
+    JsonWriter& begin(const char* key);
+    JsonWriter& end();
+
+    // The object, closed, without a newline
+    std::string str() const;
+
+    // Writes str() and a newline to stdout and flushes
+    void print() const;
+
+   private:
+    void key(const char* key);
+
+    std::string out_;
+    int depth_ = 0;
+    bool first_ = true;
+};
+
+#endif  // JSONWRITER_H
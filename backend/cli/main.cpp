@@ -0,0 +1,573 @@
+/*
+ * ==============================================================
+ * ota-cli
+ * ==============================================================
+ * Headless front end of OtaBackend, for scripts, benchmarks and devices
+ * without a display: the same backend as the dashboard, no Qt.
+ *
+ *   check     ask the service (or, with --cached, the disk cache) for an
+ *             update to the version in the version file
+ *   download  check, then download the update and verify its CRC
+ *   verify    CRC of the downloaded image against the announced one
+ *   apply     verify, then record the new version in the version file;
+ *             --reboot reboots as the dashboard's Install does
+ *   monitor   system info snapshots as the backend publishes them
+ *
+ * Output is JSON, one object per line on stdout: events while a command
+ * runs ("event"), then one result ("command", "ok", "error" on failure)
+ * with the startup and total time and the peak RSS of the process.
+ * Logs go to the log file / OTA_LOG_SINKS as usual, never to stdout.
+ * Exit status: 0 ok, 1 failed, 2 usage, 3 timeout.
+ * SIGINT / SIGTERM end a download or a monitor run cleanly.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "JsonWriter.h"
+#include "OtaBackend.h"
+#include "UpdateVerifier.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const Clock::time_point gStart = Clock::now();
+sigset_t gSignals;
+std::mutex gPrintMutex;     // events come from backend threads
+
+struct Options {
+    std::string command;
+    std::string image = "rpi4-update.wic";
+    OtaConfig config = OtaConfig::fromEnv();
+    std::string versionFile = UPDATE_VERSION_PATH;
+    std::string file;               // verify / apply: image to check
+    std::string profile = "foreground";
+    bool haveCrc = false;
+    uint32_t crc = 0;
+    bool haveVersion = false;
+    uint32_t version = 0;
+    bool cached = false;
+    bool force = false;
+    bool background = false;
+    bool progress = false;
+    bool reboot = false;
+    long timeoutSec = 0;            // 0: none
+    long count = 0;                 // monitor: 0 until interrupted
+};
+
+// State shared with the backend callbacks
+struct Events {
+    std::mutex mutex;
+    std::string error;
+    std::atomic<bool> finished{false};
+    std::atomic<bool> failed{false};
+    std::atomic<long> samples{0};
+    Clock::time_point finishedAt;
+};
+
+enum class Wait { Done, Timeout, Interrupted };
+
+void usage(const char* argv0) {
+    std::fprintf(stderr,
+                 "usage: %s <command> [options]\n"
+                 "commands:\n"
+                 "  check     [--cached]\n"
+                 "  download  [--force] [--background] [--progress]\n"
+                 "  verify    [--file PATH] [--crc CRC]\n"
+                 "  apply     [--file PATH] [--crc CRC] [--version N] [--reboot]\n"
+                 "  monitor   [--count N] [--profile foreground|idle|background]\n"
+                 "options:\n"
+                 "  --image NAME         image to request (rpi4-update.wic)\n"
+                 "  --data-dir DIR       download directory (OTA_DATA_DIR)\n"
+                 "  --version-file PATH  installed version (%s)\n"
+                 "  --timeout SEC        give up after SEC seconds\n",
+                 argv0, UPDATE_VERSION_PATH);
+}
+
+// Decimal or 0x hex, as in the version file
+bool parseUint32(const char* text, uint32_t& out) {
+    if (!text || !*text) return false;
+    char* end = nullptr;
+    const bool hex = std::strncmp(text, "0x", 2) == 0 || std::strncmp(text, "0X", 2) == 0;
+    const unsigned long long v = std::strtoull(hex ? text + 2 : text, &end, hex ? 16 : 10);
+    if (*end != '\0' || v > 0xffffffffULL) return false;
+    out = static_cast<uint32_t>(v);
+    return true;
+}
+
+bool parseOptions(int argc, char** argv, Options& o) {
+    if (argc < 2) return false;
+    o.command = argv[1];
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        const auto take = [&]() { ++i; return value != nullptr; };
+
+        if (arg == "--cached") {
+            o.cached = true;
+        } else if (arg == "--force") {
+            o.force = true;
+        } else if (arg == "--background") {
+            o.background = true;
+        } else if (arg == "--progress") {
+            o.progress = true;
+        } else if (arg == "--reboot") {
+            o.reboot = true;
+        } else if (arg == "--image" && take()) {
+            o.image = value;
+        } else if (arg == "--data-dir" && take()) {
+            o.config.dataDir = value;
+            if (!o.config.dataDir.empty() && o.config.dataDir.back() != '/') o.config.dataDir += '/';
+        } else if (arg == "--version-file" && take()) {
+            o.versionFile = value;
+        } else if (arg == "--file" && take()) {
+            o.file = value;
+        } else if (arg == "--profile" && take()) {
+            o.profile = value;
+        } else if (arg == "--crc" && take()) {
+            if (!parseUint32(value, o.crc)) return false;
+            o.haveCrc = true;
+        } else if (arg == "--version" && take()) {
+            if (!parseUint32(value, o.version)) return false;
+            o.haveVersion = true;
+        } else if (arg == "--timeout" && take()) {
+            o.timeoutSec = std::atol(value);
+        } else if (arg == "--count" && take()) {
+            o.count = std::atol(value);
+        } else {
+            return false;
+        }
+    }
+    return o.command == "check" || o.command == "download" || o.command == "verify" ||
+           o.command == "apply" || o.command == "monitor";
+}
+
+// Same rules as the dashboard: first line, decimal or 0x hex
+bool readVersion(const std::string& path, uint32_t& out) {
+    std::ifstream in(path);
+    std::string line;
+    if (!std::getline(in, line)) return false;
+    line.erase(std::remove_if(line.begin(), line.end(), ::isspace), line.end());
+    return parseUint32(line.c_str(), out);
+}
+
+// Written next to the file, synced and renamed over it, then the rename
+// is synced through the directory: after a crash or the reboot that
+// follows apply, the file holds the old or the new version, never half
+// of one and never none
+bool writeVersion(const std::string& path, uint32_t version) {
+    const std::string tmp = path + ".tmp";
+    const std::string text = std::to_string(version) + "\n";
+
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    const bool ok = ::write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size()) && fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        ::unlink(tmp.c_str());
+        return false;
+    }
+
+    const size_t slash = path.find_last_of('/');
+    const std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    const int dirFd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd < 0) return false;
+    const bool synced = fsync(dirFd) == 0;
+    ::close(dirFd);
+    return synced;
+}
+
+double msSince(Clock::time_point t) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+}
+
+std::string hex32(uint32_t v) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "0x%08x", v);
+    return buf;
+}
+
+void emit(const JsonWriter& w) {
+    std::lock_guard<std::mutex> lk(gPrintMutex);
+    w.print();
+}
+
+// Polls done() every 100 ms; SIGINT / SIGTERM end the wait
+Wait waitUntil(const std::function<bool()>& done, long timeoutSec) {
+    const Clock::time_point deadline = Clock::now() + std::chrono::seconds(timeoutSec);
+    const timespec tick = {0, 100 * 1000000L};
+    while (!done()) {
+        if (timeoutSec > 0 && Clock::now() >= deadline) return Wait::Timeout;
+        const int sig = sigtimedwait(&gSignals, nullptr, &tick);
+        if (sig == SIGINT || sig == SIGTERM) return Wait::Interrupted;
+    }
+    return Wait::Done;
+}
+
+class Cli {
+   public:
+    explicit Cli(const Options& options)
+        : o_(options),
+          backend_(options.image, options.config) {
+        constructMs_ = msSince(gStart);
+        backend_.setErrorCallback([this](const std::string& msg) {
+            std::lock_guard<std::mutex> lk(events_.mutex);
+            events_.error = msg;
+            events_.failed = true;
+        });
+        if (!readVersion(o_.versionFile, current_)) current_ = 0;
+    }
+
+    int run() {
+        if (o_.command == "check") return check();
+        if (o_.command == "download") return download();
+        if (o_.command == "verify") return verify();
+        if (o_.command == "apply") return apply();
+        return monitor();
+    }
+
+   private:
+    // The service is only brought up by commands that need it
+    bool connect() {
+        if (connected_) return true;
+        const Clock::time_point t = Clock::now();
+        connected_ = backend_.init();
+        initMs_ = msSince(t);
+        return connected_;
+    }
+
+    std::string lastError(const char* fallback) {
+        std::lock_guard<std::mutex> lk(events_.mutex);
+        return events_.error.empty() ? fallback : events_.error;
+    }
+
+    // Adds the common fields, prints the result and gives the exit status
+    int finish(JsonWriter& w, bool ok, const std::string& error, int failStatus = 1) {
+        w.add("ok", ok);
+        if (!ok) w.add("error", error);
+        rusage ru;
+        getrusage(RUSAGE_SELF, &ru);
+        w.begin("process")
+            .add("construct_ms", constructMs_)
+            .add("init_ms", connected_ ? initMs_ : 0.0)
+            .add("total_ms", msSince(gStart))
+            .add("max_rss_kb", static_cast<int64_t>(ru.ru_maxrss))
+            .end();
+        emit(w);
+        backend_.stop();
+        return ok ? 0 : failStatus;
+    }
+
+    void addUpdateInfo(JsonWriter& w, const ft::FileTransfer::UpdateInfo& info) {
+        w.add("exists", info.getExists())
+            .add("is_new", info.getIsNew())
+            .add("new_version", info.getNewVersion())
+            .add("size", static_cast<uint64_t>(info.getSize()))
+            .add("crc", hex32(info.getCrc()))
+            .add("result_code", static_cast<int>(info.getResultCode()));
+    }
+
+    /*
+     * ==============================================================
+     * bool fetchUpdate(bool preferCache, std::string& source)
+     * ==============================================================
+     * Update info for the installed version: from the disk cache if
+     * allowed and fresh (no service needed), else from the service.
+     */
+    bool fetchUpdate(bool preferCache, std::string& source) {
+        if (preferCache && backend_.loadCachedUpdate(current_)) {
+            source = "cache";
+            return true;
+        }
+        source = "service";
+        return connect() && backend_.requestUpdate(current_, OtaBackend::CheckPolicy::Refresh);
+    }
+
+    int check() {
+        JsonWriter w;
+        w.add("command", "check").add("current", current_);
+        std::string source;
+        bool ok = false;
+        if (o_.cached) {
+            ok = backend_.loadCachedUpdate(current_);
+            source = "cache";
+        } else {
+            ok = fetchUpdate(false, source);
+        }
+        w.add("source", source);
+        if (!ok) return finish(w, false, o_.cached ? "no fresh cached answer" : lastError("update check failed"));
+        addUpdateInfo(w, backend_.updateInfo());
+        return finish(w, true, "");
+    }
+
+    int download() {
+        JsonWriter w;
+        w.add("command", "download").add("current", current_);
+        std::string source;
+        if (!fetchUpdate(false, source)) return finish(w, false, lastError("update check failed"));
+        const ft::FileTransfer::UpdateInfo info = backend_.updateInfo();
+        addUpdateInfo(w, info);
+        if (!info.getExists() || info.getResultCode() != 0 || info.getSize() == 0) {
+            return finish(w, false, "no update offered");
+        }
+        if (!info.getIsNew() && !o_.force) {
+            w.add("downloaded", false);
+            return finish(w, true, "");
+        }
+
+        int lastPercent = -1;
+        backend_.setProgressCallback([this, &lastPercent](int percent) {
+            if (!o_.progress || percent == lastPercent) return;
+            lastPercent = percent;
+            JsonWriter e;
+            e.add("event", "progress").add("percent", percent).add("elapsed_ms", msSince(gStart));
+            emit(e);
+        });
+        backend_.setFinishedCallback([this]() {
+            std::lock_guard<std::mutex> lk(events_.mutex);
+            events_.finishedAt = Clock::now();
+            events_.finished = true;
+        });
+        if (o_.background) backend_.setTransferClass(OtaBackend::TransferClass::Background);
+
+        const Clock::time_point start = Clock::now();
+        {
+            std::lock_guard<std::mutex> lk(events_.mutex);
+            events_.error.clear();
+            events_.failed = false;
+        }
+        if (backend_.startDownload() != OtaBackend::StartResult::Started) return finish(w, false, lastError("download not started"));
+
+        const Wait result = waitUntil([this]() { return events_.finished || events_.failed; }, o_.timeoutSec);
+        if (result != Wait::Done || !events_.finished) {
+            w.add("downloaded", false);
+            if (result == Wait::Timeout) return finish(w, false, "timeout", 3);
+            return finish(w, false, result == Wait::Interrupted ? "interrupted" : lastError("download failed"));
+        }
+
+        double sec = 0.0;
+        {
+            std::lock_guard<std::mutex> lk(events_.mutex);
+            sec = std::chrono::duration<double>(events_.finishedAt - start).count();
+        }
+        const double bytes = static_cast<double>(backend_.updateSize());
+        w.add("downloaded", true)
+            .add("path", backend_.dataDir_ + backend_.outputFilename_)
+            .add("seconds", sec)
+            .add("mib_s", sec > 0.0 ? bytes / (1024.0 * 1024.0) / sec : 0.0)
+            .add("transport", backend_.isUnreliableTransport() ? "udp" : "tcp");
+        const OtaBackend::RepairStats r = backend_.repairStats();
+        w.begin("repair")
+            .add("nacks", r.nacks)
+            .add("repaired", r.repairedChunks)
+            .add("duplicates", r.duplicates)
+            .add("fec_rebuilt", r.fecRebuilt)
+            .add("refused", r.refused)
+            .add("slices", r.slices)
+            .end();
+        return finish(w, true, "");
+    }
+
+    /*
+     * ==============================================================
+     * bool verifyImage(JsonWriter& w, uint32_t& newVersion, std::string& error)
+     * ==============================================================
+     * CRC of the image against --crc, else against the update info (cache
+     * first, then the service). Hashes with every core: nothing else
+     * runs in this process.
+     */
+    bool verifyImage(JsonWriter& w, uint32_t& newVersion, std::string& error) {
+        const std::string path = o_.file.empty() ? backend_.dataDir_ + backend_.outputFilename_ : o_.file;
+        w.add("path", path);
+
+        uint32_t expected = o_.crc;
+        newVersion = o_.version;
+        if (!o_.haveCrc || !o_.haveVersion) {
+            std::string source;
+            if (!fetchUpdate(true, source)) {
+                error = o_.haveCrc ? "no update info for the new version, pass --version"
+                                   : lastError("no CRC to check against, pass --crc");
+                return false;
+            }
+            w.add("source", source);
+            const ft::FileTransfer::UpdateInfo info = backend_.updateInfo();
+            if (!o_.haveCrc) expected = info.getCrc();
+            if (!o_.haveVersion) newVersion = info.getNewVersion();
+        }
+        if (expected == 0) {
+            error = "no CRC announced for this update";
+            return false;
+        }
+
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            error = "cannot read " + path;
+            return false;
+        }
+        const unsigned workers = std::max(1u, std::thread::hardware_concurrency());
+        const Clock::time_point t = Clock::now();
+        uint32_t actual = 0;
+        if (!UpdateVerifier::computeCrc(path, workers, [workers]() { return workers; }, actual)) {
+            error = "cannot read " + path;
+            return false;
+        }
+        const double ms = msSince(t);
+        w.add("size", static_cast<uint64_t>(st.st_size))
+            .add("crc", hex32(actual))
+            .add("expected", hex32(expected))
+            .add("verify_ms", ms)
+            .add("mib_s", ms > 0.0 ? static_cast<double>(st.st_size) / (1024.0 * 1024.0) / (ms / 1000.0) : 0.0);
+        if (actual != expected) {
+            error = "CRC mismatch";
+            return false;
+        }
+        return true;
+    }
+
+    int verify() {
+        JsonWriter w;
+        w.add("command", "verify");
+        uint32_t version = 0;
+        std::string error;
+        const bool ok = verifyImage(w, version, error);
+        return finish(w, ok, error);
+    }
+
+    int apply() {
+        JsonWriter w;
+        w.add("command", "apply").add("previous", current_);
+        uint32_t version = 0;
+        std::string error;
+        if (!verifyImage(w, version, error)) return finish(w, false, error);
+        if (version == 0) return finish(w, false, "unknown new version, pass --version");
+        if (!writeVersion(o_.versionFile, version)) {
+            return finish(w, false, "cannot write " + o_.versionFile);
+        }
+        w.add("version", version).add("version_file", o_.versionFile).add("reboot", o_.reboot);
+
+        if (o_.reboot) {
+            const pid_t pid = fork();
+            if (pid == 0) {
+                setsid();
+                execlp("systemctl", "systemctl", "reboot", static_cast<char*>(nullptr));
+                _exit(127);
+            }
+            if (pid < 0) return finish(w, false, "cannot start systemctl");
+        }
+        return finish(w, true, "");
+    }
+
+    static void addSnapshot(JsonWriter& e, const OtaBackend::SystemInfoSnapshot& s) {
+        e.add("timestamp_ms", s.timestampMs)
+            .add("cpu_percent", s.cpuPercent)
+            .addArray("core_percent", s.coreCpuPercent, static_cast<size_t>(s.coreCount))
+            .add("iowait_percent", s.iowaitPercent)
+            .add("load1", s.loadAverage1)
+            .add("mem_used", s.memUsedBytes)
+            .add("mem_total", s.memTotalBytes)
+            .add("storage_used", s.storageUsedBytes)
+            .add("storage_total", s.storageTotalBytes)
+            .add("temperature_c", s.temperatureC)
+            .add("uptime_s", s.uptimeSeconds)
+            .begin("self")
+            .add("cpu_percent", s.selfCpuPercent)
+            .add("rss", s.selfRssBytes)
+            .add("threads", s.selfThreads)
+            .end()
+            .begin("disk")
+            .add("read_bps", s.diskReadBps)
+            .add("write_bps", s.diskWriteBps)
+            .add("iops", s.diskIops)
+            .add("util_percent", s.diskUtilPercent)
+            .end()
+            .begin("net")
+            .add("interface", std::string(s.netInterface))
+            .add("rx_bps", s.netRxBps)
+            .add("tx_bps", s.netTxBps)
+            .add("link_mbps", s.netLinkMbps)
+            .end()
+            .begin("pressure")
+            .add("memory", s.memoryPressure)
+            .add("io", s.ioPressure)
+            .end()
+            .add("download_window", s.downloadWindow)
+            .add("rate_limit_bps", s.rateLimitBps);
+    }
+
+    int monitor() {
+        JsonWriter w;
+        w.add("command", "monitor").add("profile", o_.profile);
+        if (o_.profile == "idle") {
+            backend_.setActivityProfile(OtaBackend::ActivityProfile::Idle);
+        } else if (o_.profile == "background") {
+            backend_.setActivityProfile(OtaBackend::ActivityProfile::Background);
+        }
+
+        backend_.setSystemInfoCallback([this](const OtaBackend::SystemInfoSnapshot& s) {
+            if (o_.count > 0 && events_.samples >= o_.count) return;
+            JsonWriter e;
+            e.add("event", "system");
+            addSnapshot(e, s);
+            emit(e);
+            ++events_.samples;
+        });
+        backend_.setAvailabilityCallback([](bool available) {
+            JsonWriter e;
+            e.add("event", "availability").add("available", available);
+            emit(e);
+        });
+        if (!connect()) return finish(w, false, lastError("service not available"));
+
+        const Wait result = waitUntil([this]() { return o_.count > 0 && events_.samples >= o_.count; },
+                                      o_.timeoutSec);
+        w.add("samples", static_cast<int64_t>(events_.samples.load()));
+        // Ended by the user or the timeout: a monitor run has no other end
+        return finish(w, result != Wait::Timeout || o_.count == 0, "timeout", 3);
+    }
+
+    const Options o_;
+    OtaBackend backend_;
+    Events events_;
+    uint32_t current_ = 0;
+    bool connected_ = false;
+    double constructMs_ = 0.0;
+    double initMs_ = 0.0;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // Taken by sigtimedwait() in waitUntil(), in no other thread
+    sigemptyset(&gSignals);
+    sigaddset(&gSignals, SIGINT);
+    sigaddset(&gSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &gSignals, nullptr);
+
+    Cli cli(options);
+    return cli.run();
+}
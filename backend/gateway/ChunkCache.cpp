@@ -0,0 +1,184 @@
+#include "ChunkCache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Crc32.h"
+#include "OtaLog.h"
+#include "UpdateManifest.h"
+
+ChunkCache::Image::~Image() {
+    if (data) munmap(const_cast<uint8_t*>(data), size);
+}
+
+uint32_t ChunkCache::Image::crc() const {
+    std::call_once(crcOnce_, [this]() { crc_ = crc32::update(0, data, size); });
+    return crc_;
+}
+
+ChunkCache::ChunkCache(const std::string& dir, size_t chunkSize, size_t capacityBytes)
+    : dir_(dir.empty() || dir.back() == '/' ? dir : dir + "/"),
+      chunkSize_(chunkSize),
+      capacity_(capacityBytes) {}
+
+/*
+ * ==============================================================
+ * ImagePtr open(const std::string& name)
+ * ==============================================================
+ * Returns the current mapping of the file, mapping it (again) when it is
+ * new or changed on disk. The stat() per call is cheap next to a transfer
+ * and lets an image be replaced without restarting the gateway.
+ */
+ChunkCache::ImagePtr ChunkCache::open(const std::string& name) {
+    if (!UpdateManifest::isSafeName(name)) return nullptr;
+
+    const std::string path = dir_ + name;
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) return nullptr;
+    const int64_t mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+
+    std::lock_guard<std::mutex> lk(imagesMutex_);
+    auto it = images_.find(name);
+    if (it != images_.end() && it->second->size == static_cast<uint64_t>(st.st_size) &&
+        it->second->mtimeNs == mtimeNs) {
+        return it->second;
+    }
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    void* base = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        OTA_LOG_ERROR("Gateway", "mmap of {} failed: {}", path, std::strerror(errno));
+        return nullptr;
+    }
+
+    auto image = std::make_shared<Image>();
+    image->id = nextImageId_++;
+    image->name = name;
+    image->size = static_cast<uint64_t>(st.st_size);
+    image->mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    image->data = static_cast<const uint8_t*>(base);
+
+    OTA_LOG_INFO("Gateway", "Mapped {} ({} bytes)", path, image->size);
+    images_[name] = image;
+    return image;
+}
+
+uint32_t ChunkCache::chunkCount(const Image& image) const {
+    return static_cast<uint32_t>((image.size + chunkSize_ - 1) / chunkSize_);
+}
+
+ChunkCache::Buffer ChunkCache::lookup(const Key& key) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        ++misses_;
+        return nullptr;
+    }
+    ++hits_;
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    return it->second.buffer;
+}
+
+/*
+ * ==============================================================
+ * void insert(const Key& key, const Buffer& buffer)
+ * ==============================================================
+ * Two transfers missing the same chunk at once both read it; the second
+ * insert just refreshes the entry. Evicted buffers stay valid for the
+ * sends still holding them.
+ */
+void ChunkCache::insert(const Key& key, const Buffer& buffer) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        return;
+    }
+    lru_.push_front(key);
+    entries_[key] = Entry{buffer, lru_.begin()};
+    bytes_ += buffer->size();
+
+    while (bytes_ > capacity_ && lru_.size() > 1) {
+        auto victim = entries_.find(lru_.back());
+        bytes_ -= victim->second.buffer->size();
+        entries_.erase(victim);
+        lru_.pop_back();
+    }
+}
+
+ChunkCache::Buffer ChunkCache::chunk(const ImagePtr& image, uint32_t index) {
+    const uint64_t offset = static_cast<uint64_t>(index) * chunkSize_;
+    if (!image || offset >= image->size) return nullptr;
+
+    const Key key{image->id, index};
+    if (Buffer cached = lookup(key)) return cached;
+
+    const size_t len = static_cast<size_t>(std::min<uint64_t>(chunkSize_, image->size - offset));
+    Buffer buffer = std::make_shared<const std::vector<uint8_t>>(image->data + offset, image->data + offset + len);
+    insert(key, buffer);
+    return buffer;
+}
+
+/*
+ * ==============================================================
+ * Buffer parity(const ImagePtr& image, const ReedSolomon& codec, uint32_t block, unsigned j)
+ * ==============================================================
+ * All m parity chunks of the block are encoded together and cached; the
+ * data shards come through chunk(), so they are usually cached already.
+ * A short last chunk is padded with zeros and a short last block with
+ * zero shards, as FecDecoder expects.
+ */
+ChunkCache::Buffer ChunkCache::parity(const ImagePtr& image, const ReedSolomon& codec, uint32_t block, unsigned j) {
+    const unsigned k = codec.dataShards();
+    const unsigned m = codec.parityShards();
+    if (!image || !codec.isValid() || j >= m) return nullptr;
+
+    const uint64_t tag = kParityKey | (static_cast<uint64_t>(k) << 44) | (static_cast<uint64_t>(m) << 35);
+    const uint64_t first = static_cast<uint64_t>(block) * m;
+    if (Buffer cached = lookup(Key{image->id, tag | (first + j)})) return cached;
+
+    const uint32_t chunks = chunkCount(*image);
+    std::vector<std::vector<uint8_t>> data(k, std::vector<uint8_t>(chunkSize_, 0));
+    std::vector<const uint8_t*> dataPtr(k);
+    for (unsigned i = 0; i < k; ++i) {
+        const uint64_t index = static_cast<uint64_t>(block) * k + i;
+        if (index < chunks) {
+            Buffer b = chunk(image, static_cast<uint32_t>(index));
+            std::memcpy(data[i].data(), b->data(), b->size());
+        }
+        dataPtr[i] = data[i].data();
+    }
+
+    std::vector<std::shared_ptr<std::vector<uint8_t>>> parity(m);
+    std::vector<uint8_t*> parityPtr(m);
+    for (unsigned i = 0; i < m; ++i) {
+        parity[i] = std::make_shared<std::vector<uint8_t>>(chunkSize_);
+        parityPtr[i] = parity[i]->data();
+    }
+    codec.encode(dataPtr.data(), parityPtr.data(), chunkSize_);
+
+    for (unsigned i = 0; i < m; ++i) insert(Key{image->id, tag | (first + i)}, parity[i]);
+    return parity[j];
+}
+
+ChunkCache::Stats ChunkCache::stats() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    Stats s;
+    s.hits = hits_;
+    s.misses = misses_;
+    s.bytes = bytes_;
+    s.entries = entries_.size();
+    return s;
+}
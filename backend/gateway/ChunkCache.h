@@ -0,0 +1,108 @@
+#ifndef CHUNKCACHE_H
+#define CHUNKCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ReedSolomon.h"
+
+/*
+ * ==============================================================
+ * ChunkCache
+ * ==============================================================
+ * Read side of the gateway. Every served file is mapped once (mmap) and
+ * shared by all transfers; chunks are copied out of the mapping into
+ * ready-to-send buffers that are kept in one LRU for all clients, so N
+ * clients downloading the same image cost one read and one copy per
+ * chunk while it stays cached. FEC parity is computed once per block and
+ * cached the same way.
+ * A file that changed on disk (size or mtime) is mapped again on its next
+ * open; transfers still running keep the old mapping alive.
+ * Thread safe.
+ */
+class ChunkCache {
+   public:
+    using Buffer = std::shared_ptr<const std::vector<uint8_t>>;
+
+    struct Image {
+        uint64_t id = 0;            // cache key, unique per mapping
+        std::string name;
+        uint64_t size = 0;
+        int64_t mtimeNs = 0;
+        const uint8_t* data = nullptr;
+
+        ~Image();
+        uint32_t crc() const;       // computed on first use
+
+       private:
+        friend class ChunkCache;
+        mutable std::once_flag crcOnce_;
+        mutable uint32_t crc_ = 0;
+    };
+    using ImagePtr = std::shared_ptr<const Image>;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t bytes = 0;         // currently cached
+        uint64_t entries = 0;
+    };
+
+    ChunkCache(const std::string& dir, size_t chunkSize, size_t capacityBytes);
+
+    // Null for a missing file or a name that is not a plain file name
+    ImagePtr open(const std::string& name);
+
+    // Null if index is past the end of the image
+    Buffer chunk(const ImagePtr& image, uint32_t index);
+
+    // Parity chunk j of a block of the whole image (see FecDecoder)
+    Buffer parity(const ImagePtr& image, const ReedSolomon& codec, uint32_t block, unsigned j);
+
+    size_t chunkSize() const { return chunkSize_; }
+    uint32_t chunkCount(const Image& image) const;
+    Stats stats() const;
+
+   private:
+    struct Key {
+        uint64_t image;
+        uint64_t item;              // chunk index, or kParityKey | ...
+        bool operator==(const Key& o) const { return image == o.image && item == o.item; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& k) const { return std::hash<uint64_t>()(k.image * 0x9e3779b97f4a7c15ull ^ k.item); }
+    };
+    struct Entry {
+        Buffer buffer;
+        std::list<Key>::iterator lru;
+    };
+
+    static constexpr uint64_t kParityKey = 1ull << 63;
+
+    Buffer lookup(const Key& key);
+    void insert(const Key& key, const Buffer& buffer);
+
+    const std::string dir_;
+    const size_t chunkSize_;
+    const size_t capacity_;
+
+    std::mutex imagesMutex_;
+    std::map<std::string, ImagePtr> images_;
+    uint64_t nextImageId_ = 1;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<Key, Entry, KeyHash> entries_;
+    std::list<Key> lru_;            // front: most recent
+    size_t bytes_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
+
+#endif  // CHUNKCACHE_H
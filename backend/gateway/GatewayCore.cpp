@@ -0,0 +1,423 @@
+#include "GatewayCore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+
+#include "OtaLog.h"
+
+namespace {
+
+bool parseUint64(const std::string& text, uint64_t& out) {
+    if (text.empty() || text[0] < '0' || text[0] > '9') return false;
+    char* end = nullptr;
+    out = std::strtoull(text.c_str(), &end, 10);
+    return *end == '\0';
+}
+
+uint64_t steadyNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+}  // namespace
+
+GatewayCore::Config GatewayCore::configFromEnv() {
+    Config c;
+    if (const char* v = std::getenv("OTA_GW_DIR")) {
+        if (*v) c.dir = v;
+    }
+    if (const char* v = std::getenv("OTA_GW_IMAGE")) {
+        if (*v) c.image = v;
+    }
+
+    // Version: OTA_GW_VERSION, else update.version next to the images
+    if (const char* v = std::getenv("OTA_GW_VERSION")) {
+        c.version = static_cast<uint32_t>(std::strtoul(v, nullptr, 10));
+    } else {
+        std::ifstream in((c.dir.empty() || c.dir.back() == '/' ? c.dir : c.dir + "/") + "update.version");
+        uint32_t version = 0;
+        if (in >> version) c.version = version;
+    }
+
+    if (const char* v = std::getenv("OTA_GW_CACHE_MB")) {
+        const unsigned long mb = std::strtoul(v, nullptr, 10);
+        if (mb > 0) c.cacheBytes = static_cast<size_t>(mb) << 20;
+    }
+    if (const char* v = std::getenv("OTA_GW_WORKERS")) {
+        const unsigned long n = std::strtoul(v, nullptr, 10);
+        if (n > 0) c.workers = static_cast<unsigned>(std::min<unsigned long>(n, 64));
+    } else {
+        c.workers = std::max(2u, std::min(8u, std::thread::hardware_concurrency()));
+    }
+    if (const char* v = std::getenv("OTA_GW_QUANTUM")) {
+        const unsigned long n = std::strtoul(v, nullptr, 10);
+        if (n > 0) c.quantum = static_cast<unsigned>(n);
+    }
+    if (const char* v = std::getenv("OTA_GW_PASSES")) {
+        const unsigned long n = std::strtoul(v, nullptr, 10);
+        if (n > 0) c.passes = static_cast<unsigned>(n);
+    }
+    if (const char* v = std::getenv("OTA_FEC")) {
+        if (!FecDecoder::parseConfig(v, c.fec)) OTA_LOG_WARN("Gateway", "Ignoring invalid OTA_FEC '{}'", v);
+    }
+    if (const char* v = std::getenv("OTA_GW_FAULTS")) {
+        if (*v && !FaultInjector::parseConfig(v, c.faults)) {
+            OTA_LOG_WARN("Gateway", "Ignoring invalid OTA_GW_FAULTS '{}'", v);
+        }
+    }
+    return c;
+}
+
+GatewayCore::GatewayCore(const Config& config, size_t lanes, Sink sink)
+    : config_(config),
+      sink_(std::move(sink)),
+      cache_(config.dir, config.chunkSize, config.cacheBytes) {
+    if (config_.fec.k > 0) codec_.reset(new ReedSolomon(config_.fec.k, config_.fec.m));
+    for (size_t i = 0; i < lanes; ++i) {
+        lanes_.emplace_back(new Lane());
+        if (config_.faults.enabled()) {
+            FaultInjector::Config faults = config_.faults;
+            faults.seed += static_cast<uint32_t>(i);
+            lanes_.back()->faults.reset(new FaultInjector(faults));
+        }
+    }
+}
+
+GatewayCore::~GatewayCore() {
+    stop();
+}
+
+void GatewayCore::setRestartHandler(RestartHandler handler) {
+    restartHandler_ = std::move(handler);
+}
+
+void GatewayCore::start() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (!workers_.empty()) return;
+    stopping_ = false;
+    for (unsigned i = 0; i < std::max(1u, config_.workers); ++i) {
+        workers_.emplace_back([this]() { workerLoop(); });
+    }
+    OTA_LOG_INFO("Gateway", "{} lanes, {} workers, cache {} MiB, quantum {}", lanes_.size(),
+                 workers_.size(), config_.cacheBytes >> 20, config_.quantum);
+    if (config_.faults.enabled()) {
+        OTA_LOG_WARN("Gateway", "Test mode: injecting faults, seed {}", config_.faults.seed);
+    }
+}
+
+void GatewayCore::stop() {
+    std::vector<std::thread> workers;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        stopping_ = true;
+        workers.swap(workers_);
+        for (auto& s : ready_) s->cancelled = true;
+        ready_.clear();
+        for (auto& lane : lanes_) lane->current.reset();
+    }
+    cv_.notify_all();
+    for (std::thread& t : workers) t.join();
+}
+
+bool GatewayCore::parseName(const std::string& name, std::string& file, uint64_t& offset, uint64_t& length,
+                            uint32_t& tag) {
+    tag = 0;
+    const size_t at = name.find('@');
+    if (at == std::string::npos) {
+        file = name;
+        offset = 0;
+        length = 0;
+        return !file.empty();
+    }
+    const size_t colon = name.find(':', at);
+    if (colon == std::string::npos) return false;
+    file = name.substr(0, at);
+
+    const size_t hash = name.find('#', colon);
+    if (hash != std::string::npos) {
+        uint64_t t = 0;
+        if (!parseUint64(name.substr(hash + 1), t) || t == 0 || t > RangeTransfer::kMaxTag) return false;
+        tag = static_cast<uint32_t>(t);
+    }
+    const size_t end = hash == std::string::npos ? name.size() : hash;
+    return !file.empty() && parseUint64(name.substr(at + 1, colon - at - 1), offset) &&
+           parseUint64(name.substr(colon + 1, end - colon - 1), length) && length > 0;
+}
+
+/*
+ * ==============================================================
+ * UpdateAnswer checkUpdate(uint32_t currentVersion)
+ * ==============================================================
+ * The offered image is looked up on every check, so a new image and
+ * version can be dropped in place. Its CRC is computed once per mapping.
+ */
+GatewayCore::UpdateAnswer GatewayCore::checkUpdate(uint32_t currentVersion) {
+    ++checks_;
+    UpdateAnswer a;
+    if (isDown()) {
+        a.resultCode = 2;
+        return a;
+    }
+    ChunkCache::ImagePtr image = cache_.open(config_.image);
+    if (!image) {
+        a.resultCode = 1;
+        return a;
+    }
+    a.exists = true;
+    a.newVersion = config_.version;
+    a.isNew = config_.version > currentVersion;
+    a.size = image->size;
+    a.crc = image->crc();
+    return a;
+}
+
+/*
+ * ==============================================================
+ * bool startTransfer(size_t lane, const std::string& name, uint64_t client)
+ * ==============================================================
+ * A range must start on a chunk boundary and either be whole chunks or
+ * end with the file, so its chunks are the cached chunks of the image.
+ * False for a lane busy with another client's transfer: the lane frees
+ * up when that one ends, so the client may ask again.
+ */
+bool GatewayCore::startTransfer(size_t lane, const std::string& name, uint64_t client) {
+    std::string file;
+    uint64_t offset = 0, length = 0;
+    uint32_t tag = 0;
+    ChunkCache::ImagePtr image;
+    if (lane < lanes_.size() && !isDown() && parseName(name, file, offset, length, tag)) image = cache_.open(file);
+
+    const uint64_t chunkSize = config_.chunkSize;
+    if (image && length == 0) length = image->size;
+    if (!image || offset % chunkSize != 0 || offset >= image->size || length > image->size - offset ||
+        (length % chunkSize != 0 && offset + length != image->size) ||
+        (tag != 0 && (length + chunkSize - 1) / chunkSize > RangeTransfer::kIndexMask)) {
+        OTA_LOG_WARN("Gateway", "Lane {}: refused '{}'", lane, name);
+        ++refused_;
+        return false;
+    }
+
+    auto s = std::make_shared<Stream>();
+    s->lane = lane;
+    s->client = client;
+    s->image = image;
+    s->firstChunk = static_cast<uint32_t>(offset / chunkSize);
+    s->chunks = static_cast<uint32_t>((length + chunkSize - 1) / chunkSize);
+    s->tag = tag;
+    s->fec = codec_ && offset == 0 && length == image->size && tag == 0;
+    s->passesLeft = std::max(1u, config_.passes);
+
+    std::shared_ptr<Stream> old;
+    bool busy = false;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (stopping_) return false;
+        old = lanes_[lane]->current;
+        busy = old && old->client != client;
+        if (!busy) {
+            lanes_[lane]->current = s;
+            ready_.push_back(s);
+        }
+    }
+    if (busy) {
+        if (config_.passes > 1 && old->image == image && old->firstChunk == s->firstChunk &&
+            old->chunks == s->chunks && old->tag == tag) {
+            OTA_LOG_INFO("Gateway", "Lane {}: '{}' joins the running carousel", lane, name);
+            ++joined_;
+            return true;
+        }
+        OTA_LOG_INFO("Gateway", "Lane {}: busy with another client, refused '{}'", lane, name);
+        ++busy_;
+        return false;
+    }
+    if (old) {
+        old->cancelled = true;
+        ++replaced_;
+    }
+    ++transfers_;
+    cv_.notify_one();
+
+    OTA_LOG_INFO("Gateway", "Lane {}: '{}', {} chunks{}", lane, name, s->chunks, s->fec ? " + FEC" : "");
+    return true;
+}
+
+/*
+ * ==============================================================
+ * bool nextItem(Stream& s, Item& item) const
+ * ==============================================================
+ * Send order of one pass: data chunks, with FEC the m parity chunks of
+ * each block right after its (possibly short) last data chunk. The last
+ * data chunk of a pass carries the last flag; the parity of the final
+ * block follows it and is still useful to a lossy receiver.
+ */
+bool GatewayCore::nextItem(Stream& s, Item& item) const {
+    for (;;) {
+        if (!s.fec) {
+            if (s.next < s.chunks) {
+                item = Item{s.next, false, s.next + 1 == s.chunks};
+                ++s.next;
+                return true;
+            }
+        } else {
+            const unsigned k = config_.fec.k, m = config_.fec.m;
+            const uint64_t blockStart = static_cast<uint64_t>(s.block) * k;
+            if (blockStart < s.chunks) {
+                const unsigned data = static_cast<unsigned>(std::min<uint64_t>(k, s.chunks - blockStart));
+                if (s.inBlock < data) {
+                    const uint32_t index = static_cast<uint32_t>(blockStart + s.inBlock);
+                    item = Item{index, false, index + 1 == s.chunks};
+                } else {
+                    item = Item{s.block * m + (s.inBlock - data), true, false};
+                }
+                if (++s.inBlock == data + m) {
+                    ++s.block;
+                    s.inBlock = 0;
+                }
+                return true;
+            }
+        }
+
+        if (--s.passesLeft == 0) return false;
+        s.next = 0;
+        s.block = 0;
+        s.inBlock = 0;
+    }
+}
+
+/*
+ * ==============================================================
+ * bool runTurn(Stream& s)
+ * ==============================================================
+ * Sends up to one quantum under the lane's send mutex. A stream replaced
+ * meanwhile stops at the next chunk, so the new one never interleaves
+ * with it. Returns whether the stream has more to send.
+ */
+bool GatewayCore::runTurn(Stream& s) {
+    std::lock_guard<std::mutex> lk(lanes_[s.lane]->sendMutex);
+    for (unsigned n = 0; n < config_.quantum; ++n) {
+        if (s.cancelled) return false;
+
+        Item item;
+        if (!nextItem(s, item)) return false;
+
+        ChunkCache::Buffer data;
+        uint32_t index = item.index;
+        if (item.parity) {
+            const unsigned m = config_.fec.m;
+            data = cache_.parity(s.image, *codec_, item.index / m, item.index % m);
+            index |= FecDecoder::kParityFlag;
+        } else {
+            data = cache_.chunk(s.image, s.firstChunk + item.index);
+            index |= s.tag << RangeTransfer::kTagShift;
+        }
+        if (!data) {
+            OTA_LOG_ERROR("Gateway", "Lane {}: no chunk {} of {}", s.lane, item.index, s.image->name);
+            return false;
+        }
+
+        Lane& lane = *lanes_[s.lane];
+        if (!lane.faults) {
+            sink_(s.lane, index, data, item.last);
+        } else {
+            // Held chunks come back as copies, this one as the cached buffer
+            const FaultInjector::Fault fault = lane.faults->apply(
+                index, data->data(), data->size(), item.last,
+                [this, &s, &data](uint32_t i, const uint8_t* d, size_t size, bool last) {
+                    ChunkCache::Buffer out = data;
+                    if (d != data->data()) out = std::make_shared<const std::vector<uint8_t>>(d, d + size);
+                    sink_(s.lane, i, out, last);
+                });
+            if (fault == FaultInjector::Fault::Restart) {
+                restart();
+                return false;
+            }
+        }
+        ++chunks_;
+        bytes_ += data->size();
+    }
+    return true;
+}
+
+/*
+ * ==============================================================
+ * void restart()
+ * ==============================================================
+ * Restart fault: what a client sees of a gateway dying mid-transfer and
+ * coming back restartMs later. Every stream ends where it is, with no
+ * last chunk, and requests are refused until the time is up.
+ */
+void GatewayCore::restart() {
+    const unsigned downMs = config_.faults.restartMs;
+    downUntilNs_ = steadyNs() + static_cast<uint64_t>(downMs) * 1000000ULL;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        for (auto& lane : lanes_) {
+            if (lane->current) lane->current->cancelled = true;
+            lane->current.reset();
+        }
+    }
+    OTA_LOG_WARN("Gateway", "Fault: restart, down for {} ms", downMs);
+    if (restartHandler_) restartHandler_(downMs);
+}
+
+bool GatewayCore::isDown() const {
+    return steadyNs() < downUntilNs_;
+}
+
+void GatewayCore::workerLoop() {
+    for (;;) {
+        std::shared_ptr<Stream> s;
+        {
+            std::unique_lock<std::mutex> lk(mutex_);
+            cv_.wait(lk, [this]() { return stopping_ || !ready_.empty(); });
+            if (stopping_) return;
+            s = ready_.front();
+            ready_.pop_front();
+        }
+
+        const bool more = runTurn(*s);
+
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (stopping_) return;
+        if (more) {
+            ready_.push_back(s);
+            cv_.notify_one();
+            continue;
+        }
+        if (lanes_[s->lane]->current == s) lanes_[s->lane]->current.reset();
+        if (!s->cancelled) ++completed_;
+    }
+}
+
+GatewayCore::Stats GatewayCore::stats() const {
+    Stats st;
+    st.checks = checks_;
+    st.transfers = transfers_;
+    st.refused = refused_;
+    st.completed = completed_;
+    st.replaced = replaced_;
+    st.busy = busy_;
+    st.joined = joined_;
+    st.chunks = chunks_;
+    st.bytes = bytes_;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        for (const auto& lane : lanes_) {
+            if (lane->current) ++st.active;
+        }
+    }
+    st.cache = cache_.stats();
+    for (const auto& lane : lanes_) {
+        if (!lane->faults) continue;
+        const FaultInjector::Stats f = lane->faults->stats();
+        st.faults.chunks += f.chunks;
+        st.faults.dropped += f.dropped;
+        st.faults.duplicated += f.duplicated;
+        st.faults.reordered += f.reordered;
+        st.faults.stalls += f.stalls;
+        st.faults.restarts += f.restarts;
+    }
+    return st;
+}
@@ -0,0 +1,189 @@
+#ifndef GATEWAYCORE_H
+#define GATEWAYCORE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ChunkCache.h"
+#include "FaultInjector.h"
+#include "FecDecoder.h"
+#include "RangeTransfer.h"
+#include "ReedSolomon.h"
+
+/*
+ * ==============================================================
+ * GatewayCore
+ * ==============================================================
+ * Transport independent part of the reference gateway: answers update
+ * checks and runs the chunk streams of all clients.
+ *
+ * A fileChunk event carries no transfer id and reaches every subscriber
+ * of the instance, so a service instance can run one transfer at a time;
+ * the core calls that a lane. A new request from the client running the
+ * lane replaces its transfer (restarting, or asking for a repair range).
+ * Another client is refused while the lane is busy and retries later,
+ * unless it asks for the very range a carousel (passes > 1) is sending:
+ * it joins that one.
+ *
+ * Streams are scheduled round-robin on a fixed pool of workers: a worker
+ * takes the stream at the head of the ready queue, sends up to `quantum`
+ * chunks and puts it back at the tail. All chunks having the same size,
+ * every active stream gets the same share of the send capacity however
+ * many there are, and a new stream waits at most one round for its first
+ * chunk. Chunks come from the shared ChunkCache.
+ *
+ * Request names: "file" or "file@offset:length" (see RangeTransfer) with
+ * a chunk-aligned offset, optionally tagged "file@offset:length#tag": the
+ * tag goes into every chunk index of the range. With FEC, whole-file transfers interleave m
+ * parity chunks after every k data chunks (see FecDecoder); ranges are
+ * sent without parity, as the client numbers blocks from the file start.
+ *
+ * Test mode (OTA_GW_FAULTS): each lane runs its chunks through a
+ * FaultInjector seeded with seed + lane. A restart fault cancels every
+ * stream and refuses all requests for restartMs; the restart handler
+ * lets the transport take the service down for that long too.
+ *
+ * The sink is called on the worker threads, never twice at once for the
+ * same lane.
+ */
+class GatewayCore {
+   public:
+    using Sink = std::function<void(size_t lane, uint32_t index, const ChunkCache::Buffer& data, bool last)>;
+    using RestartHandler = std::function<void(unsigned downMs)>;
+
+    struct Config {
+        std::string dir = "data/server/";
+        std::string image = "rpi4-update.wic";   // offered by requestUpdate
+        uint32_t version = 1;
+        size_t chunkSize = 64 * 1024;
+        size_t cacheBytes = 256u << 20;
+        unsigned workers = 4;
+        unsigned quantum = 4;                   // chunks per turn
+        unsigned passes = 1;                    // > 1: carousel (multicast)
+        FecDecoder::Config fec;
+        FaultInjector::Config faults;           // test mode
+    };
+
+    // OTA_GW_DIR, OTA_GW_IMAGE, OTA_GW_VERSION, OTA_GW_CACHE_MB,
+    // OTA_GW_WORKERS, OTA_GW_QUANTUM, OTA_GW_PASSES, OTA_FEC, OTA_GW_FAULTS
+    static Config configFromEnv();
+
+    // Fields of FileTransfer::UpdateInfo
+    struct UpdateAnswer {
+        bool exists = false;
+        bool isNew = false;
+        uint32_t newVersion = 0;
+        uint64_t size = 0;
+        uint32_t crc = 0;
+        int32_t resultCode = 0;     // 1: no image to offer, 2: restarting
+    };
+
+    struct Stats {
+        uint64_t checks = 0;
+        uint64_t transfers = 0;
+        uint64_t refused = 0;
+        uint64_t completed = 0;
+        uint64_t replaced = 0;
+        uint64_t busy = 0;          // refused, lane busy with another client
+        uint64_t joined = 0;        // carousels joined
+        uint64_t chunks = 0;
+        uint64_t bytes = 0;
+        unsigned active = 0;
+        ChunkCache::Stats cache;
+        FaultInjector::Stats faults;    // all lanes
+    };
+
+    GatewayCore(const Config& config, size_t lanes, Sink sink);
+    ~GatewayCore();
+
+    GatewayCore(const GatewayCore&) = delete;
+    GatewayCore& operator=(const GatewayCore&) = delete;
+
+    // Called on a worker thread after a restart fault; set before start()
+    void setRestartHandler(RestartHandler handler);
+
+    void start();
+    void stop();
+
+    UpdateAnswer checkUpdate(uint32_t currentVersion);
+    // client: any key that tells the transport's clients apart
+    bool startTransfer(size_t lane, const std::string& name, uint64_t client);
+
+    // Parses "file" / "file@offset:length"; length 0 means the whole file
+    static bool parseName(const std::string& name, std::string& file, uint64_t& offset, uint64_t& length,
+                          uint32_t& tag);
+
+    size_t lanes() const { return lanes_.size(); }
+    const Config& config() const { return config_; }
+    Stats stats() const;
+
+   private:
+    struct Stream {
+        size_t lane = 0;
+        uint64_t client = 0;
+        ChunkCache::ImagePtr image;
+        uint32_t firstChunk = 0;
+        uint32_t chunks = 0;
+        uint32_t tag = 0;                   // RangeTransfer stream tag, 0: none
+        bool fec = false;
+        unsigned passesLeft = 1;
+        // Position, owned by the worker running the stream
+        uint32_t block = 0;
+        unsigned inBlock = 0;
+        uint32_t next = 0;
+        std::atomic<bool> cancelled{false};
+    };
+
+    struct Item {
+        uint32_t index;             // sent index, relative to firstChunk
+        bool parity;
+        bool last;
+    };
+
+    struct Lane {
+        std::mutex sendMutex;       // held for a turn: one stream sends at a time
+        std::shared_ptr<Stream> current;
+        std::unique_ptr<FaultInjector> faults;  // under sendMutex
+    };
+
+    void workerLoop();
+    bool nextItem(Stream& s, Item& item) const;
+    bool runTurn(Stream& s);
+    void restart();
+    bool isDown() const;
+
+    const Config config_;
+    const Sink sink_;
+    RestartHandler restartHandler_;
+    ChunkCache cache_;
+    std::unique_ptr<ReedSolomon> codec_;
+    std::vector<std::unique_ptr<Lane>> lanes_;
+
+    mutable std::mutex mutex_;      // ready_, lane currents, stopping_
+    std::condition_variable cv_;
+    std::deque<std::shared_ptr<Stream>> ready_;
+    std::vector<std::thread> workers_;
+    bool stopping_ = false;
+
+    std::atomic<uint64_t> checks_{0};
+    std::atomic<uint64_t> transfers_{0};
+    std::atomic<uint64_t> refused_{0};
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<uint64_t> replaced_{0};
+    std::atomic<uint64_t> busy_{0};
+    std::atomic<uint64_t> joined_{0};
+    std::atomic<uint64_t> chunks_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> downUntilNs_{0};
+};
+
+#endif  // GATEWAYCORE_H
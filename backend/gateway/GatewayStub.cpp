@@ -0,0 +1,24 @@
+#include "GatewayStub.h"
+
+#include "OtaLog.h"
+
+GatewayStub::GatewayStub(GatewayCore& core, size_t lane)
+    : core_(core), lane_(lane) {}
+
+void GatewayStub::requestUpdate(const std::shared_ptr<CommonAPI::ClientId> _client, uint32_t _currentVersion,
+                                requestUpdateReply_t _reply) {
+    (void)_client;
+    const GatewayCore::UpdateAnswer a = core_.checkUpdate(_currentVersion);
+    OTA_LOG_DEBUG("Gateway", "Lane {}: requestUpdate({}) -> version {} size {}", lane_, _currentVersion,
+                  a.newVersion, a.size);
+    _reply(ft::FileTransfer::UpdateInfo(a.exists, a.isNew, a.newVersion, a.size, a.crc, a.resultCode));
+}
+
+void GatewayStub::startTransfer(const std::shared_ptr<CommonAPI::ClientId> _client, std::string _fileName,
+                                startTransferReply_t _reply) {
+    _reply(startFor(_client ? _client->hashCode() : 0, _fileName));
+}
+
+bool GatewayStub::startFor(uint64_t client, const std::string& fileName) {
+    return core_.startTransfer(lane_, fileName, client);
+}
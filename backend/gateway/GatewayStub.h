@@ -0,0 +1,43 @@
+#ifndef GATEWAYSTUB_H
+#define GATEWAYSTUB_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <CommonAPI/CommonAPI.hpp>
+#include <v0/filetransfer/example/FileTransferStubDefault.hpp>
+
+#include "GatewayCore.h"
+
+namespace ft = v0::filetransfer::example;
+
+/*
+ * ==============================================================
+ * GatewayStub
+ * ==============================================================
+ * One registered service instance of the gateway, i.e. one lane of the
+ * GatewayCore. Method calls are answered right away on the CommonAPI
+ * thread; the chunks are sent by the core's workers through
+ * fireFileChunkEvent(). The lane belongs to the client that started its
+ * transfer (by ClientId::hashCode()) until the transfer ends.
+ */
+class GatewayStub : public ft::FileTransferStubDefault {
+   public:
+    GatewayStub(GatewayCore& core, size_t lane);
+
+    void requestUpdate(const std::shared_ptr<CommonAPI::ClientId> _client, uint32_t _currentVersion,
+                       requestUpdateReply_t _reply) override;
+    void startTransfer(const std::shared_ptr<CommonAPI::ClientId> _client, std::string _fileName,
+                       startTransferReply_t _reply) override;
+
+    // startTransfer() for the client with this key
+    bool startFor(uint64_t client, const std::string& fileName);
+
+   private:
+    GatewayCore& core_;
+    const size_t lane_;
+};
+
+#endif  // GATEWAYSTUB_H
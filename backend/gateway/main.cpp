@@ -0,0 +1,144 @@
+/*
+ * ==============================================================
+ * ota_gateway
+ * ==============================================================
+ * Reference update server: registers one FileTransfer stub per service
+ * instance (OTA_GW_INSTANCES) on the same GatewayCore and serves until
+ * SIGINT / SIGTERM, logging its counters every 10 s. A restart fault
+ * (OTA_GW_FAULTS) unregisters all instances for the restart time, so
+ * clients see the service go away as in a real restart.
+ * Run with the vsomeip configuration of the clients and
+ * VSOMEIP_APPLICATION_NAME=service-sample.
+ */
+
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <CommonAPI/CommonAPI.hpp>
+
+#include "ChunkEventDeployment.h"
+#include "GatewayCore.h"
+#include "GatewayStub.h"
+#include "OtaLog.h"
+
+#define GATEWAY_LOG_PATH "ota-gateway.log"
+
+namespace {
+
+std::vector<std::string> instancesFromEnv() {
+    std::vector<std::string> out;
+    const char* v = std::getenv("OTA_GW_INSTANCES");
+    std::string list = v ? v : "filetransfer.example.FileTransfer,filetransfer.example.FileTransfer2,"
+                               "filetransfer.example.FileTransfer3,filetransfer.example.FileTransfer4";
+    size_t from = 0;
+    while (from <= list.size()) {
+        const size_t comma = std::min(list.find(',', from), list.size());
+        if (comma > from) out.push_back(list.substr(from, comma - from));
+        from = comma + 1;
+    }
+    return out;
+}
+
+}  // namespace
+
+int main() {
+    otalog::start(otalog::configFromEnv(GATEWAY_LOG_PATH));
+
+    // Signals are taken by sigtimedwait() below, in no other thread
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGUSR1);     // restart fault, from a worker
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    const std::vector<std::string> instances = instancesFromEnv();
+    const char* connection = std::getenv("OTA_CONNECTION_ID");
+    const std::string connectionId = connection ? connection : "service-sample";
+
+    std::vector<std::shared_ptr<GatewayStub>> stubs;
+    GatewayCore core(GatewayCore::configFromEnv(), instances.size(),
+                     [&stubs](size_t lane, uint32_t index, const ChunkCache::Buffer& data, bool last) {
+                         stubs[lane]->fireFileChunkEvent(index, *data, last);
+                     });
+
+    CommonAPI::Runtime::setProperty("LibraryBase", "FileTransfer");
+    chunkevent::registerStubDeployment();
+    std::shared_ptr<CommonAPI::Runtime> runtime = CommonAPI::Runtime::get();
+    if (!runtime) {
+        OTA_LOG_ERROR("Gateway", "Failed to get runtime");
+        otalog::stop();
+        return 1;
+    }
+
+    for (size_t i = 0; i < instances.size(); ++i) stubs.push_back(std::make_shared<GatewayStub>(core, i));
+    core.setRestartHandler([](unsigned) { kill(getpid(), SIGUSR1); });
+    core.start();
+
+    size_t registered = 0;
+    for (size_t i = 0; i < instances.size(); ++i) {
+        if (runtime->registerService("local", instances[i], stubs[i], connectionId)) {
+            ++registered;
+        } else {
+            OTA_LOG_ERROR("Gateway", "Failed to register {}", instances[i]);
+        }
+    }
+    if (registered == 0) {
+        core.stop();
+        otalog::stop();
+        return 1;
+    }
+
+    const GatewayCore::Config& cfg = core.config();
+    OTA_LOG_INFO("Gateway", "Serving {} version {} from {} on {} instances", cfg.image, cfg.version, cfg.dir,
+                 registered);
+
+    const timespec interval = {10, 0};
+    for (;;) {
+        const int sig = sigtimedwait(&signals, nullptr, &interval);
+        if (sig == SIGINT || sig == SIGTERM) break;
+        if (sig == SIGUSR1) {
+            for (size_t i = 0; i < instances.size(); ++i) {
+                runtime->unregisterService("local", ft::FileTransfer::getInterface(), instances[i]);
+            }
+            const unsigned downMs = cfg.faults.restartMs;
+            const timespec down = {static_cast<time_t>(downMs / 1000),
+                                   static_cast<long>(downMs % 1000) * 1000000L};
+            nanosleep(&down, nullptr);
+            for (size_t i = 0; i < instances.size(); ++i) {
+                if (!runtime->registerService("local", instances[i], stubs[i], connectionId)) {
+                    OTA_LOG_ERROR("Gateway", "Failed to register {} after restart", instances[i]);
+                }
+            }
+            OTA_LOG_INFO("Gateway", "Back after restart fault");
+            continue;
+        }
+
+        const GatewayCore::Stats s = core.stats();
+        OTA_LOG_INFO("Gateway", "active {} transfers {} done {} refused {} busy {} sent {} MiB, cache {}/{} hit",
+                     s.active, s.transfers, s.completed, s.refused, s.busy, s.bytes >> 20, s.cache.hits,
+                     s.cache.hits + s.cache.misses);
+        if (cfg.faults.enabled()) {
+            OTA_LOG_INFO("Gateway", "faults: {} dropped, {} duplicated, {} reordered, {} stalls, {} restarts",
+                         s.faults.dropped, s.faults.duplicated, s.faults.reordered, s.faults.stalls,
+                         s.faults.restarts);
+        }
+    }
+
+    OTA_LOG_INFO("Gateway", "Stopping");
+    core.stop();
+    for (size_t i = 0; i < instances.size(); ++i) {
+        runtime->unregisterService("local", ft::FileTransfer::getInterface(), instances[i]);
+    }
+    otalog::stop();
+    return 0;
+}
@@ -0,0 +1,264 @@
+#include "BundleTransfer.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "OtaLog.h"
+
+// Progress is pushed at most this often, state changes always
+static const uint64_t kPublishIntervalNs = 250 * 1000 * 1000ULL;
+
+static uint64_t steadyNs() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+BundleTransfer::BundleTransfer(size_t chunkSize)
+    : chunkSize_(chunkSize) {}
+
+BundleTransfer::~BundleTransfer() {
+    cancel();
+    join();
+}
+
+void BundleTransfer::join() {
+    if (driver_.joinable()) driver_.join();
+    if (verifier_.joinable()) verifier_.join();
+}
+
+/*
+ * ==============================================================
+ * bool start(const UpdateManifest& manifest, const std::string& dir, Hooks hooks)
+ * ==============================================================
+ * Sorts the artifacts into "check" and "transfer" and starts both threads.
+ */
+bool BundleTransfer::start(const UpdateManifest& manifest, const std::string& dir, Hooks hooks) {
+    cancel();
+    join();
+
+    std::lock_guard<std::mutex> lk(mutex_);
+    dir_ = dir;
+    hooks_ = std::move(hooks);
+    artifacts_.clear();
+    transferQueue_.clear();
+    verifyQueue_.clear();
+    current_ = -1;
+    stopping_ = false;
+    finishedSent_ = false;
+    startNs_ = steadyNs();
+    transferredBytes_ = 0;
+    lastPublishNs_ = 0;
+
+    for (const UpdateManifest::Artifact& a : manifest.artifacts) {
+        ArtifactStatus status;
+        status.name = a.name;
+        status.size = a.size;
+        status.crc = a.crc;
+
+        struct stat st;
+        const std::string path = dir_ + a.name;
+        const bool present = stat(path.c_str(), &st) == 0 && static_cast<uint64_t>(st.st_size) == a.size;
+        status.state = present ? State::Checking : State::Queued;
+        (present ? verifyQueue_ : transferQueue_).push_back(artifacts_.size());
+        artifacts_.push_back(status);
+    }
+
+    OTA_LOG_INFO("Bundle", "{} artifacts, {} to check, {} to transfer",
+                 artifacts_.size(), verifyQueue_.size(), transferQueue_.size());
+
+    active_ = true;
+    driver_ = std::thread([this]() { runDriver(); });
+    verifier_ = std::thread([this]() { runVerifier(); });
+    return true;
+}
+
+void BundleTransfer::cancel() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        stopping_ = true;
+        finishedSent_ = true;   // a cancelled bundle reports nothing
+    }
+    cv_.notify_all();
+    active_ = false;
+}
+
+BundleTransfer::Progress BundleTransfer::progress() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return snapshot();
+}
+
+BundleTransfer::Progress BundleTransfer::snapshot() const {
+    Progress p;
+    p.artifacts = artifacts_;
+    p.current = current_;
+    for (const ArtifactStatus& a : artifacts_) {
+        p.totalBytes += a.size;
+        p.doneBytes += a.doneBytes;
+    }
+    const uint64_t elapsed = steadyNs() - startNs_;
+    if (elapsed > 0) p.bytesPerSec = static_cast<double>(transferredBytes_) * 1e9 / static_cast<double>(elapsed);
+    return p;
+}
+
+void BundleTransfer::publish(bool force) {
+    Progress p;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        const uint64_t now = steadyNs();
+        if (!force && now - lastPublishNs_ < kPublishIntervalNs) return;
+        lastPublishNs_ = now;
+        p = snapshot();
+    }
+    if (hooks_.progress) hooks_.progress(p);
+}
+
+/*
+ * Driver thread: one transfer at a time. It waits for the previous one's
+ * last chunk (or for a checked artifact to turn out stale) before the next.
+ */
+void BundleTransfer::runDriver() {
+    for (;;) {
+        size_t index = 0;
+        std::string name;
+        {
+            std::unique_lock<std::mutex> lk(mutex_);
+            cv_.wait(lk, [this]() { return stopping_ || (current_ < 0 && !transferQueue_.empty()); });
+            if (stopping_) return;
+
+            index = transferQueue_.front();
+            transferQueue_.pop_front();
+            current_ = static_cast<int>(index);
+            currentStartNs_ = steadyNs();
+            artifacts_[index].state = State::Transferring;
+            artifacts_[index].doneBytes = 0;
+            name = artifacts_[index].name;
+        }
+        publish(true);
+
+        OTA_LOG_INFO("Bundle", "Transferring {}", name);
+        if (!hooks_.startTransfer || !hooks_.startTransfer(name, dir_ + name)) {
+            fail("Transfer of " + name + " refused");
+            return;
+        }
+    }
+}
+
+// Verifier thread: pre-checks of present files and downloaded artifacts
+void BundleTransfer::runVerifier() {
+    for (;;) {
+        size_t index = 0;
+        std::string path;
+        {
+            std::unique_lock<std::mutex> lk(mutex_);
+            cv_.wait(lk, [this]() { return stopping_ || !verifyQueue_.empty(); });
+            if (stopping_) return;
+            index = verifyQueue_.front();
+            verifyQueue_.pop_front();
+            path = dir_ + artifacts_[index].name;
+        }
+
+        const uint64_t start = steadyNs();
+        uint32_t crc = 0;
+        const bool read = hooks_.computeCrc && hooks_.computeCrc(path, crc);
+
+        bool failed = false;
+        std::string name;
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            if (stopping_) return;
+            ArtifactStatus& a = artifacts_[index];
+            name = a.name;
+            const bool match = read && (a.crc == 0 || crc == a.crc);
+
+            if (match) {
+                a.skipped = a.state == State::Checking;
+                a.state = State::Done;
+                a.doneBytes = a.size;
+            } else if (a.state == State::Checking) {
+                // Present but stale: fetch it again
+                a.state = State::Queued;
+                a.doneBytes = 0;
+                transferQueue_.push_back(index);
+            } else {
+                a.state = State::Failed;
+                failed = true;
+            }
+        }
+        cv_.notify_all();
+
+        OTA_LOG_INFO("Bundle", "{} {} in {} ms", name,
+                     failed ? "failed verification" : "checked", (steadyNs() - start) / 1000000ULL);
+        if (failed) {
+            fail(name + " failed CRC verification");
+            return;
+        }
+        publish(true);
+        finishIfDone();
+    }
+}
+
+void BundleTransfer::onChunkWritten(uint32_t index, bool lastChunk) {
+    bool last = false;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (current_ < 0 || stopping_) return;
+        ArtifactStatus& a = artifacts_[static_cast<size_t>(current_)];
+
+        const uint64_t done = lastChunk ? a.size
+                                        : std::min<uint64_t>(a.size, static_cast<uint64_t>(index + 1) * chunkSize_);
+        if (done > a.doneBytes) {
+            transferredBytes_ += done - a.doneBytes;
+            a.doneBytes = done;
+        }
+        const uint64_t elapsed = steadyNs() - currentStartNs_;
+        if (elapsed > 0) a.bytesPerSec = static_cast<double>(a.doneBytes) * 1e9 / static_cast<double>(elapsed);
+
+        if (lastChunk) {
+            a.state = State::Verifying;
+            verifyQueue_.push_back(static_cast<size_t>(current_));
+            current_ = -1;
+            last = true;
+        }
+    }
+    if (last) cv_.notify_all();
+    publish(last);
+}
+
+void BundleTransfer::onTransferError(const std::string& error) {
+    fail(error);
+}
+
+void BundleTransfer::fail(const std::string& error) {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (finishedSent_) return;
+        finishedSent_ = true;
+        stopping_ = true;
+        if (current_ >= 0) artifacts_[static_cast<size_t>(current_)].state = State::Failed;
+    }
+    cv_.notify_all();
+    active_ = false;
+
+    OTA_LOG_ERROR("Bundle", "Bundle failed: {}", error);
+    if (hooks_.finished) hooks_.finished(false, error);
+}
+
+void BundleTransfer::finishIfDone() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (finishedSent_) return;
+        for (const ArtifactStatus& a : artifacts_) {
+            if (a.state != State::Done) return;
+        }
+        finishedSent_ = true;
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    active_ = false;
+
+    OTA_LOG_INFO("Bundle", "All artifacts verified");
+    if (hooks_.finished) hooks_.finished(true, std::string());
+}
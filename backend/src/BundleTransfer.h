@@ -0,0 +1,117 @@
+#ifndef BUNDLETRANSFER_H
+#define BUNDLETRANSFER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "UpdateManifest.h"
+
+/*
+ * ==============================================================
+ * BundleTransfer
+ * ==============================================================
+ * Schedules the artifacts of an update bundle.
+ * - An artifact whose file is already there with the right size is
+ *   hashed first; on a CRC match it is skipped, otherwise queued.
+ * - The file chunk broadcast carries no artifact id, so transfers run
+ *   one after the other on the connection. Everything else overlaps
+ *   them: artifact N is verified while N+1 downloads, and files already
+ *   present are checked while the first transfer runs.
+ * - One driver thread starts transfers, one verifier thread hashes
+ *   (UpdateVerifier itself uses several workers).
+ * Transport and hashing are hooks, so the scheduling does not depend on
+ * CommonAPI.
+ */
+class BundleTransfer {
+   public:
+    enum class State {
+        Checking,       // present on disk, being verified
+        Queued,
+        Transferring,
+        Verifying,
+        Done,
+        Failed
+    };
+
+    struct ArtifactStatus {
+        std::string name;
+        uint64_t size = 0;
+        uint32_t crc = 0;
+        State state = State::Queued;
+        uint64_t doneBytes = 0;
+        double bytesPerSec = 0.0;     // while transferring
+        bool skipped = false;         // was already present
+    };
+
+    struct Progress {
+        std::vector<ArtifactStatus> artifacts;
+        uint64_t totalBytes = 0;
+        uint64_t doneBytes = 0;       // including skipped artifacts
+        double bytesPerSec = 0.0;     // transferred bytes over the bundle's time
+        int current = -1;             // artifact on the wire
+    };
+
+    struct Hooks {
+        // Opens the pipeline on path and asks the service for name; false if refused
+        std::function<bool(const std::string& name, const std::string& path)> startTransfer;
+        std::function<bool(const std::string& path, uint32_t& crc)> computeCrc;
+        std::function<void(const Progress&)> progress;
+        std::function<void(bool ok, const std::string& error)> finished;
+    };
+
+    explicit BundleTransfer(size_t chunkSize);
+    ~BundleTransfer();
+
+    BundleTransfer(const BundleTransfer&) = delete;
+    BundleTransfer& operator=(const BundleTransfer&) = delete;
+
+    // Artifacts are stored as dir + name
+    bool start(const UpdateManifest& manifest, const std::string& dir, Hooks hooks);
+    void cancel();
+    bool isActive() const { return active_.load(); }
+    Progress progress() const;
+
+    // From the pipeline's writer thread
+    void onChunkWritten(uint32_t index, bool lastChunk);
+    void onTransferError(const std::string& error);
+
+   private:
+    void runDriver();
+    void runVerifier();
+    void fail(const std::string& error);
+    void finishIfDone();
+    void publish(bool force);
+    Progress snapshot() const;   // mutex_ held
+    void join();
+
+    const size_t chunkSize_;
+    std::string dir_;
+    Hooks hooks_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<ArtifactStatus> artifacts_;
+    std::deque<size_t> transferQueue_;
+    std::deque<size_t> verifyQueue_;
+    int current_ = -1;
+    bool stopping_ = false;
+    bool finishedSent_ = false;
+    uint64_t startNs_ = 0;
+    uint64_t currentStartNs_ = 0;
+    uint64_t transferredBytes_ = 0;
+    uint64_t lastPublishNs_ = 0;
+
+    std::atomic<bool> active_{false};
+    std::thread driver_;
+    std::thread verifier_;
+};
+
+#endif  // BUNDLETRANSFER_H
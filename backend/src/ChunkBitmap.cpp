@@ -0,0 +1,58 @@
+#include "ChunkBitmap.h"
+
+void ChunkBitmap::reset(uint32_t chunks) {
+    words_.assign((static_cast<size_t>(chunks) + 63) / 64, 0);
+    size_ = chunks;
+    count_ = 0;
+}
+
+bool ChunkBitmap::set(uint32_t index) {
+    if (index >= size_) return false;
+    uint64_t& word = words_[index / 64];
+    const uint64_t bit = 1ULL << (index % 64);
+    if (word & bit) return false;
+    word |= bit;
+    ++count_;
+    return true;
+}
+
+bool ChunkBitmap::test(uint32_t index) const {
+    return index < size_ && (words_[index / 64] & (1ULL << (index % 64))) != 0;
+}
+
+/*
+ * ==============================================================
+ * std::vector<Run> missing(uint32_t mergeGap, size_t maxRuns) const
+ * ==============================================================
+ * Skips whole words that are complete, so a mostly received bitmap is
+ * scanned at 64 chunks per step.
+ */
+std::vector<ChunkBitmap::Run> ChunkBitmap::missing(uint32_t mergeGap, size_t maxRuns) const {
+    std::vector<Run> runs;
+    uint32_t i = 0;
+    while (i < size_) {
+        if (i % 64 == 0 && words_[i / 64] == ~0ULL) {
+            i += 64;
+            continue;
+        }
+        if (test(i)) {
+            ++i;
+            continue;
+        }
+
+        uint32_t end = i;
+        while (end < size_ && !test(end)) ++end;
+
+        if (!runs.empty() && i - (runs.back().first + runs.back().count) < mergeGap) {
+            runs.back().count = end - runs.back().first;
+        } else {
+            if (runs.size() == maxRuns) break;
+            Run r;
+            r.first = i;
+            r.count = end - i;
+            runs.push_back(r);
+        }
+        i = end;
+    }
+    return runs;
+}
@@ -0,0 +1,44 @@
+#ifndef CHUNKBITMAP_H
+#define CHUNKBITMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * ==============================================================
+ * ChunkBitmap
+ * ==============================================================
+ * Which chunks of a transfer have arrived, for transports that may lose,
+ * duplicate or reorder them. missing() lists the gaps to ask for again.
+ * Not thread safe.
+ */
+class ChunkBitmap {
+   public:
+    struct Run {
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    void reset(uint32_t chunks);
+
+    // True if index is new; false for a duplicate or out of range
+    bool set(uint32_t index);
+    bool test(uint32_t index) const;
+
+    uint32_t size() const { return size_; }
+    uint32_t count() const { return count_; }
+    bool complete() const { return count_ == size_; }
+
+    // Missing chunks as runs, first gap first. Runs separated by fewer than
+    // mergeGap received chunks are merged (those are fetched again), at
+    // most maxRuns are returned.
+    std::vector<Run> missing(uint32_t mergeGap, size_t maxRuns) const;
+
+   private:
+    std::vector<uint64_t> words_;
+    uint32_t size_ = 0;
+    uint32_t count_ = 0;
+};
+
+#endif  // CHUNKBITMAP_H
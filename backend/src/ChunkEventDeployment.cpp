@@ -0,0 +1,112 @@
+#include "ChunkEventDeployment.h"
+
+#include <v0/filetransfer/example/FileTransferSomeIPProxy.hpp>
+#include <v0/filetransfer/example/FileTransferSomeIPStubAdapter.hpp>
+
+#if !defined (COMMONAPI_INTERNAL_COMPILATION)
+#define COMMONAPI_INTERNAL_COMPILATION
+#define HAS_DEFINED_COMMONAPI_INTERNAL_COMPILATION_HERE
+#endif
+
+#include <CommonAPI/SomeIP/Factory.hpp>
+
+#if defined (HAS_DEFINED_COMMONAPI_INTERNAL_COMPILATION_HERE)
+#undef COMMONAPI_INTERNAL_COMPILATION
+#undef HAS_DEFINED_COMMONAPI_INTERNAL_COMPILATION_HERE
+#endif
+
+#include <mutex>
+#include <set>
+
+namespace ft = v0::filetransfer::example;
+
+namespace {
+
+const CommonAPI::SomeIP::eventgroup_id_t kChunkEventGroup(0x2000);
+const CommonAPI::SomeIP::event_id_t kChunkEvent(0x8020);
+
+// The generated proxy with its own fileChunk event; the generated member
+// is never subscribed
+class ChunkEventSomeIPProxy : public ft::FileTransferSomeIPProxy {
+   public:
+    ChunkEventSomeIPProxy(const CommonAPI::SomeIP::Address& address,
+                          const std::shared_ptr<CommonAPI::SomeIP::ProxyConnection>& connection)
+        : CommonAPI::SomeIP::Proxy(address, connection),
+          ft::FileTransferSomeIPProxy(address, connection),
+          fileChunk_(*this, kChunkEventGroup, kChunkEvent, CommonAPI::SomeIP::event_type_e::ET_EVENT,
+                     CommonAPI::SomeIP::reliability_type_e::RT_UNKNOWN, false,
+                     std::make_tuple(static_cast<CommonAPI::SomeIP::IntegerDeployment<uint32_t>*>(nullptr),
+                                     static_cast<CommonAPI::SomeIP::ByteBufferDeployment*>(nullptr),
+                                     static_cast<CommonAPI::EmptyDeployment*>(nullptr))) {}
+
+    FileChunkEvent& getFileChunkEvent() override { return fileChunk_; }
+
+   private:
+    CommonAPI::SomeIP::Event<FileChunkEvent,
+                             CommonAPI::Deployable<uint32_t, CommonAPI::SomeIP::IntegerDeployment<uint32_t>>,
+                             CommonAPI::Deployable<CommonAPI::ByteBuffer, CommonAPI::SomeIP::ByteBufferDeployment>,
+                             CommonAPI::Deployable<bool, CommonAPI::EmptyDeployment>> fileChunk_;
+};
+
+// The generated adapter, with the event offered again as "unknown"
+class ChunkEventSomeIPStubAdapter : public ft::FileTransferSomeIPStubAdapter<ft::FileTransferStub> {
+   public:
+    ChunkEventSomeIPStubAdapter(const CommonAPI::SomeIP::Address& address,
+                                const std::shared_ptr<CommonAPI::SomeIP::ProxyConnection>& connection,
+                                const std::shared_ptr<CommonAPI::StubBase>& stub)
+        : CommonAPI::SomeIP::StubAdapter(address, connection),
+          ft::FileTransferSomeIPStubAdapter<ft::FileTransferStub>(address, connection, stub) {
+        unregisterEvent(kChunkEvent);
+        std::set<CommonAPI::SomeIP::eventgroup_id_t> groups;
+        groups.insert(kChunkEventGroup);
+        registerEvent(kChunkEvent, groups, CommonAPI::SomeIP::event_type_e::ET_EVENT,
+                      CommonAPI::SomeIP::reliability_type_e::RT_UNKNOWN);
+    }
+};
+
+std::shared_ptr<CommonAPI::SomeIP::Proxy> createProxy(
+    const CommonAPI::SomeIP::Address& address,
+    const std::shared_ptr<CommonAPI::SomeIP::ProxyConnection>& connection) {
+    return std::make_shared<ChunkEventSomeIPProxy>(address, connection);
+}
+
+std::shared_ptr<CommonAPI::SomeIP::StubAdapter> createStubAdapter(
+    const CommonAPI::SomeIP::Address& address,
+    const std::shared_ptr<CommonAPI::SomeIP::ProxyConnection>& connection,
+    const std::shared_ptr<CommonAPI::StubBase>& stub) {
+    return std::make_shared<ChunkEventSomeIPStubAdapter>(address, connection, stub);
+}
+
+// Queued behind the generated initializers (registered statically) when
+// the binding is not initialized yet, run at once otherwise: either way
+// the last creator registered for the interface is ours
+void initializeProxy() {
+    CommonAPI::SomeIP::Factory::get()->registerProxyCreateMethod(
+        ft::FileTransfer::getInterface(), &createProxy);
+}
+
+void initializeStubAdapter() {
+    CommonAPI::SomeIP::Factory::get()->registerStubAdapterCreateMethod(
+        ft::FileTransfer::getInterface(), &createStubAdapter);
+}
+
+std::once_flag gProxyOnce;
+std::once_flag gStubOnce;
+
+}  // namespace
+
+namespace chunkevent {
+
+void registerProxyDeployment() {
+    std::call_once(gProxyOnce, []() {
+        CommonAPI::SomeIP::Factory::get()->registerInterface(initializeProxy);
+    });
+}
+
+void registerStubDeployment() {
+    std::call_once(gStubOnce, []() {
+        CommonAPI::SomeIP::Factory::get()->registerInterface(initializeStubAdapter);
+    });
+}
+
+}  // namespace chunkevent
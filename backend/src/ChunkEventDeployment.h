@@ -0,0 +1,22 @@
+#ifndef CHUNKEVENTDEPLOYMENT_H
+#define CHUNKEVENTDEPLOYMENT_H
+
+/*
+ * The generated SOME/IP code deploys the fileChunk event (0x8020) as
+ * reliable. These register FileTransfer proxy and stub adapter creators
+ * that declare it with reliability "unknown" instead, so the vsomeip
+ * configuration alone picks TCP (vsomeip.json) or UDP (vsomeip-udp.json,
+ * vsomeip-multicast.json). The generated files stay as generated.
+ *
+ * Call before the first buildProxy / registerService. Both replace the
+ * generated creator whether or not the binding is initialized yet, and
+ * are no-ops when called again.
+ */
+namespace chunkevent {
+
+void registerProxyDeployment();
+void registerStubDeployment();
+
+}  // namespace chunkevent
+
+#endif  // CHUNKEVENTDEPLOYMENT_H
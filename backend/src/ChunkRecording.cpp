@@ -0,0 +1,234 @@
+#include "ChunkRecording.h"
+
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "OtaLog.h"
+
+namespace {
+
+const char kMagic[8] = {'O', 'T', 'A', 'C', 'R', 'E', 'C', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kEventHeader = 24;
+constexpr uint64_t kInitialMap = 16u << 20;
+
+// Header field offsets
+constexpr size_t kOffVersion = 8;
+constexpr size_t kOffChunkSize = 12;
+constexpr size_t kOffImageSize = 16;
+constexpr size_t kOffImageCrc = 24;
+constexpr size_t kOffEvents = 32;
+constexpr size_t kOffUsed = 40;
+
+template <typename T>
+void put(uint8_t* at, T value) {
+    std::memcpy(at, &value, sizeof(T));
+}
+
+template <typename T>
+T get(const uint8_t* at) {
+    T value;
+    std::memcpy(&value, at, sizeof(T));
+    return value;
+}
+
+uint64_t pad8(uint64_t n) {
+    return (n + 7) & ~static_cast<uint64_t>(7);
+}
+
+uint64_t steadyNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+}  // namespace
+
+ChunkRecorder::~ChunkRecorder() {
+    close();
+}
+
+bool ChunkRecorder::open(const std::string& path, const ChunkRecordHeader& header) {
+    close();
+    std::lock_guard<std::mutex> lk(mutex_);
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) return false;
+    path_ = path;
+    used_ = ChunkRecording::kHeaderSize;
+    events_ = 0;
+    startNs_ = 0;
+    if (!reserve(kInitialMap)) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    std::memset(map_, 0, ChunkRecording::kHeaderSize);
+    std::memcpy(map_, kMagic, sizeof(kMagic));
+    put<uint32_t>(map_ + kOffVersion, kVersion);
+    put<uint32_t>(map_ + kOffChunkSize, header.chunkSize);
+    put<uint64_t>(map_ + kOffImageSize, header.imageSize);
+    put<uint32_t>(map_ + kOffImageCrc, header.imageCrc);
+    return true;
+}
+
+bool ChunkRecorder::isOpen() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return fd_ >= 0;
+}
+
+uint64_t ChunkRecorder::events() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return events_;
+}
+
+// Grows the file and the mapping to at least bytes, doubling. Under mutex_.
+bool ChunkRecorder::reserve(uint64_t bytes) {
+    if (bytes <= mapped_) return true;
+    uint64_t size = mapped_ ? mapped_ : kInitialMap;
+    while (size < bytes) size *= 2;
+    if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) return false;
+
+    void* map = map_ ? mremap(map_, mapped_, size, MREMAP_MAYMOVE)
+                     : mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) return false;
+    map_ = static_cast<uint8_t*>(map);
+    mapped_ = size;
+    return true;
+}
+
+/*
+ * ==============================================================
+ * void append(uint32_t index, const uint8_t* data, size_t size, bool last)
+ * ==============================================================
+ * Called on the CommonAPI thread for every event: a memcpy into the
+ * mapping, a syscall only when the file doubles. A failed growth closes
+ * the recording; what was recorded so far stays usable.
+ */
+void ChunkRecorder::append(uint32_t index, const uint8_t* data, size_t size, bool last) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (fd_ < 0) return;
+
+    const uint64_t now = steadyNs();
+    if (events_ == 0) startNs_ = now;
+
+    const uint64_t need = used_ + kEventHeader + pad8(size);
+    if (!reserve(need)) {
+        OTA_LOG_ERROR("Record", "{} cannot grow, recording stopped after {} events", path_, events_);
+        munmap(map_, mapped_);
+        if (::ftruncate(fd_, static_cast<off_t>(used_)) != 0) {
+            OTA_LOG_WARN("Record", "{} not trimmed", path_);
+        }
+        ::close(fd_);
+        fd_ = -1;
+        map_ = nullptr;
+        mapped_ = 0;
+        return;
+    }
+
+    uint8_t* at = map_ + used_;
+    put<uint64_t>(at, now - startNs_);
+    put<uint32_t>(at + 8, index);
+    put<uint32_t>(at + 12, static_cast<uint32_t>(size));
+    put<uint32_t>(at + 16, last ? 1u : 0u);
+    put<uint32_t>(at + 20, 0u);
+    std::memcpy(at + kEventHeader, data, size);
+
+    used_ = need;
+    ++events_;
+    put<uint64_t>(map_ + kOffEvents, events_);
+    put<uint64_t>(map_ + kOffUsed, used_);
+}
+
+void ChunkRecorder::close() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (fd_ < 0) return;
+    munmap(map_, mapped_);
+    // Still readable untrimmed: the header says how much is used
+    if (::ftruncate(fd_, static_cast<off_t>(used_)) != 0) {
+        OTA_LOG_WARN("Record", "{} not trimmed", path_);
+    }
+    OTA_LOG_INFO("Record", "{}: {} events, {} bytes", path_, events_, used_);
+    ::close(fd_);
+    fd_ = -1;
+    map_ = nullptr;
+    mapped_ = 0;
+}
+
+ChunkRecording::~ChunkRecording() {
+    close();
+}
+
+bool ChunkRecording::open(const std::string& path, std::string& error) {
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < kHeaderSize) {
+        ::close(fd);
+        error = path + " is not a chunk recording";
+        return false;
+    }
+    void* map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        error = "cannot map " + path;
+        return false;
+    }
+    map_ = static_cast<const uint8_t*>(map);
+    size_ = static_cast<uint64_t>(st.st_size);
+
+    if (std::memcmp(map_, kMagic, sizeof(kMagic)) != 0 || get<uint32_t>(map_ + kOffVersion) != kVersion) {
+        close();
+        error = path + " is not a chunk recording";
+        return false;
+    }
+    header_.chunkSize = get<uint32_t>(map_ + kOffChunkSize);
+    header_.imageSize = get<uint64_t>(map_ + kOffImageSize);
+    header_.imageCrc = get<uint32_t>(map_ + kOffImageCrc);
+    used_ = get<uint64_t>(map_ + kOffUsed);
+    if (used_ < kHeaderSize || used_ > size_) {
+        close();
+        error = path + " is truncated";
+        return false;
+    }
+
+    // Counted by walking, so a record cut short is never handed out
+    Event e;
+    while (next(e)) {
+        ++events_;
+        payload_ += e.size;
+    }
+    rewind();
+    return true;
+}
+
+void ChunkRecording::close() {
+    if (map_) munmap(const_cast<uint8_t*>(map_), size_);
+    map_ = nullptr;
+    size_ = used_ = events_ = payload_ = 0;
+    cursor_ = kHeaderSize;
+    header_ = ChunkRecordHeader();
+}
+
+bool ChunkRecording::next(Event& out) {
+    if (!map_ || cursor_ + kEventHeader > used_) return false;
+    const uint8_t* at = map_ + cursor_;
+    const uint32_t size = get<uint32_t>(at + 12);
+    if (cursor_ + kEventHeader + pad8(size) > used_) return false;
+
+    out.timeNs = get<uint64_t>(at);
+    out.index = get<uint32_t>(at + 8);
+    out.size = size;
+    out.last = (get<uint32_t>(at + 16) & 1u) != 0;
+    out.data = at + kEventHeader;
+    cursor_ += kEventHeader + pad8(size);
+    return true;
+}
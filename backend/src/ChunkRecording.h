@@ -0,0 +1,100 @@
+#ifndef CHUNKRECORDING_H
+#define CHUNKRECORDING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+/*
+ * ==============================================================
+ * ChunkRecording
+ * ==============================================================
+ * fileChunk events of one transfer in a memory-mapped file, for
+ * benchmarking the receive pipeline offline:
+ *
+ *   header (64 bytes): "OTACREC1", version, chunk size, image size and
+ *                      CRC, event count, bytes used
+ *   per event:         arrival time (ns since the first event), index,
+ *                      payload size, flags (bit 0: last chunk), then the
+ *                      payload padded to 8 bytes
+ *
+ * Little endian, as written by the host. ChunkRecorder appends (thread
+ * safe, the file grows by doubling); ChunkRecording maps a finished file
+ * read-only and hands out pointers into it, so a replay copies nothing.
+ */
+struct ChunkRecordHeader {
+    uint32_t chunkSize = 0;
+    uint64_t imageSize = 0;
+    uint32_t imageCrc = 0;
+};
+
+class ChunkRecorder {
+   public:
+    ChunkRecorder() = default;
+    ~ChunkRecorder();
+
+    ChunkRecorder(const ChunkRecorder&) = delete;
+    ChunkRecorder& operator=(const ChunkRecorder&) = delete;
+
+    bool open(const std::string& path, const ChunkRecordHeader& header);
+    bool isOpen() const;
+    void append(uint32_t index, const uint8_t* data, size_t size, bool last);
+    // Writes the counts and trims the file to its used size
+    void close();
+
+    uint64_t events() const;
+
+   private:
+    bool reserve(uint64_t bytes);
+
+    mutable std::mutex mutex_;
+    int fd_ = -1;
+    uint8_t* map_ = nullptr;
+    uint64_t mapped_ = 0;
+    uint64_t used_ = 0;
+    uint64_t events_ = 0;
+    uint64_t startNs_ = 0;
+    std::string path_;
+};
+
+class ChunkRecording {
+   public:
+    struct Event {
+        uint64_t timeNs = 0;        // since the first event
+        uint32_t index = 0;
+        bool last = false;
+        const uint8_t* data = nullptr;
+        uint32_t size = 0;
+    };
+
+    ChunkRecording() = default;
+    ~ChunkRecording();
+
+    ChunkRecording(const ChunkRecording&) = delete;
+    ChunkRecording& operator=(const ChunkRecording&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    const ChunkRecordHeader& header() const { return header_; }
+    uint64_t events() const { return events_; }
+    uint64_t payloadBytes() const { return payload_; }
+
+    // Walks the events in recorded order; false past the last one
+    bool next(Event& out);
+    void rewind() { cursor_ = kHeaderSize; }
+
+    static constexpr size_t kHeaderSize = 64;
+
+   private:
+    const uint8_t* map_ = nullptr;
+    uint64_t size_ = 0;
+    uint64_t used_ = 0;
+    uint64_t cursor_ = kHeaderSize;
+    uint64_t events_ = 0;
+    uint64_t payload_ = 0;
+    ChunkRecordHeader header_;
+};
+
+#endif  // CHUNKRECORDING_H
@@ -0,0 +1,101 @@
+#include "Crc32.h"
+
+#include <cstring>
+
+namespace {
+
+const uint32_t kPolynomial = 0xEDB88320u;
+
+struct Tables {
+    uint32_t t[8][256];
+
+    Tables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? (c >> 1) ^ kPolynomial : (c >> 1);
+            t[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int s = 1; s < 8; ++s) t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xFF];
+        }
+    }
+};
+
+const Tables& tables() {
+    static const Tables instance;
+    return instance;
+}
+
+// GF(2) matrix helpers for combine(), as in zlib
+uint32_t gf2MatrixTimes(const uint32_t* mat, uint32_t vec) {
+    uint32_t sum = 0;
+    while (vec) {
+        if (vec & 1) sum ^= *mat;
+        vec >>= 1;
+        ++mat;
+    }
+    return sum;
+}
+
+void gf2MatrixSquare(uint32_t* square, const uint32_t* mat) {
+    for (int n = 0; n < 32; ++n) square[n] = gf2MatrixTimes(mat, mat[n]);
+}
+
+}  // namespace
+
+namespace crc32 {
+
+uint32_t update(uint32_t crc, const uint8_t* data, size_t len) {
+    const Tables& tb = tables();
+    crc = ~crc;
+
+    // Little-endian slicing-by-8 (the targets are little-endian ARM/x86)
+    while (len >= 8) {
+        uint32_t lo, hi;
+        std::memcpy(&lo, data, 4);
+        std::memcpy(&hi, data + 4, 4);
+        lo ^= crc;
+        crc = tb.t[7][lo & 0xFF] ^ tb.t[6][(lo >> 8) & 0xFF] ^
+              tb.t[5][(lo >> 16) & 0xFF] ^ tb.t[4][lo >> 24] ^
+              tb.t[3][hi & 0xFF] ^ tb.t[2][(hi >> 8) & 0xFF] ^
+              tb.t[1][(hi >> 16) & 0xFF] ^ tb.t[0][hi >> 24];
+        data += 8;
+        len -= 8;
+    }
+    while (len--) crc = (crc >> 8) ^ tb.t[0][(crc ^ *data++) & 0xFF];
+
+    return ~crc;
+}
+
+uint32_t combine(uint32_t crcA, uint32_t crcB, uint64_t lenB) {
+    if (lenB == 0) return crcA;
+
+    uint32_t even[32];
+    uint32_t odd[32];
+
+    // Operator for one zero bit
+    odd[0] = kPolynomial;
+    uint32_t row = 1;
+    for (int n = 1; n < 32; ++n) {
+        odd[n] = row;
+        row <<= 1;
+    }
+    gf2MatrixSquare(even, odd);   // two zero bits
+    gf2MatrixSquare(odd, even);   // four zero bits
+
+    // Apply lenB zero bytes to crcA
+    do {
+        gf2MatrixSquare(even, odd);
+        if (lenB & 1) crcA = gf2MatrixTimes(even, crcA);
+        lenB >>= 1;
+        if (lenB == 0) break;
+
+        gf2MatrixSquare(odd, even);
+        if (lenB & 1) crcA = gf2MatrixTimes(odd, crcA);
+        lenB >>= 1;
+    } while (lenB != 0);
+
+    return crcA ^ crcB;
+}
+
+}  // namespace crc32
@@ -0,0 +1,21 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * CRC-32 (IEEE 802.3, reflected, as zlib's crc32()).
+ * crc32Update() uses slicing-by-8 tables; crc32Combine() joins the CRCs of
+ * two adjacent blocks, so blocks can be hashed in parallel.
+ */
+namespace crc32 {
+
+uint32_t update(uint32_t crc, const uint8_t* data, size_t len);
+
+// CRC of A followed by B, given crc(A), crc(B) and the length of B
+uint32_t combine(uint32_t crcA, uint32_t crcB, uint64_t lenB);
+
+}  // namespace crc32
+
+#endif  // CRC32_H
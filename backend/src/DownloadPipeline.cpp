@@ -0,0 +1,304 @@
+#include "DownloadPipeline.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include "OtaLog.h"
+#include "ThreadPriority.h"
+
+// Dirty data is written out and dropped from the page cache in steps of
+static const off_t kWriteBehindStep = 4 * 1024 * 1024;
+// Smallest bucket depth; one chunk of the largest size in use
+static const uint64_t kMinBurst = 64 * 1024;
+
+constexpr size_t DownloadPipeline::kMaxWindow;
+
+DownloadPipeline::~DownloadPipeline() {
+    abort();
+}
+
+/*
+ * ==============================================================
+ * bool begin(const std::string& path, size_t chunkSize, uint32_t totalChunks)
+ * ==============================================================
+ * Prepares a new transfer, not paused. Any previous one is aborted first.
+ * beginRange() does the same for one range of a multi-stream download;
+ * each stream has its own pipeline and descriptor on the shared file.
+ */
+bool DownloadPipeline::begin(const std::string& path, size_t chunkSize, uint32_t totalChunks) {
+    return open(path, chunkSize, O_TRUNC, 0, totalChunks);
+}
+
+bool DownloadPipeline::beginRange(const std::string& path, size_t chunkSize, uint64_t baseOffset,
+                                  uint32_t totalChunks) {
+    return open(path, chunkSize, 0, baseOffset, totalChunks);
+}
+
+bool DownloadPipeline::open(const std::string& path, size_t chunkSize, int flags, uint64_t baseOffset,
+                            uint32_t totalChunks) {
+    abort();
+
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | flags, 0644);
+    if (fd_ < 0) {
+        OTA_LOG_ERROR("Pipeline", "Failed to open {}: {}", path, std::strerror(errno));
+        return false;
+    }
+
+    chunkSize_ = chunkSize;
+    baseOffset_ = static_cast<off_t>(baseOffset);
+    flushedUpTo_ = baseOffset_;
+    startedUpTo_ = baseOffset_;
+    totalChunks_ = totalChunks;
+    writtenChunks_ = 0;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        stopping_ = false;
+        paused_ = false;
+        queue_.clear();
+    }
+
+    active_ = true;
+    writer_ = std::thread([this]() { run(); });
+    return true;
+}
+
+void DownloadPipeline::abort() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        stopping_ = true;
+        for (Chunk& c : queue_) pool_.push_back(std::move(c.data));
+        queue_.clear();
+    }
+    notEmpty_.notify_all();
+    notFull_.notify_all();
+
+    if (writer_.joinable()) writer_.join();
+
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    active_ = false;
+}
+
+void DownloadPipeline::setWindow(size_t chunks) {
+    chunks = std::max<size_t>(1, std::min(chunks, kMaxWindow));
+    if (window_.exchange(chunks) < chunks) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        notFull_.notify_all();
+    }
+}
+
+void DownloadPipeline::setRateLimit(uint64_t bytesPerSec) {
+    if (bucket_.rate() == bytesPerSec) return;
+    bucket_.configure(bytesPerSec, std::max(kMinBurst, bytesPerSec / 20));
+
+    // A larger effective window may free credits
+    std::lock_guard<std::mutex> lk(mutex_);
+    notFull_.notify_all();
+}
+
+void DownloadPipeline::setPaused(bool paused) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    paused_ = paused;
+    if (!paused) notFull_.notify_all();
+}
+
+bool DownloadPipeline::isPaused() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return paused_;
+}
+
+size_t DownloadPipeline::effectiveWindow() const {
+    const size_t window = window_.load();
+    if (bucket_.rate() == 0 || chunkSize_ == 0) return window;
+    const size_t depth = static_cast<size_t>(bucket_.burst() / chunkSize_);
+    return std::max<size_t>(1, std::min(window, depth));
+}
+
+size_t DownloadPipeline::queued() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return queue_.size();
+}
+
+size_t DownloadPipeline::credits() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    const size_t window = window_.load();
+    return paused_ || queue_.size() >= window ? 0 : window - queue_.size();
+}
+
+uint64_t DownloadPipeline::reserve(uint64_t bytes) {
+    return bucket_.reserve(bytes, TokenBucket::nowNs());
+}
+
+void DownloadPipeline::setWrittenCallback(WrittenCallback cb) {
+    writtenCb_ = std::move(cb);
+}
+
+void DownloadPipeline::setErrorCallback(ErrorCallback cb) {
+    errorCb_ = std::move(cb);
+}
+
+/*
+ * ==============================================================
+ * bool offer(uint32_t index, const uint8_t* data, size_t size, bool lastChunk)
+ * ==============================================================
+ * Takes the chunk only if it fits the window right now. The rate limit
+ * is not charged here: the caller has done that when it asked for it.
+ */
+bool DownloadPipeline::offer(uint32_t index, const uint8_t* data, size_t size, bool lastChunk) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (stopping_ || !active_ || paused_ || queue_.size() >= window_.load()) return false;
+    enqueue(index, data, size, lastChunk);
+    return true;
+}
+
+/*
+ * ==============================================================
+ * bool push(uint32_t index, const uint8_t* data, size_t size, bool lastChunk)
+ * ==============================================================
+ * Waits while paused, then for the chunk's tokens and a free credit, and
+ * queues a copy of it.
+ */
+bool DownloadPipeline::push(uint32_t index, const uint8_t* data, size_t size, bool lastChunk) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    notFull_.wait(lk, [this]() { return stopping_ || !paused_; });
+
+    const uint64_t waitNs = bucket_.reserve(size, TokenBucket::nowNs());
+    if (waitNs > 0) {
+        notFull_.wait_for(lk, std::chrono::nanoseconds(waitNs), [this]() { return stopping_; });
+    }
+    notFull_.wait(lk, [this]() { return stopping_ || queue_.size() < effectiveWindow(); });
+    if (stopping_ || !active_) return false;
+
+    enqueue(index, data, size, lastChunk);
+    return true;
+}
+
+// Buffers are recycled, so a transfer allocates at most window + 1 of them
+void DownloadPipeline::enqueue(uint32_t index, const uint8_t* data, size_t size, bool lastChunk) {
+    Chunk chunk;
+    chunk.index = index;
+    chunk.last = lastChunk;
+    if (!pool_.empty()) {
+        chunk.data = std::move(pool_.back());
+        pool_.pop_back();
+    }
+    chunk.data.assign(data, data + size);
+
+    queue_.push_back(std::move(chunk));
+    notEmpty_.notify_one();
+}
+
+/*
+ * ==============================================================
+ * void run()
+ * ==============================================================
+ * Writer thread body. Ends after the last chunk (by count when the total
+ * is known) or on abort(). The caller queues every chunk once.
+ */
+void DownloadPipeline::run() {
+    bool lowPriority = false;
+    for (;;) {
+        if (background_.load() != lowPriority) {
+            lowPriority = !lowPriority;
+            if (!threadpriority::setCurrentThreadBackground(lowPriority)) {
+                OTA_LOG_DEBUG("Pipeline", "Writer priority change (background {}) not fully applied", lowPriority);
+            }
+        }
+
+        Chunk chunk;
+        {
+            std::unique_lock<std::mutex> lk(mutex_);
+            notEmpty_.wait(lk, [this]() { return stopping_ || !queue_.empty(); });
+            if (stopping_) return;
+            chunk = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        const bool ok = writeChunk(chunk);
+        const uint32_t index = chunk.index;
+        const bool last = totalChunks_ > 0 ? ++writtenChunks_ == totalChunks_ : chunk.last;
+
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            pool_.push_back(std::move(chunk.data));
+            notFull_.notify_one();
+        }
+
+        if (!ok) {
+            if (errorCb_) errorCb_("Failed to write update file");
+            std::lock_guard<std::mutex> lk(mutex_);
+            stopping_ = true;
+            notFull_.notify_all();
+            return;
+        }
+
+        if (last) finish();
+        if (writtenCb_) writtenCb_(index, last);
+        if (last) return;
+    }
+}
+
+bool DownloadPipeline::writeChunk(const Chunk& chunk) {
+    const off_t offset = baseOffset_ + static_cast<off_t>(chunk.index) * static_cast<off_t>(chunkSize_);
+    const uint8_t* p = chunk.data.data();
+    size_t left = chunk.data.size();
+    off_t at = offset;
+
+    while (left > 0) {
+        const ssize_t n = ::pwrite(fd_, p, left, at);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            OTA_LOG_ERROR("Pipeline", "pwrite of chunk {} failed: {}", chunk.index, std::strerror(errno));
+            return false;
+        }
+        p += n;
+        at += n;
+        left -= static_cast<size_t>(n);
+    }
+
+    if (writeThrough_) {
+        sync_file_range(fd_, offset, at - offset,
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        posix_fadvise(fd_, offset, at - offset, POSIX_FADV_DONTNEED);
+        return true;
+    }
+
+    writeBehind(at);
+    return true;
+}
+
+/*
+ * Starts write-out of the newest step and waits for (then drops) the one
+ * before it, so the disk stays busy while at most two steps are dirty.
+ */
+void DownloadPipeline::writeBehind(off_t end) {
+    if (end - startedUpTo_ < kWriteBehindStep) return;
+
+    sync_file_range(fd_, startedUpTo_, end - startedUpTo_, SYNC_FILE_RANGE_WRITE);
+
+    if (startedUpTo_ > flushedUpTo_) {
+        const off_t len = startedUpTo_ - flushedUpTo_;
+        sync_file_range(fd_, flushedUpTo_, len,
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        posix_fadvise(fd_, flushedUpTo_, len, POSIX_FADV_DONTNEED);
+        flushedUpTo_ = startedUpTo_;
+    }
+    startedUpTo_ = end;
+}
+
+void DownloadPipeline::finish() {
+    if (fdatasync(fd_) != 0) {
+        OTA_LOG_WARN("Pipeline", "fdatasync failed: {}", std::strerror(errno));
+    }
+    posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd_);
+    fd_ = -1;
+    active_ = false;
+}
@@ -0,0 +1,147 @@
+#ifndef DOWNLOADPIPELINE_H
+#define DOWNLOADPIPELINE_H
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TokenBucket.h"
+
+/*
+ * ==============================================================
+ * DownloadPipeline
+ * ==============================================================
+ * Decouples chunk reception from disk writes.
+ * - offer() (event dispatch thread) copies the chunk into a pooled buffer
+ *   and queues it; a writer thread stores it with pwrite() at
+ *   base offset + index * chunkSize (the base is 0 for a whole file).
+ * - The credit window is the number of chunks allowed in the queue.
+ *   offer() never waits: a chunk that finds the window full or the
+ *   pipeline paused is refused, and the caller asks the sender for it
+ *   again. Waiting there would not hold the sender back, vsomeip keeps
+ *   reading the socket into its own unbounded queue. push() waits
+ *   instead, for producers on a thread of their own (replay).
+ * - A rate limit is a token bucket. A caller that paces its sender
+ *   charges it with reserve() per request; push() charges it per chunk,
+ *   and its window shrinks to the bucket depth.
+ * - A transfer ends once its known number of chunks is written, so the
+ *   arrival order does not matter.
+ * - Written data is flushed behind the writer and dropped from the page
+ *   cache, so a large image does not fill memory with dirty pages.
+ */
+class DownloadPipeline {
+   public:
+    // Called on the writer thread once a chunk is on disk
+    using WrittenCallback = std::function<void(uint32_t index, bool lastChunk)>;
+    using ErrorCallback = std::function<void(const std::string&)>;
+
+    static constexpr size_t kMaxWindow = 32;   // chunks
+
+    DownloadPipeline() = default;
+    ~DownloadPipeline();
+
+    DownloadPipeline(const DownloadPipeline&) = delete;
+    DownloadPipeline& operator=(const DownloadPipeline&) = delete;
+
+    // Opens (truncates) path and starts the writer thread. With totalChunks
+    // the transfer ends once that many chunks are written, in whatever
+    // order; without, on the chunk pushed as the last one.
+    bool begin(const std::string& path, size_t chunkSize, uint32_t totalChunks = 0);
+    // Same for one byte range of a file sized beforehand: chunk index i is
+    // written at baseOffset + i * chunkSize and the file is not truncated
+    bool beginRange(const std::string& path, size_t chunkSize, uint64_t baseOffset, uint32_t totalChunks);
+    // Stops the writer, dropping queued chunks, and closes the file
+    void abort();
+    bool isActive() const { return active_.load(); }
+
+    // Queues the chunk if a credit is free and not paused, without
+    // waiting. False if refused or not active.
+    bool offer(uint32_t index, const uint8_t* data, size_t size, bool lastChunk);
+    // Waits while paused, for the chunk's tokens and for a credit.
+    // Not for an event dispatch thread. Returns false if not active.
+    bool push(uint32_t index, const uint8_t* data, size_t size, bool lastChunk);
+
+    // Credit window in chunks, clamped to [1, kMaxWindow]. Thread safe.
+    void setWindow(size_t chunks);
+    size_t window() const { return window_.load(); }
+    // Window actually granted: the above, capped by the bucket depth
+    size_t effectiveWindow() const;
+    size_t queued() const;
+    // Chunks offer() would take now; 0 while paused
+    size_t credits() const;
+
+    // When set, every chunk is on disk and out of the page cache before the
+    // next one is taken: no dirty backlog, reception runs at disk speed.
+    void setWriteThrough(bool enabled) { writeThrough_ = enabled; }
+
+    // Average rate cap in bytes/s, 0 for none. Takes effect on the next
+    // push() or reserve(), also mid-transfer; the burst is 50 ms of it.
+    void setRateLimit(uint64_t bytesPerSec);
+    uint64_t rateLimit() const { return bucket_.rate(); }
+    // Charges bytes the caller is about to ask the sender for; returns
+    // how long it should wait (ns) before the next request
+    uint64_t reserve(uint64_t bytes);
+
+    // Stops granting credits until resumed: offer() refuses, push() waits.
+    // Queued chunks are still written. Thread safe.
+    void setPaused(bool paused);
+    bool isPaused() const;
+
+    // Runs the writer thread at background priority (ThreadPriority.h).
+    // Applied by the writer itself before its next chunk.
+    void setBackground(bool background) { background_ = background; }
+
+    void setWrittenCallback(WrittenCallback cb);
+    void setErrorCallback(ErrorCallback cb);
+
+   private:
+    struct Chunk {
+        uint32_t index = 0;
+        bool last = false;
+        std::vector<uint8_t> data;
+    };
+
+    bool open(const std::string& path, size_t chunkSize, int flags, uint64_t baseOffset, uint32_t totalChunks);
+    void enqueue(uint32_t index, const uint8_t* data, size_t size, bool lastChunk);   // mutex_ held
+    void run();
+    bool writeChunk(const Chunk& chunk);
+    void writeBehind(off_t end);
+    void finish();
+
+    int fd_ = -1;
+    size_t chunkSize_ = 0;
+    off_t baseOffset_ = 0;
+    off_t flushedUpTo_ = 0;    // page cache already written out and dropped
+    off_t startedUpTo_ = 0;    // write-out started
+    uint32_t totalChunks_ = 0; // 0: the last flag ends the transfer
+    uint32_t writtenChunks_ = 0;
+    TokenBucket bucket_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::deque<Chunk> queue_;
+    std::vector<std::vector<uint8_t>> pool_;
+    bool stopping_ = false;
+    bool paused_ = false;
+
+    std::atomic<bool> active_{false};
+    std::atomic<size_t> window_{kMaxWindow};
+    std::atomic<bool> writeThrough_{false};
+    std::atomic<bool> background_{false};
+    std::thread writer_;
+
+    WrittenCallback writtenCb_;
+    ErrorCallback errorCb_;
+};
+
+#endif  // DOWNLOADPIPELINE_H
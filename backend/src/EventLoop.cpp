@@ -0,0 +1,248 @@
+#include "EventLoop.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <ctime>
+
+namespace {
+
+enum : uint32_t {
+    kWakeTag = 1,
+    kTimerTag = 2
+};
+
+}  // namespace
+
+EventLoop::EventLoop() {
+    epochNs_ = monotonicNs();
+}
+
+EventLoop::~EventLoop() {
+    stop();
+}
+
+uint64_t EventLoop::monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+uint64_t EventLoop::nextGridPoint(uint64_t nowNs, uint64_t intervalNs) const {
+    const uint64_t elapsed = (nowNs > epochNs_) ? (nowNs - epochNs_) : 0;
+    return epochNs_ + (elapsed / intervalNs + 1) * intervalNs;
+}
+
+/*
+ * ==============================================================
+ * bool start()
+ * ==============================================================
+ * Creates the epoll instance with its timerfd and eventfd and starts the
+ * loop thread. Timers may be added before or after start().
+ */
+bool EventLoop::start() {
+    if (running_) return true;
+
+    const int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    const int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    const int wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        epollFd_ = epollFd;
+        timerFd_ = timerFd;
+        wakeFd_ = wakeFd;
+        stopped_ = false;
+    }
+
+    if (epollFd_ < 0 || timerFd_ < 0 || wakeFd_ < 0) {
+        stop();
+        return false;
+    }
+
+    struct epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.u32 = kWakeTag;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+    ev.data.u32 = kTimerTag;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, timerFd_, &ev);
+
+    running_ = true;
+    thread_ = std::thread([this]() { run(); });
+    return true;
+}
+
+/*
+ * The descriptors are closed under mutex_ after the loop thread is gone,
+ * and wakeFd_ is -1 from then on: a concurrent post() or addTimer() sees
+ * either the open eventfd or no eventfd, never a closed or reused number.
+ */
+void EventLoop::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        stopped_ = true;
+        if (running_.exchange(false)) wakeLocked();
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (epollFd_ >= 0) ::close(epollFd_);
+    if (timerFd_ >= 0) ::close(timerFd_);
+    if (wakeFd_ >= 0) ::close(wakeFd_);
+    epollFd_ = timerFd_ = wakeFd_ = -1;
+    posted_.clear();
+}
+
+// Caller holds mutex_
+void EventLoop::wakeLocked() {
+    if (wakeFd_ < 0) return;
+    const uint64_t one = 1;
+    ssize_t n;
+    do {
+        n = ::write(wakeFd_, &one, sizeof(one));
+    } while (n < 0 && errno == EINTR);
+}
+
+EventLoop::TimerId EventLoop::addTimer(uint32_t intervalMs, Task task) {
+    auto timer = std::make_shared<Timer>();
+    timer->intervalNs = static_cast<uint64_t>(std::max<uint32_t>(intervalMs, 1)) * 1000000ULL;
+    timer->nextNs = nextGridPoint(monotonicNs(), timer->intervalNs);
+    timer->task = std::move(task);
+
+    std::lock_guard<std::mutex> lk(mutex_);
+    timer->id = nextId_++;
+    timers_.push_back(timer);
+    wakeLocked();
+    return timer->id;
+}
+
+/*
+ * Changing an interval moves the timer to the next point of its new grid,
+ * so a faster rate applies immediately and a slower one does not
+ * postpone an already close deadline past the new period.
+ */
+bool EventLoop::setInterval(TimerId id, uint32_t intervalMs) {
+    const uint64_t intervalNs = static_cast<uint64_t>(std::max<uint32_t>(intervalMs, 1)) * 1000000ULL;
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto it = std::find_if(timers_.begin(), timers_.end(),
+                           [id](const std::shared_ptr<Timer>& t) { return t->id == id; });
+    if (it == timers_.end()) return false;
+    if ((*it)->intervalNs == intervalNs) return true;
+
+    (*it)->intervalNs = intervalNs;
+    (*it)->nextNs = std::min((*it)->nextNs, nextGridPoint(monotonicNs(), intervalNs));
+    wakeLocked();
+    return true;
+}
+
+void EventLoop::removeTimer(TimerId id) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    timers_.erase(std::remove_if(timers_.begin(), timers_.end(),
+                                 [id](const std::shared_ptr<Timer>& t) { return t->id == id; }),
+                  timers_.end());
+    wakeLocked();
+}
+
+bool EventLoop::post(Task task) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (stopped_) return false;
+    posted_.push_back(std::move(task));
+    wakeLocked();
+    return true;
+}
+
+void EventLoop::setBatchEndHandler(Task task) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    batchEnd_ = std::move(task);
+}
+
+// Arms the timerfd for the earliest deadline (absolute), or disarms it
+void EventLoop::rearm() {
+    uint64_t earliest = UINT64_MAX;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        for (const auto& t : timers_) earliest = std::min(earliest, t->nextNs);
+    }
+
+    struct itimerspec spec {};
+    if (earliest != UINT64_MAX) {
+        spec.it_value.tv_sec = static_cast<time_t>(earliest / 1000000000ULL);
+        spec.it_value.tv_nsec = static_cast<long>(earliest % 1000000000ULL);
+    }
+    timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void EventLoop::runDueTimers(uint64_t nowNs) {
+    std::vector<std::shared_ptr<Timer>> due;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        for (const auto& t : timers_) {
+            if (t->nextNs <= nowNs) {
+                // Missed periods are skipped, not replayed
+                t->nextNs = nextGridPoint(nowNs, t->intervalNs);
+                due.push_back(t);
+            }
+        }
+    }
+    for (const auto& t : due) {
+        if (t->task) t->task();
+    }
+}
+
+void EventLoop::runPosted() {
+    std::vector<Task> tasks;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        tasks.swap(posted_);
+    }
+    for (auto& task : tasks) {
+        if (task) task();
+    }
+}
+
+/*
+ * ==============================================================
+ * void run()
+ * ==============================================================
+ * Loop thread body. Blocks in epoll_wait without timeout; every return
+ * counts as one wakeup.
+ */
+void EventLoop::run() {
+    struct epoll_event events[4];
+
+    while (running_) {
+        rearm();
+
+        const int n = epoll_wait(epollFd_, events, 4, -1);
+        wakeups_.fetch_add(1, std::memory_order_relaxed);
+
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            uint64_t counter = 0;
+            const int fd = (events[i].data.u32 == kWakeTag) ? wakeFd_ : timerFd_;
+            while (::read(fd, &counter, sizeof(counter)) > 0) {
+            }
+        }
+
+        if (!running_) break;
+
+        runPosted();
+        runDueTimers(monotonicNs());
+
+        Task batchEnd;
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            batchEnd = batchEnd_;
+        }
+        if (batchEnd) batchEnd();
+    }
+}
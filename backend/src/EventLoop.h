@@ -0,0 +1,91 @@
+#ifndef EVENTLOOP_H
+#define EVENTLOOP_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * ==============================================================
+ * EventLoop
+ * ==============================================================
+ * Single backend thread driven by epoll.
+ * - One timerfd is armed for the earliest timer deadline, so the thread
+ *   only wakes when work is due.
+ * - Timer deadlines sit on a grid anchored at loop creation
+ *   (next multiple of the interval), so timers with related intervals
+ *   fire in the same wakeup.
+ * - An eventfd wakes the loop for posted tasks, interval changes and stop(),
+ *   which therefore returns immediately.
+ * - The descriptors are only touched under mutex_ (and by the loop thread
+ *   while it runs), so a wake from another thread never races stop().
+ */
+class EventLoop {
+   public:
+    using Task = std::function<void()>;
+    using TimerId = int;
+
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    bool start();
+    void stop();
+    bool isRunning() const { return running_.load(); }
+
+    // Periodic timer, first fire at the next grid point. Thread safe.
+    TimerId addTimer(uint32_t intervalMs, Task task);
+    bool setInterval(TimerId id, uint32_t intervalMs);
+    void removeTimer(TimerId id);
+
+    // Runs task on the loop thread. Thread safe. Tasks posted before start()
+    // run once it starts; after stop() they are refused (false), and the
+    // ones still queued at stop() are discarded.
+    bool post(Task task);
+
+    // Runs after every wakeup, once all due timers and posted tasks ran
+    void setBatchEndHandler(Task task);
+
+    // Number of times the loop thread returned from epoll_wait
+    uint64_t wakeups() const { return wakeups_.load(std::memory_order_relaxed); }
+
+   private:
+    struct Timer {
+        TimerId id;
+        uint64_t intervalNs;
+        uint64_t nextNs;
+        Task task;
+    };
+
+    void run();
+    void wakeLocked();
+    void rearm();
+    void runDueTimers(uint64_t nowNs);
+    void runPosted();
+    uint64_t nextGridPoint(uint64_t nowNs, uint64_t intervalNs) const;
+    static uint64_t monotonicNs();
+
+    int epollFd_ = -1;
+    int timerFd_ = -1;
+    int wakeFd_ = -1;               // mutex_
+    uint64_t epochNs_ = 0;
+
+    std::mutex mutex_;
+    bool stopped_ = false;          // stop() ran, until the next start()
+    std::vector<std::shared_ptr<Timer>> timers_;
+    std::vector<Task> posted_;
+    Task batchEnd_;
+    TimerId nextId_ = 1;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> wakeups_{0};
+};
+
+#endif  // EVENTLOOP_H
@@ -0,0 +1,200 @@
+#include "FaultInjector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+namespace {
+
+bool parseProbability(const std::string& text, double& out) {
+    char* end = nullptr;
+    const double v = std::strtod(text.c_str(), &end);
+    if (text.empty() || *end != '\0' || !(v >= 0.0 && v <= 1.0)) return false;
+    out = v;
+    return true;
+}
+
+bool parseUnsigned(const std::string& text, uint64_t& out) {
+    if (text.empty() || text[0] < '0' || text[0] > '9') return false;
+    char* end = nullptr;
+    out = std::strtoull(text.c_str(), &end, 10);
+    return *end == '\0';
+}
+
+}  // namespace
+
+bool FaultInjector::parseConfig(const char* text, Config& out) {
+    if (!text || !*text) return false;
+    Config c;
+    const std::string spec(text);
+    size_t from = 0;
+    while (from <= spec.size()) {
+        const size_t comma = std::min(spec.find(',', from), spec.size());
+        const std::string item = spec.substr(from, comma - from);
+        from = comma + 1;
+        if (item.empty()) continue;
+
+        const size_t eq = item.find('=');
+        if (eq == std::string::npos) return false;
+        const std::string key = item.substr(0, eq);
+        const std::string value = item.substr(eq + 1);
+        uint64_t n = 0;
+
+        bool ok = true;
+        if (key == "drop") {
+            ok = parseProbability(value, c.drop);
+        } else if (key == "dup") {
+            ok = parseProbability(value, c.duplicate);
+        } else if (key == "reorder") {
+            ok = parseProbability(value, c.reorder);
+        } else if (key == "stall") {
+            ok = parseProbability(value, c.stall);
+        } else if (key == "restart") {
+            ok = parseProbability(value, c.restart);
+        } else if (key == "seed" && (ok = parseUnsigned(value, n))) {
+            c.seed = static_cast<uint32_t>(n);
+        } else if (key == "depth" && (ok = parseUnsigned(value, n))) {
+            c.depth = static_cast<unsigned>(std::max<uint64_t>(n, 1));
+        } else if (key == "stall_ms" && (ok = parseUnsigned(value, n))) {
+            c.stallMs = static_cast<unsigned>(n);
+        } else if (key == "restart_ms" && (ok = parseUnsigned(value, n))) {
+            c.restartMs = static_cast<unsigned>(n);
+        } else if (key == "after") {
+            ok = parseUnsigned(value, c.after);
+        } else if (key == "limit") {
+            ok = parseUnsigned(value, c.limit);
+        } else {
+            return false;
+        }
+        if (!ok) return false;
+    }
+    if (c.drop + c.duplicate + c.reorder + c.stall + c.restart > 1.0) return false;
+    out = c;
+    return true;
+}
+
+const char* FaultInjector::name(Fault fault) {
+    switch (fault) {
+        case Fault::Drop: return "drop";
+        case Fault::Duplicate: return "dup";
+        case Fault::Reorder: return "reorder";
+        case Fault::Stall: return "stall";
+        case Fault::Restart: return "restart";
+        case Fault::None: break;
+    }
+    return "none";
+}
+
+FaultInjector::FaultInjector(const Config& config)
+    : config_(config),
+      rng_(config.seed) {}
+
+void FaultInjector::reset() {
+    rng_.seed(config_.seed);
+    uniform_.reset();
+    drawn_ = 0;
+    faults_ = 0;
+    held_.clear();
+    chunks_ = dropped_ = duplicated_ = reordered_ = stalls_ = restarts_ = 0;
+}
+
+/*
+ * ==============================================================
+ * Fault next()
+ * ==============================================================
+ * One draw per chunk, also for the chunks passed untouched, so a fault
+ * stays on the same chunk whatever `after` and `limit` say.
+ */
+FaultInjector::Fault FaultInjector::next() {
+    const double u = uniform_(rng_);
+    if (drawn_++ < config_.after) return Fault::None;
+    if (config_.limit > 0 && faults_ >= config_.limit) return Fault::None;
+
+    double edge = config_.drop;
+    Fault fault = Fault::None;
+    if (u < edge) {
+        fault = Fault::Drop;
+    } else if (u < (edge += config_.duplicate)) {
+        fault = Fault::Duplicate;
+    } else if (u < (edge += config_.reorder)) {
+        fault = Fault::Reorder;
+    } else if (u < (edge += config_.stall)) {
+        fault = Fault::Stall;
+    } else if (u < (edge += config_.restart)) {
+        fault = Fault::Restart;
+    }
+    if (fault != Fault::None) ++faults_;
+    return fault;
+}
+
+/*
+ * ==============================================================
+ * Fault apply(uint32_t index, const uint8_t* data, size_t size, bool last, const Deliver& deliver)
+ * ==============================================================
+ * The last chunk of a stream is not held back, as nothing would follow
+ * to release it; it releases everything held instead, right before it,
+ * so a receiver that ends on the last chunk still has them all. A
+ * duplicate goes right after its original.
+ */
+FaultInjector::Fault FaultInjector::apply(uint32_t index, const uint8_t* data, size_t size, bool last,
+                                          const Deliver& deliver) {
+    ++chunks_;
+    Fault fault = next();
+    if (fault == Fault::Reorder && last) fault = Fault::None;
+
+    switch (fault) {
+        case Fault::Drop:
+            ++dropped_;
+            return fault;
+        case Fault::Restart:
+            ++restarts_;
+            return fault;
+        case Fault::Reorder:
+            ++reordered_;
+            held_.push_back(Held{index, std::vector<uint8_t>(data, data + size), last, config_.depth});
+            return fault;
+        case Fault::Stall:
+            ++stalls_;
+            std::this_thread::sleep_for(std::chrono::milliseconds(config_.stallMs));
+            break;
+        case Fault::Duplicate:
+            ++duplicated_;
+            break;
+        case Fault::None:
+            break;
+    }
+    if (last) release(deliver, true);
+    deliver(index, data, size, last);
+    if (fault == Fault::Duplicate) deliver(index, data, size, last);
+    if (!last) release(deliver, false);
+    return fault;
+}
+
+void FaultInjector::flush(const Deliver& deliver) {
+    release(deliver, true);
+}
+
+// Counts one chunk through for every held chunk and delivers the ones due
+void FaultInjector::release(const Deliver& deliver, bool all) {
+    for (Held& h : held_) {
+        if (h.due > 0) --h.due;
+    }
+    while (!held_.empty() && (all || held_.front().due == 0)) {
+        const Held h = std::move(held_.front());
+        held_.pop_front();
+        deliver(h.index, h.data.data(), h.data.size(), h.last);
+    }
+}
+
+FaultInjector::Stats FaultInjector::stats() const {
+    Stats s;
+    s.chunks = chunks_;
+    s.dropped = dropped_;
+    s.duplicated = duplicated_;
+    s.reordered = reordered_;
+    s.stalls = stalls_;
+    s.restarts = restarts_;
+    return s;
+}
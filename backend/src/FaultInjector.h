@@ -0,0 +1,117 @@
+#ifndef FAULTINJECTOR_H
+#define FAULTINJECTOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <random>
+#include <vector>
+
+/*
+ * ==============================================================
+ * FaultInjector
+ * ==============================================================
+ * Test mode fault schedule for a chunk stream, on either end: the client
+ * puts it between the fileChunk subscription and onChunk (OTA_FAULTS),
+ * the reference gateway between its scheduler and the event
+ * (OTA_GW_FAULTS). For every chunk one draw of a seeded generator picks
+ * at most one fault:
+ *
+ *   drop       the chunk is not delivered
+ *   duplicate  delivered twice
+ *   reorder    held back until `depth` later chunks went through, or
+ *              until the stream's last chunk, which they go before
+ *   stall      delivered after stallMs, blocking the stream meanwhile
+ *   restart    the sender goes away for restartMs; only the gateway acts
+ *              on it, for the chunk stream it is a drop
+ *
+ * The same seed and the same chunk sequence give the same faults, so a
+ * failing run can be repeated. The first `after` chunks pass untouched,
+ * and with a limit the schedule ends after that many faults.
+ * One stream and one caller at a time; stats() may be read anywhere.
+ */
+class FaultInjector {
+   public:
+    enum class Fault { None, Drop, Duplicate, Reorder, Stall, Restart };
+
+    struct Config {
+        uint32_t seed = 1;
+        double drop = 0.0;              // probability per chunk
+        double duplicate = 0.0;
+        double reorder = 0.0;
+        double stall = 0.0;
+        double restart = 0.0;
+        unsigned depth = 4;
+        unsigned stallMs = 500;
+        unsigned restartMs = 2000;
+        uint64_t after = 0;
+        uint64_t limit = 0;             // 0: no limit
+
+        bool enabled() const { return drop + duplicate + reorder + stall + restart > 0.0; }
+    };
+
+    // "seed=7,drop=0.01,dup=0.005,reorder=0.01,depth=4,stall=0.001,
+    // stall_ms=500,restart=0.0005,restart_ms=2000,after=100,limit=5"
+    static bool parseConfig(const char* text, Config& out);
+    static const char* name(Fault fault);
+
+    struct Stats {
+        uint64_t chunks = 0;
+        uint64_t dropped = 0;
+        uint64_t duplicated = 0;
+        uint64_t reordered = 0;
+        uint64_t stalls = 0;
+        uint64_t restarts = 0;
+
+        uint64_t faults() const { return dropped + duplicated + reordered + stalls + restarts; }
+    };
+
+    using Deliver = std::function<void(uint32_t index, const uint8_t* data, size_t size, bool last)>;
+
+    explicit FaultInjector(const Config& config);
+
+    const Config& config() const { return config_; }
+
+    // Starts the schedule over from the seed, forgetting held chunks
+    void reset();
+
+    // Draws the fault for the next chunk
+    Fault next();
+
+    // next() applied to one chunk: deliver is called zero, one or more
+    // times (held chunks come out here too). Returns the fault drawn.
+    Fault apply(uint32_t index, const uint8_t* data, size_t size, bool last, const Deliver& deliver);
+
+    // Delivers the chunks still held back
+    void flush(const Deliver& deliver);
+
+    Stats stats() const;
+
+   private:
+    struct Held {
+        uint32_t index;
+        std::vector<uint8_t> data;
+        bool last;
+        unsigned due;               // chunks still to go through first
+    };
+
+    void release(const Deliver& deliver, bool all);
+
+    const Config config_;
+    std::mt19937 rng_;
+    std::uniform_real_distribution<double> uniform_{0.0, 1.0};
+    uint64_t drawn_ = 0;
+    uint64_t faults_ = 0;
+    std::deque<Held> held_;
+
+    std::atomic<uint64_t> chunks_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> duplicated_{0};
+    std::atomic<uint64_t> reordered_{0};
+    std::atomic<uint64_t> stalls_{0};
+    std::atomic<uint64_t> restarts_{0};
+};
+
+#endif  // FAULTINJECTOR_H
@@ -0,0 +1,133 @@
+#include "FecDecoder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+constexpr uint32_t FecDecoder::kParityFlag;
+
+bool FecDecoder::parseConfig(const char* text, Config& out) {
+    if (!text || !*text) return false;
+    char* end = nullptr;
+    const unsigned long k = std::strtoul(text, &end, 10);
+    if (*end != ',') return false;
+    const unsigned long m = std::strtoul(end + 1, &end, 10);
+    if (*end != '\0' || k == 0 || m == 0 || k + m > 256) return false;
+    out.k = static_cast<unsigned>(k);
+    out.m = static_cast<unsigned>(m);
+    return true;
+}
+
+FecDecoder::FecDecoder()
+    : codec_(0, 0) {}
+
+void FecDecoder::reset(const Config& config, uint64_t fileSize, size_t chunkSize) {
+    config_ = config;
+    codec_ = ReedSolomon(config.k, config.m);
+    fileSize_ = fileSize;
+    chunkSize_ = chunkSize;
+    chunks_ = chunkSize ? static_cast<uint32_t>((fileSize + chunkSize - 1) / chunkSize) : 0;
+    open_.clear();
+    closed_.assign(config.k ? (chunks_ + config.k - 1) / config.k : 0, false);
+    rebuilt_ = 0;
+    dropped_ = 0;
+}
+
+unsigned FecDecoder::dataInBlock(uint32_t block) const {
+    const uint32_t first = block * config_.k;
+    return static_cast<unsigned>(std::min<uint32_t>(config_.k, chunks_ - first));
+}
+
+size_t FecDecoder::chunkLength(uint32_t index) const {
+    const uint64_t offset = static_cast<uint64_t>(index) * chunkSize_;
+    return static_cast<size_t>(std::min<uint64_t>(chunkSize_, fileSize_ - offset));
+}
+
+// Open block, or nullptr if it is closed; drops the oldest one when full
+FecDecoder::Block* FecDecoder::openBlock(uint32_t block) {
+    if (block >= closed_.size() || closed_[block]) return nullptr;
+
+    auto it = open_.find(block);
+    if (it != open_.end()) return &it->second;
+
+    if (open_.size() >= config_.maxOpenBlocks) {
+        open_.erase(open_.begin());
+        ++dropped_;
+    }
+
+    Block& b = open_[block];
+    b.shards.resize(config_.k + config_.m);
+    b.present.assign(config_.k + config_.m, false);
+    return &b;
+}
+
+void FecDecoder::addData(uint32_t index, const uint8_t* data, size_t size, std::vector<Chunk>& rebuilt) {
+    if (!isEnabled() || index >= chunks_) return;
+    const uint32_t block = index / config_.k;
+    Block* b = openBlock(block);
+    if (!b) return;
+
+    const unsigned slot = index % config_.k;
+    if (b->present[slot]) return;
+    b->shards[slot].assign(chunkSize_, 0);
+    std::memcpy(b->shards[slot].data(), data, std::min(size, chunkSize_));
+    b->present[slot] = true;
+    ++b->dataPresent;
+
+    tryDecode(block, *b, rebuilt);
+}
+
+void FecDecoder::addParity(uint32_t parityIndex, const uint8_t* data, size_t size, std::vector<Chunk>& rebuilt) {
+    if (!isEnabled()) return;
+    parityIndex &= ~kParityFlag;
+    const uint32_t block = parityIndex / config_.m;
+    Block* b = openBlock(block);
+    if (!b) return;
+
+    const unsigned slot = config_.k + parityIndex % config_.m;
+    if (b->present[slot]) return;
+    b->shards[slot].assign(chunkSize_, 0);
+    std::memcpy(b->shards[slot].data(), data, std::min(size, chunkSize_));
+    b->present[slot] = true;
+    ++b->parityPresent;
+
+    tryDecode(block, *b, rebuilt);
+}
+
+/*
+ * Closes the block once all its data is there, or rebuilds the missing
+ * data as soon as enough parity came. The zero shards padding a short
+ * last block count as present.
+ */
+void FecDecoder::tryDecode(uint32_t block, Block& b, std::vector<Chunk>& rebuilt) {
+    const unsigned data = dataInBlock(block);
+    if (b.dataPresent == data) {
+        closed_[block] = true;
+        open_.erase(block);
+        return;
+    }
+    if (b.dataPresent + (config_.k - data) + b.parityPresent < config_.k) return;
+
+    std::vector<uint8_t*> shards(config_.k + config_.m);
+    std::unique_ptr<bool[]> present(new bool[config_.k + config_.m]);
+    for (unsigned i = 0; i < config_.k + config_.m; ++i) {
+        const bool padding = i >= data && i < config_.k;
+        if (b.shards[i].empty()) b.shards[i].assign(chunkSize_, 0);
+        shards[i] = b.shards[i].data();
+        present[i] = b.present[i] || padding;
+    }
+
+    if (codec_.decode(shards.data(), present.get(), chunkSize_)) {
+        const uint32_t first = block * config_.k;
+        for (unsigned i = 0; i < data; ++i) {
+            if (b.present[i]) continue;
+            std::vector<uint8_t>& shard = b.shards[i];
+            shard.resize(chunkLength(first + i));
+            rebuilt.emplace_back(first + i, std::move(shard));
+            ++rebuilt_;
+        }
+    }
+    closed_[block] = true;
+    open_.erase(block);
+}
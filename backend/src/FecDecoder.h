@@ -0,0 +1,80 @@
+#ifndef FECDECODER_H
+#define FECDECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "ReedSolomon.h"
+
+/*
+ * ==============================================================
+ * FecDecoder
+ * ==============================================================
+ * Client side of the forward error correction on the chunk stream.
+ * The image is cut into blocks of k chunks; after each block the sender
+ * adds m parity chunks (ReedSolomon). A parity chunk has kParityFlag set
+ * in its index, the rest being block * m + parity number; it is always
+ * a full chunk. Data chunk indexes are unchanged, so a client without
+ * FEC just drops the parity.
+ * Data chunks of a block are kept until the block is complete or has
+ * been rebuilt. At most maxOpenBlocks blocks are kept; the oldest is
+ * dropped first and starts over if its chunks come again (next pass of
+ * a multicast carousel, or a repair).
+ * Not thread safe.
+ */
+class FecDecoder {
+   public:
+    static constexpr uint32_t kParityFlag = 0x80000000u;
+
+    struct Config {
+        unsigned k = 0;                 // 0: no FEC
+        unsigned m = 0;
+        size_t maxOpenBlocks = 8;
+    };
+
+    // "k,m" (OTA_FEC), e.g. "16,2" for 12.5% overhead
+    static bool parseConfig(const char* text, Config& out);
+
+    using Chunk = std::pair<uint32_t, std::vector<uint8_t>>;
+
+    FecDecoder();
+
+    void reset(const Config& config, uint64_t fileSize, size_t chunkSize);
+    bool isEnabled() const { return config_.k > 0; }
+
+    // Both return the data chunks rebuilt thanks to this one (index, data
+    // cut to the chunk's real length). Chunks of closed blocks are ignored.
+    void addData(uint32_t index, const uint8_t* data, size_t size, std::vector<Chunk>& rebuilt);
+    void addParity(uint32_t parityIndex, const uint8_t* data, size_t size, std::vector<Chunk>& rebuilt);
+
+    uint64_t rebuiltChunks() const { return rebuilt_; }
+    uint64_t droppedBlocks() const { return dropped_; }
+
+   private:
+    struct Block {
+        std::vector<std::vector<uint8_t>> shards;   // k data, then m parity
+        std::vector<bool> present;
+        unsigned dataPresent = 0;
+        unsigned parityPresent = 0;
+    };
+
+    Block* openBlock(uint32_t block);
+    void tryDecode(uint32_t block, Block& b, std::vector<Chunk>& rebuilt);
+    unsigned dataInBlock(uint32_t block) const;
+    size_t chunkLength(uint32_t index) const;
+
+    Config config_;
+    ReedSolomon codec_;
+    uint64_t fileSize_ = 0;
+    size_t chunkSize_ = 0;
+    uint32_t chunks_ = 0;
+    std::map<uint32_t, Block> open_;
+    std::vector<bool> closed_;      // per block: complete or rebuilt
+    uint64_t rebuilt_ = 0;
+    uint64_t dropped_ = 0;
+};
+
+#endif  // FECDECODER_H
@@ -0,0 +1,300 @@
+#include "MetricsHistory.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const uint32_t kMagic = 0x4D544831;   // "MTH1"
+const uint32_t kVersion = 2;
+// Wall clock steps forward beyond this move the timeline offset
+const uint64_t kForwardStepMs = 1000;
+
+const uint64_t kBucketMs[MetricsHistory::TierCount] = {0, 60ULL * 1000, 3600ULL * 1000};
+
+size_t alignUp(size_t v, size_t a) {
+    return (v + a - 1) / a * a;
+}
+
+uint32_t capacityOf(int tier) {
+    switch (tier) {
+    case MetricsHistory::Raw:    return MetricsHistory::kRawCapacity;
+    case MetricsHistory::Minute: return MetricsHistory::kMinuteCapacity;
+    default:                     return MetricsHistory::kHourCapacity;
+    }
+}
+
+size_t tierBytes(uint32_t capacity) {
+    return capacity * (sizeof(uint64_t) + 2 * sizeof(float) * MetricsHistory::MetricCount);
+}
+
+// Empty when unknown; then only the ordering guard tells boots apart
+void readBootId(char* out, size_t size) {
+    std::memset(out, 0, size);
+    const int fd = ::open("/proc/sys/kernel/random/boot_id", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    const ssize_t n = ::read(fd, out, size - 1);
+    ::close(fd);
+    for (ssize_t i = 0; i < n; ++i) {
+        if (out[i] == '\n') out[i] = '\0';
+    }
+}
+
+}  // namespace
+
+constexpr uint32_t MetricsHistory::kRawCapacity;
+constexpr uint32_t MetricsHistory::kMinuteCapacity;
+constexpr uint32_t MetricsHistory::kHourCapacity;
+
+MetricsHistory::MetricsHistory() = default;
+
+MetricsHistory::~MetricsHistory() {
+    close();
+}
+
+size_t MetricsHistory::mappedSize() {
+    size_t size = alignUp(sizeof(Header), 64);
+    for (int t = 0; t < TierCount; ++t) size += tierBytes(capacityOf(t));
+    return alignUp(size, 4096);
+}
+
+/*
+ * ==============================================================
+ * bool open(const std::string& path)
+ * ==============================================================
+ * The file always has mappedSize() bytes, so memory use is fixed no matter
+ * how long the history runs. Writes go to the shared mapping and reach the
+ * disk through normal page writeback; close() syncs explicitly.
+ */
+bool MetricsHistory::open(const std::string& path) {
+    close();
+    std::lock_guard<std::mutex> lk(mutex_);
+
+    const size_t size = mappedSize();
+
+    if (!path.empty()) {
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd >= 0) {
+            struct stat st;
+            bool sized = fstat(fd, &st) == 0;
+            if (sized && static_cast<size_t>(st.st_size) != size) {
+                sized = ftruncate(fd, 0) == 0 && ftruncate(fd, static_cast<off_t>(size)) == 0;
+            }
+            if (sized) {
+                void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                if (p != MAP_FAILED) {
+                    base_ = p;
+                    persistent_ = true;
+                }
+            }
+            ::close(fd);
+        }
+    }
+
+    if (!base_ && !mapAnonymous()) return false;
+
+    readBootId(bootId_, sizeof(bootId_));
+    layout();
+    if (!headerValid()) reset();
+    return persistent_;
+}
+
+bool MetricsHistory::mapAnonymous() {
+    void* p = mmap(nullptr, mappedSize(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return false;
+    base_ = p;
+    persistent_ = false;
+    return true;
+}
+
+void MetricsHistory::close() {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (!base_) return;
+
+    if (persistent_) msync(base_, mappedSize(), MS_SYNC);
+    munmap(base_, mappedSize());
+
+    base_ = nullptr;
+    header_ = nullptr;
+    persistent_ = false;
+    for (auto& t : tiers_) t = TierView{};
+}
+
+void MetricsHistory::layout() {
+    char* p = static_cast<char*>(base_);
+    header_ = reinterpret_cast<Header*>(p);
+    p += alignUp(sizeof(Header), 64);
+
+    for (int t = 0; t < TierCount; ++t) {
+        const uint32_t cap = capacityOf(t);
+        TierView& v = tiers_[t];
+        v.capacity = cap;
+        v.timeMs = reinterpret_cast<uint64_t*>(p);
+        v.mean = reinterpret_cast<float*>(p + cap * sizeof(uint64_t));
+        v.peak = v.mean + static_cast<size_t>(MetricCount) * cap;
+        p += tierBytes(cap);
+    }
+}
+
+bool MetricsHistory::headerValid() const {
+    if (header_->magic != kMagic || header_->version != kVersion ||
+        header_->metricCount != MetricCount) {
+        return false;
+    }
+    for (int t = 0; t < TierCount; ++t) {
+        if (header_->capacity[t] != tiers_[t].capacity) return false;
+        if (header_->state[t].head >= tiers_[t].capacity) return false;
+        if (header_->state[t].count > tiers_[t].capacity) return false;
+    }
+    return true;
+}
+
+void MetricsHistory::reset() {
+    std::memset(base_, 0, mappedSize());
+    header_->magic = kMagic;
+    header_->version = kVersion;
+    header_->metricCount = MetricCount;
+    for (int t = 0; t < TierCount; ++t) header_->capacity[t] = tiers_[t].capacity;
+}
+
+/*
+ * ==============================================================
+ * void append(uint64_t wallMs, uint64_t bootMs, const float values[MetricCount])
+ * ==============================================================
+ * Stores a raw sample and folds it into the current minute and hour
+ * buckets. A bucket is written to its tier when the first sample of the
+ * next bucket arrives, so rollups only ever contain complete periods.
+ */
+void MetricsHistory::append(uint64_t wallMs, uint64_t bootMs, const float values[MetricCount]) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (!header_) return;
+
+    const uint64_t timeMs = timelineMs(wallMs, bootMs);
+    push(Raw, timeMs, values, values);
+    accumulate(Minute, kBucketMs[Minute], timeMs, values);
+    accumulate(Hour, kBucketMs[Hour], timeMs, values);
+}
+
+/*
+ * Maps a sample onto the stored timeline (see the class comment). The
+ * offset is taken from the wall clock at the first sample of a boot and
+ * only moves forward: with a step (NTP catching up) or to stay after the
+ * newest stored sample.
+ */
+uint64_t MetricsHistory::timelineMs(uint64_t wallMs, uint64_t bootMs) {
+    Header& h = *header_;
+    const uint64_t offset = wallMs > bootMs ? wallMs - bootMs : 0;
+
+    if (std::strncmp(h.bootId, bootId_, sizeof(h.bootId)) != 0 || h.offsetMs == 0) {
+        std::memcpy(h.bootId, bootId_, sizeof(h.bootId));
+        h.offsetMs = offset;
+    } else if (offset > h.offsetMs + kForwardStepMs) {
+        h.offsetMs = offset;
+    }
+
+    uint64_t timeMs = bootMs + h.offsetMs;
+    if (timeMs <= h.lastMs) {
+        h.offsetMs += h.lastMs + 1 - timeMs;
+        timeMs = h.lastMs + 1;
+    }
+    h.lastMs = timeMs;
+    return timeMs;
+}
+
+void MetricsHistory::accumulate(Tier tier, uint64_t bucketMs, uint64_t timeMs, const float* values) {
+    Accumulator& a = header_->acc[tier];
+    const uint64_t bucket = timeMs - timeMs % bucketMs;
+
+    if (a.samples > 0 && bucket != a.bucketStartMs) {
+        float mean[MetricCount];
+        for (int m = 0; m < MetricCount; ++m) mean[m] = a.sum[m] / static_cast<float>(a.samples);
+        push(tier, a.bucketStartMs, mean, a.peak);
+        a.samples = 0;
+    }
+
+    if (a.samples == 0) {
+        a.bucketStartMs = bucket;
+        for (int m = 0; m < MetricCount; ++m) {
+            a.sum[m] = 0.0f;
+            a.peak[m] = values[m];
+        }
+    }
+
+    for (int m = 0; m < MetricCount; ++m) {
+        a.sum[m] += values[m];
+        a.peak[m] = std::max(a.peak[m], values[m]);
+    }
+    ++a.samples;
+}
+
+// The slot is filled before head/count move, so an interrupted write
+// leaves at most one stale sample behind.
+void MetricsHistory::push(Tier tier, uint64_t timeMs, const float* mean, const float* peak) {
+    TierView& v = tiers_[tier];
+    TierState& s = header_->state[tier];
+    const uint32_t slot = s.head;
+
+    v.timeMs[slot] = timeMs;
+    for (int m = 0; m < MetricCount; ++m) {
+        v.mean[static_cast<size_t>(m) * v.capacity + slot] = mean[m];
+        v.peak[static_cast<size_t>(m) * v.capacity + slot] = peak[m];
+    }
+
+    s.head = (slot + 1) % v.capacity;
+    if (s.count < v.capacity) ++s.count;
+    ++s.sequence;
+}
+
+/*
+ * ==============================================================
+ * Series series(Tier tier, Metric metric, uint64_t sinceMs)
+ * ==============================================================
+ * Splits the occupied part of the ring into its (at most) two contiguous
+ * runs and drops the samples older than sinceMs with a binary search.
+ */
+MetricsHistory::Series MetricsHistory::series(Tier tier, Metric metric, uint64_t sinceMs) const {
+    Series s;
+    if (!header_) return s;
+
+    const TierView& v = tiers_[tier];
+    const TierState& st = header_->state[tier];
+    const uint32_t oldest = (st.head + v.capacity - st.count) % v.capacity;
+    const uint32_t firstLen = std::min(st.count, v.capacity - oldest);
+    const size_t column = static_cast<size_t>(metric) * v.capacity;
+
+    uint32_t start[2] = {oldest, 0};
+    s.length[0] = firstLen;
+    s.length[1] = st.count - firstLen;
+
+    if (sinceMs > 0) {
+        if (s.length[1] > 0 && v.timeMs[0] < sinceMs) {
+            // Everything in the first run is older
+            const uint64_t* b = v.timeMs;
+            const uint32_t skip = static_cast<uint32_t>(std::lower_bound(b, b + s.length[1], sinceMs) - b);
+            start[0] = skip;
+            s.length[0] = s.length[1] - skip;
+            s.length[1] = 0;
+        } else {
+            const uint64_t* b = v.timeMs + oldest;
+            const uint32_t skip = static_cast<uint32_t>(std::lower_bound(b, b + s.length[0], sinceMs) - b);
+            start[0] += skip;
+            s.length[0] -= skip;
+        }
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        s.timeMs[i] = v.timeMs + start[i];
+        s.mean[i] = v.mean + column + start[i];
+        s.peak[i] = v.peak + column + start[i];
+    }
+    return s;
+}
+
+uint64_t MetricsHistory::sequence(Tier tier) const {
+    return header_ ? header_->state[tier].sequence : 0;
+}
@@ -0,0 +1,149 @@
+#ifndef METRICSHISTORY_H
+#define METRICSHISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+/*
+ * ==============================================================
+ * MetricsHistory
+ * ==============================================================
+ * Fixed-size time series of the dashboard metrics.
+ * - Three tiers: every sample (Raw), 1-minute and 1-hour rollups.
+ *   Rollups keep the mean and the peak of their bucket.
+ * - Each tier is a ring stored as parallel arrays (timestamps, then one
+ *   column per metric), so reading one metric walks contiguous floats.
+ * - All storage lives in one mmap'd file of constant size, which keeps the
+ *   history across restarts. Without a file an anonymous mapping is used.
+ *
+ * Timestamps are wall clock milliseconds on a timeline that never goes
+ * back: CLOCK_BOOTTIME plus a wall clock offset kept per boot (the Pi has
+ * no RTC, so the wall clock steps after boot when NTP or fake-hwclock set
+ * it). A forward step of the wall clock moves the offset, a backward one
+ * does not, and a new boot whose clock is behind the stored samples
+ * continues right after them. series() can therefore binary search.
+ * Writers and readers may run on different threads; series() returns
+ * pointers into the rings and must be called, and used, while holding
+ * lock().
+ */
+class MetricsHistory {
+   public:
+    enum Metric {
+        Cpu,            // %
+        Iowait,         // %
+        Memory,         // % used
+        Temperature,    // degrees C
+        SelfCpu,        // % of one core
+        SelfRss,        // MiB
+        MetricCount
+    };
+
+    enum Tier {
+        Raw,
+        Minute,
+        Hour,
+        TierCount
+    };
+
+    static constexpr uint32_t kRawCapacity = 3600;     // 1 h at the fastest poll rate
+    static constexpr uint32_t kMinuteCapacity = 1440;  // 24 h
+    static constexpr uint32_t kHourCapacity = 720;     // 30 days
+
+    /*
+     * Up to two contiguous segments (the ring may wrap), oldest first.
+     * Raw samples have mean == peak.
+     */
+    struct Series {
+        const uint64_t* timeMs[2] = {nullptr, nullptr};
+        const float* mean[2] = {nullptr, nullptr};
+        const float* peak[2] = {nullptr, nullptr};
+        size_t length[2] = {0, 0};
+
+        size_t size() const { return length[0] + length[1]; }
+        uint64_t timeAt(size_t i) const { return i < length[0] ? timeMs[0][i] : timeMs[1][i - length[0]]; }
+        float meanAt(size_t i) const { return i < length[0] ? mean[0][i] : mean[1][i - length[0]]; }
+        float peakAt(size_t i) const { return i < length[0] ? peak[0][i] : peak[1][i - length[0]]; }
+    };
+
+    MetricsHistory();
+    ~MetricsHistory();
+
+    MetricsHistory(const MetricsHistory&) = delete;
+    MetricsHistory& operator=(const MetricsHistory&) = delete;
+
+    // Maps path (created or resized as needed). An incompatible file is reset.
+    // An empty path, or any failure, falls back to memory only.
+    bool open(const std::string& path);
+    void close();
+    bool isPersistent() const { return persistent_; }
+
+    // Records one sample (values indexed by Metric) taken at wallMs
+    // (CLOCK_REALTIME) / bootMs (CLOCK_BOOTTIME) and updates the rollups
+    void append(uint64_t wallMs, uint64_t bootMs, const float values[MetricCount]);
+
+    std::unique_lock<std::mutex> lock() const { return std::unique_lock<std::mutex>(mutex_); }
+
+    // Samples of one metric with timeMs >= sinceMs. Caller holds lock().
+    Series series(Tier tier, Metric metric, uint64_t sinceMs = 0) const;
+
+    // Samples ever appended to a tier (survives restarts); lets readers
+    // consume only what is new since their last visit. Caller holds lock().
+    uint64_t sequence(Tier tier) const;
+
+    static size_t mappedSize();
+
+   private:
+    struct TierState {
+        uint32_t head;          // next slot to write
+        uint32_t count;
+        uint64_t sequence;
+    };
+
+    // Rollup being built for the Minute and Hour tiers
+    struct Accumulator {
+        uint64_t bucketStartMs;
+        uint32_t samples;
+        uint32_t reserved;
+        float sum[MetricCount];
+        float peak[MetricCount];
+    };
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t metricCount;
+        uint32_t capacity[TierCount];
+        uint32_t reserved;
+        TierState state[TierCount];
+        Accumulator acc[TierCount];
+        char bootId[40];        // boot the offset belongs to
+        uint64_t offsetMs;      // timeline = CLOCK_BOOTTIME + offsetMs
+        uint64_t lastMs;        // newest timestamp handed out
+    };
+
+    struct TierView {
+        uint32_t capacity;
+        uint64_t* timeMs;
+        float* mean;        // [MetricCount][capacity]
+        float* peak;        // [MetricCount][capacity]
+    };
+
+    bool mapAnonymous();
+    void layout();
+    bool headerValid() const;
+    void reset();
+    uint64_t timelineMs(uint64_t wallMs, uint64_t bootMs);
+    void push(Tier tier, uint64_t timeMs, const float* mean, const float* peak);
+    void accumulate(Tier tier, uint64_t bucketMs, uint64_t timeMs, const float* values);
+
+    mutable std::mutex mutex_;
+    void* base_ = nullptr;
+    bool persistent_ = false;
+    Header* header_ = nullptr;
+    char bootId_[40] = {};      // this boot, from /proc/sys/kernel/random/boot_id
+    TierView tiers_[TierCount] = {};
+};
+
+#endif  // METRICSHISTORY_H
@@ -1,19 +1,63 @@
 #include "OtaBackend.h"
+#include "ChunkEventDeployment.h"
+#include "OtaLog.h"
+#include "UpdateManifest.h"
+#include "UpdateVerifier.h"
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <algorithm>
 #include <cstdlib>
-#include <iostream>
+#include <ctime>
 #include <chrono>
 #include <fstream>
 #include <thread>
-#include <sys/statvfs.h>
-#include <cstdio>
-#include <cstring>
 
 
 static const size_t CHUNK_SIZE = 64 * 1024;
 
+// Sampling intervals per metric and activity profile (ms).
+// All are multiples of one second so due timers share a wakeup.
+struct MetricIntervals {
+    uint32_t foregroundMs;
+    uint32_t idleMs;
+    uint32_t backgroundMs;
+
+    uint32_t forProfile(OtaBackend::ActivityProfile p) const {
+        switch (p) {
+        case OtaBackend::ActivityProfile::Foreground: return foregroundMs;
+        case OtaBackend::ActivityProfile::Idle:       return idleMs;
+        default:                                      return backgroundMs;
+        }
+    }
+};
+
+static const MetricIntervals kCpuIntervals         = {  1000,  3000, 10000 };
+static const MetricIntervals kMemoryIntervals      = {  2000,  6000, 20000 };
+static const MetricIntervals kTemperatureIntervals = {  2000,  6000, 20000 };
+static const MetricIntervals kStorageIntervals     = { 10000, 30000, 60000 };
+static const MetricIntervals kUptimeIntervals      = { 30000, 60000, 60000 };  // shown in minutes
+static const MetricIntervals kIoIntervals          = {  1000,  3000, 10000 };
+static const MetricIntervals kPressureIntervals    = {  1000,  2000,  5000 };
+static const uint32_t kWakeupReportMs = 60000;
+// Repair check while a single image download runs
+static const uint32_t kRepairCheckMs = 50;
+// Paced requests with a rate limit ask for about this much of it at once
+static const uint64_t kSliceMs = 100;
+// Largest bundle manifest accepted
+static const uint64_t kMaxManifestBytes = 1024 * 1024;
+// startTransfer refused: tries in all, and the wait between them
+static const int kStartAttempts = 5;
+static const uint32_t kStartRetryMs = 1000;
+// repairBases_ entry of a stream tag not in use
+static const uint32_t kNoBase = 0xffffffffu;
+
+static uint64_t steadyNs() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
 static void ensureClientDir()
 
 {
@@ -32,11 +76,101 @@ static void ensureClientDir()
 }
 
 
-OtaBackend::OtaBackend(const std::string& outputFilename)
-    : outputFilename_(outputFilename), running_(false) {}
+OtaBackend::OtaBackend(const std::string& outputFilename, const OtaConfig& config)
+    : outputFilename_(outputFilename),
+      sampler_("/",
+               config.thermalZone.empty() ? SystemSampler::kDefaultThermalPath : config.thermalZone,
+               config.dataDir.empty() ? std::string(DATA_CLIENT_PATH) : config.dataDir),
+      governor_(config.thermal),
+      verifyWorkerLimit_(governor_.config().maxWorkers),
+      checkCache_(UPDATE_CHECK_CACHE_PATH),
+      bundle_(CHUNK_SIZE),
+      range_(CHUNK_SIZE),
+      profile_(ActivityProfile::Foreground) {
+    otalog::start(otalog::configFromEnv(LOG_FILE_PATH));
+
+    memoryPressureLimit_ = config.memoryPressureLimit;
+    ioPressureLimit_ = config.ioPressureLimit;
+    checkTtlSec_ = config.checkTtlSec;
+    manifestName_ = config.manifestName;
+    backgroundRateBps_ = config.backgroundRateBps;
+    multicast_ = config.transport == OtaConfig::Transport::Multicast;
+    unreliable_ = config.transport != OtaConfig::Transport::Reliable;
+    multicastTimeoutSec_ = config.multicastTimeoutSec;
+    fecConfig_ = config.fec;
+    repairIdleMs_ = config.repairIdleMs;
+    rangeStreams_ = config.rangeStreams;
+    rangeInstances_ = config.rangeInstances;
+    if (!config.dataDir.empty()) dataDir_ = config.dataDir;
+    connectionId_ = config.connectionId;
+
+    recordPath_ = config.recordPath;
+    if (unreliable_ && !recordPath_.empty()) {
+        OTA_LOG_WARN("Backend", "OTA_RECORD_CHUNKS needs the reliable transport, not recording");
+        recordPath_.clear();
+    }
+    if (config.faults.enabled()) {
+        FaultInjector::Config faults = config.faults;
+        if (faults.restart > 0.0) {
+            OTA_LOG_WARN("Backend", "OTA_FAULTS: restart is a server fault (OTA_GW_FAULTS), ignored");
+            faults.restart = 0.0;
+        }
+        faults_.reset(new FaultInjector(faults));
+        OTA_LOG_WARN("Backend", "Test mode: injecting faults into the chunk stream");
+    }
+
+    // Runs on the pipeline's writer thread
+    pipeline_.setWrittenCallback([this](uint32_t index, bool lastChunk) {
+        if (bundle_.isActive()) {
+            bundle_.onChunkWritten(index, lastChunk);
+            if (chunkCb_) chunkCb_(index, bundleChunks_.load());
+            return;
+        }
+
+        // Counted, not derived from index: on an unreliable transport
+        // chunks are written out of order
+        const uint32_t written = ++writtenChunks_;
+        if (updateInfo_.getSize() > 0 && progressCb_) {
+            double progress =
+                (static_cast<double>(static_cast<uint64_t>(written) * CHUNK_SIZE) /
+                 static_cast<double>(updateInfo_.getSize())) * 100.0;
+            progressCb_(static_cast<int>(std::min(progress, 100.0)));
+        }
+
+        uint32_t totalChunks =
+            static_cast<uint32_t>(
+                (updateInfo_.getSize() + CHUNK_SIZE - 1) / CHUNK_SIZE
+                );
+
+        if (chunkCb_) {
+            chunkCb_(written - 1, totalChunks);
+        }
+
+        if (lastChunk) {
+            OTA_LOG_INFO("Backend", "Last chunk written, file closed");
+            postToLoop([this]() { endTransferSession(true); });
+            startVerify();
+        }
+    });
+
+    pipeline_.setErrorCallback([this](const std::string& msg) {
+        if (bundle_.isActive()) {
+            bundle_.onTransferError(msg);
+            return;
+        }
+
+        postToLoop([this]() { endTransferSession(false); });
+        if (errorCb_) {
+            errorCb_(msg);
+        }
+    });
+}
 
 OtaBackend::~OtaBackend() {
     stop();
+    history_.close();
+    otalog::setBatchSink(nullptr);
+    otalog::stop();
 }
 
 /*
@@ -66,32 +200,72 @@ void OtaBackend::setSystemInfoCallback(SystemInfoCallback cb){
     systemInfoCb_ = std::move(cb);
 }
 
+// Log records are delivered in batches from the logger's drain thread
+void OtaBackend::setLogCallback(LogCallback cb){
+    otalog::setBatchSink(std::move(cb), otalog::Level::Info);
+}
+
+void OtaBackend::setAvailabilityCallback(AvailabilityCallback cb){
+    availabilityCb_ = std::move(cb);
+}
+
+void OtaBackend::setBundleCallback(BundleCallback cb){
+    bundleCb_ = std::move(cb);
+}
+
 /*
  * ==============================================================
  * bool init()
  * ==============================================================
  * Initializes the OTA Backend
  * Prepares filesystem
- * Initializes CommonAPI runtime
- * Builds and validates SOME/IP Proxy (ensures server is connected)
- * Subscribes to file transfer event.
- * Starts system monitoring thread
+ * Starts system monitoring (startMonitor) on its own thread while
+ * connectService() brings up CommonAPI and waits for the service: the
+ * first sample does not wait for the server, and is there even when
+ * the server never shows up.
+ * Startup phases are recorded in StartupTrace.
  */
 
 bool OtaBackend::init() {
+    StartupTrace& trace = StartupTrace::instance();
+    trace.begin("backend.init");
     ensureClientDir();
+    if (dataDir_ != DATA_CLIENT_PATH) mkdir(dataDir_.c_str(), 0777);
 
+    bool monitorOk = false;
+    std::thread monitor([this, &monitorOk]() { monitorOk = startMonitor(); });
+    const bool connected = connectService();
+    monitor.join();
+
+    trace.end("backend.init");
+    return connected && monitorOk;
+}
+
+/*
+ * ==============================================================
+ * bool connectService()
+ * ==============================================================
+ * Initializes CommonAPI runtime
+ * Builds and validates SOME/IP Proxy (ensures server is connected)
+ * Subscribes to file transfer event.
+ */
+bool OtaBackend::connectService() {
+    StartupTrace& trace = StartupTrace::instance();
 
     // Set library base for CommonAPI
     CommonAPI::Runtime::setProperty("LibraryBase", "FileTransfer");
+    chunkevent::registerProxyDeployment();
 
+    trace.begin("commonapi.runtime");
     runtime_ = CommonAPI::Runtime::get();
+    trace.end("commonapi.runtime");
     if (!runtime_) {
-        std::cerr << "[Backend] Failed to get runtime\n";
+        OTA_LOG_ERROR("Backend", "Failed to get runtime");
         return false;
     }
 
-    std::cout << "[Backend] Building proxy...\n";
+    OTA_LOG_INFO("Backend", "Building proxy...");
+    trace.begin("proxy.build");
 
     // Keep trying to build proxy
     const int maxRetries = 30;
@@ -99,40 +273,58 @@ bool OtaBackend::init() {
         proxy_ = runtime_->buildProxy<ft::FileTransferProxy>(
             "local",
             "filetransfer.example.FileTransfer",
-            "client-sample");
+            connectionId_);
 
         if (proxy_) {
-            std::cout << "[Backend] Proxy built successfully\n";
+            OTA_LOG_INFO("Backend", "Proxy built successfully");
             break;
         }
 
-        std::cout << "[Backend] Proxy build attempt " << (i+1) << "/" << maxRetries << "\n";
+        OTA_LOG_INFO("Backend", "Proxy build attempt {}/{}", i + 1, maxRetries);
         std::this_thread::sleep_for(std::chrono::seconds(1));
     }
 
+    trace.end("proxy.build");
     if (!proxy_) {
-        std::cerr << "[Backend] Failed to build proxy after retries\n";
+        OTA_LOG_ERROR("Backend", "Failed to build proxy after retries");
         if (errorCb_) errorCb_("Failed to build proxy");
         return false;
     }
 
-    // Wait for service availability (like your standalone app)
-    std::cout << "[Backend] Waiting for service availability...\n";
-    const int timeoutSec = 30;
-    bool available = false;
-
-    for (int i = 0; i < timeoutSec; ++i) {
-        if (proxy_->isAvailable()) {
-            available = true;
-            std::cout << "[Backend] Service available after " << i << " seconds\n";
-            break;
+    // Availability is event driven: init() returns as soon as the service
+    // is seen, and later changes reach the controller as they happen
+    proxy_->getProxyStatusEvent().subscribe([this](const CommonAPI::AvailabilityStatus& status) {
+        const bool available = status == CommonAPI::AvailabilityStatus::AVAILABLE;
+        {
+            std::lock_guard<std::mutex> lk(availableMutex_);
+            if (serviceAvailable_ == available) return;
+            serviceAvailable_ = available;
         }
-        std::cout << "[Backend] Waiting... (" << (i+1) << "/" << timeoutSec << ")\n";
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        availableCv_.notify_all();
+        OTA_LOG_INFO("Backend", "Service {}", available ? "available" : "lost");
+        if (availabilityCb_) availabilityCb_(available);
+    });
+
+    OTA_LOG_INFO("Backend", "Waiting for service availability...");
+    trace.begin("service.wait");
+    const auto timeout = std::chrono::seconds(30);
+    const auto waitStart = std::chrono::steady_clock::now();
+    bool available = false;
+    {
+        std::unique_lock<std::mutex> lk(availableMutex_);
+        available = availableCv_.wait_for(lk, timeout, [this]() {
+            return serviceAvailable_ || proxy_->isAvailable();
+        });
+    }
+    trace.end("service.wait");
+    if (available) {
+        OTA_LOG_INFO("Backend", "Service available after {} ms",
+                     std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - waitStart).count());
     }
 
     if (!available) {
-        std::cerr << "[Backend] Service not available after timeout\n";
+        OTA_LOG_ERROR("Backend", "Service not available after timeout");
         if (errorCb_) {
             errorCb_("Service not available. Ensure server is running.");
         }
@@ -140,48 +332,206 @@ bool OtaBackend::init() {
     }
 
     // Subscribe to file chunk events
+    trace.begin("subscribe");
     proxy_->getFileChunkEvent().subscribe(
         [this](uint32_t index,
                const CommonAPI::ByteBuffer& data,
                bool last) {
-            std::cout << "[Backend] Received chunk " << index
-                      << " size=" << data.size()
-                      << " last=" << last << "\n";
-            onChunk(index, data, last);
+            OTA_LOG_TRACE("Backend", "Received chunk {} size={} last={}",
+                          index, data.size(), last);
+            if (faults_) {
+                faults_->apply(index, data.data(), data.size(), last,
+                               [this](uint32_t i, const uint8_t* d, size_t n, bool l) {
+                                   recorder_.append(i, d, n, l);
+                                   onChunk(i, d, n, l);
+                               });
+                return;
+            }
+            recorder_.append(index, data.data(), data.size(), last);
+            onChunk(index, data.data(), data.size(), last);
         });
 
-    std::cout << "[Backend] Subscribed to FileChunkEvent\n";
+    OTA_LOG_INFO("Backend", "Subscribed to FileChunkEvent");
 
-    // Start event loop thread (for processing callbacks)
-    running_ = true;
-    eventThread_ = std::thread([this]() {
-        std::cout << "[Backend] Event loop thread started\n";
-
-        using clock = std::chrono::steady_clock;
-        auto nextPoll = clock::now();
+    buildRangeProxies();
+    trace.end("subscribe");
+    return true;
+}
 
-        const auto pollInterval = std::chrono::seconds(3);
+/*
+ * ==============================================================
+ * bool startMonitor()
+ * ==============================================================
+ * Opens the samplers, takes the first sample and starts the event loop
+ * (system monitoring). Needs no service; runs once.
+ */
+bool OtaBackend::startMonitor() {
+    if (monitorStarted_.exchange(true)) return true;
+    StartupTrace& trace = StartupTrace::instance();
+    trace.begin("monitor.open");
+
+    // Descriptors for /proc and /sys stay open while the backend runs
+    if (!sampler_.open()) {
+        OTA_LOG_WARN("Backend", "System sampler could not open /proc/stat");
+    }
 
-        while (running_) {
-            const auto now = clock::now();
+    if (!history_.open(METRICS_HISTORY_PATH)) {
+        OTA_LOG_WARN("Backend", "Metrics history not persistent ({})", METRICS_HISTORY_PATH);
+    }
 
-            if(now >= nextPoll){
-                pollSystemInfoOnce();
-                nextPoll = now + pollInterval;
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-        std::cout << "[Backend] Event loop thread stopped\n";
+    trace.end("monitor.open");
+
+    // Start event loop (system monitoring), one timer per metric
+    trace.begin("monitor.firstSample");
+    pollSystemInfoOnce();
+    trace.end("monitor.firstSample");
+
+    loop_.setBatchEndHandler([this]() { publishSystemInfo(); });
+    cpuTimer_ = loop_.addTimer(kCpuIntervals.forProfile(profile_), [this]() { sampleCpu(); });
+    memoryTimer_ = loop_.addTimer(kMemoryIntervals.forProfile(profile_), [this]() { sampleMemory(); });
+    storageTimer_ = loop_.addTimer(kStorageIntervals.forProfile(profile_), [this]() { sampleStorage(); });
+    temperatureTimer_ = loop_.addTimer(kTemperatureIntervals.forProfile(profile_), [this]() { sampleTemperature(); });
+    uptimeTimer_ = loop_.addTimer(kUptimeIntervals.forProfile(profile_), [this]() { sampleUptime(); });
+    ioTimer_ = loop_.addTimer(kIoIntervals.forProfile(profile_), [this]() { sampleIo(); });
+    pressureTimer_ = loop_.addTimer(kPressureIntervals.forProfile(profile_), [this]() { samplePressure(); });
+
+    loop_.addTimer(kWakeupReportMs, [this]() {
+        const uint64_t total = loop_.wakeups();
+        OTA_LOG_DEBUG("Backend", "Event loop: {} wakeups in the last minute (profile {})",
+                      total - lastWakeupReport_, static_cast<int>(profile_.load()));
+        lastWakeupReport_ = total;
     });
 
+    if (!loop_.start()) {
+        OTA_LOG_ERROR("Backend", "Failed to start event loop");
+        return false;
+    }
+    trace.mark("monitor.loopStarted");
+    OTA_LOG_DEBUG("Backend", "Event loop started");
+
     return true;
 }
 
 void OtaBackend::stop() {
-    running_ = false;
-    if (eventThread_.joinable()) {
-        eventThread_.join();
+    verifyCancel_ = true;
+    {
+        std::lock_guard<std::mutex> lk(manifestMutex_);
+        manifestCv_.notify_all();
     }
+    bundle_.cancel();
+    range_.cancel();
+    pipeline_.abort();
+    cancelVerify();
+    stopReplay();
+    recorder_.close();
+    loop_.stop();
+}
+
+/*
+ * ==============================================================
+ * void setActivityProfile(ActivityProfile profile)
+ * ==============================================================
+ * Adapts the sampling rates to what the user can see:
+ * fast while the dashboard is in use, slower when idle or hidden.
+ * Can be called from any thread.
+ */
+void OtaBackend::setActivityProfile(ActivityProfile profile) {
+    if (profile_.exchange(profile) == profile) return;
+    OTA_LOG_INFO("Backend", "Activity profile -> {}", static_cast<int>(profile));
+    // The timer ids are the loop's (set up by startMonitor() before the loop
+    // starts); a profile set before that applies once it runs
+    postToLoop([this]() { applyActivityProfile(); });
+}
+
+OtaBackend::ActivityProfile OtaBackend::activityProfile() const {
+    return profile_.load();
+}
+
+/*
+ * ==============================================================
+ * void setTransferClass(TransferClass cls)
+ * ==============================================================
+ * Background caps the transfer at backgroundRateBps_ (or the thermal cap
+ * if lower) and drops the writer and hashing threads to low CPU and I/O
+ * priority, leaving the link and the disk to the rest of the system.
+ * Takes effect on the running transfer. Can be called from any thread.
+ */
+void OtaBackend::setTransferClass(TransferClass cls) {
+    if (transferClass_.exchange(cls) == cls) return;
+    const bool background = cls == TransferClass::Background;
+    OTA_LOG_INFO("Backend", "Transfer class -> {}", background ? "background" : "foreground");
+
+    lowPriority_ = background;
+    pipeline_.setBackground(background);
+    range_.setBackground(background);
+    postToLoop([this]() { applyRateLimit(); });
+}
+
+OtaBackend::TransferClass OtaBackend::transferClass() const {
+    return transferClass_.load();
+}
+
+/*
+ * ==============================================================
+ * void setTransferPaused(bool paused)
+ * ==============================================================
+ * The pipeline stops taking chunks, and the sender is stopped by
+ * replacing its stream with a single chunk (checkRepair(), run at once
+ * on the loop); parallel ranges hand over to the single stream first. Nothing piles up while
+ * paused. On resume the paced requests go on from the first gap.
+ * Can be called from any thread.
+ */
+void OtaBackend::setTransferPaused(bool paused) {
+    if (transferPaused_.exchange(paused) == paused) return;
+    OTA_LOG_INFO("Backend", "Transfer {}", paused ? "paused" : "resumed");
+    {
+        std::lock_guard<std::mutex> lk(repairMutex_);
+        pipeline_.setPaused(paused);
+        paced_ = true;
+        cut_ = true;
+    }
+    // The stream is cut now rather than on the next repair tick
+    if (paused) postToLoop([this]() {
+        rangesToSingle();
+        if (tracked_) checkRepair();
+    });
+}
+
+bool OtaBackend::isTransferPaused() const {
+    return transferPaused_.load();
+}
+
+void OtaBackend::setRangeStreams(size_t streams) {
+    rangeStreams_ = std::max<size_t>(1, streams);
+}
+
+size_t OtaBackend::rangeStreams() const {
+    return rangeStreams_.load();
+}
+
+uint64_t OtaBackend::eventLoopWakeups() const {
+    return loop_.wakeups();
+}
+
+const MetricsHistory& OtaBackend::history() const {
+    return history_;
+}
+
+// Runs task on the event loop thread; refused once the loop has stopped
+void OtaBackend::postToLoop(EventLoop::Task task) {
+    if (!loop_.post(std::move(task))) OTA_LOG_DEBUG("Backend", "Event loop stopped, task dropped");
+}
+
+// Loop thread
+void OtaBackend::applyActivityProfile() {
+    const ActivityProfile p = profile_.load();
+    loop_.setInterval(cpuTimer_, kCpuIntervals.forProfile(p));
+    loop_.setInterval(memoryTimer_, kMemoryIntervals.forProfile(p));
+    loop_.setInterval(storageTimer_, kStorageIntervals.forProfile(p));
+    loop_.setInterval(temperatureTimer_, kTemperatureIntervals.forProfile(p));
+    loop_.setInterval(uptimeTimer_, kUptimeIntervals.forProfile(p));
+    loop_.setInterval(ioTimer_, kIoIntervals.forProfile(p));
+    loop_.setInterval(pressureTimer_, kPressureIntervals.forProfile(p));
 }
 
 /*
@@ -192,9 +542,13 @@ void OtaBackend::stop() {
  * Result depends on the clients current version
  * Server provides SystemInfo for future use
  */
-bool OtaBackend::requestUpdate(uint32_t currentVersion) {
+bool OtaBackend::requestUpdate(uint32_t currentVersion, CheckPolicy policy) {
+    if (policy == CheckPolicy::PreferCache && loadCachedUpdate(currentVersion)) {
+        return true;
+    }
+
     if (!proxy_) {
-        std::cerr << "[Backend] Proxy not initialized\n";
+        OTA_LOG_ERROR("Backend", "Proxy not initialized");
         if (errorCb_) {
             errorCb_("Backend not initialized");
         }
@@ -202,350 +556,1182 @@ bool OtaBackend::requestUpdate(uint32_t currentVersion) {
     }
 
     if (!proxy_->isAvailable()) {
-        std::cerr << "[Backend] Service not available for requestUpdate\n";
+        OTA_LOG_ERROR("Backend", "Service not available for requestUpdate");
         if (errorCb_) {
             errorCb_("Service not available");
         }
         return false;
     }
 
-    std::cout << "[Backend] Calling requestUpdate with version " << currentVersion << "\n";
+    OTA_LOG_INFO("Backend", "Calling requestUpdate with version {}", currentVersion);
 
     CommonAPI::CallStatus status;
     proxy_->requestUpdate(currentVersion, status, updateInfo_);
 
-    std::cout << "[Backend] requestUpdate status: " << static_cast<int>(status) << "\n";
+    OTA_LOG_DEBUG("Backend", "requestUpdate status: {}", static_cast<int>(status));
 
     if(status != CommonAPI::CallStatus::SUCCESS){
-        std::cerr << "[Backend] requestUpdate failed with status " << static_cast<int>(status) << "\n";
+        OTA_LOG_ERROR("Backend", "requestUpdate failed with status {}", static_cast<int>(status));
         if(errorCb_) {
             errorCb_("requestUpdate() failed - call status: " + std::to_string(static_cast<int>(status)));
         }
         return false;
     }
 
-    std::cout << "[Backend] Update info - size: " << updateInfo_.getSize() << "\n";
+    OTA_LOG_INFO("Backend", "Update info - size: {}", updateInfo_.getSize());
+
+    // Refusals are not cached: they may be transient
+    if (updateInfo_.getResultCode() == 0) {
+        UpdateCheckCache::Entry e;
+        e.currentVersion = currentVersion;
+        e.fetchedMs = UpdateCheckCache::nowMs();
+        e.exists = updateInfo_.getExists();
+        e.isNew = updateInfo_.getIsNew();
+        e.newVersion = updateInfo_.getNewVersion();
+        e.size = updateInfo_.getSize();
+        e.crc = updateInfo_.getCrc();
+        e.resultCode = updateInfo_.getResultCode();
+        checkCache_.store(e);
+    }
+
+    return true;
+}
+
+bool OtaBackend::loadCachedUpdate(uint32_t currentVersion) {
+    UpdateCheckCache::Entry e;
+    const uint64_t now = UpdateCheckCache::nowMs();
+    if (!checkCache_.lookup(currentVersion, now, checkTtlSec_, e)) return false;
 
+    updateInfo_ = ft::FileTransfer::UpdateInfo(e.exists, e.isNew, e.newVersion, e.size, e.crc, e.resultCode);
+    OTA_LOG_INFO("Backend", "Update info from cache ({} s old) - size: {}", (now - e.fetchedMs) / 1000, e.size);
     return true;
 }
 
 
 /*
  * ==============================================================
- * bool startDownload()
+ * StartResult startDownload()
  * ==============================================================
  * Sends a request via SOME/IP to begin streaming the update file via events
  * This function only initiates the transfer
  * Actual devlivery data is handled asynchronously via onChunk()
+ * Refused only when the server said no; every other failure is Failed
  */
-bool OtaBackend::startDownload() {
+OtaBackend::StartResult OtaBackend::startDownload() {
     if (!proxy_ || !proxy_->isAvailable()) {
         if (errorCb_) {
             errorCb_("Service not available for download");
         }
-        return false;
+        return StartResult::Failed;
+    }
+
+    cancelVerify();
+    verifyCancel_ = false;
+    bundleTotalBytes_ = 0;
+    writtenChunks_ = 0;
+    tracked_ = false;
+
+    // A recording and a fault schedule cover the single image, in one stream
+    const bool singleStream = !recordPath_.empty() || faults_;
+    UpdateManifest manifest;
+    const int bundle = singleStream ? 0 : fetchManifest(manifest);
+    if (bundle < 0) {
+        if (errorCb_) {
+            errorCb_("Failed to fetch the update manifest");
+        }
+        return StartResult::Failed;
     }
+    if (bundle > 0) return startBundle(manifest) ? StartResult::Started : StartResult::Failed;
 
-    std::cout << "[Backend] Starting download for: " << outputFilename_ << "\n";
+    OTA_LOG_INFO("Backend", "Starting download for: {}", outputFilename_);
 
+    // The file is ready before the first chunk can arrive
+    const std::string path = dataDir_ + outputFilename_;
+    if (!singleStream && startRanges(path)) return StartResult::Started;
+
+    OTA_LOG_INFO("Backend", "Opening file: {}", path);
+    const uint32_t totalChunks = static_cast<uint32_t>((updateInfo_.getSize() + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    if (!pipeline_.begin(path, CHUNK_SIZE, totalChunks)) {
+        if(errorCb_){
+            errorCb_("Failed to open output file");
+        }
+        return StartResult::Failed;
+    }
+    beginRepairTracking(outputFilename_, updateInfo_.getSize());
+    const std::string request = firstRequest();
+    postToLoop([this]() { beginTransferSession(); });
+
+    if (!recordPath_.empty()) {
+        ChunkRecordHeader header;
+        header.chunkSize = CHUNK_SIZE;
+        header.imageSize = updateInfo_.getSize();
+        header.imageCrc = updateInfo_.getCrc();
+        if (recorder_.open(recordPath_, header)) {
+            OTA_LOG_INFO("Backend", "Recording chunks to {}", recordPath_);
+        } else {
+            OTA_LOG_WARN("Backend", "Cannot record chunks to {}", recordPath_);
+        }
+    }
+    if (faults_) faults_->reset();
+
+    // A gateway refuses while another client's transfer holds the
+    // instance; it is free again once that one ends
     CommonAPI::CallStatus status;
     bool accepted = false;
-    proxy_->startTransfer(outputFilename_, status, accepted);
+    for (int attempt = 1;; ++attempt) {
+        proxy_->startTransfer(request, status, accepted);
+        if (status != CommonAPI::CallStatus::SUCCESS || accepted || attempt == kStartAttempts) break;
+        OTA_LOG_WARN("Backend", "startTransfer refused, retry {}/{} in {} ms",
+                     attempt, kStartAttempts - 1, kStartRetryMs);
+        std::this_thread::sleep_for(std::chrono::milliseconds(kStartRetryMs));
+    }
 
-    std::cout << "[Backend] startTransfer status: " << static_cast<int>(status)
-              << " accepted: " << accepted << "\n";
+    OTA_LOG_INFO("Backend", "startTransfer status: {} accepted: {}",
+                 static_cast<int>(status), accepted);
 
     if(status != CommonAPI::CallStatus::SUCCESS || !accepted){
-        std::cerr << "[Backend] startTransfer rejected\n";
+        OTA_LOG_ERROR("Backend", "startTransfer rejected");
+        pipeline_.abort();
+        postToLoop([this]() { endTransferSession(false); });
         if(errorCb_){
-            errorCb_("startTransfer() rejected by server");
+            errorCb_(status == CommonAPI::CallStatus::SUCCESS
+                         ? "startTransfer() refused by server, busy or unknown file; try again later"
+                         : "startTransfer() rejected by server");
         }
-        return false;
+        return status == CommonAPI::CallStatus::SUCCESS ? StartResult::Refused : StartResult::Failed;
     }
 
-    return true;
+    return StartResult::Started;
 }
 
 /*
  * ==============================================================
- * void onChunk(uint32_t index, const CommonAPI::ByteBuffer& data, bool lastChunk)
+ * void buildRangeProxies()
  * ==============================================================
- * Called for each file chunk recieved via SOME/IP
- * Appends chunk data to the output file
- * Updates progress
- * Signals completion when the last chunk is recieved
- * The last chunk is application-level signal indicating end-of-transfer
+ * One proxy per extra instance of the service, each with its own chunk
+ * subscription, so the chunks of concurrent ranges stay apart. Stops at
+ * the first instance that cannot be built: streams are used in order.
  */
+void OtaBackend::buildRangeProxies() {
+    for (const std::string& instance : rangeInstances_) {
+        auto proxy = runtime_->buildProxy<ft::FileTransferProxy>("local", instance, connectionId_);
+        if (!proxy) {
+            OTA_LOG_WARN("Backend", "No proxy for instance {}, {} range streams at most",
+                         instance, rangeProxies_.size() + 1);
+            break;
+        }
 
-void OtaBackend::onChunk(uint32_t index,
-                         const CommonAPI::ByteBuffer& data,
-                         bool lastChunk) {
-    static std::ofstream ofs;
-
-    if (!ofs.is_open()) {
-        std::string path = DATA_CLIENT_PATH + outputFilename_;
-        std::cout << "[Backend] Opening file: " << path << "\n";
-        ofs.open(path.c_str(), std::ios::binary);
-        if(!ofs.is_open()){
-            std::cerr << "[Backend] Failed to open output file: " << path << "\n";
-            if(errorCb_){
-                errorCb_("Failed to open output file");
-            }
+        const size_t stream = rangeProxies_.size() + 1;
+        proxy->getFileChunkEvent().subscribe(
+            [this, stream](uint32_t index, const CommonAPI::ByteBuffer& data, bool last) {
+                range_.onChunk(stream, index, data.data(), data.size(), last);
+            });
+        rangeProxies_.push_back(proxy);
+    }
+}
+
+/*
+ * ==============================================================
+ * bool startRanges(const std::string& path)
+ * ==============================================================
+ * Downloads the image as parallel ranges when more than one instance is
+ * available and streams are enabled. False if not used or refused, in
+ * which case the caller falls back to the single stream.
+ */
+bool OtaBackend::startRanges(const std::string& path) {
+    // Ranges are not paced: a rate limited or paused image is one paced stream
+    if (unreliable_ || pipeline_.rateLimit() > 0 || transferPaused_) return false;
+    const size_t wanted = std::min(rangeStreams_.load(), RangeTransfer::kMaxStreams);
+    size_t streams = 1;
+    while (streams < wanted && streams <= rangeProxies_.size() &&
+           rangeProxies_[streams - 1]->isAvailable()) {
+        ++streams;
+    }
+    const uint64_t size = updateInfo_.getSize();
+    if (streams < 2 || size <= CHUNK_SIZE) return false;
+
+    const uint32_t totalChunks = static_cast<uint32_t>((size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+
+    RangeTransfer::Hooks hooks;
+    hooks.startRange = [this](size_t stream, const std::string& name) {
+        auto& proxy = stream == 0 ? proxy_ : rangeProxies_[stream - 1];
+        CommonAPI::CallStatus status;
+        bool accepted = false;
+        proxy->startTransfer(name, status, accepted);
+        return status == CommonAPI::CallStatus::SUCCESS && accepted;
+    };
+    hooks.progress = [this, totalChunks](uint64_t done, uint64_t total) {
+        if (progressCb_) progressCb_(static_cast<int>((done * 100) / total));
+        if (chunkCb_) {
+            const uint32_t chunks = static_cast<uint32_t>((done + CHUNK_SIZE - 1) / CHUNK_SIZE);
+            chunkCb_(chunks ? chunks - 1 : 0, totalChunks);
+        }
+    };
+    hooks.finished = [this](bool ok, const std::string& error) {
+        postToLoop([this, ok]() { endTransferSession(ok); });
+        if (!ok) {
+            if (errorCb_) errorCb_(error);
             return;
         }
+        startVerify();
+    };
+    hooks.overrun = [this]() {
+        postToLoop([this]() { rangesToSingle(); });
+    };
+
+    postToLoop([this]() { beginTransferSession(); });
+    if (!range_.start(outputFilename_, path, size, streams, std::move(hooks))) {
+        postToLoop([this]() { endTransferSession(false); });
+        OTA_LOG_INFO("Backend", "Range download not accepted, single stream");
+        return false;
+    }
 
+    OTA_LOG_INFO("Backend", "Downloading {} in {} ranges", outputFilename_, range_.streams());
+    return true;
+}
+
+/*
+ * ==============================================================
+ * void rangesToSingle()
+ * ==============================================================
+ * Event loop thread. A range stream had no credit for a chunk, or the
+ * transfer got a rate limit: the ranges stop, and the rest of the image
+ * is fetched as the paced single stream, from the chunks already
+ * written. Each extra instance is asked for one chunk of its range, which
+ * replaces the range it is still sending; stream 0 is replaced by the
+ * first slice.
+ */
+void OtaBackend::rangesToSingle() {
+    if (!range_.isActive()) return;
+    const std::vector<RangeTransfer::Range> ranges = range_.ranges();
+    if (!range_.cancel()) return;   // finished or failed meanwhile
+    const ChunkBitmap written = range_.written();
+
+    if (written.complete()) {
+        // The last chunk was written, only its report was cut off
+        endTransferSession(true);
+        startVerify();
+        return;
     }
 
-    ofs.write(reinterpret_cast<const char*>(data.data()),
-              static_cast<std::streamsize>(data.size()));
+    for (size_t i = 1; i < ranges.size() && i <= rangeProxies_.size(); ++i) {
+        RangeTransfer::Range one = ranges[i];
+        one.length = std::min<uint64_t>(one.length, CHUNK_SIZE);
+        rangeProxies_[i - 1]->startTransferAsync(RangeTransfer::rangeName(outputFilename_, one),
+                                                 [](const CommonAPI::CallStatus&, const bool&) {});
+    }
 
-    if(updateInfo_.getSize() > 0 && progressCb_){
-        double progress =
-            (static_cast<double>(index * CHUNK_SIZE) /
-             static_cast<double>(updateInfo_.getSize())) * 100.0;
-        progressCb_(static_cast<int>(progress));
+    OTA_LOG_INFO("Backend", "Ranges stopped at {}/{} chunks, continuing as one paced stream",
+                 written.count(), written.size());
+    const std::string path = dataDir_ + outputFilename_;
+    if (!pipeline_.beginRange(path, CHUNK_SIZE, 0, written.size() - written.count())) {
+        endTransferSession(false);
+        if (errorCb_) errorCb_("Failed to open output file");
+        return;
     }
+    writtenChunks_ = written.count();
+    beginRepairTracking(outputFilename_, updateInfo_.getSize(), &written);
+}
 
-    if (lastChunk) {
-        std::cout << "[Backend] Last chunk received, closing file\n";
-        ofs.close();
-        if(finishedCb_){
-            finishedCb_();
-        }
+/*
+ * ==============================================================
+ * int fetchManifest(UpdateManifest& manifest)
+ * ==============================================================
+ * Asks the service for the bundle manifest over the normal file transfer.
+ * Returns 1 with a parsed manifest, 0 if the service has none (single
+ * image mode) and -1 if it was accepted but could not be received or parsed.
+ */
+int OtaBackend::fetchManifest(UpdateManifest& manifest) {
+    // Manifest and artifacts rely on an in-order, lossless stream
+    if (manifestName_.empty() || unreliable_) return 0;
+
+    {
+        std::lock_guard<std::mutex> lk(manifestMutex_);
+        manifestResult_ = 0;
+        manifestData_.clear();
+    }
+    fetchingManifest_ = true;
+
+    CommonAPI::CallStatus status;
+    bool accepted = false;
+    proxy_->startTransfer(manifestName_, status, accepted);
+    if (status != CommonAPI::CallStatus::SUCCESS || !accepted) {
+        fetchingManifest_ = false;
+        OTA_LOG_INFO("Backend", "No manifest {} on the service, single image mode", manifestName_);
+        return 0;
+    }
+
+    int result = 0;
+    std::string text;
+    {
+        std::unique_lock<std::mutex> lk(manifestMutex_);
+        manifestCv_.wait_for(lk, std::chrono::seconds(10), [this]() {
+            return manifestResult_ != 0 || verifyCancel_.load();
+        });
+        result = manifestResult_;
+        text.swap(manifestData_);
     }
+    fetchingManifest_ = false;
 
-    uint32_t totalChunks =
-        static_cast<uint32_t>(
-            (updateInfo_.getSize() + CHUNK_SIZE - 1) / CHUNK_SIZE
-            );
+    if (result <= 0) {
+        OTA_LOG_ERROR("Backend", "Manifest {} not received", manifestName_);
+        return -1;
+    }
 
-    if (chunkCb_) {
-        chunkCb_(index, totalChunks);
+    std::string error;
+    if (!UpdateManifest::parse(text.data(), text.size(), manifest, error)) {
+        OTA_LOG_ERROR("Backend", "Manifest {} rejected: {}", manifestName_, error);
+        return -1;
     }
+
+    OTA_LOG_INFO("Backend", "Manifest {}: {} artifacts, {} bytes",
+                 manifestName_, manifest.artifacts.size(), manifest.totalSize());
+    return 1;
 }
 
-uint64_t OtaBackend::updateSize() const {
-    return updateInfo_.getSize();
+// Dispatch thread. The manifest is small and its size is not known up
+// front, so it is collected in memory rather than through the pipeline.
+void OtaBackend::onManifestChunk(uint32_t index, const uint8_t* data, size_t size, bool lastChunk) {
+    std::lock_guard<std::mutex> lk(manifestMutex_);
+    if (manifestResult_ != 0) return;
+
+    const uint64_t at = static_cast<uint64_t>(index) * CHUNK_SIZE;
+    if (at != manifestData_.size() || at + size > kMaxManifestBytes) {
+        manifestResult_ = -1;
+    } else {
+        manifestData_.append(reinterpret_cast<const char*>(data), size);
+        if (lastChunk) manifestResult_ = 1;
+    }
+    if (manifestResult_ != 0) manifestCv_.notify_all();
 }
 
-bool OtaBackend::isServerAvailable() const {
-    return proxy_ && proxy_->isAvailable();
+// Opens the pipeline on path and asks the service for name. Bundle driver thread.
+bool OtaBackend::beginFileTransfer(const std::string& name, const std::string& path) {
+    uint64_t size = 0;
+    for (const UpdateManifest::Artifact& a : bundleManifest_.artifacts) {
+        if (a.name == name) size = a.size;
+    }
+    bundleChunks_ = static_cast<uint32_t>((size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    if (!pipeline_.begin(path, CHUNK_SIZE, bundleChunks_)) return false;
+    beginRepairTracking(name, size);
+
+    CommonAPI::CallStatus status;
+    bool accepted = false;
+    proxy_->startTransfer(firstRequest(), status, accepted);
+    if (status != CommonAPI::CallStatus::SUCCESS || !accepted) {
+        OTA_LOG_ERROR("Backend", "startTransfer({}) rejected", name);
+        pipeline_.abort();
+        return false;
+    }
+    return true;
 }
 
-// System Info Helper functions
+/*
+ * ==============================================================
+ * bool startBundle(const UpdateManifest& manifest)
+ * ==============================================================
+ * Hands the manifest to the bundle scheduler. Overall progress goes
+ * through the usual progress callback; the per-artifact view through
+ * the bundle callback.
+ */
+bool OtaBackend::startBundle(const UpdateManifest& manifest) {
+    bundleManifest_ = manifest;
+    bundleTotalBytes_ = manifest.totalSize();
+
+    BundleTransfer::Hooks hooks;
+    hooks.startTransfer = [this](const std::string& name, const std::string& path) {
+        return beginFileTransfer(name, path);
+    };
+    hooks.computeCrc = [this](const std::string& path, uint32_t& crc) {
+        return UpdateVerifier::computeCrc(path, governor_.config().maxWorkers,
+                                          [this]() { return verifyWorkerLimit_.load(); },
+                                          crc, &verifyCancel_, &lowPriority_);
+    };
+    hooks.progress = [this](const BundleTransfer::Progress& p) {
+        if (bundleCb_) bundleCb_(p);
+        if (progressCb_ && p.totalBytes > 0) {
+            progressCb_(static_cast<int>((p.doneBytes * 100) / p.totalBytes));
+        }
+    };
+    hooks.finished = [this](bool ok, const std::string& error) {
+        postToLoop([this, ok]() { endTransferSession(ok); });
+        if (ok) {
+            if (finishedCb_) finishedCb_();
+        } else if (errorCb_) {
+            errorCb_(error);
+        }
+    };
+
+    postToLoop([this]() { beginTransferSession(); });
+    if (!bundle_.start(manifest, dataDir_, std::move(hooks))) {
+        postToLoop([this]() { endTransferSession(false); });
+        if (errorCb_) {
+            errorCb_("Failed to start the bundle download");
+        }
+        return false;
+    }
+    return true;
+}
 
 /*
  * ==============================================================
- * bool readProcStatCpu(uint64_t&, uint64_t&)
+ * bool startReplay(const std::string& recording, double speed)
  * ==============================================================
- * Reads cumulative CPU time counters from /proc/stat.
- * The returned values are monotonic since boot and must be differenced
- * accrss samples to compute CPU usage.
+ * Sets the transfer up as startDownload() does for a single image, with
+ * size and CRC from the recording, then a thread pushes the recorded
+ * events into the pipeline, so write, rate limit and verify run as in a
+ * live download. With speed > 0 each event is held back to its recorded
+ * arrival time / speed; push() waits for credits and tokens on top.
  */
-bool OtaBackend::readProcStatCpu(uint64_t& idle, uint64_t& total) {
-    FILE* f = std::fopen("/proc/stat", "r");
-    if(!f) return false;
+bool OtaBackend::startReplay(const std::string& recording, double speed) {
+    if (replayThread_.joinable()) {
+        pipeline_.abort();
+        stopReplay();
+    }
 
-    char line[512];
+    auto rec = std::make_shared<ChunkRecording>();
+    std::string error;
+    if (!rec->open(recording, error)) {
+        if (errorCb_) errorCb_(error);
+        return false;
+    }
+    if (rec->header().chunkSize != CHUNK_SIZE || unreliable_) {
+        if (errorCb_) errorCb_("Replay needs the reliable transport and chunks of " + std::to_string(CHUNK_SIZE));
+        return false;
+    }
 
-    if(!std::fgets(line, sizeof(line), f)){
-        std::fclose(f);
+    // Session and verify reports run on the loop, which init() may not have started
+    if (!loop_.start()) {
+        if (errorCb_) errorCb_("Failed to start event loop");
         return false;
     }
 
-    std::fclose(f);
+    updateInfo_ = ft::FileTransfer::UpdateInfo(true, true, 0, rec->header().imageSize, rec->header().imageCrc, 0);
+    cancelVerify();
+    verifyCancel_ = false;
+    bundleTotalBytes_ = 0;
+    writtenChunks_ = 0;
+    tracked_ = false;
+
+    const std::string path = dataDir_ + outputFilename_;
+    const uint32_t totalChunks = static_cast<uint32_t>((rec->header().imageSize + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    if (!pipeline_.begin(path, CHUNK_SIZE, totalChunks)) {
+        if (errorCb_) errorCb_("Failed to open output file");
+        return false;
+    }
+    postToLoop([this]() { beginTransferSession(); });
+
+    OTA_LOG_INFO("Backend", "Replaying {} ({} events) at {}", recording, rec->events(),
+                 speed > 0.0 ? std::to_string(speed) + "x" : std::string("full speed"));
+    replayStop_ = false;
+    replayThread_ = std::thread([this, rec, speed]() {
+        const auto start = std::chrono::steady_clock::now();
+        ChunkRecording::Event e;
+        while (!replayStop_ && rec->next(e)) {
+            if (speed > 0.0) {
+                const auto due = std::chrono::nanoseconds(static_cast<uint64_t>(static_cast<double>(e.timeNs) / speed));
+                std::this_thread::sleep_until(start + due);
+            }
+            if (e.index & FecDecoder::kParityFlag) continue;   // FEC parity, of no use in order
+            pipeline_.push(e.index, e.data, e.size, e.last);
+        }
+    });
+    return true;
+}
 
-    char cpuLabel[8];
-    uint64_t user=0,nice=0,system=0,idleVal=0,iowait=0,irq=0,softirq=0,steal=0,guest=0,guestNice=0;
+// The pipeline must be aborted first if the thread may be blocked in it
+void OtaBackend::stopReplay() {
+    replayStop_ = true;
+    if (replayThread_.joinable()) replayThread_.join();
+}
 
-    int n = std::sscanf(line, "%7s %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu",
-                                cpuLabel, &user, &nice, &system, &idleVal, &iowait, &irq,
-                        &softirq, &steal, &guest, &guestNice);
+/*
+ * ==============================================================
+ * void onChunk(uint32_t index, const uint8_t* data, size_t size, bool lastChunk)
+ * ==============================================================
+ * Called for each file chunk recieved via SOME/IP
+ * Routes it to the manifest fetch, the parallel ranges or the tracked
+ * transfer, none of which waits: the dispatch thread is never held up.
+ */
 
-    if(n < 5) return false;
+void OtaBackend::onChunk(uint32_t index,
+                         const uint8_t* data,
+                         size_t size,
+                         bool lastChunk) {
+    if (fetchingManifest_) {
+        onManifestChunk(index, data, size, lastChunk);
+        return;
+    }
+    if (range_.isActive()) {
+        range_.onChunk(0, index, data, size, lastChunk);
+        return;
+    }
+    if (tracked_) {
+        onTrackedChunk(index, data, size, lastChunk);
+        return;
+    }
+    OTA_LOG_DEBUG("Backend", "Chunk {} outside of a transfer, dropped", index);
+}
 
-    idle = idleVal + iowait;
-    total = user + nice + system + idleVal + iowait + irq + softirq + steal;
+/*
+ * ==============================================================
+ * void onTrackedChunk(uint32_t index, const uint8_t* data, size_t size, bool lastChunk)
+ * ==============================================================
+ * Chunk of the single image or of a bundle artifact: on UDP, after a
+ * gateway restart or with test mode faults it may be out of order,
+ * duplicated, or the last one may never come. The bitmap decides, and
+ * the pipeline closes the file once every chunk is written.
+ * The tag in the index says which stream sent it, so a late chunk of an
+ * earlier repair range still lands at its own offset.
+ */
+void OtaBackend::onTrackedChunk(uint32_t index, const uint8_t* data, size_t size, bool lastChunk) {
+    if (!pipeline_.isActive()) {
+        OTA_LOG_DEBUG("Backend", "Chunk {} outside of a transfer, dropped", index);
+        return;
+    }
+
+    std::vector<FecDecoder::Chunk> rebuilt;
+    std::lock_guard<std::mutex> lk(repairMutex_);
+    lastChunkNs_ = steadyNs();
+
+    if (index & FecDecoder::kParityFlag) {
+        fec_.addParity(index, data, size, rebuilt);
+    } else {
+        const uint32_t tag = index >> RangeTransfer::kTagShift;
+        const uint32_t base = repairBases_[tag];
+        const uint32_t chunk = base + (index & RangeTransfer::kIndexMask);
+        if (base == kNoBase || chunk >= received_.size()) {
+            OTA_LOG_DEBUG("Backend", "Chunk {} of no known stream, dropped", index);
+            return;
+        }
+        if (lastChunk && tag == repairTag_) senderDone_ = true;
+        // Duplicates too: a block dropped by the decoder starts over
+        fec_.addData(chunk, data, size, rebuilt);
+        if (received_.test(chunk)) {
+            ++repairStats_.duplicates;
+        } else if (takeChunk(chunk, data, size) && repairStats_.nacks > 0) {
+            ++repairStats_.repairedChunks;
+        }
+    }
+    for (const FecDecoder::Chunk& c : rebuilt) {
+        if (!received_.test(c.first) && takeChunk(c.first, c.second.data(), c.second.size())) {
+            ++repairStats_.fecRebuilt;
+        }
+    }
+}
+
+/*
+ * Queues a new chunk; repairMutex_ held, which is fine as offer() never
+ * waits. A chunk the pipeline has no credit for stays missing, and from
+ * then on the sender is paced (checkRepair()).
+ */
+bool OtaBackend::takeChunk(uint32_t chunk, const uint8_t* data, size_t size) {
+    if (!pipeline_.offer(chunk, data, size, received_.count() + 1 == received_.size())) {
+        ++repairStats_.refused;
+        if (!paced_) {
+            OTA_LOG_INFO("Backend", "Pipeline full at chunk {}, pacing the sender", chunk);
+            paced_ = true;
+            cut_ = true;
+        }
+        return false;
+    }
+    received_.set(chunk);
+    lastNewChunkNs_ = lastChunkNs_;
     return true;
 }
 
+// written: chunks already on disk, when taking over from the ranges
+void OtaBackend::beginRepairTracking(const std::string& name, uint64_t size, const ChunkBitmap* written) {
+    {
+        std::lock_guard<std::mutex> lk(repairMutex_);
+        trackedName_ = name;
+        trackedSize_ = size;
+        if (written) {
+            received_ = *written;
+        } else {
+            received_.reset(static_cast<uint32_t>((size + CHUNK_SIZE - 1) / CHUNK_SIZE));
+        }
+        repairBases_.fill(kNoBase);
+        repairBases_[0] = 0;
+        repairTag_ = 0;
+        senderDone_ = false;
+        // Rate limited or paused from the start: the first request is already a slice
+        pipeline_.setPaused(transferPaused_);
+        paced_ = written || pipeline_.rateLimit() > 0 || transferPaused_;
+        cut_ = written != nullptr;
+        nextRequestNs_ = 0;
+        lastChunkNs_ = steadyNs();
+        lastNewChunkNs_ = lastChunkNs_;
+        repairRounds_ = 0;
+        countAtRepair_ = received_.count();
+        repairStats_ = RepairStats();
+        fec_.reset(fecConfig_, size, CHUNK_SIZE);
+    }
+    tracked_ = true;
+    postToLoop([this]() {
+        if (!repairTimer_) repairTimer_ = loop_.addTimer(kRepairCheckMs, [this]() { checkRepair(); });
+    });
+}
+
+// Name of the transfer's first request: the file, or its first slice when paced
+std::string OtaBackend::firstRequest() {
+    std::lock_guard<std::mutex> lk(repairMutex_);
+    if (!paced_ || received_.complete()) return trackedName_;
+    ++repairStats_.slices;
+    return requestGap(std::max<size_t>(1, sliceChunks()));
+}
+
 /*
  * ==============================================================
- * bool readProcMeminfo(uint64_t, uint64_t)
+ * std::string requestGap(size_t limit)
  * ==============================================================
- * Reads total and available system memory from /proc/meminfo
- * Uses MemAvailable
+ * repairMutex_ held. Names the first gap (nearby gaps merged), at most
+ * limit chunks of it (0: all), as the next tagged stream, and charges it
+ * to the rate limit when paced.
  */
-bool OtaBackend::readProcMeminfo(uint64_t& memTotalBytes, uint64_t& memAvailBytes){
-    FILE* f = std::fopen("/proc/meminfo", "r");
-    if(!f) return false;
+std::string OtaBackend::requestGap(size_t limit) {
+    static const uint32_t kMergeGap = 8;
+
+    ChunkBitmap::Run gap = received_.missing(kMergeGap, 1)[0];
+    if (limit > 0) gap.count = std::min<uint32_t>(gap.count, static_cast<uint32_t>(limit));
+
+    RangeTransfer::Range range;
+    range.offset = static_cast<uint64_t>(gap.first) * CHUNK_SIZE;
+    range.length = std::min<uint64_t>(static_cast<uint64_t>(gap.count) * CHUNK_SIZE, trackedSize_ - range.offset);
+
+    repairTag_ = repairTag_ % RangeTransfer::kMaxTag + 1;
+    repairBases_[repairTag_] = gap.first;
+    senderDone_ = false;
+    cut_ = false;
+    lastChunkNs_ = steadyNs();
+    if (paced_ && pipeline_.rateLimit() > 0) nextRequestNs_ = lastChunkNs_ + pipeline_.reserve(range.length);
+
+    OTA_LOG_DEBUG("Backend", "Requesting chunks {}+{} ({}/{} received)",
+                  gap.first, gap.count, received_.count(), received_.size());
+    return RangeTransfer::rangeName(trackedName_, range, repairTag_);
+}
 
-    char key[64];
-    uint64_t valueKb = 0;
-    char unit[32];
+// Chunks the pipeline can take now; with a rate limit, kSliceMs of it at most
+size_t OtaBackend::sliceChunks() const {
+    size_t chunks = pipeline_.credits();
+    const uint64_t rate = pipeline_.rateLimit();
+    if (rate > 0) {
+        chunks = std::min<size_t>(chunks, std::max<uint64_t>(1, rate * kSliceMs / 1000 / CHUNK_SIZE));
+    }
+    return chunks;
+}
 
-    memTotalBytes = 0;
-    memAvailBytes = 0;
+/*
+ * ==============================================================
+ * void checkRepair()
+ * ==============================================================
+ * Event loop timer while a tracked download runs. Once the sender
+ * is done with the current stream (its last chunk arrived and the link
+ * is quiet for a moment) or nothing came for repairIdleMs_, the first
+ * gap is asked for again as a range (RangeTransfer::rangeName). Nearby
+ * gaps are merged into one request. Every request gets the next stream
+ * tag (1..kMaxTag, then around again), so chunks still in flight from
+ * the stream it replaces keep their own base. Gives up after repairRoundsMax_
+ * requests in a row that brought nothing new.
+ * Paced (rate limit, or the pipeline refused a chunk): the sender is
+ * throttled here rather than by the pipeline. The running stream is
+ * replaced at once, then each request is a slice of what the pipeline
+ * can take (sliceChunks()), sent once the last one is in, the queue is
+ * at most half full and the rate limit allows. Paused: the running
+ * stream is replaced by one chunk and nothing more is asked for.
+ * Multicast sends no requests: a range would reach every receiver with
+ * indexes they cannot place. Gaps are filled by the next carousel pass;
+ * the transfer fails after multicastTimeoutSec_ without a new chunk.
+ */
+void OtaBackend::checkRepair() {
+    static const uint64_t kSettleNs = 20 * 1000000ULL;
 
-    while(std::fscanf(f, "%63s %lu %31s\n", key, &valueKb, unit) == 3) {
-        if(std::strcmp(key, "MemTotal:") == 0) {
-            memTotalBytes = valueKb * 1024ULL;
-        }else if (std::strcmp(key, "MemAvailable:") == 0) {
-            memAvailBytes = valueKb * 1024ULL;
+    std::string name;
+    {
+        std::lock_guard<std::mutex> lk(repairMutex_);
+        if (!pipeline_.isActive() || received_.complete()) return;
+
+        if (multicast_) {
+            if (steadyNs() - lastNewChunkNs_ < multicastTimeoutSec_ * 1000000000ULL) return;
+            OTA_LOG_ERROR("Backend", "Multicast transfer stalled at {}/{} chunks",
+                          received_.count(), received_.size());
+            lastNewChunkNs_ = steadyNs();
+            postToLoop([this]() {
+                pipeline_.abort();
+                endTransferSession(false);
+                if (errorCb_) errorCb_("Multicast transfer stalled");
+            });
+            return;
         }
 
-        if(memTotalBytes && memAvailBytes) break;
-    }
+        // Paused: one chunk replaces the running stream, which stops the
+        // sender, and the silence after it is no loss
+        if (pipeline_.isPaused()) {
+            lastChunkNs_ = steadyNs();
+            if (!cut_) return;
+            name = requestGap(1);
+        } else {
+            if (!paced_ && pipeline_.rateLimit() > 0) {
+                OTA_LOG_INFO("Backend", "Rate limited, pacing the sender");
+                paced_ = true;
+                cut_ = true;
+            }
 
-    std::fclose(f);
-    return (memTotalBytes > 0);
-}
+            const uint64_t now = steadyNs();
+            const uint64_t quiet = now - lastChunkNs_;
+            const bool done = senderDone_ && (paced_ || quiet >= kSettleNs);
+            if (!cut_ && !done && quiet < repairIdleMs_ * 1000000ULL) return;
+            if (paced_ && (now < nextRequestNs_ || pipeline_.queued() > pipeline_.window() / 2)) return;
 
-bool OtaBackend::readStorageStatvfs(const std::string& path,
-                                    uint64_t& totalBytes,
-                                    uint64_t& usedBytes) {
-    struct statvfs vfs;
-    if (statvfs(path.c_str(), &vfs) != 0) return false;
+            if (received_.count() > countAtRepair_) {
+                repairRounds_ = 0;
+                countAtRepair_ = received_.count();
+            }
+            if (++repairRounds_ > repairRoundsMax_) {
+                OTA_LOG_ERROR("Backend", "Transfer incomplete: {}/{} chunks after {} repair requests",
+                              received_.count(), received_.size(), repairStats_.nacks + repairStats_.slices);
+                postToLoop([this]() { failTracked("Transfer incomplete, repair failed"); });
+                return;
+            }
 
-    const uint64_t blockSize = static_cast<uint64_t>(vfs.f_frsize);
-    const uint64_t total = static_cast<uint64_t>(vfs.f_blocks) * blockSize;
-    const uint64_t free = static_cast<uint64_t>(vfs.f_bfree) * blockSize;
-    const uint64_t used = (total >= free) ? (total - free) : 0;
+            if (paced_) {
+                ++repairStats_.slices;
+                name = requestGap(std::max<size_t>(1, sliceChunks()));
+            } else {
+                ++repairStats_.nacks;
+                name = requestGap(0);
+            }
+        }
+    }
 
-    totalBytes = total;
-    usedBytes = used;
-    return true;
+    proxy_->startTransferAsync(name, [name](const CommonAPI::CallStatus& status, const bool& accepted) {
+        if (status != CommonAPI::CallStatus::SUCCESS || !accepted) {
+            OTA_LOG_WARN("Backend", "Repair request {} not accepted", name);
+        }
+    });
 }
 
-bool OtaBackend::readTemperature(double& tempC) {
-    // /sys/class/thermal/thermal_zone0/temp -> millidegrees C
-    FILE* f = std::fopen("/sys/class/thermal/thermal_zone0/temp", "r");
-    if (!f) return false;
+// Event loop thread: ends the tracked transfer, a bundle through its scheduler
+void OtaBackend::failTracked(const std::string& error) {
+    pipeline_.abort();
+    if (bundle_.isActive()) {
+        bundle_.onTransferError(error);
+        return;
+    }
+    endTransferSession(false);
+    if (errorCb_) errorCb_(error);
+}
 
-    long milli = 0;
-    int n = std::fscanf(f, "%ld", &milli);
-    std::fclose(f);
+OtaBackend::RepairStats OtaBackend::repairStats() const {
+    std::lock_guard<std::mutex> lk(repairMutex_);
+    return repairStats_;
+}
 
-    if (n != 1) return false;
-    tempC = static_cast<double>(milli) / 1000.0;
-    return true;
+FaultInjector::Stats OtaBackend::faultStats() const {
+    return faults_ ? faults_->stats() : FaultInjector::Stats();
 }
 
+uint64_t OtaBackend::updateSize() const {
+    const uint64_t bundle = bundleTotalBytes_.load();
+    return bundle ? bundle : updateInfo_.getSize();
+}
+
+bool OtaBackend::isServerAvailable() const {
+    return proxy_ && proxy_->isAvailable();
+}
 
 /*
  * ==============================================================
- * void pollSystemInfoOnce()
+ * System info sampling
  * ==============================================================
- * Collects a snapshot of system metrics (CPU, memory, storage, temp, uptime)
- * Publishes systemInfo the system info callback.
+ * Each metric has its own timer on the event loop and updates its part of
+ * snapshot_. publishSystemInfo() runs once per wakeup, so metrics sampled
+ * together produce a single callback.
+ * All of these run on the event loop thread (or before it starts).
  */
 
 void OtaBackend::pollSystemInfoOnce() {
-    SystemInfoSnapshot snap;
+    sampleCpu();
+    sampleMemory();
+    sampleStorage();
+    sampleTemperature();
+    sampleUptime();
+    sampleIo();
+    samplePressure();
+    publishSystemInfo();
+}
 
-    // timestamp (ms)
-    const auto now = std::chrono::steady_clock::now().time_since_epoch();
-    snap.timestampMs = static_cast<uint64_t>(
-        std::chrono::duration_cast<std::chrono::milliseconds>(now).count()
-        );
+static int toPercent(uint64_t part, uint64_t whole) {
+    if (whole == 0) return 0;
+    int pct = static_cast<int>(100.0 * static_cast<double>(part) / static_cast<double>(whole) + 0.5);
+    if (pct < 0) pct = 0;
+    if (pct > 100) pct = 100;
+    return pct;
+}
 
-    // CPU%
-    uint64_t idle=0,total=0;
-    if (readProcStatCpu(idle, total)) {
-        if (hasLastCpuSample_) {
-            const uint64_t idleDelta = idle - lastCpuIdle_;
-            const uint64_t totalDelta = total - lastCpuTotal_;
-
-            if (totalDelta > 0) {
-                const double usage = 100.0 * (1.0 - (double)idleDelta / (double)totalDelta);
-                int pct = (int)(usage + 0.5);
-                if (pct < 0) pct = 0;
-                if (pct > 100) pct = 100;
-                snap.cpuPercent = pct;
-            }
+/*
+ * CPU: aggregate, per core, iowait share and this process.
+ * Row 0 of the counters is the aggregate, rows 1..n the cores.
+ */
+void OtaBackend::sampleCpu() {
+    SystemSampler::CpuCounters cpu;
+    if (!sampler_.readCpuCounters(cpu)) return;
+
+    SystemSampler::ProcessCounters self;
+    const bool haveSelf = sampler_.readSelf(self);
+
+    if (hasLastCpuSample_ && cpu.coreCount == lastCpu_.coreCount) {
+        int pct[SystemSampler::kMaxCores + 1];
+        const int rows = cpu.coreCount + 1;
+        for (int i = 0; i < rows; ++i) {
+            const uint64_t totalDelta = cpu.total[i] - lastCpu_.total[i];
+            const uint64_t idleDelta = cpu.idle[i] - lastCpu_.idle[i];
+            pct[i] = toPercent(totalDelta - idleDelta, totalDelta);
+        }
+
+        const uint64_t totalDelta = cpu.total[0] - lastCpu_.total[0];
+        snapshot_.cpuPercent = pct[0];
+        snapshot_.iowaitPercent = toPercent(cpu.iowait[0] - lastCpu_.iowait[0], totalDelta);
+        snapshot_.coreCount = cpu.coreCount;
+        for (int i = 0; i < cpu.coreCount; ++i) snapshot_.coreCpuPercent[i] = pct[i + 1];
+
+        // Aggregate ticks cover every core: divide to get the elapsed ticks of one core
+        const int cores = cpu.coreCount > 0 ? cpu.coreCount : 1;
+        if (haveSelf && totalDelta > 0) {
+            const double perCoreTicks = static_cast<double>(totalDelta) / cores;
+            snapshot_.selfCpuPercent =
+                100.0 * static_cast<double>(self.cpuTicks - lastSelf_.cpuTicks) / perCoreTicks;
         }
-        lastCpuIdle_ = idle;
-        lastCpuTotal_ = total;
-        hasLastCpuSample_ = true;
     }
 
-            // Memory
-    uint64_t memTotal=0, memAvail=0;
-    if (readProcMeminfo(memTotal, memAvail)) {
-        snap.memTotalBytes = memTotal;
-        snap.memUsedBytes = (memTotal >= memAvail) ? (memTotal - memAvail) : 0;
+    if (haveSelf) {
+        snapshot_.selfRssBytes = self.rssBytes;
+        snapshot_.selfThreads = self.threads;
+        lastSelf_ = self;
     }
 
-            // Storage
+    double load1 = 0.0;
+    if (sampler_.readLoadAverage(load1)) snapshot_.loadAverage1 = load1;
+
+    lastCpu_ = cpu;
+    hasLastCpuSample_ = true;
+    snapshotDirty_ = true;
+}
+
+void OtaBackend::sampleMemory() {
+    uint64_t memTotal=0, memAvail=0;
+    if (!sampler_.readMemory(memTotal, memAvail)) return;
+
+    snapshot_.memTotalBytes = memTotal;
+    snapshot_.memUsedBytes = (memTotal >= memAvail) ? (memTotal - memAvail) : 0;
+    snapshotDirty_ = true;
+}
+
+void OtaBackend::sampleStorage() {
     uint64_t stTotal=0, stUsed=0;
-    if (readStorageStatvfs("/", stTotal, stUsed)) {
-        snap.storageTotalBytes = stTotal;
-        snap.storageUsedBytes = stUsed;
-    }
+    if (!sampler_.readStorage(stTotal, stUsed)) return;
+
+    snapshot_.storageTotalBytes = stTotal;
+    snapshot_.storageUsedBytes = stUsed;
+    snapshotDirty_ = true;
+}
 
-            // Temperature
+void OtaBackend::sampleTemperature() {
     double tempC = 0.0;
-    if (readTemperature(tempC)) {
-        snap.temperatureC = tempC;
-    }
+    if (!sampler_.readTemperature(tempC)) return;
 
-    // uptime
-    uint64_t upSec = 0;
-    if (readProcUptime(upSec)) {
-        snap.uptimeSeconds = upSec;
-    }
+    snapshot_.temperatureC = tempC;
 
+    // The measured receive rate is the base when a rate cap is first set
+    if (governor_.update(static_cast<double>(steadyNs()) / 1e9, tempC, snapshot_.netRxBps)) {
+        applyRateLimit();
+        verifyWorkerLimit_ = governor_.workerLimit();
+        OTA_LOG_INFO("Backend", "Thermal governor: {} C, trend {} C/min -> rate limit {} KiB/s, {} workers",
+                     tempC, governor_.trendCPerMin(), governor_.rateLimitBps() / 1024,
+                     governor_.workerLimit());
+    }
+    snapshot_.thermalTrendCPerMin = governor_.trendCPerMin();
+    snapshot_.thermalRateLimitBps = governor_.rateLimitBps();
+    snapshot_.thermalWorkerLimit = static_cast<int>(governor_.workerLimit());
+    snapshotDirty_ = true;
+}
 
-            // Push to controller if callback exists
-    SystemInfoCallback cbCopy;
-    {
-        std::lock_guard<std::mutex> lk(systemInfoCbMutex_);
-        cbCopy = systemInfoCb_;
+// The tighter of the thermal cap and the transfer class cap. Event loop thread.
+void OtaBackend::applyRateLimit() {
+    uint64_t rate = governor_.rateLimitBps();
+    const TransferClass cls = transferClass_.load();
+    if (cls == TransferClass::Background) {
+        rate = rate ? std::min(rate, backgroundRateBps_) : backgroundRateBps_;
     }
-    if (cbCopy) cbCopy(snap);
+    pipeline_.setRateLimit(rate);
+    if (rate > 0) rangesToSingle();
+
+    snapshot_.transferClass = static_cast<int>(cls);
+    snapshot_.rateLimitBps = rate;
+    snapshotDirty_ = true;
 }
 
+void OtaBackend::sampleUptime() {
+    uint64_t upSec = 0;
+    if (!sampler_.readUptime(upSec)) return;
 
-bool OtaBackend::readProcUptime(uint64_t& uptimeSeconds) {
-    static bool initialized = false;
-    static uint64_t baseUptime = 0;
-    static struct timespec baseTime {};
+    snapshot_.uptimeSeconds = upSec;
+    snapshotDirty_ = true;
+}
 
-    if (!initialized) {
-        FILE* f = std::fopen("/proc/uptime", "r");
-        if (!f)
-            return false;
+// Counter delta per second; a counter that went backwards (reset) gives 0
+static double ratePerSecond(uint64_t now, uint64_t last, double seconds) {
+    return (now >= last && seconds > 0.0) ? static_cast<double>(now - last) / seconds : 0.0;
+}
 
-        double up = 0.0;
-        if (std::fscanf(f, "%lf", &up) != 1) {
-            std::fclose(f);
-            return false;
+/*
+ * Disk and network throughput, so a slow download can be attributed to
+ * the link or to the storage. Rates use the measured time between samples
+ * because the interval depends on the activity profile.
+ */
+void OtaBackend::sampleIo() {
+    const uint64_t nowNs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    const double seconds = lastIoNs_ ? static_cast<double>(nowNs - lastIoNs_) / 1e9 : 0.0;
+
+    SystemSampler::DiskCounters disk;
+    if (sampler_.readDisk(disk)) {
+        if (seconds > 0.0) {
+            snapshot_.diskReadBps = ratePerSecond(disk.readBytes, lastDisk_.readBytes, seconds);
+            snapshot_.diskWriteBps = ratePerSecond(disk.writeBytes, lastDisk_.writeBytes, seconds);
+            snapshot_.diskIops = ratePerSecond(disk.ios, lastDisk_.ios, seconds);
+            const double busyMs = ratePerSecond(disk.busyMs, lastDisk_.busyMs, seconds);
+            snapshot_.diskUtilPercent = static_cast<int>(std::min(100.0, busyMs / 10.0) + 0.5);
         }
+        lastDisk_ = disk;
+    }
 
-        std::fclose(f);
+    SystemSampler::NetCounters net;
+    if (sampler_.readNet(net)) {
+        // Another interface was picked: its counters start a new baseline
+        const bool sameInterface = std::strcmp(snapshot_.netInterface, sampler_.netInterface()) == 0;
+        std::strncpy(snapshot_.netInterface, sampler_.netInterface(), sizeof(snapshot_.netInterface) - 1);
+        snapshot_.netLinkMbps = net.linkMbps;
+        if (seconds > 0.0 && sameInterface) {
+            snapshot_.netRxBps = ratePerSecond(net.rxBytes, lastNet_.rxBytes, seconds);
+            snapshot_.netTxBps = ratePerSecond(net.txBytes, lastNet_.txBytes, seconds);
+            snapshot_.netUtilPercent = (net.linkMbps > 0)
+                ? static_cast<int>(std::min(100.0, snapshot_.netRxBps * 8.0 / (net.linkMbps * 1e6) * 100.0) + 0.5)
+                : 0;
+        }
+        lastNet_ = net;
+    }
+
+    lastIoNs_ = nowNs;
+    snapshotDirty_ = true;
+}
+
+/*
+ * ==============================================================
+ * void samplePressure()
+ * ==============================================================
+ * Reads memory and I/O pressure (some avg10). Above its threshold either
+ * one halves the download's credit window; once both are back under half
+ * their threshold the window grows again, a few chunks per sample.
+ */
+void OtaBackend::samplePressure() {
+    SystemSampler::Pressure memory, io;
+    const bool haveMemory = sampler_.readMemoryPressure(memory);
+    const bool haveIo = sampler_.readIoPressure(io);
+    if (!haveMemory && !haveIo) return;
+
+    snapshot_.memoryPressure = memory.someAvg10;
+    snapshot_.ioPressure = io.someAvg10;
+
+    int cause = 0;
+    if (memory.someAvg10 >= memoryPressureLimit_) cause |= ThrottleMemory;
+    if (io.someAvg10 >= ioPressureLimit_) cause |= ThrottleIo;
+    const bool calm = memory.someAvg10 < memoryPressureLimit_ / 2 && io.someAvg10 < ioPressureLimit_ / 2;
+
+    updateThrottle(cause, calm);
+    snapshotDirty_ = true;
+}
 
-        baseUptime = static_cast<uint64_t>(up);
-        clock_gettime(CLOCK_MONOTONIC, &baseTime);
+void OtaBackend::updateThrottle(int cause, bool calm) {
+    static const size_t kWindowStep = 4;
 
-        initialized = true;
+    size_t window = pipeline_.window();
+    if (cause) {
+        window = std::max<size_t>(1, window / 2);
+    } else if (calm) {
+        window = std::min(DownloadPipeline::kMaxWindow, window + kWindowStep);
+    }
+    pipeline_.setWindow(window);
+    window = pipeline_.window();
+    range_.setWindow(window);
+
+    // While throttled every chunk is flushed before the next, so the page
+    // cache cannot grow behind the writer
+    const bool throttled = window < DownloadPipeline::kMaxWindow;
+    const bool wasThrottled = throttleCause_ != 0;
+    pipeline_.setWriteThrough(throttled);
+    range_.setWriteThrough(throttled);
+
+    if (throttled != wasThrottled) {
+        const uint64_t now = steadyNs();
+        if (throttled) {
+            OTA_LOG_WARN("Backend", "Download throttled (memory {}%, io {}%), window {}",
+                         snapshot_.memoryPressure, snapshot_.ioPressure, window);
+            throttleStartNs_ = now;
+        } else {
+            OTA_LOG_INFO("Backend", "Download throttle released");
+            if (transferActive_) throttledNs_ += now - throttleStartNs_;
+        }
     }
 
-    struct timespec now {};
-    clock_gettime(CLOCK_MONOTONIC, &now);
+    // Keep the last cause while the window recovers
+    throttleCause_ = throttled ? (cause ? cause : throttleCause_) : 0;
 
-    uint64_t elapsed =
-        static_cast<uint64_t>(now.tv_sec - baseTime.tv_sec);
+    snapshot_.downloadWindow = static_cast<int>(window);
+    snapshot_.downloadWindowMax = static_cast<int>(DownloadPipeline::kMaxWindow);
+    snapshot_.throttleCause = throttleCause_;
+}
 
-    uptimeSeconds = baseUptime + elapsed;
-    return true;
+void OtaBackend::beginTransferSession() {
+    transferActive_ = true;
+    sessionStartNs_ = steadyNs();
+    throttleStartNs_ = sessionStartNs_;
+    throttledNs_ = 0;
 }
 
+// Logs how long the transfer spent throttled
+void OtaBackend::endTransferSession(bool completed) {
+    if (repairTimer_) {
+        loop_.removeTimer(repairTimer_);
+        repairTimer_ = 0;
+    }
+    recorder_.close();
+    if (!transferActive_) return;
+    transferActive_ = false;
+
+    const uint64_t now = steadyNs();
+    if (throttleCause_) throttledNs_ += now - throttleStartNs_;
+
+    OTA_LOG_INFO("Backend", "Transfer {} after {} ms, throttled for {} ms",
+                 completed ? "completed" : "ended",
+                 (now - sessionStartNs_) / 1000000ULL, throttledNs_ / 1000000ULL);
+}
 
+/*
+ * ==============================================================
+ * bool verifyDownload(std::string& error)
+ * ==============================================================
+ * Checks the image against the CRC-32 announced in UpdateInfo, hashing
+ * with as many workers as the thermal governor currently allows.
+ * A CRC of 0 means the server did not provide one. On failure error
+ * says why, and stays empty if the check was cancelled.
+ */
+bool OtaBackend::verifyDownload(std::string& error) {
+    const uint32_t expected = updateInfo_.getCrc();
+    if (expected == 0) {
+        OTA_LOG_INFO("Backend", "No CRC announced, verification skipped");
+        return true;
+    }
+
+    const std::string path = dataDir_ + outputFilename_;
+    const uint64_t start = steadyNs();
+    uint32_t actual = 0;
+
+    if (!UpdateVerifier::computeCrc(path, governor_.config().maxWorkers,
+                                    [this]() { return verifyWorkerLimit_.load(); },
+                                    actual, &verifyCancel_, &lowPriority_)) {
+        if (!verifyCancel_) error = "Failed to read update file for verification";
+        return false;
+    }
+
+    if (actual != expected) {
+        OTA_LOG_ERROR("Backend", "CRC mismatch: expected {} got {}", expected, actual);
+        error = "Update file failed CRC verification";
+        return false;
+    }
 
+    OTA_LOG_INFO("Backend", "CRC verified in {} ms", (steadyNs() - start) / 1000000ULL);
+    return true;
+}
 
+/*
+ * ==============================================================
+ * void startVerify()
+ * ==============================================================
+ * Runs verifyDownload() on verifyThread_, so the full-image CRC does
+ * not hold up the pipeline's writer thread (or a range stream) after
+ * the last chunk. The result is reported from the event loop: a
+ * callback that starts the next download never runs on verifyThread_,
+ * which therefore always ends on its own and can be joined.
+ */
+void OtaBackend::startVerify() {
+    std::lock_guard<std::mutex> lk(verifyMutex_);
+    if (verifyThread_.joinable()) verifyThread_.join();
+    const uint32_t run = verifyRun_.load();
+    verifyThread_ = std::thread([this, run]() {
+        std::string error;
+        const bool ok = verifyDownload(error);
+        if (!ok && error.empty()) return;   // cancelled
+        postToLoop([this, run, ok, error]() {
+            if (run != verifyRun_.load()) return;
+            if (ok) {
+                if (finishedCb_) finishedCb_();
+            } else if (errorCb_) {
+                errorCb_(error);
+            }
+        });
+    });
+}
 
+// Stops a running verification without reporting it, before the image
+// is rewritten or the backend goes away. A report already queued on
+// the loop is dropped as well.
+void OtaBackend::cancelVerify() {
+    std::lock_guard<std::mutex> lk(verifyMutex_);
+    ++verifyRun_;
+    if (!verifyThread_.joinable()) return;
+    verifyCancel_ = true;
+    verifyThread_.join();
+}
 
+void OtaBackend::publishSystemInfo() {
+    if (!snapshotDirty_) return;
+    snapshotDirty_ = false;
 
+    // timestamp (ms)
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    snapshot_.timestampMs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now).count()
+        );
 
+    recordHistory();
 
+    // Push to controller if callback exists
+    SystemInfoCallback cbCopy;
+    {
+        std::lock_guard<std::mutex> lk(systemInfoCbMutex_);
+        cbCopy = systemInfoCb_;
+    }
+    if (cbCopy) cbCopy(snapshot_);
+}
 
+// History is keyed by wall clock time so it lines up across restarts
+void OtaBackend::recordHistory() {
+    float values[MetricsHistory::MetricCount];
+    values[MetricsHistory::Cpu] = static_cast<float>(snapshot_.cpuPercent);
+    values[MetricsHistory::Iowait] = static_cast<float>(snapshot_.iowaitPercent);
+    values[MetricsHistory::Memory] = snapshot_.memTotalBytes
+        ? 100.0f * static_cast<float>(snapshot_.memUsedBytes) / static_cast<float>(snapshot_.memTotalBytes)
+        : 0.0f;
+    values[MetricsHistory::Temperature] = static_cast<float>(snapshot_.temperatureC);
+    values[MetricsHistory::SelfCpu] = static_cast<float>(snapshot_.selfCpuPercent);
+    values[MetricsHistory::SelfRss] = static_cast<float>(snapshot_.selfRssBytes) / (1024.0f * 1024.0f);
+
+    const auto wall = std::chrono::system_clock::now().time_since_epoch();
+    struct timespec boot;
+    clock_gettime(CLOCK_BOOTTIME, &boot);
+    history_.append(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(wall).count()),
+                    static_cast<uint64_t>(boot.tv_sec) * 1000ULL + static_cast<uint64_t>(boot.tv_nsec) / 1000000ULL,
+                    values);
+}
@@ -7,12 +7,30 @@
 
 #include <CommonAPI/CommonAPI.hpp>
 #include <v0/filetransfer/example/FileTransferProxy.hpp>
+#include "BundleTransfer.h"
+#include "ChunkBitmap.h"
+#include "ChunkRecording.h"
+#include "DownloadPipeline.h"
+#include "EventLoop.h"
+#include "FaultInjector.h"
+#include "FecDecoder.h"
+#include "MetricsHistory.h"
+#include "OtaConfig.h"
+#include "OtaLog.h"
+#include "RangeTransfer.h"
+#include "StartupTrace.h"
+#include "SystemSampler.h"
+#include "ThermalGovernor.h"
+#include "UpdateCheckCache.h"
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 #include <functional>
 #include <thread>
 #include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <ctime>
 
@@ -26,6 +44,9 @@
 
 #define UPDATE_VERSION_PATH OTA_ROOT "update.version"
 #define DATA_CLIENT_PATH OTA_ROOT "data/client/"
+#define LOG_FILE_PATH OTA_ROOT "ota-client.log"
+#define METRICS_HISTORY_PATH OTA_ROOT "metrics.history"
+#define UPDATE_CHECK_CACHE_PATH OTA_ROOT "update.check"
 
 
 
@@ -38,6 +59,9 @@ class OtaBackend {
     using FinishedCallback = std::function<void()>;
     using ErrorCallback = std::function<void(const std::string&)>;
     using ChunkCallback = std::function<void(uint32_t index, uint32_t totalChunks)>;
+    using LogCallback = std::function<void(const std::vector<otalog::Line>& lines, size_t count)>;
+    using AvailabilityCallback = std::function<void(bool available)>;
+    using BundleCallback = std::function<void(const BundleTransfer::Progress&)>;
 
     // System Info Struct
     struct SystemInfoSnapshot {
@@ -49,48 +73,203 @@ class OtaBackend {
         double temperatureC = 0.0;
         uint64_t uptimeSeconds = 0;
 
+        // Per-core utilization (0..100), first coreCount entries are valid
+        static constexpr int kMaxCores = SystemSampler::kMaxCores;
+        int coreCount = 0;
+        int coreCpuPercent[kMaxCores] = {};
+        int iowaitPercent = 0;             // share of CPU time waiting for I/O
+        double loadAverage1 = 0.0;         // 1-minute load average
+
+        // This process
+        double selfCpuPercent = 0.0;       // of one core, > 100 when multi-threaded
+        uint64_t selfRssBytes = 0;
+        uint32_t selfThreads = 0;
+
+        // Block device holding the download directory
+        double diskReadBps = 0.0;
+        double diskWriteBps = 0.0;
+        double diskIops = 0.0;
+        int diskUtilPercent = 0;           // share of time with I/O in flight
+
+        // Active network interface
+        char netInterface[16] = {};
+        double netRxBps = 0.0;
+        double netTxBps = 0.0;
+        int netLinkMbps = -1;              // -1 when the driver does not report it
+        int netUtilPercent = 0;            // rx of link speed, 0 when unknown
+
+        // Pressure stall (some avg10, %) and the download throttle it drives
+        double memoryPressure = 0.0;
+        double ioPressure = 0.0;
+        int downloadWindow = 0;            // credit window in chunks
+        int downloadWindowMax = 0;
+        int throttleCause = 0;             // ThrottleCause bits, 0 when not throttled
+
+        // Thermal governor
+        double thermalTrendCPerMin = 0.0;
+        uint64_t thermalRateLimitBps = 0;  // 0: not limited
+        int thermalWorkerLimit = 0;
+
+        // Transfer class and the rate cap in force (thermal, class), 0: none
+        int transferClass = 0;             // TransferClass
+        uint64_t rateLimitBps = 0;
+
         uint64_t timestampMs = 0;
     };
 
     using SystemInfoCallback = std::function<void(const SystemInfoSnapshot&)>;
 
-    explicit OtaBackend(const std::string& outputFilename);
+    enum ThrottleCause {
+        ThrottleMemory = 1 << 0,
+        ThrottleIo = 1 << 1
+    };
+
+    // Drives the sampling intervals of the system monitor
+    enum class ActivityProfile {
+        Foreground,   // dashboard visible and in use
+        Idle,         // visible, no interaction
+        Background    // hidden
+    };
+
+    // Bandwidth class of the transfer; can be switched while it runs
+    enum class TransferClass {
+        Foreground,   // as fast as the link, disk and thermals allow
+        Background    // capped (OTA_BACKGROUND_RATE), writer and hasher at low priority
+    };
+
+    // Whether requestUpdate() may answer from the disk cache
+    enum class CheckPolicy {
+        Refresh,      // always ask the service
+        PreferCache   // a cached answer younger than the TTL (OTA_CHECK_TTL) is used
+    };
+
+    // Options default to the OTA_* environment (see OtaConfig)
+    explicit OtaBackend(const std::string& outputFilename,
+                        const OtaConfig& config = OtaConfig::fromEnv());
     ~OtaBackend();
 
     bool init();
     void stop();
-    bool requestUpdate(uint32_t currentVersion);
-    bool startDownload();
+    bool requestUpdate(uint32_t currentVersion, CheckPolicy policy = CheckPolicy::Refresh);
+    // Fills updateInfo_ from the disk cache if it holds a fresh answer for
+    // currentVersion. Needs no service, so it works before init().
+    bool loadCachedUpdate(uint32_t currentVersion);
+    // How startDownload() ended. Refused is the server's answer (busy or an
+    // unknown file, after the retries); Failed has been reported through
+    // the error callback.
+    enum class StartResult {
+        Started,
+        Refused,
+        Failed
+    };
+
+    // Bundle mode when the service has the manifest (OTA_BUNDLE_MANIFEST),
+    // the single image otherwise
+    StartResult startDownload();
+    // Feeds a recording (OTA_RECORD_CHUNKS) into the chunk path as if the
+    // service sent it: speed 1 keeps the recorded timing, 0 is as fast as
+    // the pipeline takes it. Needs no service; init() is not required.
+    bool startReplay(const std::string& recording, double speed);
     uint64_t updateSize() const;
     bool isServerAvailable() const;
     ft::FileTransfer::UpdateInfo updateInfo() const;
 
+    void setActivityProfile(ActivityProfile profile);
+    ActivityProfile activityProfile() const;
+    uint64_t eventLoopWakeups() const;
+
+    void setTransferClass(TransferClass cls);
+    TransferClass transferClass() const;
+    // Stops the sender and takes no chunks until resumed; the transfer
+    // then continues from its first missing chunk
+    void setTransferPaused(bool paused);
+    bool isTransferPaused() const;
+    // Single image download: chunks lost on the way (UDP, multicast, a
+    // gateway restart or test mode faults)
+    struct RepairStats {
+        uint64_t nacks = 0;            // repair requests sent
+        uint64_t repairedChunks = 0;   // chunks that arrived through one
+        uint64_t duplicates = 0;       // dropped, already received
+        uint64_t fecRebuilt = 0;       // rebuilt from parity (OTA_FEC)
+        uint64_t refused = 0;          // no pipeline credit, asked for again
+        uint64_t slices = 0;           // paced requests (see checkRepair())
+    };
+    bool isUnreliableTransport() const { return unreliable_; }
+    RepairStats repairStats() const;
+    // Test mode (OTA_FAULTS): faults injected so far in this download
+    FaultInjector::Stats faultStats() const;
+
+    // Ranges of a single image downloaded in parallel, one per service
+    // instance (OTA_RANGE_STREAMS); 1 keeps one in-order stream
+    void setRangeStreams(size_t streams);
+    size_t rangeStreams() const;
+
+    // Time series of the published snapshots (thread safe, see MetricsHistory)
+    const MetricsHistory& history() const;
+
     // callback setters (called by controller)
     void setProgressCallback(ProgressCallback cb);
     void setFinishedCallback(FinishedCallback cb);
     void setErrorCallback(ErrorCallback cb);
     void setChunkCallback(ChunkCallback cb);
     void setSystemInfoCallback(SystemInfoCallback cb);
+    void setLogCallback(LogCallback cb);
+    // Service availability changes, on a CommonAPI thread
+    void setAvailabilityCallback(AvailabilityCallback cb);
+    // Per-artifact progress of a bundle download, on backend threads
+    void setBundleCallback(BundleCallback cb);
 
     std::string outputFilename_;
+    std::string dataDir_ = DATA_CLIENT_PATH;        // OTA_DATA_DIR
+    std::string connectionId_ = "client-sample";    // OTA_CONNECTION_ID
     std::shared_ptr<CommonAPI::Runtime> runtime_;
     std::shared_ptr<ft::FileTransferProxy<>> proxy_;
     ft::FileTransfer::UpdateInfo updateInfo_;
 
 
    private:
+    bool connectService();
+    bool startMonitor();
     void onChunk(uint32_t index,
-                 const CommonAPI::ByteBuffer& data,
+                 const uint8_t* data,
+                 size_t size,
                  bool lastChunk);
 
     void pollSystemInfoOnce();
-    static bool readProcStatCpu(uint64_t& idle, uint64_t& total);
-    static bool readProcMeminfo(uint64_t& memTotalBytes, uint64_t& memAvailBytes);
-    static bool readStorageStatvfs(const std::string& path,
-                                  uint64_t& totalBytes,
-                                   uint64_t& usedBytes);
-    static bool readTemperature(double& tempC);
-    static bool readProcUptime(uint64_t& uptimeSeconds);
+    void sampleCpu();
+    void sampleMemory();
+    void sampleStorage();
+    void sampleTemperature();
+    void sampleUptime();
+    void sampleIo();
+    void samplePressure();
+    void updateThrottle(int cause, bool calm);
+    void onTrackedChunk(uint32_t index, const uint8_t* data, size_t size, bool lastChunk);
+    bool takeChunk(uint32_t chunk, const uint8_t* data, size_t size);
+    void stopReplay();
+    void beginRepairTracking(const std::string& name, uint64_t size, const ChunkBitmap* written = nullptr);
+    std::string firstRequest();
+    std::string requestGap(size_t limit);
+    size_t sliceChunks() const;
+    void checkRepair();
+    void failTracked(const std::string& error);
+    void buildRangeProxies();
+    bool startRanges(const std::string& path);
+    void rangesToSingle();
+    int fetchManifest(UpdateManifest& manifest);
+    void onManifestChunk(uint32_t index, const uint8_t* data, size_t size, bool lastChunk);
+    bool startBundle(const UpdateManifest& manifest);
+    bool beginFileTransfer(const std::string& name, const std::string& path);
+    void applyRateLimit();
+    void beginTransferSession();
+    void endTransferSession(bool completed);
+    bool verifyDownload(std::string& error);
+    void startVerify();
+    void cancelVerify();
+    void publishSystemInfo();
+    void recordHistory();
+    void postToLoop(EventLoop::Task task);
+    void applyActivityProfile();
 
    private:
 
@@ -98,16 +277,130 @@ class OtaBackend {
     FinishedCallback finishedCb_;
     ErrorCallback errorCb_;
     ChunkCallback chunkCb_;
+    AvailabilityCallback availabilityCb_;
+    BundleCallback bundleCb_;
 
     SystemInfoCallback systemInfoCb_;
     std::mutex systemInfoCbMutex_;
 
-    uint64_t lastCpuIdle_ = 0;
-    uint64_t lastCpuTotal_ = 0;
+    SystemSampler sampler_;
+    DownloadPipeline pipeline_;
+    ThermalGovernor governor_;
+    std::atomic<unsigned> verifyWorkerLimit_;
+    std::atomic<bool> verifyCancel_{false};
+    std::mutex verifyMutex_;
+    std::thread verifyThread_;         // verifyDownload(), off the writer thread
+    std::atomic<uint32_t> verifyRun_{0};       // a queued report of an older run is dropped
+    std::atomic<TransferClass> transferClass_{TransferClass::Foreground};
+    std::atomic<bool> lowPriority_{false};     // background class, read by the hashers
+    std::atomic<bool> transferPaused_{false};
+    uint64_t backgroundRateBps_ = 2 * 1024 * 1024;
+    MetricsHistory history_;
+    UpdateCheckCache checkCache_;
+
+    // Bundle mode: manifest fetch, then BundleTransfer drives the pipeline
+    BundleTransfer bundle_;
+    std::string manifestName_ = "update.manifest";
+    std::atomic<bool> fetchingManifest_{false};
+    std::mutex manifestMutex_;
+    std::condition_variable manifestCv_;
+    int manifestResult_ = 0;           // 0 pending, 1 received, -1 failed
+    std::string manifestData_;
+    std::atomic<uint64_t> bundleTotalBytes_{0};
+    UpdateManifest bundleManifest_;    // read by the bundle driver while active
+    std::atomic<uint32_t> bundleChunks_{0};   // chunks of the artifact on the wire
+    uint64_t checkTtlSec_ = 30 * 60;
+
+    // Single image or bundle artifact, on either transport: received
+    // chunks and NACK repair. Each repair range is a new tagged stream
+    // (RangeTransfer::rangeName); its chunk indexes are relative to
+    // repairBases_[tag]. Tag 0 is the main stream.
+    std::atomic<bool> tracked_{false};
+    bool unreliable_ = false;
+    bool multicast_ = false;           // carousel: no repair requests
+    uint64_t multicastTimeoutSec_ = 30;
+    FecDecoder::Config fecConfig_;
+    uint32_t repairIdleMs_ = 200;
+    int repairRoundsMax_ = 20;
+    mutable std::mutex repairMutex_;
+    std::string trackedName_;          // file asked for
+    uint64_t trackedSize_ = 0;
+    ChunkBitmap received_;             // queued in the pipeline
+    std::array<uint32_t, RangeTransfer::kMaxTag + 1> repairBases_;
+    uint32_t repairTag_ = 0;           // stream the sender is on now
+    bool senderDone_ = false;          // "last" seen for the current stream
+    bool paced_ = false;               // sender asked one slice at a time
+    bool cut_ = false;                 // replace the current stream now
+    uint64_t nextRequestNs_ = 0;       // rate limit of paced requests
+    uint64_t lastChunkNs_ = 0;
+    uint64_t lastNewChunkNs_ = 0;
+    FecDecoder fec_;
+    int repairRounds_ = 0;             // without progress
+    uint32_t countAtRepair_ = 0;
+    RepairStats repairStats_;
+    EventLoop::TimerId repairTimer_ = 0;   // loop thread
+    std::atomic<uint32_t> writtenChunks_{0};
+
+    // Multi-range download: stream 0 is proxy_, stream i the i-th extra
+    // instance (OTA_RANGE_INSTANCES, configured in vsomeip.json)
+    RangeTransfer range_;
+    std::atomic<size_t> rangeStreams_{4};
+    std::vector<std::string> rangeInstances_;
+    std::vector<std::shared_ptr<ft::FileTransferProxy<>>> rangeProxies_;
+
+    // Chunk recording (OTA_RECORD_CHUNKS) and replay. Recording covers
+    // the single image over the reliable transport.
+    std::string recordPath_;
+    ChunkRecorder recorder_;
+    std::thread replayThread_;
+    std::atomic<bool> replayStop_{false};
+
+    // Test mode fault schedule between the fileChunk subscription and
+    // onChunk (OTA_FAULTS), null when off. Reset at every download.
+    std::unique_ptr<FaultInjector> faults_;
+
+    std::atomic<bool> monitorStarted_{false};
+
+    // Service availability, from the proxy status event
+    std::mutex availableMutex_;
+    std::condition_variable availableCv_;
+    bool serviceAvailable_ = false;
+
+    // Owned by the event loop thread
+    SystemInfoSnapshot snapshot_;
+    bool snapshotDirty_ = false;
+    uint64_t lastWakeupReport_ = 0;
+
+    SystemSampler::CpuCounters lastCpu_;
+    SystemSampler::ProcessCounters lastSelf_;
     bool hasLastCpuSample_ = false;
 
-    std::thread eventThread_;
-    std::atomic<bool> running_;
+    SystemSampler::DiskCounters lastDisk_;
+    SystemSampler::NetCounters lastNet_;
+    uint64_t lastIoNs_ = 0;
+
+    // PSI thresholds (some avg10, %), OTA_PSI_MEMORY / OTA_PSI_IO
+    double memoryPressureLimit_ = 10.0;
+    double ioPressureLimit_ = 30.0;
+
+    // Throttle bookkeeping, event loop thread
+    int throttleCause_ = 0;
+    bool transferActive_ = false;
+    uint64_t sessionStartNs_ = 0;
+    uint64_t throttleStartNs_ = 0;
+    uint64_t throttledNs_ = 0;
+
+    EventLoop loop_;
+    std::atomic<ActivityProfile> profile_;
+
+    // Set by startMonitor() before the loop starts, then read on the loop thread
+    EventLoop::TimerId cpuTimer_ = 0;
+    EventLoop::TimerId memoryTimer_ = 0;
+    EventLoop::TimerId storageTimer_ = 0;
+    EventLoop::TimerId temperatureTimer_ = 0;
+    EventLoop::TimerId uptimeTimer_ = 0;
+    EventLoop::TimerId ioTimer_ = 0;
+    EventLoop::TimerId pressureTimer_ = 0;
 };
 
 #endif  // OTABACKEND_H
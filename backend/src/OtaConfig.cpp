@@ -0,0 +1,70 @@
+#include "OtaConfig.h"
+
+#include "OtaLog.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+/*
+ * ==============================================================
+ * OtaConfig fromEnv()
+ * ==============================================================
+ * Unset variables keep the defaults; malformed FEC and fault specs are
+ * logged and ignored.
+ */
+OtaConfig OtaConfig::fromEnv() {
+    OtaConfig c;
+    c.thermal = ThermalGovernor::configFromEnv();
+
+    if (const char* v = std::getenv("OTA_DATA_DIR")) {
+        c.dataDir = v;
+        if (!c.dataDir.empty() && c.dataDir.back() != '/') c.dataDir += '/';
+    }
+    if (const char* v = std::getenv("OTA_CONNECTION_ID")) c.connectionId = v;
+    if (const char* v = std::getenv("OTA_THERMAL_ZONE")) c.thermalZone = v;
+    if (const char* v = std::getenv("OTA_PSI_MEMORY")) c.memoryPressureLimit = std::strtod(v, nullptr);
+    if (const char* v = std::getenv("OTA_PSI_IO")) c.ioPressureLimit = std::strtod(v, nullptr);
+    if (const char* v = std::getenv("OTA_CHECK_TTL")) c.checkTtlSec = std::strtoull(v, nullptr, 10);
+    if (const char* v = std::getenv("OTA_BUNDLE_MANIFEST")) c.manifestName = v;
+    if (const char* v = std::getenv("OTA_BACKGROUND_RATE")) {
+        const uint64_t kib = std::strtoull(v, nullptr, 10);
+        if (kib > 0) c.backgroundRateBps = kib * 1024;
+    }
+
+    if (const char* v = std::getenv("OTA_TRANSPORT")) {
+        if (std::strcmp(v, "multicast") == 0) {
+            c.transport = Transport::Multicast;
+        } else if (std::strcmp(v, "udp") == 0) {
+            c.transport = Transport::Udp;
+        }
+    }
+    if (const char* v = std::getenv("OTA_MULTICAST_TIMEOUT")) c.multicastTimeoutSec = std::strtoull(v, nullptr, 10);
+    if (const char* v = std::getenv("OTA_FEC")) {
+        if (!FecDecoder::parseConfig(v, c.fec)) {
+            OTA_LOG_WARN("Config", "OTA_FEC \"{}\" ignored, expected k,m", v);
+            c.fec = FecDecoder::Config();
+        }
+    }
+    if (const char* v = std::getenv("OTA_UDP_REPAIR_IDLE_MS")) c.repairIdleMs = std::strtoul(v, nullptr, 10);
+
+    if (const char* v = std::getenv("OTA_RANGE_STREAMS")) c.rangeStreams = std::strtoul(v, nullptr, 10);
+    if (const char* v = std::getenv("OTA_RANGE_INSTANCES")) {
+        c.rangeInstances.clear();
+        std::string list(v);
+        size_t from = 0;
+        while (from <= list.size()) {
+            const size_t comma = std::min(list.find(',', from), list.size());
+            if (comma > from) c.rangeInstances.push_back(list.substr(from, comma - from));
+            from = comma + 1;
+        }
+    }
+
+    if (const char* v = std::getenv("OTA_RECORD_CHUNKS")) c.recordPath = v;
+    const char* faultSpec = std::getenv("OTA_FAULTS");
+    if (faultSpec && *faultSpec && !FaultInjector::parseConfig(faultSpec, c.faults)) {
+        OTA_LOG_WARN("Config", "OTA_FAULTS \"{}\" ignored", faultSpec);
+        c.faults = FaultInjector::Config();
+    }
+    return c;
+}
@@ -0,0 +1,60 @@
+#ifndef OTACONFIG_H
+#define OTACONFIG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "FaultInjector.h"
+#include "FecDecoder.h"
+#include "ThermalGovernor.h"
+
+/*
+ * ==============================================================
+ * OtaConfig
+ * ==============================================================
+ * Options of an OtaBackend. fromEnv() reads the OTA_* variables (the
+ * README lists them); the benches and ota-cli start from it and change
+ * fields instead of calling setenv() before constructing the backend.
+ * Consistency rules (recording needs the reliable transport, restart is
+ * a server fault) are applied by the backend, whatever the source.
+ */
+struct OtaConfig {
+    enum class Transport {
+        Reliable,       // fileChunk over TCP
+        Udp,            // unreliable, NACK repair
+        Multicast       // unreliable carousel, no repair requests
+    };
+
+    std::string dataDir;                            // OTA_DATA_DIR, empty: DATA_CLIENT_PATH
+    std::string connectionId = "client-sample";     // OTA_CONNECTION_ID
+    std::string thermalZone;                        // OTA_THERMAL_ZONE, empty: SystemSampler default
+    ThermalGovernor::Config thermal;                // OTA_THERMAL_*
+
+    // PSI thresholds (some avg10, %), OTA_PSI_MEMORY / OTA_PSI_IO
+    double memoryPressureLimit = 10.0;
+    double ioPressureLimit = 30.0;
+
+    uint64_t checkTtlSec = 30 * 60;                 // OTA_CHECK_TTL
+    std::string manifestName = "update.manifest";   // OTA_BUNDLE_MANIFEST, empty: no bundles
+    uint64_t backgroundRateBps = 2 * 1024 * 1024;   // OTA_BACKGROUND_RATE (KiB/s)
+
+    Transport transport = Transport::Reliable;      // OTA_TRANSPORT
+    uint64_t multicastTimeoutSec = 30;              // OTA_MULTICAST_TIMEOUT
+    FecDecoder::Config fec;                         // OTA_FEC
+    uint32_t repairIdleMs = 200;                    // OTA_UDP_REPAIR_IDLE_MS
+
+    size_t rangeStreams = 4;                        // OTA_RANGE_STREAMS
+    std::vector<std::string> rangeInstances = {     // OTA_RANGE_INSTANCES
+        "filetransfer.example.FileTransfer2",
+        "filetransfer.example.FileTransfer3",
+        "filetransfer.example.FileTransfer4"};
+
+    std::string recordPath;                         // OTA_RECORD_CHUNKS, empty: off
+    FaultInjector::Config faults;                   // OTA_FAULTS, off unless enabled()
+
+    static OtaConfig fromEnv();
+};
+
+#endif  // OTACONFIG_H
@@ -0,0 +1,501 @@
+#include "OtaLog.h"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace otalog {
+
+namespace detail {
+
+std::atomic<uint8_t> gLevel{static_cast<uint8_t>(Level::Info)};
+
+/*
+ * One ring per producing thread. Only the owning thread moves head,
+ * only the drain thread moves tail. Padding keeps both indices on
+ * separate cache lines.
+ */
+struct ThreadRing {
+    static constexpr uint32_t kCapacity = 512;  // power of two
+
+    std::atomic<uint32_t> head{0};
+    char pad0[60];
+    std::atomic<uint32_t> tail{0};
+    char pad1[60];
+    std::atomic<bool> orphaned{false};
+    uint32_t tid = 0;
+
+    Record slots[kCapacity];
+};
+
+}  // namespace detail
+
+namespace {
+
+using detail::Record;
+using detail::ThreadRing;
+
+// Guards the ring list only; held briefly by a thread's first record and
+// by the drain to copy or prune the list, never across formatting or I/O
+std::mutex gRegistryMutex;
+std::vector<ThreadRing*> gRings;
+// Serializes drains (drain thread and flush()); rings are only freed by a
+// drain, so the copied list stays valid while this is held
+std::mutex gDrainOnceMutex;
+
+std::atomic<uint64_t> gDropped{0};
+uint64_t gDroppedReported = 0;  // drain thread only
+std::atomic<bool> gWakeDrain{false};
+
+std::mutex gDrainMutex;
+std::condition_variable gDrainCv;
+std::thread gDrainThread;
+std::atomic<bool> gRunning{false};
+int gStartCount = 0;  // guarded by gDrainMutex
+Config gConfig;
+
+std::mutex gBatchSinkMutex;
+BatchSink gBatchSink;
+Level gBatchSinkLevel = Level::Info;
+
+int gFileFd = -1;
+int gJournalFd = -1;
+
+// Marks the ring as orphaned when its thread exits, the drain thread frees it
+struct RingHolder {
+    ThreadRing* ring = nullptr;
+    ~RingHolder() {
+        if (ring) ring->orphaned.store(true, std::memory_order_release);
+    }
+};
+
+thread_local RingHolder tlsRing;
+
+ThreadRing* localRing() {
+    if (tlsRing.ring) return tlsRing.ring;
+
+    ThreadRing* ring = new ThreadRing();
+    ring->tid = static_cast<uint32_t>(::syscall(SYS_gettid));
+
+    {
+        std::lock_guard<std::mutex> lk(gRegistryMutex);
+        gRings.push_back(ring);
+    }
+    tlsRing.ring = ring;
+    return ring;
+}
+
+uint64_t realtimeNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+char levelLetter(Level lvl) {
+    switch (lvl) {
+    case Level::Trace: return 'T';
+    case Level::Debug: return 'D';
+    case Level::Info:  return 'I';
+    case Level::Warn:  return 'W';
+    case Level::Error: return 'E';
+    default:           return '?';
+    }
+}
+
+int journalPriority(Level lvl) {
+    switch (lvl) {
+    case Level::Trace:
+    case Level::Debug: return 7;
+    case Level::Info:  return 6;
+    case Level::Warn:  return 4;
+    default:           return 3;
+    }
+}
+
+/*
+ * Expands "{}" placeholders of rec.fmt with the stored arguments.
+ * Surplus placeholders are printed verbatim, surplus arguments are ignored.
+ */
+void formatMessage(const Record& rec, std::string& out) {
+    char num[32];
+    uint8_t argIdx = 0;
+
+    for (const char* p = rec.fmt; *p; ++p) {
+        if (p[0] == '{' && p[1] == '}' && argIdx < rec.argc) {
+            const detail::Arg& a = rec.args[argIdx++];
+            int n = 0;
+            switch (a.type) {
+            case detail::ArgType::Int:
+                n = std::snprintf(num, sizeof(num), "%lld", static_cast<long long>(a.v.i));
+                break;
+            case detail::ArgType::UInt:
+                n = std::snprintf(num, sizeof(num), "%llu", static_cast<unsigned long long>(a.v.u));
+                break;
+            case detail::ArgType::Double:
+                n = std::snprintf(num, sizeof(num), "%.3f", a.v.d);
+                break;
+            case detail::ArgType::Bool:
+                n = std::snprintf(num, sizeof(num), "%s", a.v.u ? "true" : "false");
+                break;
+            case detail::ArgType::Ptr:
+                n = std::snprintf(num, sizeof(num), "%p", a.v.p);
+                break;
+            case detail::ArgType::Str:
+                out.append(rec.text + a.v.s.off, a.v.s.len);
+                break;
+            }
+            if (n > 0) out.append(num, static_cast<size_t>(std::min<int>(n, sizeof(num) - 1)));
+            ++p;
+            continue;
+        }
+        out.push_back(*p);
+    }
+}
+
+void formatLine(const Record& rec, std::string& out) {
+    const time_t sec = static_cast<time_t>(rec.realtimeNs / 1000000000ULL);
+    const unsigned ms = static_cast<unsigned>((rec.realtimeNs / 1000000ULL) % 1000ULL);
+    struct tm tmv;
+    localtime_r(&sec, &tmv);
+
+    char head[64];
+    const size_t n = std::strftime(head, sizeof(head), "%Y-%m-%d %H:%M:%S", &tmv);
+    out.append(head, n);
+
+    char tail[48];
+    const int m = std::snprintf(tail, sizeof(tail), ".%03u %c %5u [", ms, levelLetter(rec.level), rec.tid);
+    if (m > 0) out.append(tail, static_cast<size_t>(m));
+    out.append(rec.tag ? rec.tag : "");
+    out.append("] ");
+    formatMessage(rec, out);
+    out.push_back('\n');
+}
+
+void writeAll(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        const ssize_t n = ::write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+}
+
+void sendJournal(const Record& rec, std::string& scratch) {
+    static const char kSocketPath[] = "/run/systemd/journal/socket";
+
+    scratch.clear();
+    scratch.append("PRIORITY=");
+    scratch.push_back(static_cast<char>('0' + journalPriority(rec.level)));
+    scratch.append("\nSYSLOG_IDENTIFIER=appqnxOta\nOTA_TAG=");
+    scratch.append(rec.tag ? rec.tag : "");
+    scratch.append("\nMESSAGE=");
+    const size_t msgStart = scratch.size();
+    formatMessage(rec, scratch);
+    // The simple journal field format does not allow embedded newlines
+    std::replace(scratch.begin() + static_cast<std::ptrdiff_t>(msgStart), scratch.end(), '\n', ' ');
+    scratch.push_back('\n');
+
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, kSocketPath, sizeof(kSocketPath));
+
+    ::sendto(gJournalFd, scratch.data(), scratch.size(), MSG_NOSIGNAL,
+             reinterpret_cast<const struct sockaddr*>(&addr), sizeof(addr));
+}
+
+/*
+ * ==============================================================
+ * void drainOnce()
+ * ==============================================================
+ * Collects every published record of every ring, orders them by
+ * timestamp, formats them in one buffer and hands the batch to the sinks.
+ * Rings of exited threads are released once they are empty.
+ * The registry lock is only taken to copy and to prune the ring list:
+ * a slow file write or sink never holds up a thread's first record.
+ */
+void drainOnce() {
+    static std::vector<ThreadRing*> rings;
+    static std::vector<const Record*> batch;
+    static std::vector<std::pair<ThreadRing*, uint32_t>> consumed;
+    static std::string lines;
+    static std::string scratch;
+    static std::vector<Line> sinkLines;
+    static size_t sinkUsed;
+
+    std::lock_guard<std::mutex> drainLk(gDrainOnceMutex);
+    {
+        std::lock_guard<std::mutex> lk(gRegistryMutex);
+        rings = gRings;
+    }
+
+    batch.clear();
+    consumed.clear();
+    lines.clear();
+    sinkUsed = 0;
+
+    BatchSink sink;
+    Level sinkLevel;
+    {
+        std::lock_guard<std::mutex> sinkLk(gBatchSinkMutex);
+        sink = gBatchSink;
+        sinkLevel = gBatchSinkLevel;
+    }
+
+    for (ThreadRing* ring : rings) {
+        const uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+        const uint32_t head = ring->head.load(std::memory_order_acquire);
+        for (uint32_t i = tail; i != head; ++i) {
+            batch.push_back(&ring->slots[i & (ThreadRing::kCapacity - 1)]);
+        }
+        consumed.emplace_back(ring, head);
+    }
+
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const Record* a, const Record* b) { return a->realtimeNs < b->realtimeNs; });
+
+    const uint32_t sinks = gConfig.sinks;
+    for (const Record* rec : batch) {
+        if (sinks & (SinkConsole | SinkFile)) formatLine(*rec, lines);
+        if ((sinks & SinkJournal) && gJournalFd >= 0) sendJournal(*rec, scratch);
+
+        if (sink && rec->level >= sinkLevel) {
+            // Reuse the line objects (and their string capacity) across cycles
+            if (sinkUsed == sinkLines.size()) sinkLines.emplace_back();
+            Line& line = sinkLines[sinkUsed++];
+            line.realtimeNs = rec->realtimeNs;
+            line.level = rec->level;
+            line.tag = rec->tag ? rec->tag : "";
+            line.message.clear();
+            formatMessage(*rec, line.message);
+        }
+    }
+
+    // Only the first sinkUsed lines are new; the rest are kept for reuse
+    if (sink && sinkUsed > 0) sink(sinkLines, sinkUsed);
+
+    const uint64_t droppedTotal = gDropped.load(std::memory_order_relaxed);
+    const uint64_t dropped = droppedTotal - gDroppedReported;
+    gDroppedReported = droppedTotal;
+    if (dropped) {
+        char note[96];
+        const int n = std::snprintf(note, sizeof(note),
+                                    "[Log] %llu records dropped (ring full)\n",
+                                    static_cast<unsigned long long>(dropped));
+        if (n > 0) lines.append(note, static_cast<size_t>(n));
+    }
+
+    if (!lines.empty()) {
+        if ((sinks & SinkFile) && gFileFd >= 0) writeAll(gFileFd, lines.data(), lines.size());
+        if (sinks & SinkConsole) writeAll(STDERR_FILENO, lines.data(), lines.size());
+    }
+
+    for (const auto& c : consumed) {
+        c.first->tail.store(c.second, std::memory_order_release);
+    }
+
+    // Release rings whose thread has exited and which are fully drained
+    std::lock_guard<std::mutex> lk(gRegistryMutex);
+    for (auto it = gRings.begin(); it != gRings.end();) {
+        ThreadRing* ring = *it;
+        if (ring->orphaned.load(std::memory_order_acquire) &&
+            ring->head.load(std::memory_order_acquire) == ring->tail.load(std::memory_order_relaxed)) {
+            delete ring;
+            it = gRings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void drainLoop() {
+    std::unique_lock<std::mutex> lk(gDrainMutex);
+    while (gRunning.load()) {
+        gDrainCv.wait_for(lk, std::chrono::milliseconds(gConfig.drainIntervalMs),
+                          [] { return !gRunning.load() || gWakeDrain.load(); });
+        gWakeDrain.store(false);
+        lk.unlock();
+        drainOnce();
+        lk.lock();
+    }
+    lk.unlock();
+    drainOnce();
+}
+
+uint32_t parseSinks(const char* text) {
+    uint32_t sinks = 0;
+    const std::string s(text);
+    if (s.find("console") != std::string::npos) sinks |= SinkConsole;
+    if (s.find("file") != std::string::npos) sinks |= SinkFile;
+    if (s.find("journal") != std::string::npos) sinks |= SinkJournal;
+    return sinks;
+}
+
+}  // namespace
+
+namespace detail {
+
+Record* acquire(ThreadRing*& ring) {
+    ring = localRing();
+    const uint32_t head = ring->head.load(std::memory_order_relaxed);
+    const uint32_t tail = ring->tail.load(std::memory_order_acquire);
+    if (head - tail >= ThreadRing::kCapacity) {
+        gDropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    Record* rec = &ring->slots[head & (ThreadRing::kCapacity - 1)];
+    rec->realtimeNs = realtimeNs();
+    rec->tid = ring->tid;
+    return rec;
+}
+
+void commit(ThreadRing* ring, Record* rec) {
+    ring->head.store(ring->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    // Errors are flushed promptly, everything else waits for the next drain tick
+    if (rec->level >= Level::Error && !gWakeDrain.exchange(true)) {
+        gDrainCv.notify_one();
+    }
+}
+
+}  // namespace detail
+
+const char* levelName(Level lvl) {
+    switch (lvl) {
+    case Level::Trace: return "trace";
+    case Level::Debug: return "debug";
+    case Level::Info:  return "info";
+    case Level::Warn:  return "warn";
+    case Level::Error: return "error";
+    default:           return "off";
+    }
+}
+
+bool parseLevel(const char* text, Level& out) {
+    if (!text) return false;
+    for (uint8_t i = 0; i <= static_cast<uint8_t>(Level::Off); ++i) {
+        const Level lvl = static_cast<Level>(i);
+        if (std::strcmp(text, levelName(lvl)) == 0) {
+            out = lvl;
+            return true;
+        }
+    }
+    return false;
+}
+
+Config configFromEnv(const std::string& defaultFilePath) {
+    Config cfg;
+    cfg.filePath = defaultFilePath;
+
+    Level lvl;
+    if (parseLevel(std::getenv("OTA_LOG_LEVEL"), lvl)) cfg.level = lvl;
+
+    const char* sinks = std::getenv("OTA_LOG_SINKS");
+    if (sinks && *sinks) {
+        cfg.sinks = parseSinks(sinks);
+    } else if (std::getenv("INVOCATION_ID")) {
+        // Started by systemd: journald is the natural destination
+        cfg.sinks = SinkJournal;
+    }
+
+    const char* file = std::getenv("OTA_LOG_FILE");
+    if (file && *file) cfg.filePath = file;
+
+    return cfg;
+}
+
+/*
+ * ==============================================================
+ * bool start(const Config& cfg)
+ * ==============================================================
+ * Opens the sinks and starts the drain thread on first call.
+ * Subsequent calls only add an owner.
+ */
+bool start(const Config& cfg) {
+    std::lock_guard<std::mutex> lk(gDrainMutex);
+    if (gStartCount++ > 0) return true;
+
+    gConfig = cfg;
+    if (gConfig.drainIntervalMs == 0) gConfig.drainIntervalMs = 50;
+    setLevel(cfg.level);
+
+    if ((gConfig.sinks & SinkFile) && !gConfig.filePath.empty()) {
+        gFileFd = ::open(gConfig.filePath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (gFileFd < 0) {
+            // Never lose messages silently: fall back to the console
+            gConfig.sinks = (gConfig.sinks & ~SinkFile) | SinkConsole;
+        }
+    }
+
+    if (gConfig.sinks & SinkJournal) {
+        gJournalFd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (gJournalFd < 0) {
+            gConfig.sinks = (gConfig.sinks & ~SinkJournal) | SinkConsole;
+        }
+    }
+
+    gRunning.store(true);
+    gDrainThread = std::thread(drainLoop);
+    return true;
+}
+
+void stop() {
+    {
+        std::lock_guard<std::mutex> lk(gDrainMutex);
+        if (gStartCount == 0 || --gStartCount > 0) return;
+        gRunning.store(false);
+    }
+    gDrainCv.notify_one();
+    if (gDrainThread.joinable()) gDrainThread.join();
+
+    if (gFileFd >= 0) {
+        ::close(gFileFd);
+        gFileFd = -1;
+    }
+    if (gJournalFd >= 0) {
+        ::close(gJournalFd);
+        gJournalFd = -1;
+    }
+}
+
+void flush() {
+    if (!gRunning.load()) return;
+    drainOnce();
+}
+
+void setBatchSink(BatchSink sink, Level minLevel) {
+    std::lock_guard<std::mutex> lk(gBatchSinkMutex);
+    gBatchSink = std::move(sink);
+    gBatchSinkLevel = minLevel;
+}
+
+void setLevel(Level lvl) {
+    detail::gLevel.store(static_cast<uint8_t>(lvl), std::memory_order_relaxed);
+}
+
+Level level() {
+    return static_cast<Level>(detail::gLevel.load(std::memory_order_relaxed));
+}
+
+uint64_t droppedCount() {
+    return gDropped.load(std::memory_order_relaxed);
+}
+
+}  // namespace otalog
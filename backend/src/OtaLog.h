@@ -0,0 +1,243 @@
+#ifndef OTALOG_H
+#define OTALOG_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/*
+ * ==============================================================
+ * otalog - asynchronous binary logger
+ * ==============================================================
+ * Call sites never format and never touch a file descriptor.
+ * A record (format pointer + tagged binary arguments) is copied into a
+ * lock-free single-producer ring owned by the calling thread.
+ * A background drain thread merges all rings, formats the records and
+ * writes them to the configured sinks (console, file, journald).
+ *
+ * Tags and format strings must be string literals: only their pointers
+ * are stored. Placeholders are "{}". String arguments are copied.
+ *
+ * A disabled call site costs one relaxed atomic load and a compare.
+ */
+
+namespace otalog {
+
+enum class Level : uint8_t {
+    Trace = 0,
+    Debug,
+    Info,
+    Warn,
+    Error,
+    Off
+};
+
+enum SinkFlags : uint32_t {
+    SinkConsole = 1u << 0,
+    SinkFile    = 1u << 1,
+    SinkJournal = 1u << 2
+};
+
+struct Config {
+    Level level = Level::Info;
+    uint32_t sinks = SinkFile;
+    std::string filePath;
+    uint32_t drainIntervalMs = 50;
+};
+
+// Formatted record handed to the batch sink (e.g. the UI log panel)
+struct Line {
+    uint64_t realtimeNs = 0;
+    Level level = Level::Info;
+    const char* tag = "";
+    std::string message;
+};
+
+// Called on the drain thread once per drain cycle with the new records:
+// the first count entries of lines (the vector is reused between cycles)
+using BatchSink = std::function<void(const std::vector<Line>& lines, size_t count)>;
+
+// Reads OTA_LOG_LEVEL, OTA_LOG_SINKS ("console,file,journal") and OTA_LOG_FILE
+Config configFromEnv(const std::string& defaultFilePath);
+
+// Reference counted: the drain thread runs while at least one owner is started
+bool start(const Config& cfg);
+void stop();
+void flush();
+
+// Records below minLevel are not forwarded. Pass nullptr to detach.
+void setBatchSink(BatchSink sink, Level minLevel = Level::Info);
+
+void setLevel(Level lvl);
+Level level();
+const char* levelName(Level lvl);
+bool parseLevel(const char* text, Level& out);
+
+// Records lost because a thread's ring was full
+uint64_t droppedCount();
+
+namespace detail {
+
+extern std::atomic<uint8_t> gLevel;
+
+constexpr size_t kMaxArgs = 8;
+constexpr size_t kTextBytes = 112;
+
+enum class ArgType : uint8_t { Int, UInt, Double, Bool, Str, Ptr };
+
+struct Arg {
+    struct StrRef {
+        uint16_t off;
+        uint16_t len;
+    };
+
+    ArgType type;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const void* p;
+        StrRef s;
+    } v;
+};
+
+struct Record {
+    uint64_t realtimeNs;
+    uint32_t tid;
+    Level level;
+    uint8_t argc;
+    uint16_t textUsed;
+    const char* tag;
+    const char* fmt;
+    Arg args[kMaxArgs];
+    char text[kTextBytes];
+};
+
+struct ThreadRing;
+
+// Reserves the next slot of the calling thread's ring, nullptr when full
+Record* acquire(ThreadRing*& ring);
+// Publishes the slot returned by acquire()
+void commit(ThreadRing* ring, Record* rec);
+
+class Encoder {
+   public:
+    explicit Encoder(Record& rec) : rec_(rec) {}
+
+    void put(bool v) {
+        Arg& a = next();
+        a.type = ArgType::Bool;
+        a.v.u = v ? 1 : 0;
+    }
+
+    void put(double v) {
+        Arg& a = next();
+        a.type = ArgType::Double;
+        a.v.d = v;
+    }
+
+    void put(float v) { put(static_cast<double>(v)); }
+
+    void put(const char* s) { putStr(s, s ? std::strlen(s) : 0); }
+    void put(char* s) { put(static_cast<const char*>(s)); }
+    void put(const std::string& s) { putStr(s.data(), s.size()); }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+    put(T v) {
+        Arg& a = next();
+        a.type = ArgType::Int;
+        a.v.i = static_cast<int64_t>(v);
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type
+    put(T v) {
+        Arg& a = next();
+        a.type = ArgType::UInt;
+        a.v.u = static_cast<uint64_t>(v);
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_enum<T>::value>::type put(T v) {
+        put(static_cast<typename std::underlying_type<T>::type>(v));
+    }
+
+    template <typename T>
+    void put(T* p) {
+        Arg& a = next();
+        a.type = ArgType::Ptr;
+        a.v.p = p;
+    }
+
+   private:
+    Arg& next() { return rec_.args[rec_.argc++]; }
+
+    void putStr(const char* s, size_t len) {
+        const size_t room = kTextBytes - rec_.textUsed;
+        if (len > room) len = room;
+        Arg& a = next();
+        a.type = ArgType::Str;
+        a.v.s.off = rec_.textUsed;
+        a.v.s.len = static_cast<uint16_t>(len);
+        if (len) std::memcpy(rec_.text + rec_.textUsed, s, len);
+        rec_.textUsed = static_cast<uint16_t>(rec_.textUsed + len);
+    }
+
+    Record& rec_;
+};
+
+inline void encodeArgs(Encoder&) {}
+
+template <typename A, typename... Rest>
+inline void encodeArgs(Encoder& enc, const A& a, const Rest&... rest) {
+    enc.put(a);
+    encodeArgs(enc, rest...);
+}
+
+template <typename... Args>
+void write(Level lvl, const char* tag, const char* fmt, const Args&... args) {
+    static_assert(sizeof...(Args) <= kMaxArgs, "too many log arguments");
+
+    ThreadRing* ring = nullptr;
+    Record* rec = acquire(ring);
+    if (!rec) return;
+
+    rec->level = lvl;
+    rec->tag = tag;
+    rec->fmt = fmt;
+    rec->argc = 0;
+    rec->textUsed = 0;
+
+    Encoder enc(*rec);
+    encodeArgs(enc, args...);
+
+    commit(ring, rec);
+}
+
+}  // namespace detail
+
+inline bool enabled(Level lvl) {
+    return static_cast<uint8_t>(lvl) >= detail::gLevel.load(std::memory_order_relaxed);
+}
+
+}  // namespace otalog
+
+#define OTA_LOG(lvl, tag, ...)                                   \
+    do {                                                         \
+        if (::otalog::enabled(lvl))                              \
+            ::otalog::detail::write((lvl), (tag), __VA_ARGS__);  \
+    } while (0)
+
+#define OTA_LOG_TRACE(tag, ...) OTA_LOG(::otalog::Level::Trace, tag, __VA_ARGS__)
+#define OTA_LOG_DEBUG(tag, ...) OTA_LOG(::otalog::Level::Debug, tag, __VA_ARGS__)
+#define OTA_LOG_INFO(tag, ...)  OTA_LOG(::otalog::Level::Info, tag, __VA_ARGS__)
+#define OTA_LOG_WARN(tag, ...)  OTA_LOG(::otalog::Level::Warn, tag, __VA_ARGS__)
+#define OTA_LOG_ERROR(tag, ...) OTA_LOG(::otalog::Level::Error, tag, __VA_ARGS__)
+
+#endif  // OTALOG_H
@@ -0,0 +1,82 @@
+#include "PrefetchScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+PrefetchScheduler::Config PrefetchScheduler::configFromEnv() {
+    Config c;
+    if (const char* v = std::getenv("OTA_PREFETCH")) c.enabled = std::strcmp(v, "0") != 0;
+    if (const char* v = std::getenv("OTA_PREFETCH_INTERVAL")) {
+        const double sec = std::strtod(v, nullptr);
+        if (sec > 0.0) c.intervalSec = sec;
+    }
+    return c;
+}
+
+PrefetchScheduler::PrefetchScheduler()
+    : PrefetchScheduler(Config()) {}
+
+PrefetchScheduler::PrefetchScheduler(const Config& config)
+    : PrefetchScheduler(config, std::random_device()()) {}
+
+PrefetchScheduler::PrefetchScheduler(const Config& config, uint32_t seed)
+    : config_(config), rng_(seed) {}
+
+double PrefetchScheduler::jittered(double sec, double low, double high) {
+    std::uniform_real_distribution<double> factor(low, high);
+    return sec * factor(rng_);
+}
+
+/*
+ * ==============================================================
+ * double nextCheckDelaySec()
+ * ==============================================================
+ * First check shortly after start, then the interval; after failures,
+ * exponential backoff capped at the interval.
+ */
+double PrefetchScheduler::nextCheckDelaySec() {
+    if (!checked_) return jittered(config_.firstCheckSec, 0.5, 1.0);
+    if (failures_ == 0) return jittered(config_.intervalSec, 1.0 - config_.jitter, 1.0 + config_.jitter);
+
+    const double backoff = std::min(config_.intervalSec,
+                                    config_.retrySec * std::ldexp(1.0, static_cast<int>(std::min(failures_ - 1, 30u))));
+    return jittered(backoff, 0.5, 1.0);
+}
+
+void PrefetchScheduler::checkSucceeded() {
+    checked_ = true;
+    failures_ = 0;
+}
+
+void PrefetchScheduler::checkFailed() {
+    checked_ = true;
+    ++failures_;
+}
+
+bool PrefetchScheduler::update(double nowSec, const Activity& a) {
+    const bool busy = a.cpuPercent > config_.busyCpuPercent ||
+                      a.loadPerCore > config_.busyLoadPerCore ||
+                      a.memoryPressure > config_.busyPressure ||
+                      a.ioPressure > config_.busyPressure;
+    const bool calm = a.cpuPercent < config_.idleCpuPercent &&
+                      a.loadPerCore < config_.idleLoadPerCore &&
+                      a.memoryPressure < config_.idlePressure &&
+                      a.ioPressure < config_.idlePressure;
+
+    if (!calm) {
+        calm_ = false;
+    } else if (!calm_) {
+        calm_ = true;
+        calmSinceSec_ = nowSec;
+    }
+
+    const bool wasIdle = idle_;
+    if (busy) {
+        idle_ = false;
+    } else if (calm_ && nowSec - calmSinceSec_ >= config_.idleHoldSec) {
+        idle_ = true;
+    }
+    return idle_ != wasIdle;
+}
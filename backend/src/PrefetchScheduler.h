@@ -0,0 +1,76 @@
+#ifndef PREFETCHSCHEDULER_H
+#define PREFETCHSCHEDULER_H
+
+#include <cstdint>
+#include <random>
+
+/*
+ * ==============================================================
+ * PrefetchScheduler
+ * ==============================================================
+ * When to look for updates, and whether the device is idle enough to
+ * fetch one in the background.
+ * - Checks run every interval (+-20% jitter, so a fleet does not poll in
+ *   step). A failed check is retried after retrySec, doubling per failure
+ *   up to the interval, with the delay drawn from [50%, 100%] of that.
+ * - Idle needs CPU (of other processes), load per core and PSI all below
+ *   their idle thresholds for idleHoldSec; any of them above its busy
+ *   threshold ends it at once.
+ * Pure logic like ThermalGovernor: time and readings are passed in.
+ */
+class PrefetchScheduler {
+   public:
+    struct Config {
+        bool enabled = true;
+        double intervalSec = 6 * 3600.0;
+        double firstCheckSec = 120.0;
+        double retrySec = 60.0;
+        double jitter = 0.2;
+        double idleHoldSec = 60.0;
+
+        double idleCpuPercent = 20.0;
+        double busyCpuPercent = 50.0;
+        double idleLoadPerCore = 0.5;
+        double busyLoadPerCore = 1.0;
+        double idlePressure = 5.0;    // PSI some avg10, memory and I/O
+        double busyPressure = 20.0;
+    };
+
+    struct Activity {
+        double cpuPercent = 0.0;      // without this process
+        double loadPerCore = 0.0;
+        double memoryPressure = 0.0;
+        double ioPressure = 0.0;
+    };
+
+    // OTA_PREFETCH=0 disables, OTA_PREFETCH_INTERVAL (s)
+    static Config configFromEnv();
+
+    PrefetchScheduler();
+    explicit PrefetchScheduler(const Config& config);
+    PrefetchScheduler(const Config& config, uint32_t seed);
+
+    // Delay before the next check, following the last result
+    double nextCheckDelaySec();
+    void checkSucceeded();
+    void checkFailed();
+    unsigned failures() const { return failures_; }
+
+    // Feeds one reading; returns true if isIdle() changed
+    bool update(double nowSec, const Activity& activity);
+    bool isIdle() const { return idle_; }
+    const Config& config() const { return config_; }
+
+   private:
+    double jittered(double sec, double low, double high);
+
+    Config config_;
+    std::mt19937 rng_;
+    bool checked_ = false;
+    unsigned failures_ = 0;
+    bool idle_ = false;
+    bool calm_ = false;
+    double calmSinceSec_ = 0.0;
+};
+
+#endif  // PREFETCHSCHEDULER_H
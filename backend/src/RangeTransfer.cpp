@@ -0,0 +1,192 @@
+#include "RangeTransfer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "OtaLog.h"
+
+constexpr size_t RangeTransfer::kMaxStreams;
+
+RangeTransfer::RangeTransfer(size_t chunkSize)
+    : chunkSize_(chunkSize) {
+    for (size_t i = 0; i < kMaxStreams; ++i) {
+        pipelines_.emplace_back(new DownloadPipeline());
+        pipelines_[i]->setWrittenCallback([this, i](uint32_t index, bool lastChunk) {
+            onWritten(i, index, lastChunk);
+        });
+        pipelines_[i]->setErrorCallback([this, i](const std::string& error) {
+            fail(i, error);
+        });
+    }
+}
+
+RangeTransfer::~RangeTransfer() {
+    cancel();
+}
+
+/*
+ * ==============================================================
+ * std::vector<Range> plan(uint64_t size, size_t streams, size_t chunkSize)
+ * ==============================================================
+ * Equal ranges in whole chunks; the last one takes the remainder. Fewer
+ * ranges than streams when the image has fewer chunks.
+ */
+std::vector<RangeTransfer::Range> RangeTransfer::plan(uint64_t size, size_t streams, size_t chunkSize) {
+    std::vector<Range> ranges;
+    if (size == 0 || chunkSize == 0) return ranges;
+
+    const uint64_t chunks = (size + chunkSize - 1) / chunkSize;
+    streams = static_cast<size_t>(std::max<uint64_t>(1, std::min<uint64_t>(streams, chunks)));
+    const uint64_t perStream = (chunks + streams - 1) / streams;
+
+    for (uint64_t first = 0; first < chunks; first += perStream) {
+        Range r;
+        r.offset = first * chunkSize;
+        r.length = std::min<uint64_t>(perStream * chunkSize, size - r.offset);
+        ranges.push_back(r);
+    }
+    return ranges;
+}
+
+std::string RangeTransfer::rangeName(const std::string& file, const Range& range) {
+    return file + "@" + std::to_string(range.offset) + ":" + std::to_string(range.length);
+}
+
+std::string RangeTransfer::rangeName(const std::string& file, const Range& range, uint32_t tag) {
+    return rangeName(file, range) + "#" + std::to_string(tag);
+}
+
+/*
+ * ==============================================================
+ * bool start(const std::string& file, const std::string& path, uint64_t size,
+ *            size_t streams, Hooks hooks)
+ * ==============================================================
+ * The file is created at its final size, so the streams only overwrite
+ * allocated blocks and never race on extending it. Every pipeline is
+ * ready before its range is requested.
+ */
+bool RangeTransfer::start(const std::string& file, const std::string& path, uint64_t size,
+                          size_t streams, Hooks hooks) {
+    cancel();
+
+    ranges_ = plan(size, std::min(streams, kMaxStreams), chunkSize_);
+    if (ranges_.empty()) return false;
+
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        OTA_LOG_ERROR("Range", "Failed to open {}: {}", path, std::strerror(errno));
+        return false;
+    }
+    const bool sized = ::ftruncate(fd, static_cast<off_t>(size)) == 0;
+    ::close(fd);
+    if (!sized) {
+        OTA_LOG_ERROR("Range", "Failed to size {}: {}", path, std::strerror(errno));
+        return false;
+    }
+
+    hooks_ = std::move(hooks);
+    totalBytes_ = size;
+    {
+        std::lock_guard<std::mutex> lk(writtenMutex_);
+        written_.reset(static_cast<uint32_t>((size + chunkSize_ - 1) / chunkSize_));
+    }
+    doneBytes_ = 0;
+    doneStreams_ = 0;
+    ended_ = false;
+    overrun_ = false;
+
+    for (size_t i = 0; i < ranges_.size(); ++i) {
+        const uint32_t chunks = static_cast<uint32_t>((ranges_[i].length + chunkSize_ - 1) / chunkSize_);
+        if (!pipelines_[i]->beginRange(path, chunkSize_, ranges_[i].offset, chunks)) {
+            cancel();
+            return false;
+        }
+    }
+
+    active_ = true;
+    for (size_t i = 0; i < ranges_.size(); ++i) {
+        const std::string name = rangeName(file, ranges_[i]);
+        if (!hooks_.startRange(i, name)) {
+            OTA_LOG_WARN("Range", "Range {} refused", name);
+            cancel();
+            return false;
+        }
+    }
+
+    OTA_LOG_INFO("Range", "{} bytes in {} ranges", size, ranges_.size());
+    return true;
+}
+
+bool RangeTransfer::cancel() {
+    const bool running = !ended_.exchange(true);
+    abortAll(kMaxStreams);
+    active_ = false;
+    return running;
+}
+
+ChunkBitmap RangeTransfer::written() const {
+    std::lock_guard<std::mutex> lk(writtenMutex_);
+    return written_;
+}
+
+// Aborting joins the writer, so a writer thread must skip its own pipeline
+void RangeTransfer::abortAll(size_t except) {
+    for (size_t i = 0; i < pipelines_.size(); ++i) {
+        if (i != except) pipelines_[i]->abort();
+    }
+}
+
+void RangeTransfer::onChunk(size_t stream, uint32_t index, const uint8_t* data, size_t size, bool lastChunk) {
+    if (!active_ || stream >= ranges_.size()) {
+        OTA_LOG_DEBUG("Range", "Chunk {} of stream {} outside of a transfer, dropped", index, stream);
+        return;
+    }
+    if (pipelines_[stream]->offer(index, data, size, lastChunk) || overrun_.exchange(true)) return;
+    OTA_LOG_INFO("Range", "Stream {} has no credit for chunk {}", stream, index);
+    if (hooks_.overrun) hooks_.overrun();
+}
+
+// Writer thread of stream
+void RangeTransfer::onWritten(size_t stream, uint32_t index, bool lastChunk) {
+    const Range& r = ranges_[stream];
+    {
+        std::lock_guard<std::mutex> lk(writtenMutex_);
+        written_.set(static_cast<uint32_t>(r.offset / chunkSize_) + index);
+    }
+    const uint64_t at = static_cast<uint64_t>(index) * chunkSize_;
+    const uint64_t bytes = at < r.length ? std::min<uint64_t>(chunkSize_, r.length - at) : 0;
+    const uint64_t done = doneBytes_ += bytes;
+
+    if (hooks_.progress && !ended_) hooks_.progress(done, totalBytes_);
+
+    if (lastChunk && ++doneStreams_ == ranges_.size()) {
+        if (ended_.exchange(true)) return;
+        active_ = false;
+        if (hooks_.finished) hooks_.finished(true, std::string());
+    }
+}
+
+// Writer thread of stream; the first failure ends the whole transfer
+void RangeTransfer::fail(size_t stream, const std::string& error) {
+    if (ended_.exchange(true)) return;
+    OTA_LOG_ERROR("Range", "Stream {} failed: {}", stream, error);
+    abortAll(stream);
+    active_ = false;
+    if (hooks_.finished) hooks_.finished(false, error);
+}
+
+void RangeTransfer::setWindow(size_t chunks) {
+    for (auto& p : pipelines_) p->setWindow(chunks);
+}
+
+void RangeTransfer::setWriteThrough(bool enabled) {
+    for (auto& p : pipelines_) p->setWriteThrough(enabled);
+}
+
+void RangeTransfer::setBackground(bool background) {
+    for (auto& p : pipelines_) p->setBackground(background);
+}
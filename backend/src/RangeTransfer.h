@@ -0,0 +1,114 @@
+#ifndef RANGETRANSFER_H
+#define RANGETRANSFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ChunkBitmap.h"
+#include "DownloadPipeline.h"
+
+/*
+ * ==============================================================
+ * RangeTransfer
+ * ==============================================================
+ * Downloads one image as N byte ranges at the same time.
+ * - The image is split into chunk-aligned ranges, requested by name as
+ *   "file@offset:length". The service sends each range as a normal
+ *   transfer whose chunk indexes start at 0.
+ * - A chunk carries no range id, so two ranges cannot share a service
+ *   instance. Stream i runs on instance i, and the caller routes that
+ *   instance's chunks to onChunk(i, ...).
+ * - A range may carry a stream tag, "file@offset:length#tag" with tag
+ *   1..kMaxTag: the service puts it into bits 24-30 of every chunk index
+ *   of that range. The backend's NACK repairs use it, so chunks of an
+ *   earlier stream on the same instance are still placed correctly.
+ * - Every stream has its own DownloadPipeline writing positionally into
+ *   the shared output file, sized up front. Window and priority are
+ *   applied to all of them. The streams are not paced: the first
+ *   chunk a pipeline has no credit for is reported through the overrun
+ *   hook, and the caller takes over from the chunks written so far.
+ * The transport is a hook, so this class does not depend on CommonAPI.
+ */
+class RangeTransfer {
+   public:
+    static constexpr size_t kMaxStreams = 8;
+    static constexpr uint32_t kTagShift = 24;
+    static constexpr uint32_t kMaxTag = 0x7f;
+    static constexpr uint32_t kIndexMask = (1u << kTagShift) - 1;
+
+    struct Range {
+        uint64_t offset = 0;
+        uint64_t length = 0;
+    };
+
+    struct Hooks {
+        // Asks stream's instance for the range name; false if refused
+        std::function<bool(size_t stream, const std::string& name)> startRange;
+        // Called on a writer thread after every chunk
+        std::function<void(uint64_t doneBytes, uint64_t totalBytes)> progress;
+        // Once per transfer, on a writer thread; not after cancel()
+        std::function<void(bool ok, const std::string& error)> finished;
+        // Once per transfer, on a dispatch thread: a chunk was refused
+        std::function<void()> overrun;
+    };
+
+    explicit RangeTransfer(size_t chunkSize);
+    ~RangeTransfer();
+
+    RangeTransfer(const RangeTransfer&) = delete;
+    RangeTransfer& operator=(const RangeTransfer&) = delete;
+
+    // Chunk-aligned ranges, at most streams of them, none empty
+    static std::vector<Range> plan(uint64_t size, size_t streams, size_t chunkSize);
+    static std::string rangeName(const std::string& file, const Range& range);
+    static std::string rangeName(const std::string& file, const Range& range, uint32_t tag);
+
+    // Sizes path and starts every range. False (nothing running) if the
+    // file cannot be prepared or a range is refused.
+    bool start(const std::string& file, const std::string& path, uint64_t size,
+               size_t streams, Hooks hooks);
+    // True if this ended a running transfer (its finished hook will not run)
+    bool cancel();
+    bool isActive() const { return active_.load(); }
+    size_t streams() const { return ranges_.size(); }
+    const std::vector<Range>& ranges() const { return ranges_; }
+    // Chunks of the whole image written so far; final once cancel() returned
+    ChunkBitmap written() const;
+
+    // From stream's event dispatch thread; never waits
+    void onChunk(size_t stream, uint32_t index, const uint8_t* data, size_t size, bool lastChunk);
+
+    // Forwarded to every stream pipeline. Thread safe.
+    void setWindow(size_t chunks);
+    void setWriteThrough(bool enabled);
+    void setBackground(bool background);
+
+   private:
+    void onWritten(size_t stream, uint32_t index, bool lastChunk);
+    void fail(size_t stream, const std::string& error);
+    void abortAll(size_t except);
+
+    const size_t chunkSize_;
+    std::vector<Range> ranges_;
+    // Created once, so the dispatch threads never see the vector change
+    std::vector<std::unique_ptr<DownloadPipeline>> pipelines_;
+    Hooks hooks_;
+    uint64_t totalBytes_ = 0;
+    mutable std::mutex writtenMutex_;
+    ChunkBitmap written_;
+
+    std::atomic<bool> overrun_{false};
+
+    std::atomic<bool> active_{false};
+    std::atomic<bool> ended_{false};       // finished or cancelled
+    std::atomic<uint64_t> doneBytes_{0};
+    std::atomic<size_t> doneStreams_{0};
+};
+
+#endif  // RANGETRANSFER_H
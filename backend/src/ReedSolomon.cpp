@@ -0,0 +1,144 @@
+#include "ReedSolomon.h"
+
+#include <cstring>
+
+namespace {
+
+// GF(2^8) with the polynomial x^8 + x^4 + x^3 + x^2 + 1 (0x11d)
+struct Gf256 {
+    uint8_t exp[512];
+    uint8_t log[256];
+    uint8_t mul[256][256];
+
+    Gf256() {
+        unsigned x = 1;
+        for (unsigned i = 0; i < 255; ++i) {
+            exp[i] = static_cast<uint8_t>(x);
+            log[x] = static_cast<uint8_t>(i);
+            x <<= 1;
+            if (x & 0x100) x ^= 0x11d;
+        }
+        for (unsigned i = 255; i < 512; ++i) exp[i] = exp[i - 255];
+        log[0] = 0;
+
+        for (unsigned a = 0; a < 256; ++a) {
+            for (unsigned b = 0; b < 256; ++b) {
+                mul[a][b] = (a && b) ? exp[log[a] + log[b]] : 0;
+            }
+        }
+    }
+
+    uint8_t inv(uint8_t a) const { return exp[255 - log[a]]; }
+};
+
+const Gf256& gf() {
+    static const Gf256 table;
+    return table;
+}
+
+// dst ^= c * src, the inner loop of both encode and decode
+void mulAdd(uint8_t* dst, const uint8_t* src, uint8_t c, size_t len) {
+    if (c == 0) return;
+    if (c == 1) {
+        for (size_t i = 0; i < len; ++i) dst[i] ^= src[i];
+        return;
+    }
+    const uint8_t* row = gf().mul[c];
+    for (size_t i = 0; i < len; ++i) dst[i] ^= row[src[i]];
+}
+
+}  // namespace
+
+ReedSolomon::ReedSolomon(unsigned k, unsigned m)
+    : k_(k), m_(m) {
+    if (!isValid()) return;
+
+    // Row x_i = k + i, column y_j = j: x_i ^ y_j is never 0
+    matrix_.resize(static_cast<size_t>(m_) * k_);
+    for (unsigned i = 0; i < m_; ++i) {
+        for (unsigned j = 0; j < k_; ++j) {
+            matrix_[i * k_ + j] = gf().inv(static_cast<uint8_t>((k_ + i) ^ j));
+        }
+    }
+}
+
+void ReedSolomon::encode(const uint8_t* const* data, uint8_t* const* parity, size_t len) const {
+    for (unsigned i = 0; i < m_; ++i) {
+        std::memset(parity[i], 0, len);
+        for (unsigned j = 0; j < k_; ++j) mulAdd(parity[i], data[j], coef(i, j), len);
+    }
+}
+
+/*
+ * ==============================================================
+ * bool decode(uint8_t* const* shards, const bool* present, size_t len) const
+ * ==============================================================
+ * With e data shards missing, e received parity rows give e equations in
+ * them once the known data is subtracted. The e x e Cauchy submatrix is
+ * inverted (Gauss-Jordan) and applied to those right-hand sides.
+ */
+bool ReedSolomon::decode(uint8_t* const* shards, const bool* present, size_t len) const {
+    if (!isValid()) return false;
+
+    std::vector<unsigned> lost;
+    for (unsigned j = 0; j < k_; ++j) {
+        if (!present[j]) lost.push_back(j);
+    }
+    if (lost.empty()) return true;
+
+    std::vector<unsigned> rows;
+    for (unsigned i = 0; i < m_ && rows.size() < lost.size(); ++i) {
+        if (present[k_ + i]) rows.push_back(i);
+    }
+    if (rows.size() < lost.size()) return false;
+
+    const size_t e = lost.size();
+
+    // Right-hand sides: parity minus the contribution of the known data
+    std::vector<std::vector<uint8_t>> rhs(e, std::vector<uint8_t>(len));
+    for (size_t r = 0; r < e; ++r) {
+        std::memcpy(rhs[r].data(), shards[k_ + rows[r]], len);
+        for (unsigned j = 0; j < k_; ++j) {
+            if (present[j]) mulAdd(rhs[r].data(), shards[j], coef(rows[r], j), len);
+        }
+    }
+
+    // Invert A[r][c] = coef(rows[r], lost[c])
+    std::vector<uint8_t> a(e * e), inv(e * e, 0);
+    for (size_t r = 0; r < e; ++r) {
+        for (size_t c = 0; c < e; ++c) a[r * e + c] = coef(rows[r], lost[c]);
+        inv[r * e + r] = 1;
+    }
+    const Gf256& g = gf();
+    for (size_t col = 0; col < e; ++col) {
+        size_t pivot = col;
+        while (pivot < e && a[pivot * e + col] == 0) ++pivot;
+        if (pivot == e) return false;
+        if (pivot != col) {
+            for (size_t c = 0; c < e; ++c) {
+                std::swap(a[pivot * e + c], a[col * e + c]);
+                std::swap(inv[pivot * e + c], inv[col * e + c]);
+            }
+        }
+        const uint8_t scale = g.inv(a[col * e + col]);
+        for (size_t c = 0; c < e; ++c) {
+            a[col * e + c] = g.mul[scale][a[col * e + c]];
+            inv[col * e + c] = g.mul[scale][inv[col * e + c]];
+        }
+        for (size_t r = 0; r < e; ++r) {
+            const uint8_t f = a[r * e + col];
+            if (r == col || f == 0) continue;
+            for (size_t c = 0; c < e; ++c) {
+                a[r * e + c] ^= g.mul[f][a[col * e + c]];
+                inv[r * e + c] ^= g.mul[f][inv[col * e + c]];
+            }
+        }
+    }
+
+    for (size_t c = 0; c < e; ++c) {
+        uint8_t* out = shards[lost[c]];
+        std::memset(out, 0, len);
+        for (size_t r = 0; r < e; ++r) mulAdd(out, rhs[r].data(), inv[c * e + r], len);
+    }
+    return true;
+}
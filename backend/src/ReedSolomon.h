@@ -0,0 +1,44 @@
+#ifndef REEDSOLOMON_H
+#define REEDSOLOMON_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * ==============================================================
+ * ReedSolomon
+ * ==============================================================
+ * Systematic Reed-Solomon erasure code over GF(2^8): k data shards are
+ * sent unchanged, m parity shards are added, and any k of the k + m
+ * shards rebuild the data. The parity rows form a Cauchy matrix, so every
+ * square submatrix is invertible and no search for a decodable set is
+ * needed. k + m is at most 256.
+ * All shards of a block have the same length; a short last block is
+ * padded with zero shards, a short last chunk with zero bytes.
+ */
+class ReedSolomon {
+   public:
+    ReedSolomon(unsigned k, unsigned m);
+
+    unsigned dataShards() const { return k_; }
+    unsigned parityShards() const { return m_; }
+    bool isValid() const { return k_ > 0 && m_ > 0 && k_ + m_ <= 256; }
+
+    // parity[i] (len bytes each) from data[0..k)
+    void encode(const uint8_t* const* data, uint8_t* const* parity, size_t len) const;
+
+    // shards[0..k+m), present[i] for the ones received. Rebuilds the
+    // missing data shards in place (their buffers must be len bytes).
+    // False if fewer than k shards are present.
+    bool decode(uint8_t* const* shards, const bool* present, size_t len) const;
+
+   private:
+    uint8_t coef(unsigned parityRow, unsigned dataCol) const { return matrix_[parityRow * k_ + dataCol]; }
+
+    unsigned k_;
+    unsigned m_;
+    std::vector<uint8_t> matrix_;   // m x k Cauchy matrix
+};
+
+#endif  // REEDSOLOMON_H
@@ -0,0 +1,167 @@
+#include "StartupTrace.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+uint64_t clockNs(clockid_t clock) {
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// Field 22 of /proc/self/stat: start time in clock ticks since boot
+bool processStartTicks(uint64_t& ticks) {
+    FILE* f = std::fopen("/proc/self/stat", "r");
+    if (!f) return false;
+    char buf[1024];
+    const size_t n = std::fread(buf, 1, sizeof(buf) - 1, f);
+    std::fclose(f);
+    buf[n] = '\0';
+
+    // The command name may hold spaces; fields count from its ')'
+    const char* p = std::strrchr(buf, ')');
+    if (!p) return false;
+    for (int field = 2; field < 22; ++field) {
+        p = std::strchr(p + 1, ' ');
+        if (!p) return false;
+    }
+    ticks = std::strtoull(p + 1, nullptr, 10);
+    return true;
+}
+
+int currentThread() {
+    return static_cast<int>(syscall(SYS_gettid));
+}
+
+double toMs(uint64_t ns) {
+    return static_cast<double>(ns) / 1e6;
+}
+
+}  // namespace
+
+StartupTrace& StartupTrace::instance() {
+    static StartupTrace trace;
+    return trace;
+}
+
+/*
+ * ==============================================================
+ * StartupTrace()
+ * ==============================================================
+ * The process start is known in boot time (ticks, 10 ms on most
+ * kernels); the time elapsed since then is moved onto the monotonic
+ * clock the phases use. Without /proc the origin is the first use.
+ */
+StartupTrace::StartupTrace() {
+    const uint64_t monotonic = clockNs(CLOCK_MONOTONIC);
+    originNs_ = monotonic;
+
+    uint64_t ticks = 0;
+    const long hz = sysconf(_SC_CLK_TCK);
+    if (hz > 0 && processStartTicks(ticks)) {
+        const uint64_t startBoot = ticks * (1000000000ULL / static_cast<uint64_t>(hz));
+        const uint64_t boot = clockNs(CLOCK_BOOTTIME);
+        if (boot > startBoot && boot - startBoot < monotonic) originNs_ = monotonic - (boot - startBoot);
+    }
+}
+
+uint64_t StartupTrace::nowNs() const {
+    return clockNs(CLOCK_MONOTONIC) - originNs_;
+}
+
+StartupTrace::Phase* StartupTrace::find(const char* name) {
+    for (Phase& p : phases_) {
+        if (p.name == name || std::strcmp(p.name, name) == 0) return &p;
+    }
+    return nullptr;
+}
+
+const StartupTrace::Phase* StartupTrace::find(const char* name) const {
+    return const_cast<StartupTrace*>(this)->find(name);
+}
+
+void StartupTrace::begin(const char* name) {
+    const uint64_t now = nowNs();
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (find(name)) return;
+    Phase p;
+    p.name = name;
+    p.beginNs = now;
+    p.thread = currentThread();
+    phases_.push_back(p);
+}
+
+void StartupTrace::end(const char* name) {
+    const uint64_t now = nowNs();
+    std::lock_guard<std::mutex> lk(mutex_);
+    Phase* p = find(name);
+    if (p && p->endNs == 0) p->endNs = now;
+}
+
+void StartupTrace::mark(const char* name) {
+    const uint64_t now = nowNs();
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (find(name)) return;
+    Phase p;
+    p.name = name;
+    p.beginNs = now;
+    p.endNs = now;
+    p.thread = currentThread();
+    phases_.push_back(p);
+}
+
+uint64_t StartupTrace::endNs(const char* name) const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    const Phase* p = find(name);
+    return p ? p->endNs : 0;
+}
+
+std::vector<StartupTrace::Phase> StartupTrace::phases() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return phases_;
+}
+
+std::vector<std::string> StartupTrace::report() const {
+    std::vector<std::string> lines;
+    char buf[160];
+    for (const Phase& p : phases()) {
+        if (p.endNs == 0) {
+            std::snprintf(buf, sizeof(buf), "%9.1f ms  %9s     %6d  %s (not finished)", toMs(p.beginNs), "",
+                          p.thread, p.name);
+        } else if (p.endNs == p.beginNs) {
+            std::snprintf(buf, sizeof(buf), "%9.1f ms  %9s     %6d  %s", toMs(p.beginNs), "", p.thread, p.name);
+        } else {
+            std::snprintf(buf, sizeof(buf), "%9.1f ms  +%8.1f ms  %6d  %s", toMs(p.beginNs),
+                          toMs(p.endNs - p.beginNs), p.thread, p.name);
+        }
+        lines.push_back(buf);
+    }
+    return lines;
+}
+
+std::string StartupTrace::jsonFields() const {
+    std::string out = "\"phases\":[";
+    char buf[200];
+    char end[32];
+    bool first = true;
+    for (const Phase& p : phases()) {
+        if (p.endNs == 0) {
+            std::snprintf(end, sizeof(end), "null");
+        } else {
+            std::snprintf(end, sizeof(end), "%.3f", toMs(p.endNs));
+        }
+        std::snprintf(buf, sizeof(buf), "%s{\"name\":\"%s\",\"begin_ms\":%.3f,\"end_ms\":%s,\"thread\":%d}",
+                      first ? "" : ",", p.name, toMs(p.beginNs), end, p.thread);
+        out += buf;
+        first = false;
+    }
+    out += ']';
+    return out;
+}
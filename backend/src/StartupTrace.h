@@ -0,0 +1,64 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * ==============================================================
+ * StartupTrace
+ * ==============================================================
+ * Monotonic timestamps of the startup phases, process wide: the QML
+ * load, the CommonAPI runtime, proxy build, service wait, subscription,
+ * the first system sample, the first frame. Times are from the start of
+ * the process (its start time in /proc/self/stat), so exec, dynamic
+ * linking and static initialization count too.
+ *
+ * A phase is a begin/end pair or a single mark; each name is recorded
+ * once, later calls with the same name are ignored (a retried init does
+ * not move the first numbers). Names must be string literals, as for
+ * the logger tags. Thread safe; the thread of each phase is kept so the
+ * report shows what ran in parallel.
+ */
+class StartupTrace {
+   public:
+    struct Phase {
+        const char* name = "";
+        uint64_t beginNs = 0;       // since process start
+        uint64_t endNs = 0;         // == beginNs for a mark, 0 while running
+        int thread = 0;             // kernel thread id
+    };
+
+    static StartupTrace& instance();
+
+    void begin(const char* name);
+    void end(const char* name);
+    void mark(const char* name);
+
+    // End of the phase (or the mark) since process start, 0 if not seen
+    uint64_t endNs(const char* name) const;
+    std::vector<Phase> phases() const;
+
+    // Now, since process start
+    uint64_t nowNs() const;
+
+    // One line per phase: start, duration, thread, name
+    std::vector<std::string> report() const;
+    // {"phases":[{"name":..,"begin_ms":..,"end_ms":..,"thread":..},..]}
+    // without the braces, to embed in a larger object
+    std::string jsonFields() const;
+
+   private:
+    StartupTrace();
+
+    Phase* find(const char* name);
+    const Phase* find(const char* name) const;
+
+    uint64_t originNs_ = 0;         // CLOCK_MONOTONIC at process start
+    mutable std::mutex mutex_;
+    std::vector<Phase> phases_;
+};
+
+#endif  // STARTUPTRACE_H
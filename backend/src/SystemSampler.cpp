@@ -0,0 +1,638 @@
+#include "SystemSampler.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+/*
+ * ==============================================================
+ * Non-allocating text helpers
+ * ==============================================================
+ */
+
+static inline const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    return p;
+}
+
+static inline bool parseU64(const char*& p, const char* end, uint64_t& out) {
+    p = skipBlanks(p, end);
+    if (p >= end || *p < '0' || *p > '9') return false;
+
+    uint64_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + static_cast<uint64_t>(*p - '0');
+        ++p;
+    }
+    out = v;
+    return true;
+}
+
+// "12.34" -> 12.34; only the digits /proc prints, no sign or exponent
+static inline bool parseDecimal(const char*& p, const char* end, double& out) {
+    uint64_t whole = 0;
+    if (!parseU64(p, end, whole)) return false;
+
+    double frac = 0.0;
+    if (p < end && *p == '.') {
+        double scale = 0.1;
+        for (++p; p < end && *p >= '0' && *p <= '9'; ++p) {
+            frac += (*p - '0') * scale;
+            scale *= 0.1;
+        }
+    }
+    out = static_cast<double>(whole) + frac;
+    return true;
+}
+
+static inline const char* nextLine(const char* p, const char* end) {
+    const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return nl ? static_cast<const char*>(nl) + 1 : end;
+}
+
+static inline bool hasPrefix(const char* p, const char* end, const char* lit, size_t litLen) {
+    return static_cast<size_t>(end - p) >= litLen && std::memcmp(p, lit, litLen) == 0;
+}
+
+/*
+ * ==============================================================
+ * ProcFile
+ * ==============================================================
+ */
+
+ProcFile::~ProcFile() {
+    close();
+}
+
+bool ProcFile::open(const char* path) {
+    close();
+    fd_ = ::open(path, O_RDONLY | O_CLOEXEC);
+    return fd_ >= 0;
+}
+
+void ProcFile::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+ssize_t ProcFile::read(char* buf, size_t cap) const {
+    if (fd_ < 0 || cap == 0) return -1;
+
+    ssize_t n;
+    do {
+        n = ::pread(fd_, buf, cap - 1, 0);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) return -1;
+    buf[n] = '\0';
+    return n;
+}
+
+/*
+ * ==============================================================
+ * SystemSampler
+ * ==============================================================
+ */
+
+SystemSampler::SystemSampler(const std::string& storagePath, const std::string& thermalPath,
+                             const std::string& ioPath)
+    : storagePath_(storagePath), thermalPath_(thermalPath), ioPath_(ioPath) {
+    buf_[0] = '\0';
+    const long page = sysconf(_SC_PAGESIZE);
+    if (page > 0) pageSize_ = static_cast<uint64_t>(page);
+}
+
+SystemSampler::~SystemSampler() {
+    close();
+}
+
+bool SystemSampler::open() {
+    const bool statOk = stat_.open("/proc/stat");
+    meminfo_.open("/proc/meminfo");
+    thermal_.open(thermalPath_.c_str());
+    selfStat_.open("/proc/self/stat");
+    diskstats_.open("/proc/diskstats");
+    netDev_.open("/proc/net/dev");
+    netRoute_.open("/proc/net/route");
+    memoryPressure_.open("/proc/pressure/memory");
+    ioPressure_.open("/proc/pressure/io");
+    loadavg_.open("/proc/loadavg");
+
+    if (storageFd_ < 0) {
+        storageFd_ = ::open(storagePath_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+
+    resolveDiskDevice();
+    char routed[kInterfaceNameSize] = {};
+    readDefaultRoute(routed);
+    selectInterface(routed);
+
+    return statOk;
+}
+
+void SystemSampler::close() {
+    stat_.close();
+    meminfo_.close();
+    thermal_.close();
+    selfStat_.close();
+    diskstats_.close();
+    netDev_.close();
+    netRoute_.close();
+    linkSpeed_.close();
+    memoryPressure_.close();
+    ioPressure_.close();
+    loadavg_.close();
+    if (storageFd_ >= 0) {
+        ::close(storageFd_);
+        storageFd_ = -1;
+    }
+}
+
+/*
+ * ==============================================================
+ * bool readCpu(uint64_t&, uint64_t&)
+ * ==============================================================
+ * Reads cumulative CPU time counters from the aggregate line of /proc/stat.
+ * The returned values are monotonic since boot and must be differenced
+ * across samples to compute CPU usage.
+ * Only the first line is needed, so a short read is enough.
+ */
+bool SystemSampler::readCpu(uint64_t& idle, uint64_t& total) {
+    const ssize_t n = stat_.read(buf_, 512);
+    if (n <= 0) return false;
+    return parseCpuLine(buf_, static_cast<size_t>(n), idle, total);
+}
+
+bool SystemSampler::parseCpuLine(const char* data, size_t len, uint64_t& idle, uint64_t& total) {
+    const char* p = data;
+    const char* end = data + len;
+
+    if (!hasPrefix(p, end, "cpu ", 4)) return false;
+    p += 4;
+
+    // user nice system idle iowait irq softirq steal (guest fields are already in user/nice)
+    uint64_t v[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    int count = 0;
+    while (count < 8 && parseU64(p, end, v[count])) ++count;
+
+    if (count < 4) return false;
+
+    idle = v[3] + v[4];
+    total = v[0] + v[1] + v[2] + v[3] + v[4] + v[5] + v[6] + v[7];
+    return true;
+}
+
+/*
+ * ==============================================================
+ * bool readCpuCounters(CpuCounters&)
+ * ==============================================================
+ * Reads the aggregate and the per-core lines of /proc/stat.
+ * Cores beyond kMaxCores are ignored.
+ */
+bool SystemSampler::readCpuCounters(CpuCounters& out) {
+    const ssize_t n = stat_.read(buf_, 4096);
+    if (n <= 0) return false;
+    return parseCpuCounters(buf_, static_cast<size_t>(n), out);
+}
+
+bool SystemSampler::parseCpuCounters(const char* data, size_t len, CpuCounters& out) {
+    const char* p = data;
+    const char* end = data + len;
+    int row = 0;
+
+    out.coreCount = 0;
+
+    while (p < end && row <= kMaxCores && hasPrefix(p, end, "cpu", 3)) {
+        const char* lineEnd = nextLine(p, end);
+        const char* q = p + 3;
+
+        // "cpu " is the aggregate, "cpuN " a core; rows follow file order
+        while (q < lineEnd && *q != ' ') ++q;
+
+        uint64_t v[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        int count = 0;
+        while (count < 8 && parseU64(q, lineEnd, v[count])) ++count;
+        if (count < 4) return false;
+
+        out.total[row] = v[0] + v[1] + v[2] + v[3] + v[4] + v[5] + v[6] + v[7];
+        out.idle[row] = v[3] + v[4];
+        out.iowait[row] = v[4];
+
+        ++row;
+        p = lineEnd;
+    }
+
+    if (row == 0) return false;
+    out.coreCount = row - 1;
+    return true;
+}
+
+/*
+ * ==============================================================
+ * bool readSelf(ProcessCounters&)
+ * ==============================================================
+ * CPU time, resident set size and thread count of this process.
+ * /proc/self/stat carries all three (VmRSS and Threads of
+ * /proc/self/status are derived from the same counters).
+ */
+bool SystemSampler::readSelf(ProcessCounters& out) {
+    const ssize_t n = selfStat_.read(buf_, 1024);
+    if (n <= 0) return false;
+    return parseSelfStat(buf_, static_cast<size_t>(n), pageSize_, out);
+}
+
+bool SystemSampler::parseSelfStat(const char* data, size_t len, uint64_t pageSize,
+                                  ProcessCounters& out) {
+    const char* end = data + len;
+
+    // comm may contain spaces and parentheses: fields restart after the last ')'
+    const char* p = end;
+    while (p > data && *(p - 1) != ')') --p;
+    if (p == data) return false;
+
+    // p now points after ')', at field 3 (state). Wanted: 14 utime, 15 stime,
+    // 20 num_threads, 24 rss. Other fields may be negative and are skipped.
+    uint64_t utime = 0, stime = 0, threads = 0, rssPages = 0;
+    for (int field = 3; field <= 24 && p < end; ++field) {
+        p = skipBlanks(p, end);
+        const char* tokEnd = p;
+        while (tokEnd < end && *tokEnd != ' ' && *tokEnd != '\n') ++tokEnd;
+
+        const char* q = p;
+        switch (field) {
+        case 14: if (!parseU64(q, tokEnd, utime)) return false; break;
+        case 15: if (!parseU64(q, tokEnd, stime)) return false; break;
+        case 20: if (!parseU64(q, tokEnd, threads)) return false; break;
+        case 24: if (!parseU64(q, tokEnd, rssPages)) return false; break;
+        default: break;
+        }
+        p = tokEnd;
+    }
+
+    out.cpuTicks = utime + stime;
+    out.threads = static_cast<uint32_t>(threads);
+    out.rssBytes = rssPages * pageSize;
+    return true;
+}
+
+/*
+ * ==============================================================
+ * bool readMemory(uint64_t&, uint64_t&)
+ * ==============================================================
+ * Reads total and available system memory from /proc/meminfo.
+ * Uses MemAvailable. Both keys are in the first few lines.
+ */
+bool SystemSampler::readMemory(uint64_t& memTotalBytes, uint64_t& memAvailBytes) {
+    const ssize_t n = meminfo_.read(buf_, 512);
+    if (n <= 0) return false;
+    return parseMeminfo(buf_, static_cast<size_t>(n), memTotalBytes, memAvailBytes);
+}
+
+bool SystemSampler::parseMeminfo(const char* data, size_t len,
+                                 uint64_t& memTotalBytes, uint64_t& memAvailBytes) {
+    const char* p = data;
+    const char* end = data + len;
+
+    memTotalBytes = 0;
+    memAvailBytes = 0;
+
+    while (p < end && !(memTotalBytes && memAvailBytes)) {
+        const char* lineEnd = nextLine(p, end);
+        uint64_t kb = 0;
+
+        if (hasPrefix(p, lineEnd, "MemTotal:", 9)) {
+            const char* q = p + 9;
+            if (parseU64(q, lineEnd, kb)) memTotalBytes = kb * 1024ULL;
+        } else if (hasPrefix(p, lineEnd, "MemAvailable:", 13)) {
+            const char* q = p + 13;
+            if (parseU64(q, lineEnd, kb)) memAvailBytes = kb * 1024ULL;
+        }
+        p = lineEnd;
+    }
+
+    return memTotalBytes > 0;
+}
+
+bool SystemSampler::readStorage(uint64_t& totalBytes, uint64_t& usedBytes) {
+    struct statvfs vfs;
+    if (storageFd_ >= 0) {
+        if (fstatvfs(storageFd_, &vfs) != 0) return false;
+    } else if (statvfs(storagePath_.c_str(), &vfs) != 0) {
+        return false;
+    }
+
+    const uint64_t blockSize = static_cast<uint64_t>(vfs.f_frsize);
+    const uint64_t total = static_cast<uint64_t>(vfs.f_blocks) * blockSize;
+    const uint64_t free = static_cast<uint64_t>(vfs.f_bfree) * blockSize;
+
+    totalBytes = total;
+    usedBytes = (total >= free) ? (total - free) : 0;
+    return true;
+}
+
+bool SystemSampler::readTemperature(double& tempC) {
+    // millidegrees C
+    const ssize_t n = thermal_.read(buf_, 32);
+    if (n <= 0) return false;
+    return parseMilliCelsius(buf_, static_cast<size_t>(n), tempC);
+}
+
+bool SystemSampler::parseMilliCelsius(const char* data, size_t len, double& tempC) {
+    const char* p = skipBlanks(data, data + len);
+    const char* end = data + len;
+
+    bool negative = false;
+    if (p < end && *p == '-') {
+        negative = true;
+        ++p;
+    }
+
+    uint64_t milli = 0;
+    if (!parseU64(p, end, milli)) return false;
+
+    tempC = (negative ? -1.0 : 1.0) * static_cast<double>(milli) / 1000.0;
+    return true;
+}
+
+// "0.52 0.58 0.59 1/389 12345"
+bool SystemSampler::readLoadAverage(double& load1) {
+    const ssize_t n = loadavg_.read(buf_, 128);
+    if (n <= 0) return false;
+    return parseLoadAverage(buf_, static_cast<size_t>(n), load1);
+}
+
+bool SystemSampler::parseLoadAverage(const char* data, size_t len, double& load1) {
+    const char* p = data;
+    return parseDecimal(p, data + len, load1);
+}
+
+/*
+ * Uptime comes straight from CLOCK_BOOTTIME, which is what /proc/uptime
+ * reports, without any file access.
+ */
+bool SystemSampler::readUptime(uint64_t& uptimeSeconds) {
+    struct timespec ts {};
+    if (clock_gettime(CLOCK_BOOTTIME, &ts) != 0) return false;
+    uptimeSeconds = static_cast<uint64_t>(ts.tv_sec);
+    return true;
+}
+
+/*
+ * ==============================================================
+ * Disk and network throughput
+ * ==============================================================
+ */
+
+// The device is looked up by the st_dev of ioPath, or of its closest
+// existing parent (the download directory may not exist yet).
+void SystemSampler::resolveDiskDevice() {
+    haveDisk_ = false;
+    std::string path = ioPath_;
+    struct stat st;
+
+    while (::stat(path.c_str(), &st) != 0) {
+        const size_t slash = path.find_last_of('/', path.size() > 1 ? path.size() - 2 : 0);
+        if (slash == std::string::npos || path.size() <= 1) return;
+        path.resize(slash + 1);
+    }
+
+    diskMajor_ = major(st.st_dev);
+    diskMinor_ = minor(st.st_dev);
+    // Major 0 is a virtual filesystem (tmpfs, overlay...) without diskstats
+    haveDisk_ = diskMajor_ != 0;
+}
+
+bool SystemSampler::readDefaultRoute(char* iface) {
+    iface[0] = '\0';
+    const ssize_t n = netRoute_.read(buf_, kBufferSize);
+    return n > 0 && parseDefaultRoute(buf_, static_cast<size_t>(n), iface, kInterfaceNameSize);
+}
+
+// routed: the default route's interface, empty if there is none. Without
+// one, a down interface (eth0 unplugged while Wi-Fi is still coming up)
+// is only taken if no other is up.
+void SystemSampler::selectInterface(const char* routed) {
+    netInterface_[0] = '\0';
+    linkSpeed_.close();
+    lastNet_ = NetCounters();
+    netStalls_ = 0;
+
+    if (routed[0] != '\0') {
+        std::strncpy(netInterface_, routed, kInterfaceNameSize - 1);
+    } else {
+        // First non-loopback entry of /proc/net/dev, preferring one that is up
+        const ssize_t n = netDev_.read(buf_, kBufferSize);
+        const char* end = buf_ + (n > 0 ? n : 0);
+        const char* p = (n > 0) ? nextLine(nextLine(buf_, end), end) : end;
+        for (; p < end; p = nextLine(p, end)) {
+            const char* name = skipBlanks(p, end);
+            const char* colon = static_cast<const char*>(std::memchr(name, ':', static_cast<size_t>(end - name)));
+            if (!colon) break;
+            const size_t len = static_cast<size_t>(colon - name);
+            if (len == 0 || len >= kInterfaceNameSize || (len == 2 && std::memcmp(name, "lo", 2) == 0)) continue;
+
+            char candidate[kInterfaceNameSize];
+            std::memcpy(candidate, name, len);
+            candidate[len] = '\0';
+            if (netInterface_[0] == '\0') std::memcpy(netInterface_, candidate, len + 1);
+
+            ProcFile operstate;
+            char state[16];
+            const std::string statePath = std::string("/sys/class/net/") + candidate + "/operstate";
+            if (operstate.open(statePath.c_str()) && operstate.read(state, sizeof(state)) >= 2 &&
+                std::memcmp(state, "up", 2) == 0) {
+                std::memcpy(netInterface_, candidate, len + 1);
+                break;
+            }
+        }
+    }
+
+    if (netInterface_[0] != '\0') {
+        const std::string speedPath = std::string("/sys/class/net/") + netInterface_ + "/speed";
+        linkSpeed_.open(speedPath.c_str());
+    }
+}
+
+/*
+ * ==============================================================
+ * bool readDisk(DiskCounters&)
+ * ==============================================================
+ * Counters of the partition holding ioPath. Sectors in diskstats are
+ * always 512 bytes, whatever the device's block size.
+ */
+bool SystemSampler::readDisk(DiskCounters& out) {
+    if (!haveDisk_) return false;
+    const ssize_t n = diskstats_.read(buf_, kBufferSize);
+    if (n <= 0) return false;
+    return parseDiskstats(buf_, static_cast<size_t>(n), diskMajor_, diskMinor_, out);
+}
+
+bool SystemSampler::parseDiskstats(const char* data, size_t len, unsigned major, unsigned minor,
+                                   DiskCounters& out) {
+    const char* p = data;
+    const char* end = data + len;
+
+    for (; p < end; p = nextLine(p, end)) {
+        const char* lineEnd = nextLine(p, end);
+        const char* q = p;
+        uint64_t maj = 0, min = 0;
+        if (!parseU64(q, lineEnd, maj) || !parseU64(q, lineEnd, min)) continue;
+        if (maj != major || min != minor) continue;
+
+        // device name, then: reads merged sectorsRead msRead writes merged sectorsWritten
+        // msWrite inFlight ioTicks
+        q = skipBlanks(q, lineEnd);
+        while (q < lineEnd && *q != ' ') ++q;
+
+        uint64_t v[10] = {};
+        int count = 0;
+        while (count < 10 && parseU64(q, lineEnd, v[count])) ++count;
+        if (count < 10) return false;
+
+        out.readBytes = v[2] * 512ULL;
+        out.writeBytes = v[6] * 512ULL;
+        out.ios = v[0] + v[4];
+        out.busyMs = v[9];
+        return true;
+    }
+    return false;
+}
+
+/*
+ * ==============================================================
+ * bool readNet(NetCounters&)
+ * ==============================================================
+ * Byte counters of the selected interface and its negotiated link speed,
+ * which can change when the link renegotiates. The interface is picked
+ * again when the default route appears or moves (DHCP, Wi-Fi up after
+ * boot), or, without a route, when its counters stop for kNetStallReads
+ * reads. The first read after a new pick is its baseline.
+ */
+bool SystemSampler::readNet(NetCounters& out) {
+    char routed[kInterfaceNameSize] = {};
+    readDefaultRoute(routed);
+    const bool moved = routed[0] != '\0' && std::strcmp(routed, netInterface_) != 0;
+    const bool lost = routed[0] == '\0' && (netInterface_[0] == '\0' || netStalls_ >= kNetStallReads);
+    if (moved || lost) selectInterface(routed);
+
+    if (netInterface_[0] == '\0') return false;
+    const ssize_t n = netDev_.read(buf_, kBufferSize);
+    if (n <= 0) return false;
+    if (!parseNetDev(buf_, static_cast<size_t>(n), netInterface_, out)) return false;
+
+    if (out.rxBytes == lastNet_.rxBytes && out.txBytes == lastNet_.txBytes) {
+        ++netStalls_;
+    } else {
+        netStalls_ = 0;
+    }
+    lastNet_ = out;
+
+    out.linkMbps = -1;
+    const ssize_t s = linkSpeed_.read(buf_, 32);
+    if (s > 0) {
+        const char* q = buf_;
+        uint64_t mbps = 0;
+        if (parseU64(q, buf_ + s, mbps) && mbps > 0) out.linkMbps = static_cast<int>(mbps);
+    }
+    return true;
+}
+
+bool SystemSampler::parseNetDev(const char* data, size_t len, const char* iface, NetCounters& out) {
+    const char* p = data;
+    const char* end = data + len;
+    const size_t ifaceLen = std::strlen(iface);
+
+    for (; p < end; p = nextLine(p, end)) {
+        const char* lineEnd = nextLine(p, end);
+        const char* name = skipBlanks(p, lineEnd);
+        if (!hasPrefix(name, lineEnd, iface, ifaceLen) || name + ifaceLen >= lineEnd ||
+            name[ifaceLen] != ':') {
+            continue;
+        }
+
+        // rx: bytes packets errs drop fifo frame compressed multicast, then tx: bytes ...
+        const char* q = name + ifaceLen + 1;
+        uint64_t v[9] = {};
+        int count = 0;
+        while (count < 9 && parseU64(q, lineEnd, v[count])) ++count;
+        if (count < 9) return false;
+
+        out.rxBytes = v[0];
+        out.txBytes = v[8];
+        return true;
+    }
+    return false;
+}
+
+// /proc/net/route: "Iface Destination Gateway ...", destination in hex
+bool SystemSampler::parseDefaultRoute(const char* data, size_t len, char* iface, size_t cap) {
+    const char* p = data;
+    const char* end = data + len;
+
+    for (p = nextLine(p, end); p < end; p = nextLine(p, end)) {
+        const char* lineEnd = nextLine(p, end);
+        const char* name = skipBlanks(p, lineEnd);
+        const char* q = name;
+        while (q < lineEnd && *q != '\t' && *q != ' ') ++q;
+        const size_t nameLen = static_cast<size_t>(q - name);
+
+        q = skipBlanks(q, lineEnd);
+        if (hasPrefix(q, lineEnd, "00000000", 8) && nameLen > 0 && nameLen < cap) {
+            std::memcpy(iface, name, nameLen);
+            iface[nameLen] = '\0';
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * ==============================================================
+ * Pressure stall information
+ * ==============================================================
+ * "some avg10=1.23 avg60=... total=...\nfull avg10=..."
+ * Only the 10 s averages are used: they react fast enough to throttle a
+ * transfer and are already smoothed by the kernel.
+ */
+bool SystemSampler::readMemoryPressure(Pressure& out) {
+    const ssize_t n = memoryPressure_.read(buf_, 256);
+    if (n <= 0) return false;
+    return parsePressure(buf_, static_cast<size_t>(n), out);
+}
+
+bool SystemSampler::readIoPressure(Pressure& out) {
+    const ssize_t n = ioPressure_.read(buf_, 256);
+    if (n <= 0) return false;
+    return parsePressure(buf_, static_cast<size_t>(n), out);
+}
+
+bool SystemSampler::parsePressure(const char* data, size_t len, Pressure& out) {
+    const char* p = data;
+    const char* end = data + len;
+    bool haveSome = false;
+
+    out = Pressure();
+    for (; p < end; p = nextLine(p, end)) {
+        const char* lineEnd = nextLine(p, end);
+        double* target = nullptr;
+        if (hasPrefix(p, lineEnd, "some avg10=", 11)) {
+            target = &out.someAvg10;
+            haveSome = true;
+        } else if (hasPrefix(p, lineEnd, "full avg10=", 11)) {
+            target = &out.fullAvg10;
+        }
+        if (!target) continue;
+
+        const char* q = p + 11;
+        if (!parseDecimal(q, lineEnd, *target)) return false;
+    }
+    return haveSome;
+}
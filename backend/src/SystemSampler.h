@@ -0,0 +1,171 @@
+#ifndef SYSTEMSAMPLER_H
+#define SYSTEMSAMPLER_H
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * ==============================================================
+ * ProcFile
+ * ==============================================================
+ * A /proc or /sys file kept open for the lifetime of the sampler.
+ * read() re-generates the content with pread() at offset 0, so a tick
+ * costs one syscall and no open/close, stdio buffering or allocation.
+ */
+class ProcFile {
+   public:
+    ProcFile() = default;
+    ~ProcFile();
+
+    ProcFile(const ProcFile&) = delete;
+    ProcFile& operator=(const ProcFile&) = delete;
+
+    bool open(const char* path);
+    void close();
+    bool isOpen() const { return fd_ >= 0; }
+    int fd() const { return fd_; }
+
+    // Returns the number of bytes read (buffer is NUL terminated), -1 on error
+    ssize_t read(char* buf, size_t cap) const;
+
+   private:
+    int fd_ = -1;
+};
+
+/*
+ * ==============================================================
+ * SystemSampler
+ * ==============================================================
+ * Reads the system metrics shown on the dashboard.
+ * All descriptors are opened once by open(); every read*() call then
+ * uses a fixed internal buffer and a hand-written parser.
+ */
+class SystemSampler {
+   public:
+    static constexpr const char* kDefaultThermalPath = "/sys/class/thermal/thermal_zone0/temp";
+    static constexpr int kMaxCores = 16;
+
+    /*
+     * Cumulative /proc/stat counters (clock ticks) as parallel arrays.
+     * Row 0 is the aggregate "cpu" line, rows 1..coreCount the "cpuN" lines.
+     * Deltas between two samples are computed with one linear pass.
+     */
+    struct CpuCounters {
+        int coreCount = 0;
+        uint64_t total[kMaxCores + 1] = {};
+        uint64_t idle[kMaxCores + 1] = {};     // idle + iowait
+        uint64_t iowait[kMaxCores + 1] = {};
+    };
+
+    // This process, from /proc/self/stat
+    struct ProcessCounters {
+        uint64_t cpuTicks = 0;   // utime + stime
+        uint64_t rssBytes = 0;
+        uint32_t threads = 0;
+    };
+
+    // Cumulative /proc/diskstats counters of one block device
+    struct DiskCounters {
+        uint64_t readBytes = 0;
+        uint64_t writeBytes = 0;
+        uint64_t ios = 0;        // completed reads + writes
+        uint64_t busyMs = 0;     // time with I/O in flight (io_ticks)
+    };
+
+    // Cumulative /proc/net/dev counters of one interface
+    struct NetCounters {
+        uint64_t rxBytes = 0;
+        uint64_t txBytes = 0;
+        int linkMbps = -1;       // /sys/class/net/<if>/speed, -1 if unknown (e.g. Wi-Fi)
+    };
+
+    // Pressure stall information (/proc/pressure/*), share of wall time in %
+    struct Pressure {
+        double someAvg10 = 0.0;  // at least one task stalled
+        double fullAvg10 = 0.0;  // all non-idle tasks stalled
+    };
+
+    // ioPath selects the block device for readDisk() (the one it lives on)
+    explicit SystemSampler(const std::string& storagePath = "/",
+                           const std::string& thermalPath = kDefaultThermalPath,
+                           const std::string& ioPath = "/");
+    ~SystemSampler();
+
+    SystemSampler(const SystemSampler&) = delete;
+    SystemSampler& operator=(const SystemSampler&) = delete;
+
+    // Opens every source that exists; missing ones make their read*() fail
+    bool open();
+    void close();
+
+    bool readCpu(uint64_t& idle, uint64_t& total);
+    bool readCpuCounters(CpuCounters& out);
+    bool readSelf(ProcessCounters& out);
+    bool readMemory(uint64_t& memTotalBytes, uint64_t& memAvailBytes);
+    bool readStorage(uint64_t& totalBytes, uint64_t& usedBytes);
+    bool readTemperature(double& tempC);
+    bool readUptime(uint64_t& uptimeSeconds);
+    // 1-minute load average (runnable + uninterruptible tasks)
+    bool readLoadAverage(double& load1);
+    bool readDisk(DiskCounters& out);
+    bool readNet(NetCounters& out);
+    // Fail on kernels without CONFIG_PSI (or booted with psi=0)
+    bool readMemoryPressure(Pressure& out);
+    bool readIoPressure(Pressure& out);
+
+    // Interface read by readNet(): the default route's, else the first
+    // non-loopback one that is up. Selected again when the route changes.
+    const char* netInterface() const { return netInterface_; }
+
+    // Parsers (public for the benchmark)
+    static bool parseCpuLine(const char* data, size_t len, uint64_t& idle, uint64_t& total);
+    static bool parseCpuCounters(const char* data, size_t len, CpuCounters& out);
+    static bool parseSelfStat(const char* data, size_t len, uint64_t pageSize, ProcessCounters& out);
+    static bool parseMeminfo(const char* data, size_t len, uint64_t& memTotalBytes, uint64_t& memAvailBytes);
+    static bool parseMilliCelsius(const char* data, size_t len, double& tempC);
+    static bool parseDiskstats(const char* data, size_t len, unsigned major, unsigned minor, DiskCounters& out);
+    static bool parseNetDev(const char* data, size_t len, const char* iface, NetCounters& out);
+    static bool parseDefaultRoute(const char* data, size_t len, char* iface, size_t cap);
+    static bool parsePressure(const char* data, size_t len, Pressure& out);
+    static bool parseLoadAverage(const char* data, size_t len, double& load1);
+
+   private:
+    static constexpr size_t kBufferSize = 16384;
+    static constexpr size_t kInterfaceNameSize = 16;   // IFNAMSIZ
+    static constexpr unsigned kNetStallReads = 3;       // unchanged counters before a new pick
+
+    void resolveDiskDevice();
+    bool readDefaultRoute(char* iface);
+    void selectInterface(const char* routed);
+
+    std::string storagePath_;
+    std::string thermalPath_;
+    std::string ioPath_;
+
+    ProcFile stat_;
+    ProcFile meminfo_;
+    ProcFile thermal_;
+    ProcFile selfStat_;
+    ProcFile diskstats_;
+    ProcFile netDev_;
+    ProcFile netRoute_;
+    ProcFile linkSpeed_;
+    ProcFile memoryPressure_;
+    ProcFile ioPressure_;
+    ProcFile loadavg_;
+    int storageFd_ = -1;
+    unsigned diskMajor_ = 0;
+    unsigned diskMinor_ = 0;
+    bool haveDisk_ = false;
+    char netInterface_[kInterfaceNameSize] = {};
+    NetCounters lastNet_;
+    unsigned netStalls_ = 0;
+    uint64_t pageSize_ = 4096;
+
+    char buf_[kBufferSize];
+};
+
+#endif  // SYSTEMSAMPLER_H
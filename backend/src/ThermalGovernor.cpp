@@ -0,0 +1,65 @@
+#include "ThermalGovernor.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+
+static const double kTrendSmoothing = 0.3;   // EWMA weight of the newest slope
+static const double kCutFactor = 0.7;
+static const double kGrowFactor = 1.25;
+
+ThermalGovernor::Config ThermalGovernor::configFromEnv() {
+    Config c;
+    if (const char* v = std::getenv("OTA_THERMAL_CEILING")) c.ceilingC = std::strtod(v, nullptr);
+    if (const char* v = std::getenv("OTA_THERMAL_HORIZON")) c.horizonSec = std::strtod(v, nullptr);
+
+    const unsigned cpus = std::thread::hardware_concurrency();
+    c.maxWorkers = std::max(1u, std::min(cpus ? cpus : 1u, 4u));
+    return c;
+}
+
+ThermalGovernor::ThermalGovernor()
+    : ThermalGovernor(Config()) {}
+
+ThermalGovernor::ThermalGovernor(const Config& config)
+    : config_(config), workerLimit_(config.maxWorkers) {}
+
+/*
+ * ==============================================================
+ * bool update(double nowSec, double tempC, double currentRateBps)
+ * ==============================================================
+ * One control step per temperature reading.
+ */
+bool ThermalGovernor::update(double nowSec, double tempC, double currentRateBps) {
+    if (haveLast_ && nowSec > lastSec_) {
+        const double slope = (tempC - lastC_) / (nowSec - lastSec_);
+        trendCPerSec_ = kTrendSmoothing * slope + (1.0 - kTrendSmoothing) * trendCPerSec_;
+    }
+    haveLast_ = true;
+    lastSec_ = nowSec;
+    lastC_ = tempC;
+
+    // Only a rising trend is extrapolated; cooling is taken as it is now
+    predictedC_ = tempC + std::max(0.0, trendCPerSec_) * config_.horizonSec;
+
+    const uint64_t oldRate = rateLimitBps_;
+    const unsigned oldWorkers = workerLimit_;
+
+    if (predictedC_ >= config_.ceilingC) {
+        const double base = rateLimitBps_ ? static_cast<double>(rateLimitBps_) : currentRateBps;
+        if (base > 0.0) {
+            rateLimitBps_ = std::max(config_.minRateBps, static_cast<uint64_t>(base * kCutFactor));
+        }
+        workerLimit_ = std::max(1u, workerLimit_ - 1);
+    } else if (predictedC_ < config_.ceilingC - config_.hysteresisC) {
+        if (rateLimitBps_) {
+            const double grown = static_cast<double>(rateLimitBps_) * kGrowFactor;
+            // Lifted once it no longer holds the measured rate back
+            rateLimitBps_ = (currentRateBps > 0.0 && grown > 2.0 * currentRateBps)
+                ? 0 : static_cast<uint64_t>(grown);
+        }
+        workerLimit_ = std::min(config_.maxWorkers, workerLimit_ + 1);
+    }
+
+    return rateLimitBps_ != oldRate || workerLimit_ != oldWorkers;
+}
@@ -0,0 +1,59 @@
+#ifndef THERMALGOVERNOR_H
+#define THERMALGOVERNOR_H
+
+#include <cstdint>
+
+/*
+ * ==============================================================
+ * ThermalGovernor
+ * ==============================================================
+ * Keeps the SoC under a temperature ceiling set below the firmware
+ * throttle point (80 C on a Pi 4), trading a slightly lower steady rate
+ * for not being clocked down mid-transfer.
+ * - The trend is a smoothed slope of successive readings (C/min).
+ * - When the temperature extrapolated over the horizon reaches the
+ *   ceiling, the transfer rate is cut to 70% and one hashing worker is
+ *   removed; once the prediction is a hysteresis below it, both grow
+ *   back step by step.
+ * Pure logic: time and temperature are passed in, so it can be driven by
+ * a fake thermal zone or a simulation.
+ */
+class ThermalGovernor {
+   public:
+    struct Config {
+        double ceilingC = 75.0;
+        double hysteresisC = 5.0;
+        double horizonSec = 30.0;
+        unsigned maxWorkers = 4;
+        uint64_t minRateBps = 256 * 1024;
+    };
+
+    // OTA_THERMAL_CEILING (C), OTA_THERMAL_HORIZON (s); workers from the CPU count
+    static Config configFromEnv();
+
+    ThermalGovernor();
+    explicit ThermalGovernor(const Config& config);
+
+    // Feeds one reading; currentRateBps is the throughput measured now,
+    // used as the base of the first cap. Returns true if a limit changed.
+    bool update(double nowSec, double tempC, double currentRateBps);
+
+    uint64_t rateLimitBps() const { return rateLimitBps_; }   // 0: unlimited
+    unsigned workerLimit() const { return workerLimit_; }
+    double trendCPerMin() const { return trendCPerSec_ * 60.0; }
+    double predictedC() const { return predictedC_; }
+    bool isLimiting() const { return rateLimitBps_ != 0 || workerLimit_ < config_.maxWorkers; }
+    const Config& config() const { return config_; }
+
+   private:
+    Config config_;
+    bool haveLast_ = false;
+    double lastSec_ = 0.0;
+    double lastC_ = 0.0;
+    double trendCPerSec_ = 0.0;
+    double predictedC_ = 0.0;
+    uint64_t rateLimitBps_ = 0;
+    unsigned workerLimit_;
+};
+
+#endif  // THERMALGOVERNOR_H
@@ -0,0 +1,32 @@
+#include "ThreadPriority.h"
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// linux/ioprio.h, not exported by glibc
+const int kIoprioWhoProcess = 1;
+const int kIoprioClassShift = 13;
+const int kIoprioClassBestEffort = 2;
+
+int ioprioValue(int cls, int level) {
+    return (cls << kIoprioClassShift) | level;
+}
+
+}  // namespace
+
+namespace threadpriority {
+
+bool setCurrentThreadBackground(bool background) {
+    const pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+
+    // On Linux both calls act on a single thread when given its tid
+    const bool niceOk = setpriority(PRIO_PROCESS, static_cast<id_t>(tid), background ? 10 : 0) == 0;
+    const bool ioOk = syscall(SYS_ioprio_set, kIoprioWhoProcess, tid,
+                              ioprioValue(kIoprioClassBestEffort, background ? 7 : 4)) == 0;
+    return niceOk && ioOk;
+}
+
+}  // namespace threadpriority
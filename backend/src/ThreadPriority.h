@@ -0,0 +1,16 @@
+#ifndef THREADPRIORITY_H
+#define THREADPRIORITY_H
+
+/*
+ * Scheduling class of the calling thread for background transfers:
+ * nice 10 and best-effort I/O priority 7 (lowest), or back to nice 0 and
+ * best-effort 4. Going back up needs CAP_SYS_NICE (or RLIMIT_NICE);
+ * without it the thread stays low and false is returned.
+ */
+namespace threadpriority {
+
+bool setCurrentThreadBackground(bool background);
+
+}  // namespace threadpriority
+
+#endif  // THREADPRIORITY_H
@@ -0,0 +1,53 @@
+#include "TokenBucket.h"
+
+#include <algorithm>
+#include <chrono>
+
+TokenBucket::TokenBucket(uint64_t rateBps, uint64_t burstBytes) {
+    configure(rateBps, burstBytes);
+}
+
+uint64_t TokenBucket::nowNs() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void TokenBucket::configure(uint64_t rateBps, uint64_t burstBytes) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    const bool wasUnlimited = rate_ == 0;
+    rate_ = rateBps;
+    burst_ = std::max<uint64_t>(burstBytes, 1);
+    // Coming from unlimited the bucket starts empty: whatever is already in
+    // flight is the burst
+    tokens_ = wasUnlimited ? 0.0 : std::min(tokens_, static_cast<double>(burst_));
+    lastNs_ = 0;
+}
+
+uint64_t TokenBucket::rate() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return rate_;
+}
+
+uint64_t TokenBucket::burst() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return burst_;
+}
+
+void TokenBucket::refill(uint64_t nowNs) {
+    if (lastNs_ != 0 && nowNs > lastNs_) {
+        tokens_ += static_cast<double>(rate_) * static_cast<double>(nowNs - lastNs_) / 1e9;
+        tokens_ = std::min(tokens_, static_cast<double>(burst_));
+    }
+    lastNs_ = std::max(lastNs_, nowNs);
+}
+
+uint64_t TokenBucket::reserve(uint64_t bytes, uint64_t nowNs) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    if (rate_ == 0) return 0;
+
+    refill(nowNs);
+    tokens_ -= static_cast<double>(bytes);
+    if (tokens_ >= 0.0) return 0;
+    return static_cast<uint64_t>(-tokens_ * 1e9 / static_cast<double>(rate_));
+}
@@ -0,0 +1,42 @@
+#ifndef TOKENBUCKET_H
+#define TOKENBUCKET_H
+
+#include <cstdint>
+#include <mutex>
+
+/*
+ * ==============================================================
+ * TokenBucket
+ * ==============================================================
+ * Byte rate limiter. Tokens accrue at `rate` bytes/s up to `burst`;
+ * reserve() always takes the tokens (the bucket may go into debt) and
+ * returns how long the caller has to wait before sending, so one call
+ * per chunk is enough. A rate of 0 disables limiting.
+ * Time is passed in, which lets benchmarks run it on a simulated clock.
+ */
+class TokenBucket {
+   public:
+    explicit TokenBucket(uint64_t rateBps = 0, uint64_t burstBytes = 0);
+
+    // Keeps the current fill (capped to the new burst) so a change
+    // mid-transfer takes effect without a spike
+    void configure(uint64_t rateBps, uint64_t burstBytes);
+    uint64_t rate() const;
+    uint64_t burst() const;
+
+    // Nanoseconds to wait before `bytes` may go out
+    uint64_t reserve(uint64_t bytes, uint64_t nowNs);
+
+    static uint64_t nowNs();
+
+   private:
+    void refill(uint64_t nowNs);
+
+    mutable std::mutex mutex_;
+    uint64_t rate_ = 0;
+    uint64_t burst_ = 0;
+    double tokens_ = 0.0;
+    uint64_t lastNs_ = 0;
+};
+
+#endif  // TOKENBUCKET_H
@@ -0,0 +1,121 @@
+#include "UpdateCheckCache.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#include "Crc32.h"
+#include "OtaLog.h"
+
+namespace {
+
+const uint32_t kMagic = 0x55434331;   // "UCC1"
+
+// On-disk layout, fixed width; crc covers everything before it
+struct Record {
+    uint32_t magic;
+    uint32_t currentVersion;
+    uint64_t fetchedMs;
+    uint64_t size;
+    uint32_t newVersion;
+    uint32_t crc;
+    int32_t resultCode;
+    uint8_t exists;
+    uint8_t isNew;
+    uint8_t reserved[2];
+    uint32_t recordCrc;
+};
+
+uint32_t recordCrc(const Record& r) {
+    return crc32::update(0, reinterpret_cast<const uint8_t*>(&r), offsetof(Record, recordCrc));
+}
+
+}  // namespace
+
+UpdateCheckCache::UpdateCheckCache(const std::string& path)
+    : path_(path) {}
+
+uint64_t UpdateCheckCache::nowMs() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+bool UpdateCheckCache::load(Entry& out) const {
+    const int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    Record r;
+    const ssize_t n = ::read(fd, &r, sizeof(r));
+    ::close(fd);
+    if (n != static_cast<ssize_t>(sizeof(r)) || r.magic != kMagic || r.recordCrc != recordCrc(r)) {
+        OTA_LOG_WARN("CheckCache", "Ignoring invalid cache file {}", path_);
+        return false;
+    }
+
+    out.currentVersion = r.currentVersion;
+    out.fetchedMs = r.fetchedMs;
+    out.exists = r.exists != 0;
+    out.isNew = r.isNew != 0;
+    out.newVersion = r.newVersion;
+    out.size = r.size;
+    out.crc = r.crc;
+    out.resultCode = r.resultCode;
+    return true;
+}
+
+/*
+ * ==============================================================
+ * bool store(const Entry& entry)
+ * ==============================================================
+ * Write, fsync, rename: a crash leaves either the old or the new record.
+ */
+bool UpdateCheckCache::store(const Entry& entry) const {
+    Record r;
+    std::memset(&r, 0, sizeof(r));
+    r.magic = kMagic;
+    r.currentVersion = entry.currentVersion;
+    r.fetchedMs = entry.fetchedMs;
+    r.size = entry.size;
+    r.newVersion = entry.newVersion;
+    r.crc = entry.crc;
+    r.resultCode = entry.resultCode;
+    r.exists = entry.exists ? 1 : 0;
+    r.isNew = entry.isNew ? 1 : 0;
+    r.recordCrc = recordCrc(r);
+
+    const std::string tmp = path_ + ".tmp";
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        OTA_LOG_WARN("CheckCache", "Cannot write {}: {}", tmp, std::strerror(errno));
+        return false;
+    }
+
+    const bool ok = ::write(fd, &r, sizeof(r)) == static_cast<ssize_t>(sizeof(r)) && fdatasync(fd) == 0;
+    ::close(fd);
+    if (!ok || std::rename(tmp.c_str(), path_.c_str()) != 0) {
+        OTA_LOG_WARN("CheckCache", "Failed to store {}", path_);
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+void UpdateCheckCache::clear() const {
+    ::unlink(path_.c_str());
+}
+
+bool UpdateCheckCache::lookup(uint32_t currentVersion, uint64_t nowMs, uint64_t ttlSec, Entry& out) const {
+    Entry e;
+    if (!load(e)) return false;
+    if (e.currentVersion != currentVersion) return false;
+    if (nowMs < e.fetchedMs || nowMs - e.fetchedMs > ttlSec * 1000) return false;
+
+    out = e;
+    return true;
+}
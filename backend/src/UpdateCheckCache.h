@@ -0,0 +1,48 @@
+#ifndef UPDATECHECKCACHE_H
+#define UPDATECHECKCACHE_H
+
+#include <cstdint>
+#include <string>
+
+/*
+ * ==============================================================
+ * UpdateCheckCache
+ * ==============================================================
+ * The last successful requestUpdate() answer, kept on disk so it can be
+ * shown before the service is reachable and reused instead of asking
+ * again within its TTL.
+ * - One small record, written to a temporary file and renamed over the
+ *   old one; a CRC over the record rejects anything torn or foreign.
+ * - An entry only applies to the client version it was asked for.
+ * - Age is wall clock based. A clock that went backwards (no RTC on a Pi
+ *   until NTP has run) makes the entry stale rather than young.
+ */
+class UpdateCheckCache {
+   public:
+    struct Entry {
+        uint32_t currentVersion = 0;   // version the question was asked for
+        uint64_t fetchedMs = 0;        // wall clock
+        bool exists = false;
+        bool isNew = false;
+        uint32_t newVersion = 0;
+        uint64_t size = 0;
+        uint32_t crc = 0;
+        int32_t resultCode = 0;
+    };
+
+    explicit UpdateCheckCache(const std::string& path);
+
+    bool load(Entry& out) const;
+    bool store(const Entry& entry) const;
+    void clear() const;
+
+    // Entry for currentVersion no older than ttlSec
+    bool lookup(uint32_t currentVersion, uint64_t nowMs, uint64_t ttlSec, Entry& out) const;
+
+    static uint64_t nowMs();
+
+   private:
+    std::string path_;
+};
+
+#endif  // UPDATECHECKCACHE_H
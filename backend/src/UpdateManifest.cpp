@@ -0,0 +1,103 @@
+#include "UpdateManifest.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static const char kHeader[] = "OTA-MANIFEST 1";
+static const size_t kMaxArtifacts = 64;
+
+uint64_t UpdateManifest::totalSize() const {
+    uint64_t total = 0;
+    for (const Artifact& a : artifacts) total += a.size;
+    return total;
+}
+
+bool UpdateManifest::isSafeName(const std::string& name) {
+    if (name.empty() || name.size() > 128 || name[0] == '.') return false;
+    for (char c : name) {
+        const bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                        c == '.' || c == '_' || c == '-';
+        if (!ok) return false;
+    }
+    return true;
+}
+
+/*
+ * ==============================================================
+ * bool parse(const char* data, size_t len, UpdateManifest& out, std::string& error)
+ * ==============================================================
+ * Line based; blank lines and '#' comments are skipped. Duplicate names
+ * are rejected, they would overwrite each other on disk.
+ */
+bool UpdateManifest::parse(const char* data, size_t len, UpdateManifest& out, std::string& error) {
+    out.artifacts.clear();
+    const std::string text(data, len);
+    size_t pos = 0;
+    int lineNo = 0;
+    bool haveHeader = false;
+
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string::npos) end = text.size();
+        std::string line = text.substr(pos, end - pos);
+        pos = end + 1;
+        ++lineNo;
+
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        const size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos || line[first] == '#') continue;
+
+        if (!haveHeader) {
+            if (line != kHeader) {
+                error = "missing OTA-MANIFEST 1 header";
+                return false;
+            }
+            haveHeader = true;
+            continue;
+        }
+
+        char name[129] = {};
+        char size[32] = {};
+        char digest[32] = {};
+        char extra = 0;
+        if (std::sscanf(line.c_str(), "%128s %31s %31s %c", name, size, digest, &extra) != 3) {
+            error = "line " + std::to_string(lineNo) + ": expected <name> <size> crc32:<hex>";
+            out.artifacts.clear();
+            return false;
+        }
+
+        Artifact a;
+        a.name = name;
+        char* sizeEnd = nullptr;
+        a.size = std::strtoull(size, &sizeEnd, 10);
+        char* crcEnd = nullptr;
+        const bool digestOk = std::strncmp(digest, "crc32:", 6) == 0 && std::strlen(digest) == 14;
+        if (digestOk) a.crc = static_cast<uint32_t>(std::strtoul(digest + 6, &crcEnd, 16));
+
+        if (!isSafeName(a.name) || *sizeEnd != '\0' || size[0] == '-' || !digestOk || *crcEnd != '\0') {
+            error = "line " + std::to_string(lineNo) + ": invalid artifact";
+            out.artifacts.clear();
+            return false;
+        }
+        for (const Artifact& other : out.artifacts) {
+            if (other.name == a.name) {
+                error = "line " + std::to_string(lineNo) + ": duplicate artifact " + a.name;
+                out.artifacts.clear();
+                return false;
+            }
+        }
+        if (out.artifacts.size() == kMaxArtifacts) {
+            error = "too many artifacts";
+            out.artifacts.clear();
+            return false;
+        }
+        out.artifacts.push_back(a);
+    }
+
+    if (!haveHeader || out.artifacts.empty()) {
+        error = haveHeader ? "no artifacts" : "missing OTA-MANIFEST 1 header";
+        return false;
+    }
+    return true;
+}
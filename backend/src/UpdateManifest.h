@@ -0,0 +1,41 @@
+#ifndef UPDATEMANIFEST_H
+#define UPDATEMANIFEST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * ==============================================================
+ * UpdateManifest
+ * ==============================================================
+ * Artifact list of an update bundle, served as a plain text file next
+ * to the image:
+ *
+ *   OTA-MANIFEST 1
+ *   # name          size        digest
+ *   rootfs.ext4     268435456   crc32:1a2b3c4d
+ *   boot.tar        1048576     crc32:00c0ffee
+ *
+ * Names are plain file names (letters, digits, '.', '_', '-'), stored
+ * under the client data directory. CRC-32 is the only digest, as it is
+ * what the service announces for single images.
+ */
+struct UpdateManifest {
+    struct Artifact {
+        std::string name;
+        uint64_t size = 0;
+        uint32_t crc = 0;
+    };
+
+    std::vector<Artifact> artifacts;
+
+    uint64_t totalSize() const;
+
+    // False with a reason on a malformed manifest; artifacts is empty then
+    static bool parse(const char* data, size_t len, UpdateManifest& out, std::string& error);
+    static bool isSafeName(const std::string& name);
+};
+
+#endif  // UPDATEMANIFEST_H
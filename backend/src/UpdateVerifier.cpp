@@ -0,0 +1,105 @@
+#include "UpdateVerifier.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "Crc32.h"
+#include "OtaLog.h"
+#include "ThreadPriority.h"
+
+static const size_t kBlockSize = 1024 * 1024;
+
+/*
+ * ==============================================================
+ * bool computeCrc(...)
+ * ==============================================================
+ * Blocks are claimed from a shared counter, so workers finish together
+ * whatever their number. Each block's CRC is stored by index and the
+ * results are joined with crc32::combine().
+ */
+bool UpdateVerifier::computeCrc(const std::string& path, unsigned maxWorkers,
+                                const WorkerLimit& allowedWorkers, uint32_t& crcOut,
+                                const std::atomic<bool>* cancel,
+                                const std::atomic<bool>* background) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        OTA_LOG_ERROR("Verifier", "Cannot open {} for verification", path);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    const uint64_t size = static_cast<uint64_t>(st.st_size);
+    const size_t blocks = static_cast<size_t>((size + kBlockSize - 1) / kBlockSize);
+    std::vector<uint32_t> blockCrc(blocks, 0);
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    auto worker = [&](unsigned id) {
+        std::vector<uint8_t> buf(kBlockSize);
+        bool lowPriority = false;
+        for (;;) {
+            // Worker 0 is the calling thread, whose priority is its owner's business
+            if (id != 0 && background && background->load() != lowPriority) {
+                lowPriority = !lowPriority;
+                threadpriority::setCurrentThreadBackground(lowPriority);
+            }
+
+            // Park while this worker is above the current limit
+            while (allowedWorkers && id >= std::max(1u, allowedWorkers()) && !failed) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+
+            if (cancel && cancel->load()) failed = true;
+
+            const size_t b = next.fetch_add(1);
+            if (b >= blocks || failed) return;
+
+            const off_t offset = static_cast<off_t>(b) * static_cast<off_t>(kBlockSize);
+            const size_t len = static_cast<size_t>(std::min<uint64_t>(kBlockSize, size - offset));
+            size_t got = 0;
+            while (got < len) {
+                const ssize_t n = ::pread(fd, buf.data() + got, len - got, offset + static_cast<off_t>(got));
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) {
+                    failed = true;
+                    return;
+                }
+                got += static_cast<size_t>(n);
+            }
+            blockCrc[b] = crc32::update(0, buf.data(), len);
+        }
+    };
+
+    const unsigned workers = std::max(1u, std::min<unsigned>(maxWorkers, static_cast<unsigned>(std::max<size_t>(blocks, 1))));
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < workers; ++i) pool.emplace_back(worker, i);
+    worker(0);
+    for (auto& t : pool) t.join();
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+    if (failed) return false;
+
+    uint32_t crc = 0;
+    for (size_t b = 0; b < blocks; ++b) {
+        const uint64_t len = std::min<uint64_t>(kBlockSize, size - static_cast<uint64_t>(b) * kBlockSize);
+        crc = crc32::combine(crc, blockCrc[b], len);
+    }
+    crcOut = crc;
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef UPDATEVERIFIER_H
+#define UPDATEVERIFIER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/*
+ * ==============================================================
+ * UpdateVerifier
+ * ==============================================================
+ * CRC-32 of a downloaded image, hashed in 1 MiB blocks by a pool of
+ * worker threads and combined in order.
+ * The number of workers allowed to run can be lowered while hashing
+ * (thermal governor): workers above the limit park between blocks.
+ * While `background` is set the pool threads run at background priority
+ * (ThreadPriority.h); the flag is checked per block. The calling thread
+ * also hashes and keeps whatever priority it has.
+ */
+class UpdateVerifier {
+   public:
+    using WorkerLimit = std::function<unsigned()>;
+
+    // Returns false if the file cannot be read or cancel was set;
+    // crcOut holds the CRC otherwise
+    static bool computeCrc(const std::string& path, unsigned maxWorkers,
+                           const WorkerLimit& allowedWorkers, uint32_t& crcOut,
+                           const std::atomic<bool>* cancel = nullptr,
+                           const std::atomic<bool>* background = nullptr);
+};
+
+#endif  // UPDATEVERIFIER_H
@@ -1,4 +1,5 @@
 import QtQuick
+import qnxOta
 
 Rectangle {
     id: cardChecking
@@ -30,7 +31,8 @@ Rectangle {
                     from: 0
                     to: 360
                     duration: 1500
-                    running: true
+                    // Hidden (a cached card) or low power: no frames for it
+                    running: refreshIcon.visible && !OtaController.lowPower
                     loops: Animation.Infinite
                 }
             }
@@ -1,6 +1,7 @@
 import QtQuick
 import QtQuick.Controls
 import QtQuick.Layouts
+import qnxOta
 import "../components"
 
 Rectangle {
@@ -55,7 +56,7 @@ Rectangle {
             btnColor: down ? "#aa2e00" :
                      (hovered ? "#ff6420" : "#ff4500")
 
-            onClicked: otaController.applyUpdate()
+            onClicked: OtaController.applyUpdate()
         }
 
         // Secondary button: Return to Dashboard
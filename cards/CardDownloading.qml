@@ -1,6 +1,7 @@
 import QtQuick
 import QtQuick.Controls
 import QtQuick.Layouts
+import qnxOta
 import "../components"
 
 
@@ -13,12 +14,12 @@ Rectangle {
     border.width: 1
     border.color: "#e2e8f0"
 
-    property int progressPercent: otaController.progress
+    property int progressPercent: OtaController.progress
     property int downloadedMB: Math.round((progressPercent / 100) * totalMB)
-    property int totalMB: Math.round(otaController.totalSize / (1024 * 1024))
-    property real speedMB: otaController.speedMBps.toFixed(1)
-    property int chunksReceived: otaController.chunksReceived
-    property int totalChunks: otaController.totalChunks
+    property int totalMB: Math.round(OtaController.totalSize / (1024 * 1024))
+    property real speedMB: OtaController.speedMBps.toFixed(1)
+    property int chunksReceived: OtaController.chunksReceived
+    property int totalChunks: OtaController.totalChunks
 
     property int uiSegments: 20
     property int currentSegment: {
@@ -71,7 +72,8 @@ Rectangle {
                             from: 0
                             to: 360
                             duration: 1500
-                            running: true
+                            // Hidden (a cached card) or low power: no frames for it
+                            running: refreshIcon.visible && !OtaController.lowPower
                             loops: Animation.Infinite
                         }
                     }
@@ -232,6 +234,131 @@ Rectangle {
                     }
 
                 }
+                // Link and storage throughput, to tell which one limits the speed
+                Column {
+                    width: parent.width
+                    spacing: 6
+
+                    Text {
+                        text: "Network " + (OtaController.netInterface || "-") + ": "
+                              + OtaController.netRxMBps.toFixed(1) + " MB/s"
+                              + (OtaController.netLinkMbps > 0
+                                 ? " (" + OtaController.netUtilPercent + "% of " + OtaController.netLinkMbps + " Mb/s)"
+                                 : "")
+                        font.pixelSize: 15
+                        color: "#1e293b"
+                    }
+
+                    Text {
+                        text: "Storage: " + OtaController.diskWriteMBps.toFixed(1) + " MB/s write, "
+                              + OtaController.diskIops + " IOPS, "
+                              + OtaController.diskUtilPercent + "% busy"
+                        font.pixelSize: 15
+                        color: "#1e293b"
+                    }
+
+                    Row {
+                        spacing: 10
+
+                        Switch {
+                            checked: OtaController.backgroundTransfer
+                            onToggled: OtaController.backgroundTransfer = checked
+                        }
+
+                        Text {
+                            anchors.verticalCenter: parent.verticalCenter
+                            text: OtaController.backgroundTransfer
+                                  ? "Background download" + (OtaController.rateLimitText !== ""
+                                                              ? " (" + OtaController.rateLimitText + ")" : "")
+                                  : "Full-speed download"
+                            font.pixelSize: 15
+                            color: "#1e293b"
+                        }
+                    }
+
+                    Text {
+                        visible: OtaController.thermalLimited
+                        text: OtaController.thermalText
+                        font.pixelSize: 15
+                        font.bold: true
+                        color: "#b45309"
+                    }
+
+                    Text {
+                        visible: OtaController.downloadThrottled
+                        text: OtaController.throttleText
+                        font.pixelSize: 15
+                        font.bold: true
+                        color: "#b91c1c"
+                    }
+
+                    Text {
+                        visible: OtaController.bottleneckText !== ""
+                        text: "Limited by: " + OtaController.bottleneckText
+                        font.pixelSize: 15
+                        font.bold: true
+                        color: "#b45309"
+                    }
+                }
+
+                // Bundle artifacts, one row each
+                Column {
+                    visible: OtaController.artifacts.length > 0
+                    width: parent.width
+                    spacing: 8
+
+                    Text {
+                        text: "Artifacts (" + speedMB + " MB/s overall)"
+                        font.pixelSize: 15
+                        font.bold: true
+                        color: "#1e293b"
+                    }
+
+                    Repeater {
+                        model: OtaController.artifacts
+
+                        Column {
+                            width: parent.width
+                            spacing: 4
+
+                            Row {
+                                width: parent.width
+                                spacing: 10
+
+                                Text {
+                                    text: modelData.name + " (" + modelData.sizeMB.toFixed(1) + " MB)"
+                                    font.pixelSize: 14
+                                    color: "#1e293b"
+                                }
+
+                                Text {
+                                    text: modelData.skipped ? "Already present"
+                                          : modelData.state === "Downloading"
+                                            ? modelData.state + " " + modelData.progress + "%, "
+                                              + modelData.speedMBps.toFixed(1) + " MB/s"
+                                            : modelData.state
+                                    font.pixelSize: 14
+                                    color: modelData.state === "Failed" ? "#b91c1c" : "#64748b"
+                                }
+                            }
+
+                            Rectangle {
+                                width: parent.width
+                                height: 6
+                                radius: 3
+                                color: "#d0d5dd"
+
+                                Rectangle {
+                                    width: parent.width * (modelData.progress / 100.0)
+                                    height: parent.height
+                                    radius: 3
+                                    color: modelData.skipped ? "#588157" : "#007bff"
+                                }
+                            }
+                        }
+                    }
+                }
+
                 // Chunk Progress
 
                 Text {
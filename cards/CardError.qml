@@ -0,0 +1,57 @@
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Layouts
+import qnxOta
+import "../components"
+
+
+Rectangle {
+    id: errorCard
+    width: parent.width
+    implicitHeight: contentColumn.implicitHeight + 60
+    color: "#fde8e8"
+    radius: 15
+    border.width: 1
+    border.color: "#e2e8f0"
+    Column {
+        id: contentColumn
+        anchors.fill: parent
+        spacing: 17
+        anchors.margins: 30
+
+        Image {
+            source: "../assets/error.png"
+            opacity: 0.5
+            width: 60
+            height: 60
+            anchors.horizontalCenter: parent.horizontalCenter
+        }
+
+        Text {
+            text: qsTr("Update Failed")
+            font.pixelSize: 20
+            anchors.horizontalCenter: parent.horizontalCenter
+        }
+
+        Text {
+            text: OtaController.lastError
+            font.pixelSize: 18
+            width: parent.width
+            horizontalAlignment: Text.AlignHCenter
+            wrapMode: Text.WordWrap
+            color: "#64748b"
+        }
+
+        PrimaryButton {
+            id: backBtn
+            width: parent.width * 0.85
+            anchors.horizontalCenter: parent.horizontalCenter
+            text: "Back"
+            color: backBtn.hovered ? "#adb5bd" : "#6c757d"
+            iconSource: ""
+            onClicked: errorCard.returnRequested()
+        }
+    }
+
+    signal returnRequested()
+}
@@ -1,6 +1,7 @@
 import QtQuick
 import QtQuick.Controls
 import QtQuick.Layouts
+import qnxOta
 import "../components"
 
 
@@ -40,6 +41,14 @@ Rectangle {
             color: "#64748b"
         }
 
+        Text {
+            visible: text !== ""
+            text: OtaController.prefetchText
+            font.pixelSize: 14
+            anchors.horizontalCenter: parent.horizontalCenter
+            color: "#588157"
+        }
+
         PrimaryButton {
             id: checkBtn
             width: parent.width * 0.85
@@ -1,6 +1,7 @@
 import QtQuick
 import QtQuick.Controls
 import QtQuick.Layouts
+import qnxOta
 import "../components"
 
 Rectangle {
@@ -12,7 +13,7 @@ Rectangle {
     border.width: 1
     border.color: "#e2e8f0"
 
-    property real updateSize: Math.round(otaController.totalSize / (1024 * 1024))
+    property real updateSize: Math.round(OtaController.totalSize / (1024 * 1024))
     property string updateVersion: "1.0.0"
     property string updateDate: "9 Dec, 2025"
 
@@ -45,6 +46,14 @@ Rectangle {
             color: "#64748b"
         }
 
+        Text {
+            visible: text !== ""
+            text: OtaController.prefetchText
+            font.pixelSize: 14
+            anchors.horizontalCenter: parent.horizontalCenter
+            color: "#588157"
+        }
+
         // -------------------------------------------------------
         // UPDATE INFO BOX
         // -------------------------------------------------------
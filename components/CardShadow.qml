@@ -1,5 +1,6 @@
 import QtQuick
 import QtQuick.Effects
+import qnxOta
 
 MultiEffect {
     id: root
@@ -7,6 +8,9 @@ MultiEffect {
     property Item target
 
     source: target
+    // The blur is redone whenever the target's content changes; in low
+    // power the cards go without it
+    visible: !OtaController.lowPower
     shadowBlur: 1.0
     shadowEnabled: true
     shadowColor: "#22000000"
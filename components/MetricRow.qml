@@ -1,4 +1,5 @@
 import QtQuick
+import qnxOta
 
 Rectangle {
     width: parent.width
@@ -9,6 +10,11 @@ Rectangle {
     property alias text: deviceName.text
     property string deviceData
 
+    // MetricsHistory metric drawn as a sparkline next to the value, -1 for none
+    property int historyMetric: -1
+    property real historyMinimum: 0
+    property real historyMaximum: 100
+
     Row {
         anchors.fill: parent
         width: parent.width
@@ -30,7 +36,24 @@ Rectangle {
             anchors.leftMargin: 12
         }
 
+        Loader {
+            active: historyMetric >= 0
+            width: 90
+            height: 22
+            anchors.verticalCenter: parent.verticalCenter
+            anchors.right: valueText.left
+            anchors.rightMargin: 12
+
+            sourceComponent: Sparkline {
+                source: OtaController
+                metric: historyMetric
+                minimum: historyMinimum
+                maximum: historyMaximum
+            }
+        }
+
         Text {
+            id: valueText
             text: deviceData
             font.pixelSize: 18
             anchors.verticalCenter: parent.verticalCenter
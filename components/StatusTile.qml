@@ -1,4 +1,5 @@
 import QtQuick
+import qnxOta
 
 Rectangle {
     id: root
@@ -46,7 +47,7 @@ Rectangle {
             spacing: 7
             anchors.left: parent.left
             OnlineStatusIndicator {
-                connected: otaController.serverConnected
+                connected: OtaController.serverConnected
             }
 
             Text {
@@ -1,22 +1,47 @@
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
-#include <QQmlContext>
+#include <QQuickWindow>
 
 #include "OtaController.h"
+#include "StartupTrace.h"
 
 int main(int argc, char *argv[]) {
+    StartupTrace::instance().mark("main");
     QGuiApplication app(argc, argv);
 
     QQmlApplicationEngine engine;
     OtaController otaController;
+    StartupTrace::instance().mark("controller");
 
-    engine.rootContext()->setContextProperty("otaController", &otaController);
+    // QML reaches it as the OtaController singleton (OtaController::create)
+    // Backend init (service connect, first system sample) runs on its own
+    // threads while the QML below loads
     otaController.initialize();
 
 
     QObject::connect(
         &engine, &QQmlApplicationEngine::objectCreationFailed, &app, []() { QCoreApplication::exit(-1); }, Qt::QueuedConnection);
+    StartupTrace::instance().begin("qml.load");
     engine.loadFromModule("qnxOta", "Main");
+    StartupTrace::instance().end("qml.load");
+
+    // Time to first frame: frameSwapped fires on the render thread
+    if (!engine.rootObjects().isEmpty()) {
+        if (QQuickWindow* window = qobject_cast<QQuickWindow*>(engine.rootObjects().first())) {
+            QObject::connect(
+                window, &QQuickWindow::frameSwapped, &otaController,
+                [&otaController]() {
+                    StartupTrace::instance().mark("firstFrame");
+                    QMetaObject::invokeMethod(&otaController, [&otaController]() { otaController.onFirstFrame(); },
+                                              Qt::QueuedConnection);
+                },
+                static_cast<Qt::ConnectionType>(Qt::DirectConnection | Qt::SingleShotConnection));
+            // Frames per minute, for the low-power rendering report
+            QObject::connect(
+                window, &QQuickWindow::frameSwapped, &otaController, [&otaController]() { otaController.countFrame(); },
+                Qt::DirectConnection);
+        }
+    }
 
     return app.exec();
 }